@@ -96,6 +96,9 @@ extern "C"
  **************************************************************************************************/
 typedef void (*halKeyCBack_t) (uint8 keys, uint8 state);
 
+/* Called from the Port 0 ISR with the pending P0IFG bits it registered for */
+typedef void (*halKeyPortCBack_t) (uint8 pxifg);
+
 /**************************************************************************************************
  *                                             GLOBAL VARIABLES
  **************************************************************************************************/
@@ -120,6 +123,11 @@ extern void HalKeyConfig( bool interruptEnable, const halKeyCBack_t cback);
  */
 extern uint8 HalKeyRead( void);
 
+/*
+ * Share the Port 0 interrupt with a non-key driver
+ */
+extern void HalKeyPort0Register( uint8 bits, halKeyPortCBack_t cback );
+
 /*
  * Enter sleep mode, store important values
  */
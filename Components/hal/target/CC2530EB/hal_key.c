@@ -207,6 +207,8 @@
 static uint8 halKeySavedKeys;     /* used to store previous key state in polling mode */
 static halKeyCBack_t pHalKeyProcessFunction;
 static uint8 HalKeyConfigured;
+static halKeyPortCBack_t pHalKeyPort0Cback; /* non-key user of the Port 0 interrupt */
+static uint8 halKeyPort0CbackBits;
 bool Hal_KeyIntEnable;            /* interrupt enable/disable flag */
 
 /**************************************************************************************************
@@ -361,6 +363,28 @@ void HalKeyConfig (bool interruptEnable, halKeyCBack_t cback)
 }
 
 
+/**************************************************************************************************
+ * @fn      HalKeyPort0Register
+ *
+ * @brief   Register a driver for Port 0 pin interrupts. P0INT_VECTOR is owned by the key
+ *          service, so a driver on another P0 pin is called from halKeyPort0Isr instead of
+ *          installing its own ISR. The driver enables its own P0IEN bits.
+ *
+ * @param   bits  - P0IFG bits the driver owns
+ * @param   cback - called in interrupt context with the pending owned bits, NULL to remove
+ *
+ * @return  None
+ **************************************************************************************************/
+void HalKeyPort0Register( uint8 bits, halKeyPortCBack_t cback )
+{
+  halIntState_t intState;
+
+  HAL_ENTER_CRITICAL_SECTION(intState);
+  halKeyPort0CbackBits = (cback != NULL) ? bits : 0;
+  pHalKeyPort0Cback = cback;
+  HAL_EXIT_CRITICAL_SECTION(intState);
+}
+
 /**************************************************************************************************
  * @fn      HalKeyRead
  *
@@ -613,6 +637,11 @@ HAL_ISR_FUNCTION( halKeyPort0Isr, P0INT_VECTOR )
 {
   HAL_ENTER_ISR();
 
+  if (HAL_KEY_SW_6_PXIFG & halKeyPort0CbackBits)
+  {
+    pHalKeyPort0Cback(HAL_KEY_SW_6_PXIFG & halKeyPort0CbackBits);
+  }
+
   if (HAL_KEY_SW_6_PXIFG & HAL_KEY_SW_6_BIT)
   {
     halProcessKeyInterrupt();
@@ -666,6 +695,7 @@ HAL_ISR_FUNCTION( halKeyPort2Isr, P2INT_VECTOR )
 void HalKeyInit(void){}
 void HalKeyConfig(bool interruptEnable, halKeyCBack_t cback){}
 uint8 HalKeyRead(void){ return 0;}
+void HalKeyPort0Register(uint8 bits, halKeyPortCBack_t cback){}
 void HalKeyPoll(void){}
 
 #endif /* HAL_KEY */
@@ -0,0 +1,22 @@
+/**************************************************************************************************
+  Filename:       hal_aes.h
+
+  Description:    Host (Linux/x86) simulation target: the CC2530 AES engine. Same entry points
+                  as the CC2530EB target for loading a key and encrypting a block with it, run
+                  in software.
+
+**************************************************************************************************/
+
+#ifndef     HAL_AES_H_
+#define     HAL_AES_H_
+
+#include "ZComDef.h"
+
+#define     STATE_BLENGTH   16      // Number of bytes in State
+#define     KEY_BLENGTH     16      // Number of bytes in Key
+#define     KEY_EXP_LENGTH  176     // Nb * (Nr+1) * 4
+
+extern void ssp_HW_KeyInit (uint8 *);
+extern void sspAesEncryptHW (uint8 *, uint8 *);
+
+#endif  // HAL_AES_H_
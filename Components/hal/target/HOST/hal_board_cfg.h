@@ -0,0 +1,186 @@
+/**************************************************************************************************
+  Filename:       hal_board_cfg.h
+
+  Description:    Board configuration for the host (Linux/x86) simulation target.
+
+**************************************************************************************************/
+
+#ifndef HAL_BOARD_CFG_H
+#define HAL_BOARD_CFG_H
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+
+#include "hal_mcu.h"
+#include "hal_defs.h"
+#include "hal_types.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Board Indentifier
+ * ------------------------------------------------------------------------------------------------
+ */
+
+#define HAL_BOARD_HOST
+
+/* ------------------------------------------------------------------------------------------------
+ *                                          Clock Speed
+ * ------------------------------------------------------------------------------------------------
+ */
+
+#define HAL_CPU_CLOCK_MHZ     32
+
+#define HAL_CLOCK_STABLE()
+
+/* -----------------------------------------------------------------------------
+ *                                   		MY CONFIGURATION
+ * -----------------------------------------------------------------------------
+*/
+#define UART_DEBUG_TERMINAL   FALSE
+#define UART_DEBUG_LCD        FALSE
+#define UART_ZCMD             TRUE
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       LED Configuration
+ * ------------------------------------------------------------------------------------------------
+ */
+
+#define HAL_NUM_LEDS            3
+
+#define HAL_LED_BLINK_DELAY()
+
+#define ACTIVE_LOW        !
+#define ACTIVE_HIGH       !!    /* double negation forces result to be '1' */
+
+/* ------------------------------------------------------------------------------------------------
+ *                                    LCD Configuration
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* LCD Max Chars and Buffer */
+#define HAL_LCD_MAX_CHARS   16
+#define HAL_LCD_MAX_BUFF    25
+
+/* ------------------------------------------------------------------------------------------------
+ *                         OSAL NV implemented by internal flash pages.
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* The flash image is a plain file (see hal_flash.c) with the same geometry as the CC2530F256. */
+#define HAL_FLASH_PAGE_PER_BANK    16
+#define HAL_FLASH_PAGE_SIZE        2048
+#define HAL_FLASH_WORD_SIZE        4
+#define HAL_FLASH_PAGE_MAP         0x8000
+
+#define HAL_FLASH_LOCK_BITS        16
+#define HAL_NV_PAGE_END            126
+#define HAL_NV_PAGE_CNT            6
+
+#define HAL_FLASH_IEEE_SIZE        8
+#define HAL_FLASH_IEEE_PAGE       (HAL_NV_PAGE_END+1)
+#define HAL_FLASH_IEEE_OSET       (HAL_FLASH_PAGE_SIZE - HAL_FLASH_LOCK_BITS - HAL_FLASH_IEEE_SIZE)
+#define HAL_INFOP_IEEE_OSET        0xC
+
+#define HAL_NV_PAGE_BEG           (HAL_NV_PAGE_END-HAL_NV_PAGE_CNT+1)
+
+/* ------------------------------------------------------------------------------------------------
+ *                                            Macros
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* ----------- Board Initialization ---------- */
+#define HAL_BOARD_INIT()
+
+/* ----------- Debounce ---------- */
+#define HAL_DEBOUNCE(expr)
+
+/* ----------- Push Buttons ---------- */
+#define HAL_PUSH_BUTTON1()        (0)
+#define HAL_PUSH_BUTTON2()        (0)
+#define HAL_PUSH_BUTTON3()        (0)
+#define HAL_PUSH_BUTTON4()        (0)
+#define HAL_PUSH_BUTTON5()        (0)
+#define HAL_PUSH_BUTTON6()        (0)
+
+/* ----------- LED's ---------- */
+#define HAL_TURN_OFF_LED1()
+#define HAL_TURN_OFF_LED2()
+#define HAL_TURN_OFF_LED3()
+#define HAL_TURN_OFF_LED4()
+#define HAL_TURN_ON_LED1()
+#define HAL_TURN_ON_LED2()
+#define HAL_TURN_ON_LED3()
+#define HAL_TURN_ON_LED4()
+#define HAL_TOGGLE_LED1()
+#define HAL_TOGGLE_LED2()
+#define HAL_TOGGLE_LED3()
+#define HAL_TOGGLE_LED4()
+#define HAL_STATE_LED1()          (0)
+#define HAL_STATE_LED2()          (0)
+#define HAL_STATE_LED3()          (0)
+#define HAL_STATE_LED4()          (0)
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                     Driver Configuration
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* Set to TRUE enable H/W TIMER usage, FALSE disable it */
+#ifndef HAL_TIMER
+#define HAL_TIMER FALSE
+#endif
+
+/* Set to TRUE enable ADC usage, FALSE disable it */
+#ifndef HAL_ADC
+#define HAL_ADC FALSE
+#endif
+
+/* Set to TRUE enable DMA usage, FALSE disable it */
+#ifndef HAL_DMA
+#define HAL_DMA FALSE
+#endif
+
+/* Set to TRUE enable Flash access, FALSE disable it */
+#ifndef HAL_FLASH
+#define HAL_FLASH TRUE
+#endif
+
+/* Set to TRUE enable AES usage, FALSE disable it */
+#ifndef HAL_AES
+#define HAL_AES FALSE
+#endif
+
+#ifndef HAL_AES_DMA
+#define HAL_AES_DMA FALSE
+#endif
+
+/* Set to TRUE enable LCD usage, FALSE disable it */
+#ifndef HAL_LCD
+#define HAL_LCD FALSE
+#endif
+
+/* Set to TRUE enable LED usage, FALSE disable it */
+#ifndef HAL_LED
+#define HAL_LED FALSE
+#endif
+
+/* Set to TRUE enable KEY usage, FALSE disable it */
+#ifndef HAL_KEY
+#define HAL_KEY FALSE
+#endif
+
+/* Set to TRUE enable UART usage, FALSE disable it */
+#ifndef HAL_UART
+#define HAL_UART TRUE
+#endif
+
+/* The host UART is an in-memory loopback (see hal_uart.c), no DMA or ISR back end. */
+#define HAL_UART_DMA  0
+#define HAL_UART_ISR  0
+#define HAL_UART_USB  0
+
+#endif
+/*******************************************************************************************************
+*/
@@ -0,0 +1,288 @@
+/**************************************************************************************************
+  Filename:       hal_flash.c
+
+  Description:    Host (Linux/x86) simulation target: internal flash modelled as a RAM image with
+                  NOR semantics (erase sets 0xFF, programming can only clear bits), optionally
+                  mirrored to a file so NV survives process restarts.
+
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                          Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "hal_assert.h"
+#include "hal_board_cfg.h"
+#include "hal_flash.h"
+#include "hal_host.h"
+#include "hal_mcu.h"
+#include "hal_types.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                          Constants
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* The IEEE/lock-bits page is the last page of the part. */
+#define HOST_FLASH_PAGES   (HAL_FLASH_IEEE_PAGE + 1)
+#define HOST_FLASH_SIZE    ((uint32)HOST_FLASH_PAGES * HAL_FLASH_PAGE_SIZE)
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+static uint8 hostFlash[HOST_FLASH_SIZE];
+static uint8 hostFlashInit;
+static FILE *hostFlashFile;
+static uint32 hostFlashWriteCnt;
+static uint32 hostFlashEraseCnt;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+static void hostFlashCheckInit( void );
+static void hostFlashSync( uint32 addr, uint32 len );
+
+/**************************************************************************************************
+ * @fn          hostFlashCheckInit
+ *
+ * @brief       A part fresh from the factory reads back as erased.
+ *
+ * @param       none
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+static void hostFlashCheckInit( void )
+{
+  if ( !hostFlashInit )
+  {
+    (void)memset( hostFlash, 0xFF, sizeof( hostFlash ) );
+    hostFlashInit = TRUE;
+  }
+}
+
+/**************************************************************************************************
+ * @fn          hostFlashSync
+ *
+ * @brief       Mirror a modified range of the image to the attached file, if any.
+ *
+ * @param       addr - Byte address of the range.
+ * @param       len - Length of the range.
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+static void hostFlashSync( uint32 addr, uint32 len )
+{
+  if ( hostFlashFile != NULL )
+  {
+    if ( (fseek( hostFlashFile, (long)addr, SEEK_SET ) != 0) ||
+         (fwrite( hostFlash + addr, 1, len, hostFlashFile ) != len) )
+    {
+      HAL_ASSERT_FORCED();
+    }
+    (void)fflush( hostFlashFile );
+  }
+}
+
+/**************************************************************************************************
+ * @fn          halHostFlashAttach
+ *
+ * @brief       Back the flash image with a file. An existing file of the right size is loaded,
+ *              otherwise the file is (re)created holding an erased part.
+ *
+ * @param       path - File name.
+ *
+ * @return      TRUE on success, FALSE if the file could not be opened.
+ **************************************************************************************************
+ */
+uint8 halHostFlashAttach( const char *path )
+{
+  halHostFlashDetach();
+  hostFlashCheckInit();
+
+  hostFlashFile = fopen( path, "r+b" );
+  if ( hostFlashFile != NULL )
+  {
+    if ( fread( hostFlash, 1, HOST_FLASH_SIZE, hostFlashFile ) == HOST_FLASH_SIZE )
+    {
+      return TRUE;
+    }
+    (void)fclose( hostFlashFile );
+  }
+
+  hostFlashFile = fopen( path, "w+b" );
+  if ( hostFlashFile == NULL )
+  {
+    return FALSE;
+  }
+
+  (void)memset( hostFlash, 0xFF, sizeof( hostFlash ) );
+  hostFlashSync( 0, HOST_FLASH_SIZE );
+
+  return TRUE;
+}
+
+/**************************************************************************************************
+ * @fn          halHostFlashDetach
+ *
+ * @brief       Stop mirroring the flash image to a file; the RAM image is kept.
+ *
+ * @param       none
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void halHostFlashDetach( void )
+{
+  if ( hostFlashFile != NULL )
+  {
+    (void)fclose( hostFlashFile );
+    hostFlashFile = NULL;
+  }
+}
+
+/**************************************************************************************************
+ * @fn          halHostFlashFormat
+ *
+ * @brief       Erase the whole part (and the attached file) and clear the operation counters.
+ *
+ * @param       none
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void halHostFlashFormat( void )
+{
+  (void)memset( hostFlash, 0xFF, sizeof( hostFlash ) );
+  hostFlashInit = TRUE;
+  hostFlashWriteCnt = 0;
+  hostFlashEraseCnt = 0;
+  hostFlashSync( 0, HOST_FLASH_SIZE );
+}
+
+/**************************************************************************************************
+ * @fn          halHostFlashWriteCount / halHostFlashEraseCount
+ *
+ * @brief       Number of HalFlashWrite() / HalFlashErase() calls since the last format.
+ *
+ * @param       none
+ *
+ * @return      Operation count.
+ **************************************************************************************************
+ */
+uint32 halHostFlashWriteCount( void )
+{
+  return hostFlashWriteCnt;
+}
+
+uint32 halHostFlashEraseCount( void )
+{
+  return hostFlashEraseCnt;
+}
+
+/**************************************************************************************************
+ * @fn          HalFlashRead
+ *
+ * @brief       This function reads 'cnt' bytes from the internal flash.
+ *
+ * input parameters
+ *
+ * @param       pg - A valid flash page number.
+ * @param       offset - A valid offset into the page.
+ * @param       buf - A valid buffer space at least as big as the 'cnt' parameter.
+ * @param       cnt - A valid number of bytes to read.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ **************************************************************************************************
+ */
+void HalFlashRead(uint8 pg, uint16 offset, uint8 *buf, uint16 cnt)
+{
+  uint32 addr = (uint32)pg * HAL_FLASH_PAGE_SIZE + offset;
+  halIntState_t is;
+
+  HAL_ASSERT( addr + cnt <= HOST_FLASH_SIZE );
+  hostFlashCheckInit();
+
+  HAL_ENTER_CRITICAL_SECTION(is);
+  (void)memcpy( buf, hostFlash + addr, cnt );
+  HAL_EXIT_CRITICAL_SECTION(is);
+}
+
+/**************************************************************************************************
+ * @fn          HalFlashWrite
+ *
+ * @brief       This function writes 'cnt' bytes to the internal flash.
+ *
+ * input parameters
+ *
+ * @param       addr - Valid HAL flash write address: actual addr / 4 and quad-aligned.
+ * @param       buf - Valid buffer space at least as big as 'cnt' X 4.
+ * @param       cnt - Number of 4-byte blocks to write.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ **************************************************************************************************
+ */
+void HalFlashWrite(uint16 addr, uint8 *buf, uint16 cnt)
+{
+  uint32 byteAddr = (uint32)addr * HAL_FLASH_WORD_SIZE;
+  uint32 len = (uint32)cnt * HAL_FLASH_WORD_SIZE;
+  uint32 idx;
+
+  HAL_ASSERT( byteAddr + len <= HOST_FLASH_SIZE );
+  hostFlashCheckInit();
+
+  // Programming can only pull bits low, exactly like the CC2530 flash controller.
+  for ( idx = 0; idx < len; idx++ )
+  {
+    hostFlash[byteAddr + idx] &= buf[idx];
+  }
+
+  hostFlashWriteCnt++;
+  hostFlashSync( byteAddr, len );
+}
+
+/**************************************************************************************************
+ * @fn          HalFlashErase
+ *
+ * @brief       This function erases the specified page of the internal flash.
+ *
+ * input parameters
+ *
+ * @param       pg - A valid flash page number to erase.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ **************************************************************************************************
+ */
+void HalFlashErase(uint8 pg)
+{
+  uint32 addr = (uint32)pg * HAL_FLASH_PAGE_SIZE;
+
+  HAL_ASSERT( pg < HOST_FLASH_PAGES );
+  hostFlashCheckInit();
+
+  (void)memset( hostFlash + addr, 0xFF, HAL_FLASH_PAGE_SIZE );
+
+  hostFlashEraseCnt++;
+  hostFlashSync( addr, HAL_FLASH_PAGE_SIZE );
+}
+
+/**************************************************************************************************
+*/
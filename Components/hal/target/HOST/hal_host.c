@@ -0,0 +1,183 @@
+/**************************************************************************************************
+  Filename:       hal_host.c
+
+  Description:    Host (Linux/x86) simulation target: interrupt flag, MAC precision counter,
+                  reset and assert handling.
+
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                          Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "hal_assert.h"
+#include "hal_host.h"
+#include "hal_mcu.h"
+#include "hal_types.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Global Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* Interrupts start disabled, as out of the 8051 reset vector; ZMain/the driver enables them. */
+volatile unsigned char halHostIntEnable = 0;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+static uint32 hostTicks;          /* Free running count of 320us ticks. */
+static uint32 hostUsRemainder;    /* Microseconds not yet accounted for in hostTicks. */
+static uint32 hostResetCnt;
+static void (*hostResetHandler)( void );
+
+/* ------------------------------------------------------------------------------------------------
+ *                                       Global Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* Prototype kept local: the real one lives in the CC2530 MAC low level (mac_mcu.h). */
+uint32 macMcuPrecisionCount( void );
+
+/**************************************************************************************************
+ * @fn          macMcuPrecisionCount
+ *
+ * @brief       Simulated MAC backoff timer: a free running count of 320us ticks.
+ *
+ * @param       none
+ *
+ * @return      The current tick count.
+ **************************************************************************************************
+ */
+uint32 macMcuPrecisionCount( void )
+{
+  return hostTicks;
+}
+
+/**************************************************************************************************
+ * @fn          halHostClockAdvance
+ *
+ * @brief       Advance simulated time by a number of 320us ticks.
+ *
+ * @param       ticks - Number of ticks.
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void halHostClockAdvance( uint32 ticks )
+{
+  hostTicks += ticks;
+}
+
+/**************************************************************************************************
+ * @fn          halHostClockAdvanceMs
+ *
+ * @brief       Advance simulated time by a number of milliseconds; the sub-tick remainder is
+ *              carried over so that repeated short advances do not drift.
+ *
+ * @param       ms - Number of milliseconds.
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void halHostClockAdvanceMs( uint32 ms )
+{
+  uint32 us = ms * 1000 + hostUsRemainder;
+
+  hostTicks += us / 320;
+  hostUsRemainder = us % 320;
+}
+
+/**************************************************************************************************
+ * @fn          halHostClockTicks
+ *
+ * @brief       Read the simulated 320us tick count.
+ *
+ * @param       none
+ *
+ * @return      The current tick count.
+ **************************************************************************************************
+ */
+uint32 halHostClockTicks( void )
+{
+  return hostTicks;
+}
+
+/**************************************************************************************************
+ * @fn          halHostSetResetHandler
+ *
+ * @brief       Install the function that HAL_SYSTEM_RESET() hands control to.
+ *
+ * @param       handler - Function to call, or NULL to exit the process on reset.
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void halHostSetResetHandler( void (*handler)( void ) )
+{
+  hostResetHandler = handler;
+}
+
+/**************************************************************************************************
+ * @fn          halHostResetCount
+ *
+ * @brief       Number of HAL_SYSTEM_RESET() calls seen so far.
+ *
+ * @param       none
+ *
+ * @return      Reset count.
+ **************************************************************************************************
+ */
+uint32 halHostResetCount( void )
+{
+  return hostResetCnt;
+}
+
+/**************************************************************************************************
+ * @fn          halHostSystemReset
+ *
+ * @brief       Implementation of HAL_SYSTEM_RESET() for the host.
+ *
+ * @param       none
+ *
+ * @return      Only if the installed reset handler returns.
+ **************************************************************************************************
+ */
+void halHostSystemReset( void )
+{
+  hostResetCnt++;
+  HAL_DISABLE_INTERRUPTS();
+
+  if ( hostResetHandler != NULL )
+  {
+    hostResetHandler();
+  }
+  else
+  {
+    fprintf( stderr, "hal_host: system reset requested\n" );
+    exit( EXIT_FAILURE );
+  }
+}
+
+/**************************************************************************************************
+ * @fn          halAssertHandler
+ *
+ * @brief       Logic to handle an assert: on the host there is a debugger, so just abort.
+ *
+ * @param       none
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void halAssertHandler( void )
+{
+  fprintf( stderr, "hal_host: HAL_ASSERT failed\n" );
+  abort();
+}
+
+/**************************************************************************************************
+*/
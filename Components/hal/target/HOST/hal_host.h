@@ -0,0 +1,85 @@
+/**************************************************************************************************
+  Filename:       hal_host.h
+
+  Description:    Host (Linux/x86) simulation target: hooks that let a native test or benchmark
+                  driver feed the simulated peripherals and observe what the stack did with them.
+
+**************************************************************************************************/
+
+#ifndef HAL_HOST_H
+#define HAL_HOST_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/* ------------------------------------------------------------------------------------------------
+ *                                          Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include "hal_types.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                          Constants
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* Size of the simulated UART Rx/Tx buffers (per port). */
+#define HAL_HOST_UART_BUF_SIZE     512
+
+/* ------------------------------------------------------------------------------------------------
+ *                                          Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/*
+ * Clock: the simulated MAC precision counter only moves when the driver advances it, so OSAL
+ * timers are fully deterministic. halHostClockAdvanceMs() rounds to whole 320us ticks.
+ */
+extern void   halHostClockAdvance( uint32 ticks );
+extern void   halHostClockAdvanceMs( uint32 ms );
+extern uint32 halHostClockTicks( void );
+
+/*
+ * Flash: the internal flash is a RAM image. Attaching a file makes it persistent: the image is
+ * loaded from the file (or erased if absent) and written back on every program/erase operation.
+ */
+extern uint8  halHostFlashAttach( const char *path );
+extern void   halHostFlashDetach( void );
+extern void   halHostFlashFormat( void );
+extern uint32 halHostFlashWriteCount( void );
+extern uint32 halHostFlashEraseCount( void );
+
+/*
+ * OTA: the download image is a RAM image of the external NV, or of the internal flash with
+ * HAL_OTA_XNV_IS_INT. The seek count is the number of writes that did not continue where the
+ * previous write ended; the erase count that of the pages a write to their first word erased.
+ */
+extern void   halHostOtaFormat( void );
+extern uint32 halHostOtaWriteCount( void );
+extern uint32 halHostOtaSeekCount( void );
+extern uint32 halHostOtaEraseCount( void );
+
+/*
+ * UART: bytes injected into a port's Rx buffer are delivered to the registered callback on the
+ * next HalUARTPoll(); bytes written by the stack accumulate in the Tx buffer until drained.
+ */
+extern uint16 halHostUartInject( uint8 port, const uint8 *buf, uint16 len );
+extern uint16 halHostUartDrain( uint8 port, uint8 *buf, uint16 len );
+
+/*
+ * Reset: counts calls of HAL_SYSTEM_RESET(). A driver may install a handler (e.g. longjmp) to
+ * regain control; without one the process exits.
+ */
+extern void   halHostSetResetHandler( void (*handler)( void ) );
+extern uint32 halHostResetCount( void );
+
+/**************************************************************************************************
+*/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
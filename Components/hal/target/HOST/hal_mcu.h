@@ -0,0 +1,89 @@
+/**************************************************************************************************
+  Filename:       hal_mcu.h
+
+  Description:    Host (Linux/x86) simulation target: the 8051 interrupt enable bit is modelled by
+                  a plain variable so that critical sections cost the same few instructions as on
+                  the CC2530 and code paths stay identical.
+
+**************************************************************************************************/
+
+#ifndef _HAL_MCU_H
+#define _HAL_MCU_H
+
+/*
+ *  Target : Host simulation (native process, single threaded)
+ *
+ */
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                           Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include "hal_defs.h"
+#include "hal_types.h"
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Target Defines
+ * ------------------------------------------------------------------------------------------------
+ */
+#define HAL_MCU_HOST
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                     Compiler Abstraction
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* ---------------------- GNU Compiler ---------------------- */
+#if defined __GNUC__
+#define HAL_COMPILER_GNU
+#define HAL_MCU_LITTLE_ENDIAN()   (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define HAL_ISR_FUNC_DECLARATION(f,v)   void f(void)
+#define HAL_ISR_FUNC_PROTOTYPE(f,v)     void f(void)
+#define HAL_ISR_FUNCTION(f,v)           HAL_ISR_FUNC_PROTOTYPE(f,v); HAL_ISR_FUNC_DECLARATION(f,v)
+
+/* ------------------ Unrecognized Compiler ------------------ */
+#else
+#error "ERROR: Unknown compiler."
+#endif
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Interrupt Macros
+ * ------------------------------------------------------------------------------------------------
+ */
+extern volatile unsigned char halHostIntEnable;   /* Stand-in for the 8051 EA bit. */
+
+#define HAL_ENABLE_INTERRUPTS()         st( halHostIntEnable = 1; )
+#define HAL_DISABLE_INTERRUPTS()        st( halHostIntEnable = 0; )
+#define HAL_INTERRUPTS_ARE_ENABLED()    (halHostIntEnable)
+
+typedef unsigned char halIntState_t;
+#define HAL_ENTER_CRITICAL_SECTION(x)   st( x = halHostIntEnable;  HAL_DISABLE_INTERRUPTS(); )
+#define HAL_EXIT_CRITICAL_SECTION(x)    st( halHostIntEnable = x; )
+#define HAL_CRITICAL_STATEMENT(x)       st( halIntState_t _s; HAL_ENTER_CRITICAL_SECTION(_s); x; HAL_EXIT_CRITICAL_SECTION(_s); )
+
+#define HAL_ENTER_ISR()
+#define HAL_EXIT_ISR()
+
+/* Dummy for this platform */
+#define HAL_AES_ENTER_WORKAROUND()
+#define HAL_AES_EXIT_WORKAROUND()
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Reset Macro
+ * ------------------------------------------------------------------------------------------------
+ */
+extern void halHostSystemReset(void);
+
+#define WD_KICK()
+#define HAL_SYSTEM_RESET()  halHostSystemReset()
+
+#define CLEAR_SLEEP_MODE()
+#define ALLOW_SLEEP_MODE()
+
+/**************************************************************************************************
+ */
+#endif
@@ -0,0 +1,325 @@
+/**************************************************************************************************
+  Filename:       hal_ota.c
+
+  Description:    Host (Linux/x86) simulation target: OTA image storage. The download image
+                  lives in a RAM image of the external NV, or of its internal flash area with
+                  HAL_OTA_XNV_IS_INT; the run code image is read from and written to the
+                  simulated internal flash exactly as on the CC2530.
+
+**************************************************************************************************/
+
+/* ------------------------------------------------------------------------------------------------
+ *                                          Includes
+ * ------------------------------------------------------------------------------------------------
+ */
+#include <string.h>
+
+#include "comdef.h"
+#include "hal_assert.h"
+#include "hal_board_cfg.h"
+#include "hal_flash.h"
+#include "hal_host.h"
+#include "hal_ota.h"
+#include "hal_types.h"
+
+#include "ota_common.h"
+
+/* ------------------------------------------------------------------------------------------------
+ *                                          Typedefs
+ * ------------------------------------------------------------------------------------------------
+ */
+typedef struct
+{
+  uint16 crc[2];
+  uint32 programSize;
+} OTA_CrcControl_t;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Variables
+ * ------------------------------------------------------------------------------------------------
+ */
+static uint8 hostOtaXnv[HAL_OTA_DL_MAX];
+static uint8 hostOtaXnvInit;
+static uint32 hostOtaWriteCnt;
+static uint32 hostOtaSeekCnt;
+static uint32 hostOtaEraseCnt;
+static uint32 hostOtaNextOset;
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Local Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+static void hostOtaCheckInit( void );
+static uint16 runPoly( uint16 crc, uint8 val );
+
+/**************************************************************************************************
+ * @fn          hostOtaCheckInit
+ *
+ * @brief       The external NV reads back as erased until something is written to it.
+ *
+ * @param       none
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+static void hostOtaCheckInit( void )
+{
+  if ( !hostOtaXnvInit )
+  {
+    (void)memset( hostOtaXnv, 0xFF, sizeof( hostOtaXnv ) );
+    hostOtaXnvInit = TRUE;
+  }
+}
+
+/**************************************************************************************************
+ * @fn          runPoly
+ *
+ * @brief       Run the CRC16 Polynomial calculation over the byte parameter.
+ *
+ * @param       crc - Running CRC calculated so far.
+ * @param       val - Value on which to run the CRC16.
+ *
+ * @return      crc - Updated for the run.
+ **************************************************************************************************
+ */
+static uint16 runPoly( uint16 crc, uint8 val )
+{
+  const uint16 poly = 0x1021;
+  uint8 cnt;
+
+  for ( cnt = 0; cnt < 8; cnt++, val <<= 1 )
+  {
+    uint8 msb = (crc & 0x8000) ? 1 : 0;
+
+    crc <<= 1;
+    if ( val & 0x80 )  crc |= 0x0001;
+    if ( msb )         crc ^= poly;
+  }
+
+  return crc;
+}
+
+/**************************************************************************************************
+ * @fn          halHostOtaFormat
+ *
+ * @brief       Erase the download image and clear the write counters.
+ *
+ * @param       none
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void halHostOtaFormat( void )
+{
+  (void)memset( hostOtaXnv, 0xFF, sizeof( hostOtaXnv ) );
+  hostOtaXnvInit = TRUE;
+  hostOtaWriteCnt = 0;
+  hostOtaSeekCnt = 0;
+  hostOtaEraseCnt = 0;
+  hostOtaNextOset = 0;
+}
+
+/**************************************************************************************************
+ * @fn          halHostOtaWriteCount / halHostOtaSeekCount
+ *
+ * @brief       Number of HalOTAWrite() calls to the download image since the last format, and
+ *              how many of them did not start where the previous one ended.
+ *
+ * @param       none
+ *
+ * @return      Operation count.
+ **************************************************************************************************
+ */
+uint32 halHostOtaWriteCount( void )
+{
+  return hostOtaWriteCnt;
+}
+
+uint32 halHostOtaSeekCount( void )
+{
+  return hostOtaSeekCnt;
+}
+
+/**************************************************************************************************
+ * @fn          halHostOtaEraseCount
+ *
+ * @brief       Number of download image pages erased since the last format, always 0 unless
+ *              HAL_OTA_XNV_IS_INT.
+ *
+ * @param       none
+ *
+ * @return      Page erase count.
+ **************************************************************************************************
+ */
+uint32 halHostOtaEraseCount( void )
+{
+  return hostOtaEraseCnt;
+}
+
+/**************************************************************************************************
+ * @fn          HalOTAChkDL
+ *
+ * @brief       Run the CRC16 Polynomial calculation over the DL image.
+ *
+ * @param       dlImagePreambleOffset - Unused, as on the CC2530.
+ *
+ * @return      SUCCESS or FAILURE.
+ **************************************************************************************************
+ */
+uint8 HalOTAChkDL( uint8 dlImagePreambleOffset )
+{
+  uint32 oset;
+  uint16 crc = 0;
+  OTA_CrcControl_t crcControl;
+  OTA_ImageHeader_t header;
+  uint32 programStart;
+
+  (void)dlImagePreambleOffset;
+
+  HalOTARead( 0, (uint8 *)&header, sizeof( OTA_ImageHeader_t ), HAL_OTA_DL );
+
+  programStart = header.headerLength + OTA_SUB_ELEMENT_HDR_LEN;
+
+  HalOTARead( programStart + HAL_OTA_CRC_OSET, (uint8 *)&crcControl, sizeof( crcControl ),
+              HAL_OTA_DL );
+
+  if ( (crcControl.programSize > HAL_OTA_DL_MAX) || (crcControl.programSize == 0) )
+  {
+    return FAILURE;
+  }
+
+  for ( oset = 0; oset < crcControl.programSize; oset++ )
+  {
+    if ( (oset < HAL_OTA_CRC_OSET) || (oset >= HAL_OTA_CRC_OSET+4) )
+    {
+      uint8 buf;
+      HalOTARead( oset + programStart, &buf, 1, HAL_OTA_DL );
+      crc = runPoly( crc, buf );
+    }
+  }
+
+  return ( crcControl.crc[0] == crc ) ? SUCCESS : FAILURE;
+}
+
+/**************************************************************************************************
+ * @fn          HalOTAInvRC
+ *
+ * @brief       Invalidate the active image so that the boot code will instantiate the DL image
+ *              on the next reset.
+ *
+ * @param       none
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void HalOTAInvRC( void )
+{
+  uint16 crc[2] = {0,0xFFFF};
+  HalFlashWrite( (HAL_OTA_CRC_ADDR / HAL_FLASH_WORD_SIZE), (uint8 *)crc, 1 );
+}
+
+/**************************************************************************************************
+ * @fn          HalOTARead
+ *
+ * @brief       Read from the storage medium according to image type.
+ *
+ * @param       oset - Offset into the monolithic image.
+ * @param       pBuf - Pointer to the buffer in which to copy the bytes read.
+ * @param       len - Number of bytes to read.
+ * @param       type - Which image: HAL_OTA_RC or HAL_OTA_DL.
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void HalOTARead( uint32 oset, uint8 *pBuf, uint16 len, image_t type )
+{
+  if ( HAL_OTA_RC != type )
+  {
+    oset += HAL_OTA_DL_OSET;
+    HAL_ASSERT( oset + len <= HAL_OTA_DL_MAX );
+    hostOtaCheckInit();
+    (void)memcpy( pBuf, hostOtaXnv + oset, len );
+    return;
+  }
+
+  oset += HAL_OTA_RC_START;
+  HalFlashRead( oset / HAL_FLASH_PAGE_SIZE, oset % HAL_FLASH_PAGE_SIZE, pBuf, len );
+}
+
+/**************************************************************************************************
+ * @fn          HalOTAWrite
+ *
+ * @brief       Write to the storage medium according to the image type. The external NV takes
+ *              any byte range; the internal flash, and the download image with
+ *              HAL_OTA_XNV_IS_INT, have the CC2530 page erase behaviour.
+ *
+ * @param       oset - Offset into the monolithic image.
+ * @param       pBuf - Pointer to the buffer in from which to write.
+ * @param       len - Number of bytes to write.
+ * @param       type - Which image: HAL_OTA_RC or HAL_OTA_DL.
+ *
+ * @return      none
+ **************************************************************************************************
+ */
+void HalOTAWrite( uint32 oset, uint8 *pBuf, uint16 len, image_t type )
+{
+  if ( HAL_OTA_RC != type )
+  {
+    oset += HAL_OTA_DL_OSET;
+    HAL_ASSERT( oset + len <= HAL_OTA_DL_MAX );
+    hostOtaCheckInit();
+#if HAL_OTA_XNV_IS_INT
+    {
+      uint16 idx;
+
+      // As HalFlashWrite: the first word of a page erases it, programming only clears bits
+      if ( ((oset + HAL_OTA_RC_START) % HAL_FLASH_PAGE_SIZE) == 0 )
+      {
+        (void)memset( hostOtaXnv + oset, 0xFF, HAL_FLASH_PAGE_SIZE );
+        hostOtaEraseCnt++;
+      }
+      for ( idx = 0; idx < len; idx++ )
+      {
+        hostOtaXnv[oset + idx] &= pBuf[idx];
+      }
+    }
+#else
+    (void)memcpy( hostOtaXnv + oset, pBuf, len );
+#endif
+
+    if ( oset != HAL_OTA_DL_OSET + hostOtaNextOset )
+    {
+      hostOtaSeekCnt++;
+    }
+    hostOtaNextOset = oset - HAL_OTA_DL_OSET + len;
+    hostOtaWriteCnt++;
+    return;
+  }
+
+  oset += HAL_OTA_RC_START;
+
+  if ( (oset % HAL_FLASH_PAGE_SIZE) == 0 )
+  {
+    HalFlashErase( oset / HAL_FLASH_PAGE_SIZE );
+  }
+
+  HalFlashWrite( oset / HAL_FLASH_WORD_SIZE, pBuf, len / HAL_FLASH_WORD_SIZE );
+}
+
+/**************************************************************************************************
+ * @fn          HalOTAAvail
+ *
+ * @brief       Determine the space available for downloading an image.
+ *
+ * @param       none
+ *
+ * @return      Number of bytes available for storing an OTA image.
+ **************************************************************************************************
+ */
+uint32 HalOTAAvail( void )
+{
+  return HAL_OTA_DL_MAX - HAL_OTA_DL_OSET;
+}
+
+/**************************************************************************************************
+*/
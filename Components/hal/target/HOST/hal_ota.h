@@ -0,0 +1,91 @@
+/**************************************************************************************************
+  Filename:       hal_ota.h
+
+  Description:    Host (Linux/x86) simulation target: OTA image storage. Same API and layout
+                  constants as the CC2530EB target with the download image in an external (SPI)
+                  NV, or in internal flash with HAL_OTA_XNV_IS_INT, modelled here as a RAM image,
+                  and the run code image in the simulated internal flash.
+
+**************************************************************************************************/
+
+#ifndef HAL_OTA_H
+#define HAL_OTA_H
+
+/******************************************************************************
+ * INCLUDES
+ */
+
+#include "hal_board_cfg.h"
+#include "hal_types.h"
+
+/******************************************************************************
+ * MACROS
+ */
+
+#if !defined HAL_OTA_BOOT_CODE
+#define HAL_OTA_BOOT_CODE  FALSE
+#endif
+
+#define PACK_1
+
+/******************************************************************************
+ * CONSTANTS
+ */
+
+#define HAL_OTA_RC_START           0x0800
+#define HAL_OTA_CRC_ADDR           0x0888
+#define HAL_OTA_CRC_OSET          (HAL_OTA_CRC_ADDR - HAL_OTA_RC_START)
+
+/* TRUE gives the download image the internal flash layout and page erase behaviour of the
+ * CC2530EB target with HAL_OTA_XNV_IS_INT; it stays a RAM image either way.
+ */
+#if !defined HAL_OTA_XNV_IS_INT
+#define HAL_OTA_XNV_IS_INT         FALSE
+#endif
+#define HAL_OTA_XNV_IS_SPI        !HAL_OTA_XNV_IS_INT
+
+#define HAL_OTA_BOOT_PG_CNT        2
+
+#if HAL_OTA_XNV_IS_SPI
+#define HAL_OTA_DL_MAX    0x40000
+#define HAL_OTA_DL_SIZE  (0x40000 - ((HAL_NV_PAGE_CNT+HAL_OTA_BOOT_PG_CNT)*HAL_FLASH_PAGE_SIZE))
+#define HAL_OTA_DL_OSET   0x0
+#else
+#define HAL_OTA_DL_MAX   (0x40000 - ((HAL_NV_PAGE_CNT+HAL_OTA_BOOT_PG_CNT)*HAL_FLASH_PAGE_SIZE))
+#define HAL_OTA_DL_SIZE  (HAL_OTA_DL_MAX / 2)
+#define HAL_OTA_DL_OSET  (HAL_OTA_DL_MAX / 2)
+#endif
+
+#define PREAMBLE_OFFSET            0x8C
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef enum {
+  HAL_OTA_RC,  /* Run code / active image.          */
+  HAL_OTA_DL   /* Downloaded code to be activated later. */
+} image_t;
+
+typedef struct {
+  uint16 crc;
+  uint16 crc_shadow;
+} otaCrc_t;
+
+typedef struct {
+  uint32 programLength;
+  uint16 manufacturerId;
+  uint16 imageType;
+  uint32 imageVersion;
+} preamble_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+uint8 HalOTAChkDL(uint8 dlImagePreambleOffset);
+void HalOTAInvRC(void);
+uint32 HalOTAAvail(void);
+void HalOTARead(uint32 oset, uint8 *pBuf, uint16 len, image_t type);
+void HalOTAWrite(uint32 oset, uint8 *pBuf, uint16 len, image_t type);
+#endif
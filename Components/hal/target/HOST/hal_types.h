@@ -0,0 +1,79 @@
+/**************************************************************************************************
+  Filename:       hal_types.h
+
+  Description:    Basic types for the host (Linux/x86) simulation target.
+
+**************************************************************************************************/
+
+#ifndef _HAL_TYPES_H
+#define _HAL_TYPES_H
+
+/* Host simulation - native x86 / x86-64 */
+
+/* ------------------------------------------------------------------------------------------------
+ *                                               Types
+ * ------------------------------------------------------------------------------------------------
+ */
+typedef signed   char   int8;
+typedef unsigned char   uint8;
+
+typedef signed   short  int16;
+typedef unsigned short  uint16;
+
+typedef signed   int    int32;
+typedef unsigned int    uint32;
+
+typedef unsigned char   bool;
+
+/* The heap must hand out blocks that are safe for native pointers. */
+typedef void *          halDataAlign_t;
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                               Memory Attributes and Compiler Macros
+ * ------------------------------------------------------------------------------------------------
+ */
+
+/* ----------- GNU Compiler ----------- */
+#if defined __GNUC__
+#define  CODE
+#define  XDATA
+#define ASM_NOP __asm__ __volatile__ ("nop")
+
+/* 8051 memory and calling attributes used throughout the stack (and by f8wConfig.cfg) have no
+ * meaning on the host.
+ */
+#define __code
+#define __xdata
+#define __data
+#define __idata
+#define __generic
+#define __near_func
+#define __no_init
+
+/* ----------- Unrecognized Compiler ----------- */
+#else
+#error "ERROR: Unknown compiler."
+#endif
+
+
+/* ------------------------------------------------------------------------------------------------
+ *                                        Standard Defines
+ * ------------------------------------------------------------------------------------------------
+ */
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#ifndef NULL
+#define NULL 0
+#endif
+
+
+/**************************************************************************************************
+ */
+#endif
@@ -0,0 +1,392 @@
+/**************************************************************************************************
+  Filename:       hal_uart.c
+
+  Description:    Host (Linux/x86) simulation target: UART ports backed by in-memory ring
+                  buffers. The driver side injects Rx bytes and drains Tx bytes through hal_host.h;
+                  the stack side sees the normal HalUARTxxx() API and callback events.
+
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+#include "hal_board_cfg.h"
+#include "hal_defs.h"
+#include "hal_host.h"
+#include "hal_mcu.h"
+#include "hal_types.h"
+#include "hal_uart.h"
+
+/*********************************************************************
+ * MACROS
+ */
+
+#define HOST_UART_BUF_LEN(b) \
+  ((uint16)(((b)->head >= (b)->tail) ? ((b)->head - (b)->tail) : \
+                                       (HAL_HOST_UART_BUF_SIZE - (b)->tail + (b)->head)))
+
+#define HOST_UART_BUF_FREE(b)  ((uint16)(HAL_HOST_UART_BUF_SIZE - 1 - HOST_UART_BUF_LEN(b)))
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef struct
+{
+  uint16 head;
+  uint16 tail;
+  uint8  buf[HAL_HOST_UART_BUF_SIZE];
+} hostUartBuf_t;
+
+typedef struct
+{
+  bool           configured;
+  uint16         rxThreshold;
+  halUARTCBack_t callBackFunc;
+  hostUartBuf_t  rx;
+  hostUartBuf_t  tx;
+} hostUartPort_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static hostUartPort_t hostUart[HAL_UART_PORT_MAX];
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+static uint16 hostUartPut( hostUartBuf_t *pBuf, const uint8 *pData, uint16 length );
+static uint16 hostUartGet( hostUartBuf_t *pBuf, uint8 *pData, uint16 length );
+
+/******************************************************************************
+ * @fn      hostUartPut
+ *
+ * @brief   Append as many bytes as fit into a ring buffer.
+ *
+ * @param   pBuf   - ring buffer
+ *          pData  - data to append
+ *          length - number of bytes
+ *
+ * @return  Number of bytes appended
+ *****************************************************************************/
+static uint16 hostUartPut( hostUartBuf_t *pBuf, const uint8 *pData, uint16 length )
+{
+  uint16 cnt = HOST_UART_BUF_FREE( pBuf );
+
+  if ( length < cnt )
+  {
+    cnt = length;
+  }
+
+  for ( length = 0; length < cnt; length++ )
+  {
+    pBuf->buf[pBuf->head] = *pData++;
+    if ( ++pBuf->head >= HAL_HOST_UART_BUF_SIZE )
+    {
+      pBuf->head = 0;
+    }
+  }
+
+  return cnt;
+}
+
+/******************************************************************************
+ * @fn      hostUartGet
+ *
+ * @brief   Remove up to 'length' bytes from a ring buffer.
+ *
+ * @param   pBuf   - ring buffer
+ *          pData  - destination
+ *          length - maximum number of bytes
+ *
+ * @return  Number of bytes removed
+ *****************************************************************************/
+static uint16 hostUartGet( hostUartBuf_t *pBuf, uint8 *pData, uint16 length )
+{
+  uint16 cnt = 0;
+
+  while ( (cnt < length) && (pBuf->tail != pBuf->head) )
+  {
+    *pData++ = pBuf->buf[pBuf->tail];
+    if ( ++pBuf->tail >= HAL_HOST_UART_BUF_SIZE )
+    {
+      pBuf->tail = 0;
+    }
+    cnt++;
+  }
+
+  return cnt;
+}
+
+/******************************************************************************
+ * @fn      halHostUartInject
+ *
+ * @brief   Simulate bytes arriving on the Rx line of a port.
+ *
+ * @param   port   - UART port
+ *          buf    - received bytes
+ *          len    - number of bytes
+ *
+ * @return  Number of bytes accepted (the rest is lost, as on an overrun)
+ *****************************************************************************/
+uint16 halHostUartInject( uint8 port, const uint8 *buf, uint16 len )
+{
+  if ( port >= HAL_UART_PORT_MAX )
+  {
+    return 0;
+  }
+
+  return hostUartPut( &hostUart[port].rx, buf, len );
+}
+
+/******************************************************************************
+ * @fn      halHostUartDrain
+ *
+ * @brief   Collect bytes the stack has written to a port.
+ *
+ * @param   port   - UART port
+ *          buf    - destination, or NULL to discard
+ *          len    - maximum number of bytes
+ *
+ * @return  Number of bytes collected
+ *****************************************************************************/
+uint16 halHostUartDrain( uint8 port, uint8 *buf, uint16 len )
+{
+  hostUartBuf_t *pBuf;
+  uint16 cnt;
+
+  if ( port >= HAL_UART_PORT_MAX )
+  {
+    return 0;
+  }
+
+  pBuf = &hostUart[port].tx;
+
+  if ( buf != NULL )
+  {
+    return hostUartGet( pBuf, buf, len );
+  }
+
+  cnt = HOST_UART_BUF_LEN( pBuf );
+  if ( len < cnt )
+  {
+    cnt = len;
+  }
+  pBuf->tail = (uint16)((pBuf->tail + cnt) % HAL_HOST_UART_BUF_SIZE);
+
+  return cnt;
+}
+
+/******************************************************************************
+ * @fn      HalUARTInit
+ *
+ * @brief   Initialize the UART
+ *
+ * @param   none
+ *
+ * @return  none
+ *****************************************************************************/
+void HalUARTInit(void)
+{
+  uint8 port;
+
+  for ( port = 0; port < HAL_UART_PORT_MAX; port++ )
+  {
+    hostUart[port].configured = FALSE;
+    hostUart[port].callBackFunc = NULL;
+    hostUart[port].rx.head = hostUart[port].rx.tail = 0;
+    hostUart[port].tx.head = hostUart[port].tx.tail = 0;
+  }
+}
+
+/******************************************************************************
+ * @fn      HalUARTOpen
+ *
+ * @brief   Open a port according tp the configuration specified by parameter.
+ *
+ * @param   port   - UART port
+ *          config - contains configuration information
+ *
+ * @return  Status of the function call
+ *****************************************************************************/
+uint8 HalUARTOpen(uint8 port, halUARTCfg_t *config)
+{
+  if ( port >= HAL_UART_PORT_MAX )
+  {
+    return HAL_UART_NOT_SUPPORTED;
+  }
+
+  hostUart[port].configured = TRUE;
+  hostUart[port].callBackFunc = config->callBackFunc;
+  hostUart[port].rxThreshold = config->flowControlThreshold;
+  config->configured = TRUE;
+
+  return HAL_UART_SUCCESS;
+}
+
+/*****************************************************************************
+ * @fn      HalUARTRead
+ *
+ * @brief   Read a buffer from the UART
+ *
+ * @param   port - USART module designation
+ *          buf  - valid data buffer at least 'len' bytes in size
+ *          len  - max length number of bytes to copy to 'buf'
+ *
+ * @return  length of buffer that was read
+ *****************************************************************************/
+uint16 HalUARTRead(uint8 port, uint8 *buf, uint16 len)
+{
+  if ( (port >= HAL_UART_PORT_MAX) || !hostUart[port].configured )
+  {
+    return 0;
+  }
+
+  return hostUartGet( &hostUart[port].rx, buf, len );
+}
+
+/******************************************************************************
+ * @fn      HalUARTWrite
+ *
+ * @brief   Write a buffer to the UART.
+ *
+ * @param   port - UART port
+ *          buf  - pointer to the buffer that will be written, not freed
+ *          len  - length of
+ *
+ * @return  length of the buffer that was sent
+ *****************************************************************************/
+uint16 HalUARTWrite(uint8 port, uint8 *buf, uint16 len)
+{
+  if ( (port >= HAL_UART_PORT_MAX) || !hostUart[port].configured )
+  {
+    return 0;
+  }
+
+  // Like the ISR/DMA drivers: all or nothing.
+  if ( HOST_UART_BUF_FREE( &hostUart[port].tx ) < len )
+  {
+    return 0;
+  }
+
+  return hostUartPut( &hostUart[port].tx, buf, len );
+}
+
+/******************************************************************************
+ * @fn      HalUARTSuspend
+ *
+ * @brief   Suspend UART hardware before entering PM mode 1, 2 or 3.
+ *
+ * @param   None
+ *
+ * @return  None
+ *****************************************************************************/
+void HalUARTSuspend( void )
+{
+}
+
+/******************************************************************************
+ * @fn      HalUARTResume
+ *
+ * @brief   Resume UART hardware after exiting PM mode 1, 2 or 3.
+ *
+ * @param   None
+ *
+ * @return  None
+ *****************************************************************************/
+void HalUARTResume( void )
+{
+}
+
+/***************************************************************************************************
+ * @fn      HalUARTPoll
+ *
+ * @brief   Poll the UART: report pending Rx data to the registered callback. Every poll is
+ *          treated as the end of a burst, so HAL_UART_RX_TIMEOUT is raised whenever data is
+ *          waiting (HAL_UART_RX_ABOUT_FULL/FULL take precedence, as on the target).
+ *
+ * @param   none
+ *
+ * @return  none
+ *****************************************************************************/
+void HalUARTPoll(void)
+{
+  uint8 port;
+
+  for ( port = 0; port < HAL_UART_PORT_MAX; port++ )
+  {
+    hostUartPort_t *pPort = &hostUart[port];
+    uint16 cnt;
+    uint8 evt;
+
+    if ( !pPort->configured || (pPort->callBackFunc == NULL) )
+    {
+      continue;
+    }
+
+    cnt = HOST_UART_BUF_LEN( &pPort->rx );
+    if ( cnt == 0 )
+    {
+      continue;
+    }
+
+    if ( cnt >= HAL_HOST_UART_BUF_SIZE - 1 )
+    {
+      evt = HAL_UART_RX_FULL;
+    }
+    else if ( (pPort->rxThreshold != 0) && (cnt >= HAL_HOST_UART_BUF_SIZE - pPort->rxThreshold) )
+    {
+      evt = HAL_UART_RX_ABOUT_FULL;
+    }
+    else
+    {
+      evt = HAL_UART_RX_TIMEOUT;
+    }
+
+    pPort->callBackFunc( port, evt );
+  }
+}
+
+/**************************************************************************************************
+ * @fn      Hal_UART_RxBufLen()
+ *
+ * @brief   Calculate Rx Buffer length - the number of bytes in the buffer.
+ *
+ * @param   port - UART port
+ *
+ * @return  length of current Rx Buffer
+ **************************************************************************************************/
+uint16 Hal_UART_RxBufLen( uint8 port )
+{
+  if ( port >= HAL_UART_PORT_MAX )
+  {
+    return 0;
+  }
+
+  return HOST_UART_BUF_LEN( &hostUart[port].rx );
+}
+
+/**************************************************************************************************
+ * @fn      Hal_UART_TxBufLen()
+ *
+ * @brief   Calculate Tx Buffer length - the number of bytes in the buffer.
+ *
+ * @param   port - UART port
+ *
+ * @return  length of current Tx buffer
+ **************************************************************************************************/
+uint16 Hal_UART_TxBufLen( uint8 port )
+{
+  if ( port >= HAL_UART_PORT_MAX )
+  {
+    return 0;
+  }
+
+  return HOST_UART_BUF_LEN( &hostUart[port].tx );
+}
+
+/******************************************************************************
+******************************************************************************/
@@ -531,6 +531,7 @@ extern "C"
 #define MT_PERIODIC_MSG_EVENT           0x0020
 #define MT_MSG_SEQUENCE_EVT             0x0040
 #define MT_KEYPRESS_POLL_EVT            0x0080
+#define MT_UART_TX_FLUSH_EVT            0x2000
 
 /* SYS_OSAL_EVENT ID's */
 #define MT_SYS_OSAL_EVENT_0             0x0800
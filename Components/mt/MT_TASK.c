@@ -139,6 +139,14 @@ UINT16 MT_ProcessEvent(uint8 task_id, uint16 events)
     return (events ^ MT_ZTOOL_SERIAL_RCV_BUFFER_FULL);
   }
 
+#if defined (MT_UART_DEFAULT_PORT) && MT_UART_TX_COALESCE
+  if ( events & MT_UART_TX_FLUSH_EVT )
+  {
+    MT_UartTxFlush();
+    return (events ^ MT_UART_TX_FLUSH_EVT);
+  }
+#endif
+
 #if !defined( NONWK )
   if ( events & MT_AF_EXEC_EVT )
   {
@@ -274,7 +282,7 @@ static void MT_ProcessIncomingCommand( mtOSALSerialData_t *msg )
 #endif
 
 #ifdef MT_UART_DEFAULT_PORT
-      HalUARTWrite ( MT_UART_DEFAULT_PORT, msg_ptr, len );
+      MT_UartWrite ( msg_ptr, len );
 #endif
       break;
 
@@ -363,7 +371,7 @@ void MT_TransportSend(uint8 *pBuf)
 
   /* Send to UART */
 #ifdef MT_UART_DEFAULT_PORT
-  HalUARTWrite(MT_UART_DEFAULT_PORT, msgPtr, dataLen + SPI_0DATA_MSG_LEN);
+  MT_UartWrite(msgPtr, dataLen + SPI_0DATA_MSG_LEN);
 #endif
 
   /* Deallocate */
@@ -63,6 +63,11 @@
 #define DATA_STATE     0x04
 #define FCS_STATE      0x05
 
+/* Bytes taken from the UART driver per read while looking for frame headers (stack buffer) */
+#if !defined MT_UART_RX_CHUNK
+  #define MT_UART_RX_CHUNK  32
+#endif
+
 /***************************************************************************************************
  *                                         GLOBAL VARIABLES
  ***************************************************************************************************/
@@ -77,6 +82,17 @@ uint8  FSC_Token;
 mtOSALSerialData_t  *pMsg;
 uint8  tempDataLen;
 
+/* FCS of the frame being received, folded in as the bytes arrive */
+static uint8 mtUartRxFcs;
+
+#if defined (MT_UART_DEFAULT_PORT) && MT_UART_TX_COALESCE
+/* Frames waiting for the coalesced write */
+static uint8  mtUartTxBuf[MT_UART_TX_COALESCE_BUF];
+static uint16 mtUartTxLen;
+
+mtUartTxStats_t MT_UartTxStats;
+#endif
+
 #if defined (ZAPP_P1) || defined (ZAPP_P2)
 uint16  MT_UartMaxZAppBufLen;
 bool    MT_UartZAppRxStatus;
@@ -186,6 +202,12 @@ byte MT_UartCalcFCS( uint8 *msg_ptr, uint8 len )
  *          Parses the data and determine either is SPI or just simply serial data
  *          then send the data to correct place (MT or APP)
  *
+ *          Whatever is waiting in the Rx buffer is read in MT_UART_RX_CHUNK pieces and
+ *          scanned in place, so a burst of frames costs a few driver calls instead of one
+ *          per header byte. A payload is copied from the piece, or read straight into the
+ *          message once the piece runs out, and the FCS is folded in on the way. The state
+ *          is kept across calls, frames may start and end anywhere in a callback.
+ *
  * @param   port     - UART port
  *          event    - Event that causes the callback
  *
@@ -194,115 +216,252 @@ byte MT_UartCalcFCS( uint8 *msg_ptr, uint8 len )
  ***************************************************************************************************/
 void MT_UartProcessZToolData ( uint8 port, uint8 event )
 {
-  uint8  ch;
-  uint8  bytesInRxBuffer;
-  
+  uint8  rxBuf[MT_UART_RX_CHUNK];
+  uint8  *pRx;
+  uint8  *pEnd;
+  uint8  *pData;
+  uint16 rxLen;
+  uint8  fcs;
+  uint8  len;
+
   (void)event;  // Intentionally unreferenced parameter
 
-  while (Hal_UART_RxBufLen(port))
+  while (1)
   {
-    HalUARTRead (port, &ch, 1);
-
-    switch (state)
+    if ((state == DATA_STATE) && (tempDataLen < LEN_Token))
     {
-      case SOP_STATE:
-        if (ch == MT_UART_SOF)
-          state = LEN_STATE;
+      /* Rest of the payload goes straight from the driver into the message */
+      pData = &pMsg->msg[MT_RPC_FRAME_HDR_SZ + tempDataLen];
+      rxLen = HalUARTRead (port, pData, LEN_Token - tempDataLen);
+      if (rxLen == 0)
+      {
         break;
+      }
 
-      case LEN_STATE:
-        LEN_Token = ch;
+      tempDataLen += (uint8)rxLen;
+      mtUartRxFcs ^= MT_UartCalcFCS (pData, (uint8)rxLen);
 
-        tempDataLen = 0;
+      /* If number of bytes read is equal to data length, time to move on to FCS */
+      if (tempDataLen == LEN_Token)
+      {
+        state = FCS_STATE;
+      }
+      continue;
+    }
 
-        /* Allocate memory for the data */
-        pMsg = (mtOSALSerialData_t *)osal_msg_allocate( sizeof ( mtOSALSerialData_t ) +
-                                                        MT_RPC_FRAME_HDR_SZ + LEN_Token );
+    rxLen = HalUARTRead (port, rxBuf, MT_UART_RX_CHUNK);
+    if (rxLen == 0)
+    {
+      break;
+    }
 
-        if (pMsg)
-        {
-          /* Fill up what we can */
-          pMsg->hdr.event = CMD_SERIAL_MSG;
-          pMsg->msg = (uint8*)(pMsg+1);
-          pMsg->msg[MT_RPC_POS_LEN] = LEN_Token;
-          state = CMD_STATE1;
-        }
-        else
-        {
-          state = SOP_STATE;
-          return;
-        }
-        break;
+    pRx = rxBuf;
+    pEnd = rxBuf + rxLen;
 
-      case CMD_STATE1:
-        pMsg->msg[MT_RPC_POS_CMD0] = ch;
-        state = CMD_STATE2;
-        break;
+    while (pRx < pEnd)
+    {
+      switch (state)
+      {
+        case SOP_STATE:
+          /* Skip anything up to the next start of frame */
+          while ((pRx < pEnd) && (*pRx != MT_UART_SOF))
+          {
+            pRx++;
+          }
+          if (pRx < pEnd)
+          {
+            pRx++;
+            state = LEN_STATE;
+          }
+          break;
+
+        case LEN_STATE:
+          LEN_Token = *pRx++;
+
+          tempDataLen = 0;
+
+          /* Allocate memory for the data */
+          pMsg = (mtOSALSerialData_t *)osal_msg_allocate( sizeof ( mtOSALSerialData_t ) +
+                                                          MT_RPC_FRAME_HDR_SZ + LEN_Token );
+
+          if (pMsg)
+          {
+            /* Fill up what we can */
+            pMsg->hdr.event = CMD_SERIAL_MSG;
+            pMsg->msg = (uint8*)(pMsg+1);
+            pMsg->msg[MT_RPC_POS_LEN] = LEN_Token;
+            mtUartRxFcs = LEN_Token;
+            state = CMD_STATE1;
+          }
+          else
+          {
+            /* No room for this one, look for the next frame */
+            state = SOP_STATE;
+          }
+          break;
+
+        case CMD_STATE1:
+          pMsg->msg[MT_RPC_POS_CMD0] = *pRx;
+          mtUartRxFcs ^= *pRx++;
+          state = CMD_STATE2;
+          break;
+
+        case CMD_STATE2:
+          pMsg->msg[MT_RPC_POS_CMD1] = *pRx;
+          mtUartRxFcs ^= *pRx++;
+          /* If there is no data, skip to FCS state */
+          if (LEN_Token)
+          {
+            state = DATA_STATE;
+          }
+          else
+          {
+            state = FCS_STATE;
+          }
+          break;
+
+        case DATA_STATE:
+          /* Copy what this piece holds of the payload */
+          len = LEN_Token - tempDataLen;
+          if (len > pEnd - pRx)
+          {
+            len = (uint8)(pEnd - pRx);
+          }
+
+          pData = &pMsg->msg[MT_RPC_FRAME_HDR_SZ + tempDataLen];
+          tempDataLen += len;
+          fcs = mtUartRxFcs;
+          while (len--)
+          {
+            fcs ^= *pRx;
+            *pData++ = *pRx++;
+          }
+          mtUartRxFcs = fcs;
+
+          /* If number of bytes read is equal to data length, time to move on to FCS */
+          if (tempDataLen == LEN_Token)
+          {
+            state = FCS_STATE;
+          }
+          break;
 
-      case CMD_STATE2:
-        pMsg->msg[MT_RPC_POS_CMD1] = ch;
-        /* If there is no data, skip to FCS state */
-        if (LEN_Token)
-        {
-          state = DATA_STATE;
-        }
-        else
-        {
-          state = FCS_STATE;
-        }
-        break;
+        case FCS_STATE:
 
-      case DATA_STATE:
+          FSC_Token = *pRx++;
 
-        /* Fill in the buffer the first byte of the data */
-        pMsg->msg[MT_RPC_FRAME_HDR_SZ + tempDataLen++] = ch;
+          /* Make sure it's correct */
+          if (mtUartRxFcs == FSC_Token)
+          {
+            osal_msg_send( App_TaskID, (byte *)pMsg );
+          }
+          else
+          {
+            /* deallocate the msg */
+            osal_msg_deallocate ( (uint8 *)pMsg );
+          }
 
-        /* Check number of bytes left in the Rx buffer */
-        bytesInRxBuffer = Hal_UART_RxBufLen(port);
+          /* Reset the state, send or discard the buffers at this point */
+          state = SOP_STATE;
 
-        /* If the remain of the data is there, read them all, otherwise, just read enough */
-        if (bytesInRxBuffer <= LEN_Token - tempDataLen)
-        {
-          HalUARTRead (port, &pMsg->msg[MT_RPC_FRAME_HDR_SZ + tempDataLen], bytesInRxBuffer);
-          tempDataLen += bytesInRxBuffer;
-        }
-        else
-        {
-          HalUARTRead (port, &pMsg->msg[MT_RPC_FRAME_HDR_SZ + tempDataLen], LEN_Token - tempDataLen);
-          tempDataLen += (LEN_Token - tempDataLen);
-        }
+          break;
 
-        /* If number of bytes read is equal to data length, time to move on to FCS */
-        if ( tempDataLen == LEN_Token )
-            state = FCS_STATE;
+        default:
+          /* Unknown state, resynchronize on the next frame */
+          state = SOP_STATE;
+          break;
+      }
+    }
+  }
+}
 
-        break;
+#if defined (MT_UART_DEFAULT_PORT)
+/***************************************************************************************************
+ * @fn      MT_UartWrite
+ *
+ * @brief   Send a complete frame, SOF to FCS. With MT_UART_TX_COALESCE the frame is queued
+ *          behind the ones still pending and they all go out in one UART write when the
+ *          queue is full, when MT_UART_TX_COALESCE_DELAY has passed since the first one was
+ *          queued, or right away for a synchronous response the host is waiting for.
+ *
+ * @param   pFrame - frame, not freed
+ *          len    - frame length
+ *
+ * @return  None
+ ***************************************************************************************************/
+void MT_UartWrite( uint8 *pFrame, uint16 len )
+{
+#if MT_UART_TX_COALESCE
+  uint8 cmd0 = pFrame[MT_RPC_POS_CMD0 + 1];
 
-      case FCS_STATE:
+  MT_UartTxStats.frameCnt[cmd0 >> 5]++;
 
-        FSC_Token = ch;
+  /* Make room, a frame is never split across writes */
+  if (len > MT_UART_TX_COALESCE_BUF - mtUartTxLen)
+  {
+    MT_UartTxFlush();
+  }
 
-        /* Make sure it's correct */
-        if ((MT_UartCalcFCS ((uint8*)&pMsg->msg[0], MT_RPC_FRAME_HDR_SZ + LEN_Token) == FSC_Token))
-        {
-          osal_msg_send( App_TaskID, (byte *)pMsg );
-        }
-        else
-        {
-          /* deallocate the msg */
-          osal_msg_deallocate ( (uint8 *)pMsg );
-        }
+  if (len > MT_UART_TX_COALESCE_BUF - mtUartTxLen)
+  {
+    /* Too big to queue, or the driver is still full: write it on its own */
+    MT_UartTxStats.writeCnt++;
+    if (HalUARTWrite (MT_UART_DEFAULT_PORT, pFrame, len) == 0)
+    {
+      MT_UartTxStats.dropCnt++;
+    }
+    return;
+  }
 
-        /* Reset the state, send or discard the buffers at this point */
-        state = SOP_STATE;
+  if (mtUartTxLen == 0)
+  {
+    /* First one of a batch bounds the latency of the whole batch */
+    osal_start_timerEx (MT_TaskID, MT_UART_TX_FLUSH_EVT, MT_UART_TX_COALESCE_DELAY);
+  }
 
-        break;
+  osal_memcpy (&mtUartTxBuf[mtUartTxLen], pFrame, len);
+  mtUartTxLen += len;
 
-      default:
-       break;
-    }
+  if ((cmd0 & MT_RPC_CMD_TYPE_MASK) == MT_RPC_CMD_SRSP)
+  {
+    MT_UartTxFlush();
+  }
+#else
+  HalUARTWrite (MT_UART_DEFAULT_PORT, pFrame, len);
+#endif
+}
+
+#if MT_UART_TX_COALESCE
+/***************************************************************************************************
+ * @fn      MT_UartTxFlush
+ *
+ * @brief   Write the pending frames out in one UART write. If the driver has no room for
+ *          them yet, they stay queued and are retried after MT_UART_TX_COALESCE_DELAY.
+ *
+ * @param   None
+ *
+ * @return  None
+ ***************************************************************************************************/
+void MT_UartTxFlush( void )
+{
+  if (mtUartTxLen == 0)
+  {
+    return;
+  }
+
+  MT_UartTxStats.writeCnt++;
+  if (HalUARTWrite (MT_UART_DEFAULT_PORT, mtUartTxBuf, mtUartTxLen) != 0)
+  {
+    mtUartTxLen = 0;
+    osal_stop_timerEx (MT_TaskID, MT_UART_TX_FLUSH_EVT);
+    osal_clear_event (MT_TaskID, MT_UART_TX_FLUSH_EVT);
+  }
+  else
+  {
+    osal_start_timerEx (MT_TaskID, MT_UART_TX_FLUSH_EVT, MT_UART_TX_COALESCE_DELAY);
   }
 }
+#endif
+#endif /* MT_UART_DEFAULT_PORT */
 
 #if defined (ZAPP_P1) || defined (ZAPP_P2)
 /***************************************************************************************************
@@ -47,7 +47,7 @@ extern "C"
 /***************************************************************************************************
  *                                               INCLUDES
  ***************************************************************************************************/
-#include "Onboard.h"
+#include "OnBoard.h"
 #include "OSAL.h"
 
 /***************************************************************************************************
@@ -81,6 +81,21 @@ extern "C"
 #endif
 #define MT_UART_DEFAULT_IDLE_TIMEOUT     MT_UART_IDLE_TIMEOUT
 
+/* Tx coalescing: frames written within MT_UART_TX_COALESCE_DELAY ms of the first one that is
+ * still pending go out in one UART write. A synchronous response flushes right away. */
+#if !defined MT_UART_TX_COALESCE
+  #define MT_UART_TX_COALESCE            FALSE
+#endif
+#if !defined MT_UART_TX_COALESCE_BUF
+  #define MT_UART_TX_COALESCE_BUF        MT_UART_DEFAULT_MAX_TX_BUFF
+#endif
+#if !defined MT_UART_TX_COALESCE_DELAY
+  #define MT_UART_TX_COALESCE_DELAY      2
+#endif
+
+/* Number of MT command types (MT_RPC_CMD_TYPE_MASK >> 5) */
+#define MT_UART_TX_TYPE_CNT               8
+
 /* Application Flow Control */
 #define MT_UART_ZAPP_RX_NOT_READY         0x00
 #define MT_UART_ZAPP_RX_READY             0x01
@@ -91,6 +106,17 @@ typedef struct
   uint8             *msg;
 } mtOSALSerialData_t;
 
+#if MT_UART_TX_COALESCE
+typedef struct
+{
+  uint32 frameCnt[MT_UART_TX_TYPE_CNT];  /* Frames sent, by command type (CMD0 >> 5) */
+  uint32 writeCnt;                       /* HalUARTWrite() calls */
+  uint32 dropCnt;                        /* Frames the UART driver had no room for */
+} mtUartTxStats_t;
+
+extern mtUartTxStats_t MT_UartTxStats;
+#endif
+
 /*
  * Initialization
  */
@@ -116,6 +142,20 @@ extern uint8 MT_UartCalcFCS( uint8 *msg_ptr, uint8 length );
  */
 extern void MT_UartRegisterTaskID( uint8 taskID );
 
+#if defined (MT_UART_DEFAULT_PORT)
+/*
+ * Send a complete frame (SOF to FCS), coalesced with its neighbours if enabled
+ */
+extern void MT_UartWrite( uint8 *pFrame, uint16 len );
+
+#if MT_UART_TX_COALESCE
+/*
+ * Write the coalesced frames out, on MT_UART_TX_FLUSH_EVT
+ */
+extern void MT_UartTxFlush( void );
+#endif
+#endif
+
 /*
  * Register max length that application can take
  */
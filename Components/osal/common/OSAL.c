@@ -52,11 +52,13 @@
 #include "OSAL_Memory.h"
 #include "OSAL_PwrMgr.h"
 #include "OSAL_Clock.h"
+#include "OSAL_Nv.h"
 
 #include "OnBoard.h"
 
 /* HAL */
 #include "hal_drivers.h"
+#include "hal_assert.h"
 
 #ifdef IAR_ARMCM3_LM
   #include "FreeRTOSConfig.h"
@@ -71,9 +73,38 @@
  * MACROS
  */
 
+#define OSAL_READY_BIT( idx )   ((uint32)0x80000000 >> (idx))
+
+#if defined ( __GNUC__ )
+  #define OSAL_CLZ32( x )       ((uint8)__builtin_clz( (unsigned int)(x) ))
+#endif
+
 /*********************************************************************
  * CONSTANTS
  */
+
+/*
+ * OSAL_MSG_TASK_QUEUES=TRUE gives every task its own head/tail message
+ * queue: send, push and receive are O(1) and find/count only walk the
+ * messages of the task asked for. FALSE keeps the single global queue
+ * that every receive searches from the top.
+ */
+#if !defined OSAL_MSG_TASK_QUEUES
+#define OSAL_MSG_TASK_QUEUES    TRUE
+#endif
+
+/*
+ * OSAL_RUN_READY_MAP=TRUE keeps one bit per task with events pending,
+ * task 0 in the MSB, so osal_run_system() finds the highest priority
+ * ready task with a count leading zeros instead of scanning
+ * tasksEvents[]. Builds with more than OSAL_READY_MAP_TASKS tasks scan.
+ */
+#if !defined OSAL_RUN_READY_MAP
+#define OSAL_RUN_READY_MAP      TRUE
+#endif
+
+#define OSAL_READY_MAP_TASKS    32
+
 #ifdef USE_ICALL
 // A bit mask to use to indicate a proxy OSAL task ID.
 #define OSAL_PROXY_ID_FLAG       0x80
@@ -83,12 +114,39 @@
  * TYPEDEFS
  */
 
+#if OSAL_MSG_TASK_QUEUES
+typedef struct
+{
+  osal_msg_q_t head;
+  osal_msg_q_t tail;     // Last message, valid while head != NULL
+} osal_msg_tq_t;
+#endif
+
+typedef struct
+{
+  const osalEventHandlerRec_t *pTable;
+  uint8 cnt;
+} osalEventTable_t;
+
+#if OSAL_RUN_METRICS
+typedef struct
+{
+  osalTaskStats_t stats;
+  uint32 readyTime;      // osal_GetSystemClock() when the task became ready
+  uint32 readyPass;      // osalRunPass when the task became ready
+} osalTaskMetrics_t;
+#endif
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
 
 // Message Pool Definitions
+#if OSAL_MSG_TASK_QUEUES
+static osal_msg_tq_t *osal_qTask;  // tasksCnt queues, indexed by task ID
+#else
 osal_msg_q_t osal_qHead;
+#endif
 
 #ifdef USE_ICALL
 // OSAL event loop hook function pointer 
@@ -110,6 +168,20 @@ void (*osal_eventloop_hook)(void) = NULL;
 // Index of active task
 static uint8 activeTaskID = TASK_NO_TASK;
 
+#if OSAL_RUN_READY_MAP
+// Tasks with events pending, see OSAL_READY_BIT(). A set bit may be stale
+// (tasksEvents[] cleared directly), a task with events always has its bit.
+static uint32 osalReadyMap;
+#endif
+
+// Event handler tables, allocated by the first osal_register_event_handlers()
+static osalEventTable_t *osalEventTables;
+
+#if OSAL_RUN_METRICS
+static osalTaskMetrics_t *osalTaskMetrics;
+static uint32 osalRunPass;     // Tasks dispatched since osal_init_system()
+#endif
+
 #ifdef USE_ICALL
 // Maximum number of proxy tasks
 #ifndef OSAL_MAX_NUM_PROXY_TASKS
@@ -155,6 +227,12 @@ static uint8 osal_notask_entity;
  */
 
 static uint8 osal_msg_enqueue_push( uint8 destination_task, uint8 *msg_ptr, uint8 urgent );
+static uint8 osal_next_ready( void );
+static void osal_task_ready( uint8 task_id );
+static uint16 osal_run_event_handlers( uint8 task_id, uint16 events );
+#if OSAL_RUN_READY_MAP && !defined ( OSAL_CLZ32 )
+static uint8 OSAL_CLZ32( uint32 x );
+#endif
 
 #ifdef USE_ICALL
 static uint8 osal_alien2proxy(ICall_EntityID entity);
@@ -381,11 +459,11 @@ uint32 osal_build_uint32( uint8 *swapped, uint8 len )
  *
  * @return  pointer to buffer
  */
-unsigned char * _ltoa(unsigned long l, unsigned char *buf, unsigned char radix)
+unsigned char * _ltoa(uint32 l, unsigned char *buf, unsigned char radix)
 {
 #if defined (__TI_COMPILER_VERSION)
   return ( (unsigned char*)ltoa( l, (char *)buf ) );
-#elif defined( __GNUC__ )
+#elif defined( __GNUC__ ) && !defined( HAL_MCU_HOST )
   return ( (char*)ltoa( l, buf, radix ) );
 #else
   unsigned char tmp1[10] = "", tmp2[10] = "", tmp3[10] = "";
@@ -735,6 +813,34 @@ static uint8 osal_msg_enqueue_push( uint8 destination_task, uint8 *msg_ptr, uint
 
   OSAL_MSG_ID( msg_ptr ) = destination_task;
 
+#if OSAL_MSG_TASK_QUEUES
+  {
+    osal_msg_tq_t *pQ = &osal_qTask[destination_task];
+    halIntState_t intState;
+
+    HAL_ENTER_CRITICAL_SECTION(intState);
+
+    if ( pQ->head == NULL )
+    {
+      pQ->head = msg_ptr;
+      pQ->tail = msg_ptr;
+    }
+    else if ( push == TRUE )
+    {
+      // prepend the message
+      OSAL_MSG_NEXT( msg_ptr ) = pQ->head;
+      pQ->head = msg_ptr;
+    }
+    else
+    {
+      // append the message
+      OSAL_MSG_NEXT( pQ->tail ) = msg_ptr;
+      pQ->tail = msg_ptr;
+    }
+
+    HAL_EXIT_CRITICAL_SECTION(intState);
+  }
+#else
   if ( push == TRUE )
   {
     // prepend the message
@@ -745,6 +851,7 @@ static uint8 osal_msg_enqueue_push( uint8 destination_task, uint8 *msg_ptr, uint
     // append the message
     osal_msg_enqueue( &osal_qHead, msg_ptr );
   }
+#endif
 
   // Signal the task that a message is waiting
   osal_set_event( destination_task, SYS_EVENT_MSG );
@@ -767,6 +874,45 @@ static uint8 osal_msg_enqueue_push( uint8 destination_task, uint8 *msg_ptr, uint
  */
 uint8 *osal_msg_receive( uint8 task_id )
 {
+#if OSAL_MSG_TASK_QUEUES
+  osal_msg_tq_t  *pQ;
+  osal_msg_hdr_t *foundHdr;
+  halIntState_t   intState;
+
+  if ( task_id >= tasksCnt )
+  {
+    return ( NULL );
+  }
+  pQ = &osal_qTask[task_id];
+
+  // Hold off interrupts
+  HAL_ENTER_CRITICAL_SECTION(intState);
+
+  foundHdr = pQ->head;
+  if ( foundHdr != NULL )
+  {
+    // Take off the head of the task's queue
+    pQ->head = OSAL_MSG_NEXT( foundHdr );
+    OSAL_MSG_NEXT( foundHdr ) = NULL;
+    OSAL_MSG_ID( foundHdr ) = TASK_NO_TASK;
+  }
+
+  if ( pQ->head != NULL )
+  {
+    // Signal the task that a message is waiting
+    osal_set_event( task_id, SYS_EVENT_MSG );
+  }
+  else
+  {
+    // No more
+    osal_clear_event( task_id, SYS_EVENT_MSG );
+  }
+
+  // Release interrupts
+  HAL_EXIT_CRITICAL_SECTION(intState);
+
+  return ( (uint8*) foundHdr );
+#else
   osal_msg_hdr_t *listHdr;
   osal_msg_hdr_t *prevHdr = NULL;
   osal_msg_hdr_t *foundHdr = NULL;
@@ -824,6 +970,7 @@ uint8 *osal_msg_receive( uint8 task_id )
   HAL_EXIT_CRITICAL_SECTION(intState);
 
   return ( (uint8*) foundHdr );
+#endif // OSAL_MSG_TASK_QUEUES
 }
 
 /**************************************************************************************************
@@ -849,9 +996,20 @@ osal_event_hdr_t *osal_msg_find(uint8 task_id, uint8 event)
   osal_msg_hdr_t *pHdr;
   halIntState_t intState;
 
+#if OSAL_MSG_TASK_QUEUES
+  if (task_id >= tasksCnt)
+  {
+    return NULL;
+  }
+#endif
+
   HAL_ENTER_CRITICAL_SECTION(intState);  // Hold off interrupts.
 
+#if OSAL_MSG_TASK_QUEUES
+  pHdr = osal_qTask[task_id].head;  // Point to the top of the task's queue.
+#else
   pHdr = osal_qHead;  // Point to the top of the queue.
+#endif
 
   // Look through the queue for a message that matches the task_id and event parameters.
   while (pHdr != NULL)
@@ -894,9 +1052,20 @@ uint8 osal_msg_count( uint8 task_id, uint8 event )
   osal_msg_hdr_t *pHdr;
   halIntState_t intState;
 
+#if OSAL_MSG_TASK_QUEUES
+  if ( task_id >= tasksCnt )
+  {
+    return ( 0 );
+  }
+#endif
+
   HAL_ENTER_CRITICAL_SECTION(intState);  // Hold off interrupts.
 
+#if OSAL_MSG_TASK_QUEUES
+  pHdr = osal_qTask[task_id].head;  // Point to the top of the task's queue.
+#else
   pHdr = osal_qHead;  // Point to the top of the queue.
+#endif
 
   // Look through the queue for a message that matches the task_id and event parameters.
   while (pHdr != NULL)
@@ -1185,6 +1354,10 @@ uint8 osal_set_event( uint8 task_id, uint16 event_flag )
   {
     halIntState_t   intState;
     HAL_ENTER_CRITICAL_SECTION(intState);    // Hold off interrupts
+    if ( (tasksEvents[task_id] == 0) && (event_flag != 0) )
+    {
+      osal_task_ready( task_id );
+    }
     tasksEvents[task_id] |= event_flag;  // Stuff the event bit(s)
     HAL_EXIT_CRITICAL_SECTION(intState);     // Release interrupts
 #ifdef USE_ICALL
@@ -1218,6 +1391,12 @@ uint8 osal_clear_event( uint8 task_id, uint16 event_flag )
     halIntState_t   intState;
     HAL_ENTER_CRITICAL_SECTION(intState);    // Hold off interrupts
     tasksEvents[task_id] &= ~(event_flag);   // Clear the event bit(s)
+#if OSAL_RUN_READY_MAP
+    if ( (tasksEvents[task_id] == 0) && (task_id < OSAL_READY_MAP_TASKS) )
+    {
+      osalReadyMap &= ~OSAL_READY_BIT( task_id );
+    }
+#endif
     HAL_EXIT_CRITICAL_SECTION(intState);     // Release interrupts
     return ( SUCCESS );
   }
@@ -1227,6 +1406,242 @@ uint8 osal_clear_event( uint8 task_id, uint16 event_flag )
   }
 }
 
+/*********************************************************************
+ * @fn      osal_register_event_handlers
+ *
+ * @brief
+ *
+ *    Register a table of event handlers for a task. When the task is
+ *    dispatched, every pending event found in the table is cleared and
+ *    its handler called, all in the same dispatch. The events left are
+ *    then passed to the task's event loop as before. Register a NULL
+ *    table to remove it.
+ *
+ * @param   uint8 task_id - task of the table
+ * @param   const osalEventHandlerRec_t *pTable - handlers, kept by reference
+ * @param   uint8 cnt - number of records in pTable
+ *
+ * @return  SUCCESS, INVALID_TASK, MSG_BUFFER_NOT_AVAIL
+ */
+uint8 osal_register_event_handlers( uint8 task_id, const osalEventHandlerRec_t *pTable, uint8 cnt )
+{
+  if ( task_id >= tasksCnt )
+  {
+    return ( INVALID_TASK );
+  }
+
+  if ( osalEventTables == NULL )
+  {
+    if ( pTable == NULL )
+    {
+      return ( SUCCESS );
+    }
+
+    osalEventTables = (osalEventTable_t *)osal_mem_alloc( sizeof( osalEventTable_t ) * tasksCnt );
+    if ( osalEventTables == NULL )
+    {
+      return ( MSG_BUFFER_NOT_AVAIL );
+    }
+    osal_memset( osalEventTables, 0, sizeof( osalEventTable_t ) * tasksCnt );
+  }
+
+  osalEventTables[task_id].pTable = pTable;
+  osalEventTables[task_id].cnt = ( pTable != NULL ) ? cnt : 0;
+
+  return ( SUCCESS );
+}
+
+#if OSAL_RUN_METRICS
+/*********************************************************************
+ * @fn      osal_task_stats
+ *
+ * @brief
+ *
+ *    Get the dispatch counters of a task: how often it ran, how many
+ *    events its handler table ran, and how long it waited from the
+ *    first event being set to its dispatch.
+ *
+ * @param   uint8 task_id - task
+ * @param   osalTaskStats_t *pStats - counters
+ *
+ * @return  SUCCESS, INVALID_TASK
+ */
+uint8 osal_task_stats( uint8 task_id, osalTaskStats_t *pStats )
+{
+  halIntState_t intState;
+
+  if ( (task_id >= tasksCnt) || (osalTaskMetrics == NULL) )
+  {
+    return ( INVALID_TASK );
+  }
+
+  HAL_ENTER_CRITICAL_SECTION(intState);
+  *pStats = osalTaskMetrics[task_id].stats;
+  HAL_EXIT_CRITICAL_SECTION(intState);
+
+  return ( SUCCESS );
+}
+#endif // OSAL_RUN_METRICS
+
+/*********************************************************************
+ * @fn      osal_task_ready
+ *
+ * @brief
+ *
+ *    A task went from no events to events pending: mark it in the
+ *    ready map and start its wait. Called in a critical section.
+ *
+ * @param   uint8 task_id - task
+ *
+ * @return  none
+ */
+static void osal_task_ready( uint8 task_id )
+{
+#if OSAL_RUN_READY_MAP
+  if ( task_id < OSAL_READY_MAP_TASKS )
+  {
+    osalReadyMap |= OSAL_READY_BIT( task_id );
+  }
+#endif
+
+#if OSAL_RUN_METRICS
+  if ( osalTaskMetrics != NULL )
+  {
+    osalTaskMetrics[task_id].readyTime = osal_GetSystemClock();
+    osalTaskMetrics[task_id].readyPass = osalRunPass;
+  }
+#endif
+
+  (void)task_id;
+}
+
+/*********************************************************************
+ * @fn      osal_next_ready
+ *
+ * @brief
+ *
+ *    Find the highest priority (lowest ID) task with events pending.
+ *
+ * @param   void
+ *
+ * @return  task ID, tasksCnt if no task is ready
+ */
+static uint8 osal_next_ready( void )
+{
+  uint8 idx = 0;
+
+#if OSAL_RUN_READY_MAP
+  if ( tasksCnt <= OSAL_READY_MAP_TASKS )
+  {
+    halIntState_t intState;
+
+    HAL_ENTER_CRITICAL_SECTION(intState);
+    for ( ;; )
+    {
+      if ( osalReadyMap == 0 )
+      {
+        idx = tasksCnt;
+        break;
+      }
+
+      idx = OSAL_CLZ32( osalReadyMap );
+      if ( tasksEvents[idx] )
+      {
+        break;
+      }
+
+      // Stale bit, the events were cleared behind our back
+      osalReadyMap &= ~OSAL_READY_BIT( idx );
+    }
+    HAL_EXIT_CRITICAL_SECTION(intState);
+
+    return ( idx );
+  }
+#endif
+
+  do {
+    if (tasksEvents[idx])  // Task is highest priority that is ready.
+    {
+      break;
+    }
+  } while (++idx < tasksCnt);
+
+  return ( idx );
+}
+
+/*********************************************************************
+ * @fn      osal_run_event_handlers
+ *
+ * @brief
+ *
+ *    Run the handlers of the task's table for all pending events.
+ *
+ * @param   uint8 task_id - task being dispatched
+ * @param   uint16 events - events pending
+ *
+ * @return  events not handled by the table
+ */
+static uint16 osal_run_event_handlers( uint8 task_id, uint16 events )
+{
+  const osalEventHandlerRec_t *pRec = osalEventTables[task_id].pTable;
+  uint8 cnt = osalEventTables[task_id].cnt;
+
+  for ( ; (cnt > 0) && (events != 0); cnt--, pRec++ )
+  {
+    if ( events & pRec->event )
+    {
+      events &= ~pRec->event;
+      pRec->pfnHandler( task_id );
+#if OSAL_RUN_METRICS
+      if ( osalTaskMetrics != NULL )
+      {
+        osalTaskMetrics[task_id].stats.handled++;
+      }
+#endif
+    }
+  }
+
+  return ( events );
+}
+
+#if OSAL_RUN_READY_MAP && !defined ( OSAL_CLZ32 )
+/*********************************************************************
+ * @fn      OSAL_CLZ32
+ *
+ * @brief
+ *
+ *    Count leading zeros for compilers without a builtin, a nibble
+ *    at a time.
+ *
+ * @param   uint32 x - value, not 0
+ *
+ * @return  number of leading 0 bits
+ */
+static uint8 OSAL_CLZ32( uint32 x )
+{
+  static CONST uint8 clz4[16] = { 4, 3, 2, 2, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0 };
+  uint8 n = 0;
+
+  if ( (x & 0xFFFF0000) == 0 )
+  {
+    n += 16;
+    x <<= 16;
+  }
+  if ( (x & 0xFF000000) == 0 )
+  {
+    n += 8;
+    x <<= 8;
+  }
+  if ( (x & 0xF0000000) == 0 )
+  {
+    n += 4;
+    x <<= 4;
+  }
+
+  return ( n + clz4[(uint8)(x >> 28)] );
+}
+#endif
+
 /*********************************************************************
  * @fn      osal_isr_register
  *
@@ -1329,7 +1744,30 @@ uint8 osal_init_system( void )
 #endif /* !defined USE_ICALL && !defined OSAL_PORT2TIRTOS */
 
   // Initialize the message queue
+#if OSAL_MSG_TASK_QUEUES
+  osal_qTask = (osal_msg_tq_t *)osal_mem_alloc( sizeof( osal_msg_tq_t ) * tasksCnt );
+  if ( osal_qTask == NULL )
+  {
+    // The heap cannot hold a queue per task, so no message could ever be
+    // delivered: stop here rather than run without them
+    HAL_ASSERT_FORCED();
+    HAL_DISABLE_INTERRUPTS();
+    for ( ;; )
+    {
+    }
+  }
+  osal_memset( osal_qTask, 0, sizeof( osal_msg_tq_t ) * tasksCnt );
+#else
   osal_qHead = NULL;
+#endif
+
+#if OSAL_RUN_METRICS
+  osalTaskMetrics = (osalTaskMetrics_t *)osal_mem_alloc( sizeof( osalTaskMetrics_t ) * tasksCnt );
+  if ( osalTaskMetrics != NULL )
+  {
+    osal_memset( osalTaskMetrics, 0, sizeof( osalTaskMetrics_t ) * tasksCnt );
+  }
+#endif
 
   // Initialize the timers
   osalTimerInit();
@@ -1641,12 +2079,7 @@ void osal_run_system( void )
   }
 #endif /* USE_ICALL */
 
-  do {
-    if (tasksEvents[idx])  // Task is highest priority that is ready.
-    {
-      break;
-    }
-  } while (++idx < tasksCnt);
+  idx = osal_next_ready();
 
   if (idx < tasksCnt)
   {
@@ -1656,13 +2089,54 @@ void osal_run_system( void )
     HAL_ENTER_CRITICAL_SECTION(intState);
     events = tasksEvents[idx];
     tasksEvents[idx] = 0;  // Clear the Events for this task.
+#if OSAL_RUN_READY_MAP
+    if ( idx < OSAL_READY_MAP_TASKS )
+    {
+      osalReadyMap &= ~OSAL_READY_BIT( idx );
+    }
+#endif
+#if OSAL_RUN_METRICS
+    if ( osalTaskMetrics != NULL )
+    {
+      osalTaskMetrics_t *pMet = &osalTaskMetrics[idx];
+      uint32 wait = osal_GetSystemClock() - pMet->readyTime;
+
+      pMet->stats.runs++;
+      pMet->stats.waitSum += wait;
+      if ( wait > pMet->stats.waitMax )
+      {
+        pMet->stats.waitMax = (wait > 0xFFFF) ? 0xFFFF : (uint16)wait;
+      }
+      wait = osalRunPass - pMet->readyPass;
+      if ( wait > pMet->stats.passMax )
+      {
+        pMet->stats.passMax = (wait > 0xFFFF) ? 0xFFFF : (uint16)wait;
+      }
+      osalRunPass++;
+    }
+#endif
     HAL_EXIT_CRITICAL_SECTION(intState);
 
     activeTaskID = idx;
-    events = (tasksArr[idx])( idx, events );
+    if ( (osalEventTables != NULL) && (osalEventTables[idx].cnt != 0) )
+    {
+      events = osal_run_event_handlers( idx, events );
+    }
+    if ( events != 0 )
+    {
+      events = (tasksArr[idx])( idx, events );
+    }
     activeTaskID = TASK_NO_TASK;
 
+#if OSAL_NV_DEFER_CNT
+    osal_nv_flush();  // NV writes deferred by the event handlers of the task.
+#endif
+
     HAL_ENTER_CRITICAL_SECTION(intState);
+    if ( (tasksEvents[idx] == 0) && (events != 0) )
+    {
+      osal_task_ready( idx );
+    }
     tasksEvents[idx] |= events;  // Add back unprocessed events to the current task.
     HAL_EXIT_CRITICAL_SECTION(intState);
   }
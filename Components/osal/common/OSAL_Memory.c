@@ -143,6 +143,27 @@
 #define OSALMEM_PROFILER_LL        FALSE  // Special profiling of the Long-Lived bucket.
 #endif
 
+/* Size-class front-end ("slab"): freed blocks whose length matches one of the classes below are
+ * kept, still marked in-use, on a per-class free list and handed straight back by the next
+ * allocation of that class, so the high frequency messages, timers and ZCL parse buffers skip the
+ * first-fit walk and do not fragment the heap. Allocations of a class are always made at the
+ * class block size so that they can be recycled. When the heap cannot satisfy a request the class
+ * lists are released back to it and the search is retried.
+ *
+ * Class sizes are whole block sizes (header included) in increasing order and must be
+ * multiples of OSALMEM_HDRSZ. The defaults fit osalTimerRec_t and small ZCL command buffers (small
+ * block), zclIncomingMsg_t (32), afIncomingMSGPacket_t with a short ZCL frame (64) or with a
+ * multi-attribute report (96). OSALMEM_SLAB_DEPTHS bounds the free blocks held per class.
+ */
+#if OSALMEM_SLAB
+#if !defined OSALMEM_SLAB_SIZES
+#define OSALMEM_SLAB_SIZES         OSALMEM_SMALL_BLKSZ, 32, 64, 96
+#endif
+#if !defined OSALMEM_SLAB_DEPTHS
+#define OSALMEM_SLAB_DEPTHS        4, 4, 2, 2
+#endif
+#endif
+
 #if OSALMEM_PROFILER
 #define OSALMEM_INIT              'X'
 #define OSALMEM_ALOC              'A'
@@ -193,6 +214,21 @@ static uint16 memAlo;  // Current total memory allocated.
 static uint16 memMax;  // Max total memory ever allocated at once.
 #endif
 
+#if OSALMEM_SLAB
+static CONST uint16 slabSz[] = { OSALMEM_SLAB_SIZES };
+static CONST uint8 slabDepth[] = { OSALMEM_SLAB_DEPTHS };
+#define OSALMEM_SLAB_CNT  (sizeof(slabSz) / sizeof(slabSz[0]))
+
+static osalMemHdr_t *slabFree[OSALMEM_SLAB_CNT];  // Head of each class free list.
+static uint8 slabCached[OSALMEM_SLAB_CNT];        // Blocks on each class free list.
+#if OSALMEM_METRICS
+static uint16 slabCur[OSALMEM_SLAB_CNT];          // Class blocks now handed out.
+static uint16 slabMax[OSALMEM_SLAB_CNT];          // Max class blocks ever handed out at once.
+static uint32 slabHit[OSALMEM_SLAB_CNT];          // Allocations served from the free list.
+static uint32 slabMiss[OSALMEM_SLAB_CNT];         // Allocations that had to search the heap.
+#endif
+#endif
+
 #if OSALMEM_PROFILER
 #define OSALMEM_PROMAX  8
 /* The profiling buckets must differ by at least OSALMEM_MIN_BLKSZ; the
@@ -216,6 +252,16 @@ static uint16 proSmallBlkMiss;
 extern int dprintf(const char *fmt, ...);
 #endif /* DPRINTF_HEAPTRACE */
 
+/* ------------------------------------------------------------------------------------------------
+ *                                           Local Functions
+ * ------------------------------------------------------------------------------------------------
+ */
+
+static void osalMemFreeHdr(osalMemHdr_t *hdr);
+#if OSALMEM_SLAB
+static uint8 osalMemSlabRelease(void);
+#endif
+
 /**************************************************************************************************
  * @fn          osal_mem_init
  *
@@ -236,6 +282,19 @@ void osal_mem_init(void)
   HAL_ASSERT(((OSALMEM_MIN_BLKSZ % OSALMEM_HDRSZ) == 0));
   HAL_ASSERT(((OSALMEM_LL_BLKSZ % OSALMEM_HDRSZ) == 0));
   HAL_ASSERT(((OSALMEM_SMALL_BLKSZ % OSALMEM_HDRSZ) == 0));
+#if OSALMEM_SLAB
+  {
+    uint8 idx;
+
+    for (idx = 0; idx < OSALMEM_SLAB_CNT; idx++)
+    {
+      HAL_ASSERT(((slabSz[idx] % OSALMEM_HDRSZ) == 0));
+      HAL_ASSERT(((idx == 0) || (slabSz[idx] > slabSz[idx-1])));
+      slabFree[idx] = NULL;
+      slabCached[idx] = 0;
+    }
+  }
+#endif
 
 #if OSALMEM_PROFILER
   (void)osal_memset(theHeap, OSALMEM_INIT, MAXMEMHEAP);
@@ -324,6 +383,9 @@ void *osal_mem_alloc( uint16 size )
   osalMemHdr_t *hdr;
   halIntState_t intState;
   uint8 coal = 0;
+#if OSALMEM_SLAB
+  uint8 cls = OSALMEM_SLAB_CNT;
+#endif
 
   size += OSALMEM_HDRSZ;
 
@@ -344,6 +406,52 @@ void *osal_mem_alloc( uint16 size )
 
   HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
 
+#if OSALMEM_SLAB
+  // Long-lived allocations (before the kick) always come from the LL block.
+  if (osalMemStat != 0)
+  {
+    for (cls = 0; cls < OSALMEM_SLAB_CNT; cls++)
+    {
+      if (size <= slabSz[cls])
+      {
+        break;
+      }
+    }
+
+    if (cls < OSALMEM_SLAB_CNT)
+    {
+      hdr = slabFree[cls];
+
+      if (hdr != NULL)
+      {
+        // The link to the next free block of the class is kept in the data area.
+        slabFree[cls] = *(osalMemHdr_t **)(hdr + 1);
+        slabCached[cls]--;
+#if ( OSALMEM_METRICS )
+        slabHit[cls]++;
+        if (++slabCur[cls] > slabMax[cls])
+        {
+          slabMax[cls] = slabCur[cls];
+        }
+#endif
+        HAL_EXIT_CRITICAL_SECTION( intState );  // Re-enable interrupts.
+
+        return (void *)(hdr + 1);
+      }
+
+#if ( OSALMEM_METRICS )
+      slabMiss[cls]++;
+#endif
+      // Allocate at the class size so that the block can be recycled by the class.
+      size = slabSz[cls];
+    }
+  }
+
+  do
+  {
+    coal = 0;
+#endif
+
   // Smaller allocations are first attempted in the small-block bucket, and all long-lived
   // allocations are channeled into the LL block reserved within this bucket.
   if ((osalMemStat == 0) || (size <= OSALMEM_SMALL_BLKSZ))
@@ -399,6 +507,11 @@ void *osal_mem_alloc( uint16 size )
     }
   } while (1);
 
+#if OSALMEM_SLAB
+  // Out of heap: give the blocks held by the classes back and search once more.
+  } while ((hdr == NULL) && osalMemSlabRelease());
+#endif
+
   if ( hdr != NULL )
   {
     uint16 tmp = hdr->hdr.len - size;
@@ -480,6 +593,16 @@ void *osal_mem_alloc( uint16 size )
       ff1 = (osalMemHdr_t *)((uint8 *)hdr + hdr->hdr.len);
     }
 
+#if ( OSALMEM_SLAB && OSALMEM_METRICS )
+    if (cls < OSALMEM_SLAB_CNT)
+    {
+      if (++slabCur[cls] > slabMax[cls])
+      {
+        slabMax[cls] = slabCur[cls];
+      }
+    }
+#endif
+
     hdr++;
   }
 
@@ -525,6 +648,66 @@ void osal_mem_free(void *ptr)
   HAL_ASSERT(hdr->hdr.inUse);
 
   HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
+
+#if OSALMEM_SLAB
+  if (osalMemStat != 0)
+  {
+    uint8 cls;
+
+    // A block belongs to a class if it is at least the class size but too short to have been
+    // split, i.e. it is what an allocation of that class returns.
+    for (cls = 0; cls < OSALMEM_SLAB_CNT; cls++)
+    {
+      if (hdr->hdr.len < slabSz[cls] + OSALMEM_MIN_BLKSZ)
+      {
+        break;
+      }
+    }
+
+    if ((cls < OSALMEM_SLAB_CNT) && (hdr->hdr.len >= slabSz[cls]))
+    {
+#if ( OSALMEM_METRICS )
+      if (slabCur[cls] != 0)
+      {
+        slabCur[cls]--;
+      }
+#endif
+
+      if (slabCached[cls] < slabDepth[cls])
+      {
+        *(osalMemHdr_t **)ptr = slabFree[cls];
+        slabFree[cls] = hdr;
+        slabCached[cls]++;
+
+        HAL_EXIT_CRITICAL_SECTION( intState );  // Re-enable interrupts.
+        return;
+      }
+    }
+  }
+#endif
+
+  osalMemFreeHdr(hdr);
+
+  HAL_EXIT_CRITICAL_SECTION( intState );  // Re-enable interrupts.
+}
+
+/**************************************************************************************************
+ * @fn          osalMemFreeHdr
+ *
+ * @brief       Return a block to the heap. Interrupts must be disabled.
+ *
+ * input parameters
+ *
+ * @param hdr - Header of the in-use block to free.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ */
+static void osalMemFreeHdr(osalMemHdr_t *hdr)
+{
   hdr->hdr.inUse = FALSE;
 
   if (ff1 > hdr)
@@ -556,10 +739,72 @@ void osal_mem_free(void *ptr)
   memAlo -= hdr->hdr.len;
   blkFree++;
 #endif
+}
 
-  HAL_EXIT_CRITICAL_SECTION( intState );  // Re-enable interrupts.
+#if OSALMEM_SLAB
+/**************************************************************************************************
+ * @fn          osalMemSlabRelease
+ *
+ * @brief       Return every block held on the class free lists to the heap.
+ *              Interrupts must be disabled.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      TRUE if any block was released.
+ */
+static uint8 osalMemSlabRelease(void)
+{
+  uint8 released = FALSE;
+  uint8 cls;
+
+  for (cls = 0; cls < OSALMEM_SLAB_CNT; cls++)
+  {
+    while (slabFree[cls] != NULL)
+    {
+      osalMemHdr_t *hdr = slabFree[cls];
+
+      slabFree[cls] = *(osalMemHdr_t **)(hdr + 1);
+      osalMemFreeHdr(hdr);
+      released = TRUE;
+    }
+    slabCached[cls] = 0;
+  }
+
+  return released;
 }
 
+/**************************************************************************************************
+ * @fn          osal_mem_slab_flush
+ *
+ * @brief       Return the blocks held by the size-class free lists to the heap, e.g. before a
+ *              large allocation or to measure the heap without them.
+ *
+ * input parameters
+ *
+ * None.
+ *
+ * output parameters
+ *
+ * None.
+ *
+ * @return      None.
+ */
+void osal_mem_slab_flush(void)
+{
+  halIntState_t intState;
+
+  HAL_ENTER_CRITICAL_SECTION(intState);  // Hold off interrupts.
+  (void)osalMemSlabRelease();
+  HAL_EXIT_CRITICAL_SECTION(intState);  // Re-enable interrupts.
+}
+#endif
+
 #if OSALMEM_METRICS
 /*********************************************************************
  * @fn      osal_heap_block_max
@@ -619,6 +864,40 @@ uint16 osal_heap_mem_used( void )
 #endif
 
 #if defined (ZTOOL_P1) || defined (ZTOOL_P2)
+#if ( OSALMEM_SLAB && OSALMEM_METRICS )
+/*********************************************************************
+ * @fn      osal_heap_slab_stats
+ *
+ * @brief   Return the counters of one size class of the allocator
+ *          front-end.
+ *
+ * @param   cls - size class index, 0 for the smallest
+ * @param   pStats - filled with the counters
+ *
+ * @return  FALSE if 'cls' is not a valid class, TRUE otherwise.
+ */
+uint8 osal_heap_slab_stats( uint8 cls, osalMemSlabStats_t *pStats )
+{
+  halIntState_t intState;
+
+  if ( cls >= OSALMEM_SLAB_CNT )
+  {
+    return FALSE;
+  }
+
+  HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
+  pStats->blkSz = slabSz[cls];
+  pStats->cached = slabCached[cls];
+  pStats->cur = slabCur[cls];
+  pStats->max = slabMax[cls];
+  pStats->hit = slabHit[cls];
+  pStats->miss = slabMiss[cls];
+  HAL_EXIT_CRITICAL_SECTION( intState );  // Re-enable interrupts.
+
+  return TRUE;
+}
+#endif
+
 /*********************************************************************
  * @fn      osal_heap_high_water
  *
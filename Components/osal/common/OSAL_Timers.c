@@ -51,10 +51,37 @@
  * MACROS
  */
 
+// TRUE if absolute time 'a' is before absolute time 'b' (wrap safe, the
+// longest timeout OSAL_TIMERS_MAX_TIMEOUT is well below 2^31 ms)
+#define OSAL_TIMERS_BEFORE( a, b )  ((int32)((uint32)(a) - (uint32)(b)) < 0)
+
 /*********************************************************************
  * CONSTANTS
  */
 
+/* Timer bookkeeping: FALSE keeps the original unsorted list of heap
+ * allocated records, which costs a walk of every timer on every tick.
+ * TRUE uses a statically allocated pool of OSAL_TIMERS_MAX records
+ * kept in a binary min-heap ordered by absolute expiry time, with a
+ * small hash on (task, event) for start/stop. A tick with nothing
+ * expiring is then a single compare and osal_next_timeout() is O(1).
+ */
+#if !defined OSAL_TIMERS_HEAP
+#define OSAL_TIMERS_HEAP        FALSE
+#endif
+
+#if OSAL_TIMERS_HEAP
+#if !defined OSAL_TIMERS_MAX
+#define OSAL_TIMERS_MAX         24     // Must be < OSAL_TIMERS_NONE
+#endif
+#define OSAL_TIMERS_HASH_SIZE   16     // Power of 2
+#define OSAL_TIMERS_NONE        0xFF
+
+#define OSAL_TIMERS_HASH( task, evt ) \
+  ((uint8)((uint16)(((uint16)(evt) ^ ((uint16)(task) << 8)) * 40503u) >> 12) & \
+   (OSAL_TIMERS_HASH_SIZE - 1))
+#endif
+
 /*********************************************************************
  * TYPEDEFS
  */
@@ -65,6 +92,17 @@ typedef union {
   uint8 time8[4];
 } osalTime_t;
 
+#if OSAL_TIMERS_HEAP
+typedef struct
+{
+  uint32 expire;         // Absolute expiry, in osal_systemClock ms
+  uint32 reloadTimeout;
+  uint16 event_flag;
+  uint8  task_id;
+  uint8  heapIdx;        // Position in osalTimerHeap[]
+  uint8  next;           // Hash chain, or free list when not in use
+} osalTimerRec_t;
+#else
 typedef struct
 {
   void   *next;
@@ -73,12 +111,15 @@ typedef struct
   uint8  task_id;
   uint32 reloadTimeout;
 } osalTimerRec_t;
+#endif
 
 /*********************************************************************
  * GLOBAL VARIABLES
  */
 
+#if !OSAL_TIMERS_HEAP
 osalTimerRec_t *timerHead;
+#endif
 
 /*********************************************************************
  * EXTERNAL VARIABLES
@@ -94,6 +135,14 @@ osalTimerRec_t *timerHead;
 // Milliseconds since last reboot
 static uint32 osal_systemClock;
 
+#if OSAL_TIMERS_HEAP
+static osalTimerRec_t osalTimerPool[OSAL_TIMERS_MAX];
+static uint8 osalTimerHeap[OSAL_TIMERS_MAX];       // Pool indexes, soonest first
+static uint8 osalTimerHash[OSAL_TIMERS_HASH_SIZE];
+static uint8 osalTimerCnt;
+static uint8 osalTimerFree;
+#endif
+
 /*********************************************************************
  * LOCAL FUNCTION PROTOTYPES
  */
@@ -101,6 +150,12 @@ osalTimerRec_t  *osalAddTimer( uint8 task_id, uint16 event_flag, uint32 timeout
 osalTimerRec_t *osalFindTimer( uint8 task_id, uint16 event_flag );
 void osalDeleteTimer( osalTimerRec_t *rmTimer );
 
+#if OSAL_TIMERS_HEAP
+static void osalTimerSiftUp( uint8 pos );
+static void osalTimerSiftDown( uint8 pos );
+static void osalTimerHeapRemove( uint8 pos );
+#endif
+
 /*********************************************************************
  * FUNCTIONS
  *********************************************************************/
@@ -117,8 +172,272 @@ void osalDeleteTimer( osalTimerRec_t *rmTimer );
 void osalTimerInit( void )
 {
   osal_systemClock = 0;
+
+#if OSAL_TIMERS_HEAP
+  {
+    uint8 idx;
+
+    for ( idx = 0; idx < OSAL_TIMERS_MAX; idx++ )
+    {
+      osalTimerPool[idx].next = idx + 1;
+    }
+    osalTimerPool[OSAL_TIMERS_MAX - 1].next = OSAL_TIMERS_NONE;
+    osalTimerFree = 0;
+    osalTimerCnt = 0;
+
+    for ( idx = 0; idx < OSAL_TIMERS_HASH_SIZE; idx++ )
+    {
+      osalTimerHash[idx] = OSAL_TIMERS_NONE;
+    }
+  }
+#endif
+}
+
+#if OSAL_TIMERS_HEAP
+/*********************************************************************
+ * @fn      osalTimerSiftUp
+ *
+ * @brief   Move a heap entry towards the root until its parent expires
+ *          no later than it does.
+ *          Ints must be disabled.
+ *
+ * @param   pos - heap position
+ *
+ * @return  none
+ */
+static void osalTimerSiftUp( uint8 pos )
+{
+  uint8 idx = osalTimerHeap[pos];
+  uint32 expire = osalTimerPool[idx].expire;
+
+  while ( pos > 0 )
+  {
+    uint8 parent = (pos - 1) >> 1;
+    uint8 pIdx = osalTimerHeap[parent];
+
+    if ( !OSAL_TIMERS_BEFORE( expire, osalTimerPool[pIdx].expire ) )
+    {
+      break;
+    }
+
+    osalTimerHeap[pos] = pIdx;
+    osalTimerPool[pIdx].heapIdx = pos;
+    pos = parent;
+  }
+
+  osalTimerHeap[pos] = idx;
+  osalTimerPool[idx].heapIdx = pos;
 }
 
+/*********************************************************************
+ * @fn      osalTimerSiftDown
+ *
+ * @brief   Move a heap entry towards the leaves until both children
+ *          expire no earlier than it does.
+ *          Ints must be disabled.
+ *
+ * @param   pos - heap position
+ *
+ * @return  none
+ */
+static void osalTimerSiftDown( uint8 pos )
+{
+  uint8 idx = osalTimerHeap[pos];
+  uint32 expire = osalTimerPool[idx].expire;
+
+  for ( ;; )
+  {
+    uint8 child = (pos << 1) + 1;
+    uint8 cIdx;
+
+    if ( child >= osalTimerCnt )
+    {
+      break;
+    }
+
+    if ( (child + 1 < osalTimerCnt) &&
+         OSAL_TIMERS_BEFORE( osalTimerPool[osalTimerHeap[child + 1]].expire,
+                             osalTimerPool[osalTimerHeap[child]].expire ) )
+    {
+      child++;
+    }
+
+    cIdx = osalTimerHeap[child];
+    if ( !OSAL_TIMERS_BEFORE( osalTimerPool[cIdx].expire, expire ) )
+    {
+      break;
+    }
+
+    osalTimerHeap[pos] = cIdx;
+    osalTimerPool[cIdx].heapIdx = pos;
+    pos = child;
+  }
+
+  osalTimerHeap[pos] = idx;
+  osalTimerPool[idx].heapIdx = pos;
+}
+
+/*********************************************************************
+ * @fn      osalTimerHeapRemove
+ *
+ * @brief   Take the entry at a heap position out of the heap.
+ *          Ints must be disabled.
+ *
+ * @param   pos - heap position
+ *
+ * @return  none
+ */
+static void osalTimerHeapRemove( uint8 pos )
+{
+  osalTimerCnt--;
+
+  if ( pos < osalTimerCnt )
+  {
+    // Fill the hole with the last entry, which may have to move either way.
+    uint8 idx = osalTimerHeap[osalTimerCnt];
+
+    osalTimerHeap[pos] = idx;
+    osalTimerSiftDown( pos );
+    osalTimerSiftUp( osalTimerPool[idx].heapIdx );
+  }
+}
+#endif // OSAL_TIMERS_HEAP
+
+#if OSAL_TIMERS_HEAP
+/*********************************************************************
+ * @fn      osalAddTimer
+ *
+ * @brief   Add a timer to the timer heap, or restart it if it exists.
+ *          Ints must be disabled.
+ *
+ * @param   task_id
+ * @param   event_flag
+ * @param   timeout - in milliseconds, at most OSAL_TIMERS_MAX_TIMEOUT
+ *
+ * @return  osalTimerRec_t * - pointer to the timer, NULL if the pool
+ *          is exhausted
+ */
+osalTimerRec_t * osalAddTimer( uint8 task_id, uint16 event_flag, uint32 timeout )
+{
+  osalTimerRec_t *newTimer;
+  uint8 idx;
+  uint8 hash;
+
+  // The heap orders expiry times with OSAL_TIMERS_BEFORE, which wraps for
+  // timeouts of 2^31 ms and more
+  if ( timeout > OSAL_TIMERS_MAX_TIMEOUT )
+  {
+    timeout = OSAL_TIMERS_MAX_TIMEOUT;
+  }
+
+  // Look for an existing timer first
+  newTimer = osalFindTimer( task_id, event_flag );
+  if ( newTimer )
+  {
+    // Timer is found - update it.
+    newTimer->expire = osal_systemClock + timeout;
+    osalTimerSiftDown( newTimer->heapIdx );
+    osalTimerSiftUp( newTimer->heapIdx );
+
+    return ( newTimer );
+  }
+
+  idx = osalTimerFree;
+  if ( idx == OSAL_TIMERS_NONE )
+  {
+    return ( (osalTimerRec_t *)NULL );
+  }
+
+  // Fill in new timer
+  newTimer = &osalTimerPool[idx];
+  osalTimerFree = newTimer->next;
+
+  newTimer->task_id = task_id;
+  newTimer->event_flag = event_flag;
+  newTimer->expire = osal_systemClock + timeout;
+  newTimer->reloadTimeout = 0;
+
+  hash = OSAL_TIMERS_HASH( task_id, event_flag );
+  newTimer->next = osalTimerHash[hash];
+  osalTimerHash[hash] = idx;
+
+  osalTimerHeap[osalTimerCnt] = idx;
+  osalTimerSiftUp( osalTimerCnt++ );
+
+  return ( newTimer );
+}
+
+/*********************************************************************
+ * @fn      osalFindTimer
+ *
+ * @brief   Find a timer by task and event.
+ *          Ints must be disabled.
+ *
+ * @param   task_id
+ * @param   event_flag
+ *
+ * @return  osalTimerRec_t *
+ */
+osalTimerRec_t *osalFindTimer( uint8 task_id, uint16 event_flag )
+{
+  uint8 idx = osalTimerHash[OSAL_TIMERS_HASH( task_id, event_flag )];
+
+  while ( idx != OSAL_TIMERS_NONE )
+  {
+    osalTimerRec_t *srchTimer = &osalTimerPool[idx];
+
+    if ( srchTimer->event_flag == event_flag &&
+         srchTimer->task_id == task_id )
+    {
+      return ( srchTimer );
+    }
+
+    idx = srchTimer->next;
+  }
+
+  return ( (osalTimerRec_t *)NULL );
+}
+
+/*********************************************************************
+ * @fn      osalDeleteTimer
+ *
+ * @brief   Delete a timer: unlike the list version the record is
+ *          returned to the pool at once.
+ *          Ints must be disabled.
+ *
+ * @param   rmTimer
+ *
+ * @return  none
+ */
+void osalDeleteTimer( osalTimerRec_t *rmTimer )
+{
+  uint8 idx;
+  uint8 *pLink;
+
+  if ( rmTimer == NULL )
+  {
+    return;
+  }
+
+  idx = (uint8)(rmTimer - osalTimerPool);
+
+  // Unlink from the hash chain
+  pLink = &osalTimerHash[OSAL_TIMERS_HASH( rmTimer->task_id, rmTimer->event_flag )];
+  while ( *pLink != idx )
+  {
+    pLink = &osalTimerPool[*pLink].next;
+  }
+  *pLink = rmTimer->next;
+
+  osalTimerHeapRemove( rmTimer->heapIdx );
+
+  rmTimer->event_flag = 0;
+  rmTimer->next = osalTimerFree;
+  osalTimerFree = idx;
+}
+
+#else // !OSAL_TIMERS_HEAP
+
 /*********************************************************************
  * @fn      osalAddTimer
  *
@@ -241,6 +560,7 @@ void osalDeleteTimer( osalTimerRec_t *rmTimer )
     rmTimer->event_flag = 0;
   }
 }
+#endif // OSAL_TIMERS_HEAP
 
 /*********************************************************************
  * @fn      osal_start_timerEx
@@ -291,6 +611,14 @@ uint8 osal_start_reload_timer( uint8 taskID, uint16 event_id, uint32 timeout_val
   halIntState_t intState;
   osalTimerRec_t *newTimer;
 
+#if OSAL_TIMERS_HEAP
+  // Reloaded from the heap as it was added, within OSAL_TIMERS_MAX_TIMEOUT
+  if ( timeout_value > OSAL_TIMERS_MAX_TIMEOUT )
+  {
+    timeout_value = OSAL_TIMERS_MAX_TIMEOUT;
+  }
+#endif
+
   HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
 
   // Add timer
@@ -361,7 +689,14 @@ uint32 osal_get_timeoutEx( uint8 task_id, uint16 event_id )
 
   if ( tmr )
   {
+#if OSAL_TIMERS_HEAP
+    if ( OSAL_TIMERS_BEFORE( osal_systemClock, tmr->expire ) )
+    {
+      rtrn = tmr->expire - osal_systemClock;
+    }
+#else
     rtrn = tmr->timeout.time32;
+#endif
   }
 
   HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
@@ -380,6 +715,9 @@ uint32 osal_get_timeoutEx( uint8 task_id, uint16 event_id )
  */
 uint8 osal_timer_num_active( void )
 {
+#if OSAL_TIMERS_HEAP
+  return osalTimerCnt;
+#else
   halIntState_t intState;
   uint8 num_timers = 0;
   osalTimerRec_t *srchTimer;
@@ -399,6 +737,7 @@ uint8 osal_timer_num_active( void )
   HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
 
   return num_timers;
+#endif
 }
 
 /*********************************************************************
@@ -410,6 +749,53 @@ uint8 osal_timer_num_active( void )
  *
  * @return  none
  *********************************************************************/
+#if OSAL_TIMERS_HEAP
+void osalTimerUpdate( uint32 updateTime )
+{
+  halIntState_t intState;
+
+  HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
+  // Update the system time
+  osal_systemClock += updateTime;
+  HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
+
+  // Expire timers soonest first; stop at the first one still pending.
+  for ( ;; )
+  {
+    osalTimerRec_t *expTimer;
+    uint16 event_flag;
+    uint8 task_id;
+
+    HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
+
+    if ( (osalTimerCnt == 0) ||
+         OSAL_TIMERS_BEFORE( osal_systemClock, osalTimerPool[osalTimerHeap[0]].expire ) )
+    {
+      HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
+      break;
+    }
+
+    expTimer = &osalTimerPool[osalTimerHeap[0]];
+    task_id = expTimer->task_id;
+    event_flag = expTimer->event_flag;
+
+    if ( expTimer->reloadTimeout )
+    {
+      // Reload from now, like the list version: missed periods are not replayed.
+      expTimer->expire = osal_systemClock + expTimer->reloadTimeout;
+      osalTimerSiftDown( 0 );
+    }
+    else
+    {
+      osalDeleteTimer( expTimer );
+    }
+
+    HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
+
+    osal_set_event( task_id, event_flag );
+  }
+}
+#else // !OSAL_TIMERS_HEAP
 void osalTimerUpdate( uint32 updateTime )
 {
   halIntState_t intState;
@@ -524,6 +910,7 @@ void osalTimerUpdate( uint32 updateTime )
     }
   }
 }
+#endif // OSAL_TIMERS_HEAP
 
 #ifdef POWER_SAVING
 /*********************************************************************
@@ -539,7 +926,11 @@ void osal_adjust_timers( void )
 {
   uint32 eTime;
 
+#if OSAL_TIMERS_HEAP
+  if ( osalTimerCnt != 0 )
+#else
   if ( timerHead != NULL )
+#endif
   {
     // Compute elapsed time (msec)
     eTime = TimerElapsed() / TICK_COUNT;
@@ -567,6 +958,27 @@ void osal_adjust_timers( void )
  *********************************************************************/
 uint32 osal_next_timeout( void )
 {
+#if OSAL_TIMERS_HEAP
+  uint32 nextTimeout = 0;
+  halIntState_t intState;
+
+  HAL_ENTER_CRITICAL_SECTION( intState );  // Hold off interrupts.
+
+  if ( osalTimerCnt != 0 )
+  {
+    nextTimeout = osalTimerPool[osalTimerHeap[0]].expire - osal_systemClock;
+
+    // Already due but not yet processed: 0 would read as "no timers".
+    if ( (int32)nextTimeout <= 0 )
+    {
+      nextTimeout = 1;
+    }
+  }
+
+  HAL_EXIT_CRITICAL_SECTION( intState );   // Re-enable interrupts.
+
+  return ( nextTimeout );
+#else
   uint32 nextTimeout;
   osalTimerRec_t *srchTimer;
 
@@ -594,6 +1006,7 @@ uint32 osal_next_timeout( void )
   }
 
   return ( nextTimeout );
+#endif
 }
 #endif // POWER_SAVING || USE_ICALL
 
@@ -90,6 +90,11 @@ extern "C"
 /*** Interrupts ***/
 #define INTS_ALL    0xFF
 
+// Per-task dispatch counters of osal_run_system (see osal_task_stats).
+#if !defined ( OSAL_RUN_METRICS )
+  #define OSAL_RUN_METRICS  FALSE
+#endif
+
 /*********************************************************************
  * TYPEDEFS
  */
@@ -117,6 +122,26 @@ typedef struct
 
 typedef void * osal_msg_q_t;
 
+// Handler of one event bit, see osal_register_event_handlers()
+typedef void (*osalEventHandler_t)( uint8 task_id );
+
+typedef struct
+{
+  uint16             event;     // Event bit(s) handled
+  osalEventHandler_t pfnHandler;
+} osalEventHandlerRec_t;
+
+#if ( OSAL_RUN_METRICS )
+typedef struct
+{
+  uint32 runs;      // Dispatches of the task
+  uint32 handled;   // Events run from the task's event handler table
+  uint32 waitSum;   // Total ms from an event being set to the dispatch
+  uint16 waitMax;   // Longest of those waits, in ms
+  uint16 passMax;   // Most dispatches of other tasks during one wait
+} osalTaskStats_t;
+#endif
+
 #ifdef USE_ICALL
 /* High resolution timer callback function type */
 typedef void (*osal_highres_timer_cback_t)(void *arg);
@@ -217,6 +242,18 @@ extern void (*osal_eventloop_hook)(void);
    */
   extern uint8 osal_clear_event( uint8 task_id, uint16 event_flag );
 
+  /*
+   * Register a table of event handlers run before the task's event loop
+   */
+  extern uint8 osal_register_event_handlers( uint8 task_id, const osalEventHandlerRec_t *pTable, uint8 cnt );
+
+#if ( OSAL_RUN_METRICS )
+  /*
+   * Get the dispatch counters of a task
+   */
+  extern uint8 osal_task_stats( uint8 task_id, osalTaskStats_t *pStats );
+#endif
+
 
 /*** Interrupt Management  ***/
 
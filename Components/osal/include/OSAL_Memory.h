@@ -58,6 +58,11 @@ extern "C"
   #define OSALMEM_METRICS  FALSE
 #endif
 
+// Size-class free lists in front of the heap (see OSAL_Memory.c).
+#if !defined ( OSALMEM_SLAB )
+  #define OSALMEM_SLAB  FALSE
+#endif
+
 /*********************************************************************
  * MACROS
  */
@@ -68,6 +73,18 @@ extern "C"
  * TYPEDEFS
  */
 
+#if ( OSALMEM_SLAB && OSALMEM_METRICS )
+typedef struct
+{
+  uint16 blkSz;   // Block size of the class, including the header.
+  uint16 cached;  // Free blocks held by the class right now.
+  uint16 cur;     // Blocks of the class handed out right now.
+  uint16 max;     // Most blocks of the class ever handed out at once.
+  uint32 hit;     // Allocations served from the class free list.
+  uint32 miss;    // Allocations that had to search the heap.
+} osalMemSlabStats_t;
+#endif
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -128,11 +145,25 @@ extern "C"
   uint16 osal_heap_mem_used( void );
 #endif
 
+#if ( OSALMEM_SLAB )
+ /*
+  * Return the blocks held by the size-class free lists to the heap.
+  */
+  void osal_mem_slab_flush( void );
+#endif
+
 #if defined (ZTOOL_P1) || defined (ZTOOL_P2)
  /*
   * Return the highest number of bytes ever used in the heap.
   */
   uint16 osal_heap_high_water( void );
+
+#if ( OSALMEM_SLAB && OSALMEM_METRICS )
+ /*
+  * Return the hit/miss/high-water counters of a size class.
+  */
+  uint8 osal_heap_slab_stats( uint8 cls, osalMemSlabStats_t *pStats );
+#endif
 #endif
 
 /*********************************************************************
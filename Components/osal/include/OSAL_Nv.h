@@ -55,6 +55,31 @@ extern "C"
  * CONSTANTS
  */
 
+// Entries of the RAM directory of NV item locations (see OSAL_Nv.c), 0 for none.
+#if !defined ( OSAL_NV_DIR_MAX )
+  #define OSAL_NV_DIR_MAX  32
+#endif
+
+/* Small partial writes can be appended as delta records of the item instead of copying the
+ * whole item (see OSAL_Nv.c). OSAL_NV_JRN_ITEMS items can have up to OSAL_NV_JRN_DEPTH records
+ * of up to OSAL_NV_JRN_DATA_MAX bytes each. 0 items for none: the records are not understood
+ * by builds without the journal, so it is off unless the product enables it.
+ */
+#if !defined ( OSAL_NV_JRN_ITEMS )
+  #define OSAL_NV_JRN_ITEMS  0
+#endif
+#if !defined ( OSAL_NV_JRN_DEPTH )
+  #define OSAL_NV_JRN_DEPTH  4
+#endif
+#if !defined ( OSAL_NV_JRN_DATA_MAX )
+  #define OSAL_NV_JRN_DATA_MAX  16
+#endif
+
+// Writes of up to OSAL_NV_JRN_DATA_MAX bytes held by osal_nv_write_defer(), 0 for none.
+#if !defined ( OSAL_NV_DEFER_CNT )
+  #define OSAL_NV_DEFER_CNT  0
+#endif
+
 /*********************************************************************
  * MACROS
  */
@@ -63,6 +88,30 @@ extern "C"
  * TYPEDEFS
  */
 
+#if ( OSAL_NV_DIR_MAX )
+typedef struct
+{
+  uint32 hits;      // Lookups answered by the directory.
+  uint32 absent;    // Lookups of missing Ids answered by the directory.
+  uint32 scans;     // Lookups that had to walk the NV pages.
+  uint8  cnt;       // Items in the directory.
+  uint8  max;       // OSAL_NV_DIR_MAX.
+  uint8  complete;  // TRUE while every item in NV is in the directory.
+} osalNvDirStats_t;
+#endif
+
+#if ( OSAL_NV_JRN_ITEMS || OSAL_NV_DEFER_CNT )
+typedef struct
+{
+  uint32 appends;   // Writes stored as a delta record.
+  uint32 copies;    // Writes that copied the item.
+  uint32 deferred;  // Writes taken by osal_nv_write_defer().
+  uint32 flushed;   // Item writes made by osal_nv_flush().
+  uint32 failed;    // Deferred writes that failed when flushed.
+  uint8  items;     // Items with delta records.
+} osalNvJrnStats_t;
+#endif
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -101,6 +150,30 @@ extern uint16 osal_nv_item_len( uint16 id );
  */
 extern uint8 osal_nv_delete( uint16 id, uint16 len );
 
+/*
+ * Write an NV attribute at the end of the current OSAL task event.
+ */
+extern uint8 osal_nv_write_defer( uint16 id, uint16 offset, uint16 len, void *buf );
+
+/*
+ * Write the deferred NV attributes.
+ */
+extern void osal_nv_flush( void );
+
+#if ( OSAL_NV_DIR_MAX )
+/*
+ * Get the item directory counters.
+ */
+extern void osal_nv_dir_stats( osalNvDirStats_t *pStats );
+#endif
+
+#if ( OSAL_NV_JRN_ITEMS || OSAL_NV_DEFER_CNT )
+/*
+ * Get the journal and deferred write counters.
+ */
+extern void osal_nv_jrn_stats( osalNvJrnStats_t *pStats );
+#endif
+
 #if defined ( OSAL_NV_EXTENDED )
 /*
  * Initialize an item in NV (extended format)
@@ -50,6 +50,7 @@
 #include "hal_adc.h"
 #include "hal_flash.h"
 #include "hal_types.h"
+#include "OSAL.h"
 #include "OSAL_Nv.h"
 #include "ZComDef.h"
 #ifdef HAL_MCU_CC2533
@@ -89,6 +90,37 @@ static const uint16 hotIds[OSAL_NV_MAX_HOT] = {
   ZCD_NV_NWK_ALTERN_KEY_INFO,
 };
 
+/* The item directory keeps the page and data offset of up to OSAL_NV_DIR_MAX item Ids in RAM,
+ * sorted by Id. It is built by initNV() and kept current by every item write, compaction,
+ * zeroing and page erase, so findItem() does not walk the pages for the Ids it holds. While it
+ * holds every item in NV it also answers for the Ids that do not exist. Each entry is 5 bytes.
+ */
+#if OSAL_NV_DIR_MAX > 255
+#error "OSAL_NV_DIR_MAX must fit in a uint8"
+#endif
+
+#define OSAL_NV_DIR_OFF         0  // Not built yet (initNV() in progress).
+#define OSAL_NV_DIR_COMPLETE    1  // Every item in NV is in the directory.
+#define OSAL_NV_DIR_PARTIAL     2  // Items may be missing: a miss walks the pages.
+
+/* A delta record is stored as an item whose Id is the Id of the item it patches with the MSB set;
+ * item Ids are below 0x8000, so no item search ever matches one. Its data is the item index the
+ * patch applies at (little-endian) followed by the patch bytes. The records of an item copy are
+ * the live records with its Id that follow it on the same page, applied in page order: a new
+ * copy made by osal_nv_write() or compactPage() has them folded in. The RAM journal indexes the
+ * records of up to OSAL_NV_JRN_ITEMS item copies for the reads; initNV() builds it.
+ */
+#define OSAL_NV_JRN_ID          0x8000
+#define OSAL_NV_JRN_HDR         2   // Item index at the start of the record data.
+#define OSAL_NV_JRN_CHUNK       16  // Bytes read at a time when folding records into a copy.
+
+#if OSAL_NV_JRN_DEPTH > 255
+#error "OSAL_NV_JRN_DEPTH must fit in a uint8"
+#endif
+#if OSAL_NV_JRN_DATA_MAX > 255
+#error "OSAL_NV_JRN_DATA_MAX must fit in a uint8"
+#endif
+
 /*********************************************************************
  * MACROS
  */
@@ -97,6 +129,8 @@ static const uint16 hotIds[OSAL_NV_MAX_HOT] = {
 #define OSAL_NV_CHECK_BUS_VOLTAGE  HalAdcCheckVdd(VDD_MIN_NV)
 #elif defined HAL_MCU_CC2533
 # define  OSAL_NV_CHECK_BUS_VOLTAGE  (HalBatMonRead( HAL_BATMON_MIN_FLASH ))
+#elif defined HAL_MCU_HOST
+# define  OSAL_NV_CHECK_BUS_VOLTAGE  TRUE
 #else
 # warning No implementation of a low Vdd check.
 # define  OSAL_NV_CHECK_BUS_VOLTAGE
@@ -167,6 +201,36 @@ typedef enum
   eNvZero
 } eNvHdrEnum;
 
+#if OSAL_NV_DIR_MAX
+typedef struct
+{
+  uint16 id;
+  uint16 off;   // Offset of the item data, as returned by findItem().
+  uint8  pg;
+} osalNvDirEnt_t;
+#endif
+
+#if OSAL_NV_JRN_ITEMS
+typedef struct
+{
+  uint16 off;                     // Offset of the data of the item copy the records patch.
+  uint16 chk;                     // Checksum of the item data with the records applied.
+  uint8  pg;                      // OSAL_NV_PAGE_NULL for a free entry.
+  uint8  cnt;
+  uint16 rec[OSAL_NV_JRN_DEPTH];  // Offsets of the record data, oldest first.
+} osalNvJrnEnt_t;
+#endif
+
+#if OSAL_NV_DEFER_CNT
+typedef struct
+{
+  uint16 id;
+  uint16 ndx;
+  uint16 len;
+  uint8  buf[OSAL_NV_JRN_DATA_MAX];
+} osalNvDeferEnt_t;
+#endif
+
 typedef enum
 {
   ePgActive,
@@ -206,6 +270,30 @@ static uint8 findPg;
 static uint8 hotPg[OSAL_NV_MAX_HOT];
 static uint16 hotOff[OSAL_NV_MAX_HOT];
 
+#if OSAL_NV_DIR_MAX
+// Item directory, sorted by Id.
+static osalNvDirEnt_t nvDir[OSAL_NV_DIR_MAX];
+static uint8 nvDirCnt;
+static uint8 nvDirState = OSAL_NV_DIR_OFF;
+static uint32 nvDirHits, nvDirAbsent, nvDirScans;
+#endif
+
+#if OSAL_NV_JRN_ITEMS
+// Delta record journal. Until initNV() has built it, records are found by walking the page.
+static osalNvJrnEnt_t nvJrn[OSAL_NV_JRN_ITEMS];
+static uint8 nvJrnBuilt;
+#endif
+
+#if OSAL_NV_DEFER_CNT
+// Writes held by osal_nv_write_defer() until osal_nv_flush(), oldest first.
+static osalNvDeferEnt_t nvDefer[OSAL_NV_DEFER_CNT];
+static uint8 nvDeferCnt;
+#endif
+
+#if ( OSAL_NV_JRN_ITEMS || OSAL_NV_DEFER_CNT )
+static osalNvJrnStats_t nvJrnStats;
+#endif
+
 /*********************************************************************
  * LOCAL FUNCTIONS
  */
@@ -235,6 +323,34 @@ static uint8  writeItem( uint8 pg, uint16 id, uint16 len, void *buf, uint8 flag
 static uint8  hotItem(uint16 id);
 static void   hotItemUpdate(uint8 pg, uint16 off, uint16 id);
 
+#if OSAL_NV_DIR_MAX
+static uint8  dirSearch( uint16 id, uint8 *pIdx );
+static void   dirSet( uint8 pg, uint16 off, uint16 id, uint8 replace );
+static void   dirDrop( uint8 pg, uint16 off, uint16 id );
+static void   dirDropPage( uint8 pg );
+static void   dirBuild( void );
+#endif
+
+#if OSAL_NV_JRN_ITEMS
+static osalNvJrnEnt_t *jrnFind( uint8 pg, uint16 off );
+static void   jrnPatch( uint8 pg, uint16 off, uint16 ndx, uint16 len, uint8 *buf );
+static void   jrnApply( osalNvJrnEnt_t *pJrn, uint16 ndx, uint16 len, uint8 *buf );
+static void   jrnScan( uint8 pg, uint16 off, uint16 ndx, uint16 len, uint8 *buf );
+static uint16 jrnXfer( uint8 srcPg, uint16 srcOff, uint16 ndx, uint8 dstPg, uint16 dstOff,
+                       uint16 len );
+static uint8  jrnAppend( uint8 pg, uint16 off, uint16 id, uint16 itemLen,
+                         uint16 ndx, uint16 len, uint8 *buf, uint16 chk );
+static void   jrnDrop( uint8 pg, uint16 off );
+static void   jrnDropPage( uint8 pg );
+static uint16 jrnBase( uint8 pg, uint16 end, uint16 id );
+static uint16 jrnChk( osalNvJrnEnt_t *pJrn );
+static void   jrnBuild( void );
+#endif
+
+#if OSAL_NV_DEFER_CNT
+static void   deferApply( uint16 id, uint16 ndx, uint16 len, uint8 *buf );
+#endif
+
 /*********************************************************************
  * @fn      initNV
  *
@@ -252,6 +368,16 @@ static uint8 initNV( void )
   uint8 pg;
 
   pgRes = OSAL_NV_PAGE_NULL;
+#if OSAL_NV_DIR_MAX
+  nvDirState = OSAL_NV_DIR_OFF;
+#endif
+#if OSAL_NV_JRN_ITEMS
+  osal_memset( nvJrn, 0, sizeof( nvJrn ) );
+  nvJrnBuilt = FALSE;
+#endif
+#if OSAL_NV_DEFER_CNT
+  nvDeferCnt = 0;
+#endif
 
   for ( pg = OSAL_NV_PAGE_BEG; pg <= OSAL_NV_PAGE_END; pg++ )
   {
@@ -351,6 +477,13 @@ static uint8 initNV( void )
     erasePage( pgRes );  // The last page erase had been interrupted by a power-cycle.
   }
 
+#if OSAL_NV_JRN_ITEMS
+  jrnBuild();
+#endif
+#if OSAL_NV_DIR_MAX
+  dirBuild();
+#endif
+
   return TRUE;
 }
 
@@ -452,7 +585,7 @@ static uint16 initPage( uint8 pg, uint16 id, uint8 findDups )
         {
           if ( findDups )
           {
-            if ( hdr.stat == OSAL_NV_ERASED_ID )
+            if ( (hdr.stat == OSAL_NV_ERASED_ID) && !(hdr.id & OSAL_NV_JRN_ID) )
             {
               /* The trick of setting the MSB of the item Id causes the logic
                * immediately above to return a valid page only if the header 'stat'
@@ -508,6 +641,13 @@ static void erasePage( uint8 pg )
 
   pgOff[pg - OSAL_NV_PAGE_BEG] = OSAL_NV_PAGE_HDR_SIZE;
   pgLost[pg - OSAL_NV_PAGE_BEG] = 0;
+
+#if OSAL_NV_JRN_ITEMS
+  jrnDropPage( pg );
+#endif
+#if OSAL_NV_DIR_MAX
+  dirDropPage( pg );
+#endif
 }
 
 /*********************************************************************
@@ -584,7 +724,8 @@ static uint8 compactPage( uint8 srcPg, uint16 skipId )
 
     srcOff += OSAL_NV_HDR_SIZE;
 
-    if ( (hdr.id != OSAL_NV_ZEROED_ID) && (hdr.id != skipId) )
+    // Delta records are folded into the copy of their item.
+    if ( (hdr.id != OSAL_NV_ZEROED_ID) && (hdr.id != skipId) && !(hdr.id & OSAL_NV_JRN_ID) )
     {
       if ( hdr.chk == calcChkF( srcPg, srcOff, hdr.len ) )
       {
@@ -599,7 +740,17 @@ static uint8 compactPage( uint8 srcPg, uint16 skipId )
         if ( writeItem( pgRes, hdr.id, hdr.len, NULL, FALSE ) )
         {
           dstOff += OSAL_NV_HDR_SIZE;
-          xferBuf( srcPg, srcOff, pgRes, dstOff, sz );
+#if OSAL_NV_JRN_ITEMS
+          if ( !nvJrnBuilt || (jrnFind( srcPg, srcOff ) != NULL) )
+          {
+            hdr.chk = jrnXfer( srcPg, srcOff, 0, pgRes, dstOff, hdr.len ) +
+                      (sz - hdr.len) * OSAL_NV_ERASED;
+          }
+          else
+#endif
+          {
+            xferBuf( srcPg, srcOff, pgRes, dstOff, sz );
+          }
           // Calculate and write the new checksum.
           if (hdr.chk == calcChkF(pgRes, dstOff, hdr.len))
           {
@@ -662,11 +813,40 @@ static uint16 findItem( uint16 id )
   uint16 off;
   uint8 pg;
 
+#if OSAL_NV_DIR_MAX
+  if ( (nvDirState != OSAL_NV_DIR_OFF) && ((id & OSAL_NV_SOURCE_ID) == 0) )
+  {
+    uint8 idx;
+
+    if ( dirSearch( id, &idx ) )
+    {
+      nvDirHits++;
+      findPg = nvDir[idx].pg;
+      return nvDir[idx].off;
+    }
+    else if ( nvDirState == OSAL_NV_DIR_COMPLETE )
+    {
+      nvDirAbsent++;
+      findPg = OSAL_NV_PAGE_NULL;
+      return OSAL_NV_ITEM_NULL;
+    }
+
+    nvDirScans++;
+  }
+#endif
+
   for ( pg = OSAL_NV_PAGE_BEG; pg <= OSAL_NV_PAGE_END; pg++ )
   {
     if ( (off = initPage( pg, id, FALSE )) != OSAL_NV_ITEM_NULL )
     {
       findPg = pg;
+#if OSAL_NV_DIR_MAX
+      if ( nvDirState != OSAL_NV_DIR_OFF )
+      {
+        // Keep it, unless this is the old copy of an item with a current one.
+        dirSet( pg, off, (id & ~OSAL_NV_SOURCE_ID), ((id & OSAL_NV_SOURCE_ID) == 0) );
+      }
+#endif
       return off;
     }
   }
@@ -811,6 +991,12 @@ static void setItem( uint8 pg, uint16 offset, eNvHdrEnum stat )
   {
     uint16 sz = ((hdr.len + (OSAL_NV_WORD_SIZE-1)) / OSAL_NV_WORD_SIZE) * OSAL_NV_WORD_SIZE +
                                                                           OSAL_NV_HDR_SIZE;
+#if OSAL_NV_JRN_ITEMS
+    jrnDrop( pg, offset + OSAL_NV_HDR_SIZE );
+#endif
+#if OSAL_NV_DIR_MAX
+    dirDrop( pg, offset + OSAL_NV_HDR_SIZE, hdr.id );
+#endif
     hdr.id = 0;
     writeWord( pg, offset, (uint8 *)(&hdr) );
     pgLost[pg-OSAL_NV_PAGE_BEG] += sz;
@@ -1173,7 +1359,8 @@ static uint8 hotItem(uint16 id)
 /*********************************************************************
  * @fn      hotItemUpdate
  *
- * @brief   If the parameter 'id' is a hot item, update the corresponding hot item data.
+ * @brief   If the parameter 'id' is a hot item, update the corresponding hot item data,
+ *          and update the item directory.
  *
  * @param   pg - The new NV page corresponding to the hot item.
  * @param   off - The new NV page offset corresponding to the hot item.
@@ -1185,6 +1372,17 @@ static void hotItemUpdate(uint8 pg, uint16 off, uint16 id)
 {
   uint8 hotIdx = hotItem(id);
 
+#if OSAL_NV_JRN_ITEMS
+  if ( id & OSAL_NV_JRN_ID )
+  {
+    return;  // A delta record written by jrnAppend().
+  }
+#endif
+#if OSAL_NV_DIR_MAX
+  // Every new current copy of an item comes through here.
+  dirSet( pg, off, id, TRUE );
+#endif
+
   if (hotIdx < OSAL_NV_MAX_HOT)
   {
     {
@@ -1194,189 +1392,935 @@ static void hotItemUpdate(uint8 pg, uint16 off, uint16 id)
   }
 }
 
+#if OSAL_NV_DIR_MAX
 /*********************************************************************
- * @fn      osal_nv_init
+ * @fn      dirSearch
  *
- * @brief   Initialize NV service.
+ * @brief   Binary search the item directory.
  *
- * @param   p - Not used.
+ * @param   id - A valid NV item Id.
+ * @param   pIdx - Index of the Id if found, else where it would be inserted.
  *
- * @return  none
+ * @return  TRUE if the Id is in the directory.
  */
-void osal_nv_init( void *p )
+static uint8 dirSearch( uint16 id, uint8 *pIdx )
 {
-  (void)p;  // Suppress Lint warning.
-  (void)initNV();  // Always returns TRUE after pages have been erased.
+  uint8 lo = 0;
+  uint8 hi = nvDirCnt;
+
+  while ( lo < hi )
+  {
+    uint8 mid = (uint8)((lo + hi) / 2);
+
+    if ( nvDir[mid].id < id )
+    {
+      lo = mid + 1;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+
+  *pIdx = lo;
+
+  return ( (lo < nvDirCnt) && (nvDir[lo].id == id) );
 }
 
 /*********************************************************************
- * @fn      osal_nv_item_init
+ * @fn      dirSet
  *
- * @brief   If the NV item does not already exist, it is created and
- *          initialized with the data passed to the function, if any.
- *          This function must be called before calling osal_nv_read() or
- *          osal_nv_write().
+ * @brief   Record the location of an item in the directory. When the directory is full the item
+ *          is left out and the directory stops answering for missing Ids.
  *
- * @param   id  - Valid NV item Id.
- * @param   len - Item length.
- * @param  *buf - Pointer to item initalization data. Set to NULL if none.
+ * @param   pg - NV page of the item.
+ * @param   off - Offset of the item data in the page.
+ * @param   id - A valid NV item Id.
+ * @param   replace - TRUE to move an Id already in the directory, FALSE to only add it.
  *
- * @return  NV_ITEM_UNINIT - Id did not exist and was created successfully.
- *          SUCCESS        - Id already existed, no action taken.
- *          NV_OPER_FAILED - Failure to find or create Id.
+ * @return  none
  */
-uint8 osal_nv_item_init( uint16 id, uint16 len, void *buf )
+static void dirSet( uint8 pg, uint16 off, uint16 id, uint8 replace )
 {
-  uint16 offset;
+  uint8 idx;
 
-  if ( !OSAL_NV_CHECK_BUS_VOLTAGE )
-  {
-    return NV_OPER_FAILED;
-  }
-  else if ((offset = findItem(id)) != OSAL_NV_ITEM_NULL)
+  if ( !dirSearch( id, &idx ) )
   {
-    // Re-populate the NV hot item data if the corresponding items are already established.
-    hotItemUpdate(findPg, offset, id);
+    uint8 cnt;
 
-    return SUCCESS;
+    if ( nvDirCnt == OSAL_NV_DIR_MAX )
+    {
+      nvDirState = OSAL_NV_DIR_PARTIAL;
+      return;
+    }
+
+    for ( cnt = nvDirCnt; cnt > idx; cnt-- )
+    {
+      nvDir[cnt] = nvDir[cnt - 1];
+    }
+    nvDirCnt++;
+    nvDir[idx].id = id;
   }
-  else if ( initItem( TRUE, id, len, buf ) != OSAL_NV_PAGE_NULL )
+  else if ( !replace )
   {
-    return NV_ITEM_UNINIT;
+    return;
   }
-  else
+
+  nvDir[idx].pg = pg;
+  nvDir[idx].off = off;
+}
+
+/*********************************************************************
+ * @fn      dirDrop
+ *
+ * @brief   An item is zeroed out: remove it from the directory if it is the copy recorded there.
+ *
+ * @param   pg - NV page of the item.
+ * @param   off - Offset of the item data in the page.
+ * @param   id - A valid NV item Id.
+ *
+ * @return  none
+ */
+static void dirDrop( uint8 pg, uint16 off, uint16 id )
+{
+  uint8 idx;
+
+  if ( dirSearch( id, &idx ) && (nvDir[idx].pg == pg) && (nvDir[idx].off == off) )
   {
-    return NV_OPER_FAILED;
+    nvDirCnt--;
+    for ( ; idx < nvDirCnt; idx++ )
+    {
+      nvDir[idx] = nvDir[idx + 1];
+    }
   }
 }
 
 /*********************************************************************
- * @fn      osal_nv_item_len
+ * @fn      dirDropPage
  *
- * @brief   Get the data length of the item stored in NV memory.
+ * @brief   A page is erased: remove its items from the directory. Items still recorded there
+ *          only when a compaction onto the page was abandoned, and their older copies are still
+ *          in NV, so the directory no longer answers for missing Ids.
  *
- * @param   id  - Valid NV item Id.
+ * @param   pg - Valid NV page.
  *
- * @return  Item length, if found; zero otherwise.
+ * @return  none
  */
-uint16 osal_nv_item_len( uint16 id )
+static void dirDropPage( uint8 pg )
 {
-  osalNvHdr_t hdr;
-  uint16 offset;
-  uint8 hotIdx;
+  uint8 src, dst = 0;
 
-  if ((hotIdx = hotItem(id)) < OSAL_NV_MAX_HOT)
+  for ( src = 0; src < nvDirCnt; src++ )
   {
-    findPg = hotPg[hotIdx];
-    offset = hotOff[hotIdx];
+    if ( nvDir[src].pg != pg )
+    {
+      nvDir[dst++] = nvDir[src];
+    }
   }
-  else if ((offset = findItem(id)) == OSAL_NV_ITEM_NULL)
+
+  if ( dst != nvDirCnt )
   {
-    return 0;
+    nvDirCnt = dst;
+    if ( nvDirState != OSAL_NV_DIR_OFF )
+    {
+      nvDirState = OSAL_NV_DIR_PARTIAL;
+    }
   }
-
-  HalFlashRead(findPg, (offset - OSAL_NV_HDR_SIZE), (uint8 *)(&hdr), OSAL_NV_HDR_SIZE);
-  return hdr.len;
 }
 
 /*********************************************************************
- * @fn      osal_nv_write
+ * @fn      dirBuild
  *
- * @brief   Write a data item to NV. Function can write an entire item to NV or
- *          an element of an item by indexing into the item with an offset.
+ * @brief   Build the directory from the item headers once initNV() has validated the pages.
+ *          An item only found as the old copy of an interrupted write is recorded as such,
+ *          as findItem() would return it.
  *
- * @param   id  - Valid NV item Id.
- * @param   ndx - Index offset into item
- * @param   len - Length of data to write.
- * @param  *buf - Data to write.
+ * @param   none
  *
- * @return  SUCCESS if successful, NV_ITEM_UNINIT if item did not
- *          exist in NV and offset is non-zero, NV_OPER_FAILED if failure.
+ * @return  none
  */
-uint8 osal_nv_write( uint16 id, uint16 ndx, uint16 len, void *buf )
+static void dirBuild( void )
 {
-  uint8 rtrn = SUCCESS;
+  uint8 pg;
 
-  if ( !OSAL_NV_CHECK_BUS_VOLTAGE )
-  {
-    return NV_OPER_FAILED;
-  }
-  else if ( len != 0 )
+  nvDirCnt = 0;
+  nvDirState = OSAL_NV_DIR_COMPLETE;
+
+  for ( pg = OSAL_NV_PAGE_BEG; pg <= OSAL_NV_PAGE_END; pg++ )
   {
+    uint16 offset = OSAL_NV_PAGE_HDR_SIZE;
     osalNvHdr_t hdr;
-    uint16 origOff, srcOff;
-    uint16 cnt, chk;
-    uint8 *ptr, srcPg;
 
-    origOff = srcOff = findItem( id );
-    srcPg = findPg;
-    if ( srcOff == OSAL_NV_ITEM_NULL )
+    if ( pg == pgRes )
     {
-      return NV_ITEM_UNINIT;
+      continue;
     }
 
-    HalFlashRead(srcPg, (srcOff - OSAL_NV_HDR_SIZE), (uint8 *)(&hdr), OSAL_NV_HDR_SIZE);
-    if ( hdr.len < (ndx + len) )
+    while ( offset < (OSAL_NV_PAGE_SIZE - OSAL_NV_HDR_SIZE) )
     {
-      return NV_OPER_FAILED;
-    }
+      uint16 sz;
 
-    srcOff += ndx;
-    ptr = buf;
-    cnt = len;
-    chk = 0;
-    while ( cnt-- )
-    {
-      uint8 tmp;
-      HalFlashRead(srcPg, srcOff, &tmp, 1);
-      if ( tmp != *ptr )
+      HalFlashRead(pg, offset, (uint8 *)(&hdr), OSAL_NV_HDR_SIZE);
+      if ( hdr.id == OSAL_NV_ERASED_ID )
       {
-        chk = 1;  // Mark that at least one byte is different.
-        // Calculate expected checksum after transferring old data and writing new data.
-        hdr.chk -= tmp;
-        hdr.chk += *ptr;
+        break;
       }
-      srcOff++;
-      ptr++;
-    }
 
-    if ( chk != 0 )  // If the buffer to write is different in one or more bytes.
-    {
-      uint8 comPg = OSAL_NV_PAGE_NULL;
-      uint8 dstPg = initItem( FALSE, id, hdr.len, &comPg );
+      sz = OSAL_NV_DATA_SIZE( hdr.len );
+      if ( sz > (OSAL_NV_PAGE_SIZE - OSAL_NV_HDR_SIZE - offset) )
+      {
+        break;
+      }
 
-      if ( dstPg != OSAL_NV_PAGE_NULL )
+      offset += OSAL_NV_HDR_SIZE;
+      if ( (hdr.id != OSAL_NV_ZEROED_ID) && !(hdr.id & OSAL_NV_JRN_ID) )
       {
-        uint16 tmp = OSAL_NV_DATA_SIZE( hdr.len );
-        uint16 dstOff = pgOff[dstPg-OSAL_NV_PAGE_BEG] - tmp;
-        srcOff = origOff;
+        dirSet( pg, offset, hdr.id, (hdr.stat == OSAL_NV_ERASED_ID) );
+      }
+      offset += sz;
+    }
+  }
+}
 
-        /* Prevent excessive re-writes to item header caused by numerous, rapid, & successive
-         * OSAL_Nv interruptions caused by resets.
-         */
-        if ( hdr.stat == OSAL_NV_ERASED_ID )
-        {
-          setItem( srcPg, srcOff, eNvXfer );
-        }
+/*********************************************************************
+ * @fn      osal_nv_dir_stats
+ *
+ * @brief   Get the item directory counters.
+ *
+ * @param   pStats - Counters.
+ *
+ * @return  none
+ */
+void osal_nv_dir_stats( osalNvDirStats_t *pStats )
+{
+  pStats->hits = nvDirHits;
+  pStats->absent = nvDirAbsent;
+  pStats->scans = nvDirScans;
+  pStats->cnt = nvDirCnt;
+  pStats->max = OSAL_NV_DIR_MAX;
+  pStats->complete = (nvDirState == OSAL_NV_DIR_COMPLETE);
+}
+#endif // OSAL_NV_DIR_MAX
 
-        xferBuf( srcPg, srcOff, dstPg, dstOff, ndx );
-        srcOff += ndx;
-        dstOff += ndx;
+#if OSAL_NV_JRN_ITEMS
+/*********************************************************************
+ * @fn      jrnFind
+ *
+ * @brief   Look up the journal entry of an item copy.
+ *
+ * @param   pg - NV page of the item, OSAL_NV_PAGE_NULL to get a free entry.
+ * @param   off - Offset of the item data in the page, 0 to get a free entry.
+ *
+ * @return  The entry, or NULL if the item copy has no delta records.
+ */
+static osalNvJrnEnt_t *jrnFind( uint8 pg, uint16 off )
+{
+  uint8 idx;
 
-        writeBuf( dstPg, dstOff, len, buf );
-        srcOff += len;
-        dstOff += len;
+  for ( idx = 0; idx < OSAL_NV_JRN_ITEMS; idx++ )
+  {
+    if ( (nvJrn[idx].pg == pg) && (nvJrn[idx].off == off) )
+    {
+      return &nvJrn[idx];
+    }
+  }
 
-        xferBuf( srcPg, srcOff, dstPg, dstOff, (hdr.len-ndx-len) );
+  return NULL;
+}
 
-        // Calculate and write the new checksum.
-        dstOff = pgOff[dstPg-OSAL_NV_PAGE_BEG] - tmp;
+/*********************************************************************
+ * @fn      jrnPatch
+ *
+ * @brief   Apply the part of a delta record that falls in a range of the item data.
+ *
+ * @param   pg - NV page of the record.
+ * @param   off - Offset of the record data in the page.
+ * @param   ndx - Item index of the first byte in 'buf'.
+ * @param   len - Byte count of 'buf'.
+ * @param   buf - Item data to patch.
+ *
+ * @return  none
+ */
+static void jrnPatch( uint8 pg, uint16 off, uint16 ndx, uint16 len, uint8 *buf )
+{
+  uint8 tmp[OSAL_NV_JRN_HDR];
+  uint16 recLen, recNdx, beg, end;
 
-        if ( hdr.chk == calcChkF( dstPg, dstOff, hdr.len ) )
-        {
-          if ( hdr.chk != setChk( dstPg, dstOff, hdr.chk ) )
-          {
-            rtrn = NV_OPER_FAILED;
+  HalFlashRead(pg, off - OSAL_NV_HDR_SIZE + OSAL_NV_HDR_LEN, (uint8 *)(&recLen), sizeof( recLen ));
+  HalFlashRead(pg, off, tmp, OSAL_NV_JRN_HDR);
+  recNdx = BUILD_UINT16( tmp[0], tmp[1] );
+  recLen -= OSAL_NV_JRN_HDR;
+
+  beg = (recNdx > ndx) ? recNdx : ndx;
+  end = ((recNdx + recLen) < (ndx + len)) ? (recNdx + recLen) : (ndx + len);
+
+  if ( beg < end )
+  {
+    HalFlashRead(pg, off + OSAL_NV_JRN_HDR + (beg - recNdx), buf + (beg - ndx), end - beg);
+  }
+}
+
+/*********************************************************************
+ * @fn      jrnApply
+ *
+ * @brief   Apply the indexed delta records of an item copy to a range of its data.
+ *
+ * @param   pJrn - Journal entry of the item copy.
+ * @param   ndx - Item index of the first byte in 'buf'.
+ * @param   len - Byte count of 'buf'.
+ * @param   buf - Item data read from the copy.
+ *
+ * @return  none
+ */
+static void jrnApply( osalNvJrnEnt_t *pJrn, uint16 ndx, uint16 len, uint8 *buf )
+{
+  uint8 idx;
+
+  for ( idx = 0; idx < pJrn->cnt; idx++ )
+  {
+    jrnPatch( pJrn->pg, pJrn->rec[idx], ndx, len, buf );
+  }
+}
+
+/*********************************************************************
+ * @fn      jrnScan
+ *
+ * @brief   Apply the delta records of an item copy found by walking the rest of its page.
+ *          Used while initNV() has not built the journal yet.
+ *
+ * @param   pg - NV page of the item.
+ * @param   off - Offset of the item data in the page.
+ * @param   ndx - Item index of the first byte in 'buf'.
+ * @param   len - Byte count of 'buf'.
+ * @param   buf - Item data read from the copy.
+ *
+ * @return  none
+ */
+static void jrnScan( uint8 pg, uint16 off, uint16 ndx, uint16 len, uint8 *buf )
+{
+  osalNvHdr_t hdr;
+  uint16 id;
+
+  HalFlashRead(pg, off - OSAL_NV_HDR_SIZE, (uint8 *)(&hdr), OSAL_NV_HDR_SIZE);
+  id = hdr.id | OSAL_NV_JRN_ID;
+  off += OSAL_NV_DATA_SIZE( hdr.len );
+
+  while ( off < (OSAL_NV_PAGE_SIZE - OSAL_NV_HDR_SIZE) )
+  {
+    uint16 sz;
+
+    HalFlashRead(pg, off, (uint8 *)(&hdr), OSAL_NV_HDR_SIZE);
+    if ( hdr.id == OSAL_NV_ERASED_ID )
+    {
+      break;
+    }
+
+    sz = OSAL_NV_DATA_SIZE( hdr.len );
+    if ( sz > (OSAL_NV_PAGE_SIZE - OSAL_NV_HDR_SIZE - off) )
+    {
+      break;
+    }
+
+    off += OSAL_NV_HDR_SIZE;
+    if ( (hdr.id == id) && (hdr.chk == calcChkF( pg, off, hdr.len )) )
+    {
+      jrnPatch( pg, off, ndx, len, buf );
+    }
+    off += sz;
+  }
+}
+
+/*********************************************************************
+ * @fn      jrnXfer
+ *
+ * @brief   Copy a range of item data with its delta records applied.
+ *
+ * @param   srcPg - NV page of the item copy.
+ * @param   srcOff - Offset of the item data in the page.
+ * @param   ndx - Item index of the first byte to copy.
+ * @param   dstPg - Destination NV page.
+ * @param   dstOff - Destination offset of the first byte.
+ * @param   len - Byte count to copy.
+ *
+ * @return  Byte-wise checksum of the data written.
+ */
+static uint16 jrnXfer( uint8 srcPg, uint16 srcOff, uint16 ndx, uint8 dstPg, uint16 dstOff,
+                       uint16 len )
+{
+  osalNvJrnEnt_t *pJrn = jrnFind( srcPg, srcOff );
+  uint16 chk = 0;
+
+  while ( len )
+  {
+    uint8 tmp[OSAL_NV_JRN_CHUNK];
+    uint8 cnt = (len < OSAL_NV_JRN_CHUNK) ? (uint8)len : OSAL_NV_JRN_CHUNK;
+    uint8 idx;
+
+    HalFlashRead(srcPg, srcOff + ndx, tmp, cnt);
+    if ( !nvJrnBuilt )
+    {
+      jrnScan( srcPg, srcOff, ndx, cnt, tmp );
+    }
+    else if ( pJrn != NULL )
+    {
+      jrnApply( pJrn, ndx, cnt, tmp );
+    }
+
+    writeBuf( dstPg, dstOff, cnt, tmp );
+    for ( idx = 0; idx < cnt; idx++ )
+    {
+      chk += tmp[idx];
+    }
+
+    ndx += cnt;
+    dstOff += cnt;
+    len -= cnt;
+  }
+
+  return chk;
+}
+
+/*********************************************************************
+ * @fn      jrnAppend
+ *
+ * @brief   Write a partial item write as a delta record on the page of the item copy, if the
+ *          record is smaller than a new copy, fits on the page and can be indexed.
+ *
+ * @param   pg - NV page of the item copy.
+ * @param   off - Offset of the item data in the page.
+ * @param   id - Valid NV item Id.
+ * @param   itemLen - Item data length.
+ * @param   ndx - Index offset into the item.
+ * @param   len - Length of data to write.
+ * @param   buf - Data to write.
+ * @param   chk - Checksum of the item data once written.
+ *
+ * @return  TRUE if the record is written; FALSE if the caller has to copy the item.
+ */
+static uint8 jrnAppend( uint8 pg, uint16 off, uint16 id, uint16 itemLen,
+                        uint16 ndx, uint16 len, uint8 *buf, uint16 chk )
+{
+  uint8 rec[OSAL_NV_JRN_HDR + OSAL_NV_JRN_DATA_MAX];
+  uint16 sz = OSAL_NV_ITEM_SIZE( len + OSAL_NV_JRN_HDR );
+  uint16 recOff = pgOff[pg - OSAL_NV_PAGE_BEG];
+  osalNvJrnEnt_t *pJrn;
+
+  if ( !nvJrnBuilt || (len > OSAL_NV_JRN_DATA_MAX) || (sz >= OSAL_NV_ITEM_SIZE( itemLen )) ||
+       (sz > (OSAL_NV_PAGE_SIZE - recOff)) )
+  {
+    return FALSE;
+  }
+
+  if ( (pJrn = jrnFind( pg, off )) == NULL )
+  {
+    if ( (pJrn = jrnFind( OSAL_NV_PAGE_NULL, 0 )) == NULL )
+    {
+      return FALSE;
+    }
+    pJrn->cnt = 0;
+  }
+  else if ( pJrn->cnt == OSAL_NV_JRN_DEPTH )
+  {
+    return FALSE;  // The copy folds the records.
+  }
+
+  rec[0] = LO_UINT16( ndx );
+  rec[1] = HI_UINT16( ndx );
+  osal_memcpy( rec + OSAL_NV_JRN_HDR, buf, len );
+
+  if ( !writeItem( pg, (id | OSAL_NV_JRN_ID), (len + OSAL_NV_JRN_HDR), rec, TRUE ) )
+  {
+    return FALSE;  // A bad record is never indexed; initNV() zeroes it.
+  }
+
+  pJrn->pg = pg;
+  pJrn->off = off;
+  pJrn->chk = chk;
+  pJrn->rec[pJrn->cnt++] = recOff + OSAL_NV_HDR_SIZE;
+  nvJrnStats.appends++;
+
+  return TRUE;
+}
+
+/*********************************************************************
+ * @fn      jrnDrop
+ *
+ * @brief   An item copy is zeroed out: zero out its delta records first, so that they can
+ *          never be applied to anything else.
+ *
+ * @param   pg - NV page of the item.
+ * @param   off - Offset of the item data in the page.
+ *
+ * @return  none
+ */
+static void jrnDrop( uint8 pg, uint16 off )
+{
+  osalNvJrnEnt_t *pJrn = jrnFind( pg, off );
+
+  if ( pJrn != NULL )
+  {
+    uint8 idx;
+
+    pJrn->pg = OSAL_NV_PAGE_NULL;
+    pJrn->off = 0;
+
+    for ( idx = 0; idx < pJrn->cnt; idx++ )
+    {
+      setItem( pg, pJrn->rec[idx], eNvZero );
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      jrnDropPage
+ *
+ * @brief   A page is erased: free the journal entries of its items.
+ *
+ * @param   pg - Valid NV page.
+ *
+ * @return  none
+ */
+static void jrnDropPage( uint8 pg )
+{
+  uint8 idx;
+
+  for ( idx = 0; idx < OSAL_NV_JRN_ITEMS; idx++ )
+  {
+    if ( nvJrn[idx].pg == pg )
+    {
+      nvJrn[idx].pg = OSAL_NV_PAGE_NULL;
+      nvJrn[idx].off = 0;
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      jrnBase
+ *
+ * @brief   Find the item copy a delta record patches: the last live copy of the item before it.
+ *
+ * @param   pg - NV page of the record.
+ * @param   end - Offset of the record header in the page.
+ * @param   id - Valid NV item Id.
+ *
+ * @return  Offset of the item data, or OSAL_NV_ITEM_NULL if the record is left over from a
+ *          copy that has been zeroed out.
+ */
+static uint16 jrnBase( uint8 pg, uint16 end, uint16 id )
+{
+  uint16 offset = OSAL_NV_PAGE_HDR_SIZE;
+  uint16 base = OSAL_NV_ITEM_NULL;
+
+  while ( offset < end )
+  {
+    osalNvHdr_t hdr;
+
+    HalFlashRead(pg, offset, (uint8 *)(&hdr), OSAL_NV_HDR_SIZE);
+    offset += OSAL_NV_HDR_SIZE;
+    if ( hdr.id == id )
+    {
+      base = offset;
+    }
+    offset += OSAL_NV_DATA_SIZE( hdr.len );
+  }
+
+  return base;
+}
+
+/*********************************************************************
+ * @fn      jrnChk
+ *
+ * @brief   Calculate the checksum of an item copy with its delta records applied.
+ *
+ * @param   pJrn - Journal entry of the item copy.
+ *
+ * @return  The checksum.
+ */
+static uint16 jrnChk( osalNvJrnEnt_t *pJrn )
+{
+  uint16 len, ndx, chk;
+
+  HalFlashRead(pJrn->pg, pJrn->off - OSAL_NV_HDR_SIZE + OSAL_NV_HDR_LEN,
+               (uint8 *)(&len), sizeof( len ));
+  chk = (OSAL_NV_DATA_SIZE( len ) - len) * OSAL_NV_ERASED;
+
+  for ( ndx = 0; ndx < len; )
+  {
+    uint8 tmp[OSAL_NV_JRN_CHUNK];
+    uint8 cnt = ((len - ndx) < OSAL_NV_JRN_CHUNK) ? (uint8)(len - ndx) : OSAL_NV_JRN_CHUNK;
+    uint8 idx;
+
+    HalFlashRead(pJrn->pg, pJrn->off + ndx, tmp, cnt);
+    jrnApply( pJrn, ndx, cnt, tmp );
+    for ( idx = 0; idx < cnt; idx++ )
+    {
+      chk += tmp[idx];
+    }
+    ndx += cnt;
+  }
+
+  return chk;
+}
+
+/*********************************************************************
+ * @fn      jrnBuild
+ *
+ * @brief   Index the delta records once initNV() has validated the pages. Records left over
+ *          from zeroed copies are zeroed out. A page with more records than the journal can
+ *          hold (e.g. after OSAL_NV_JRN_ITEMS was lowered) is compacted to fold them.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void jrnBuild( void )
+{
+  uint8 tries;
+
+  for ( tries = 0; tries < OSAL_NV_PAGES_USED; tries++ )
+  {
+    uint8 full = OSAL_NV_PAGE_NULL;
+    uint8 pg;
+
+    osal_memset( nvJrn, 0, sizeof( nvJrn ) );
+
+    for ( pg = OSAL_NV_PAGE_BEG; pg <= OSAL_NV_PAGE_END; pg++ )
+    {
+      uint16 offset = OSAL_NV_PAGE_HDR_SIZE;
+      osalNvHdr_t hdr;
+
+      if ( pg == pgRes )
+      {
+        continue;
+      }
+
+      while ( offset < (OSAL_NV_PAGE_SIZE - OSAL_NV_HDR_SIZE) )
+      {
+        uint16 sz;
+
+        HalFlashRead(pg, offset, (uint8 *)(&hdr), OSAL_NV_HDR_SIZE);
+        if ( hdr.id == OSAL_NV_ERASED_ID )
+        {
+          break;
+        }
+
+        sz = OSAL_NV_DATA_SIZE( hdr.len );
+        if ( sz > (OSAL_NV_PAGE_SIZE - OSAL_NV_HDR_SIZE - offset) )
+        {
+          break;
+        }
+
+        offset += OSAL_NV_HDR_SIZE;
+        if ( (hdr.id != OSAL_NV_ZEROED_ID) && (hdr.id & OSAL_NV_JRN_ID) )
+        {
+          uint16 base = jrnBase( pg, offset - OSAL_NV_HDR_SIZE, (hdr.id & ~OSAL_NV_JRN_ID) );
+          osalNvJrnEnt_t *pJrn;
+
+          if ( base == OSAL_NV_ITEM_NULL )
+          {
+            setItem( pg, offset, eNvZero );
+          }
+          else if ( (((pJrn = jrnFind( pg, base )) == NULL) &&
+                     ((pJrn = jrnFind( OSAL_NV_PAGE_NULL, 0 )) == NULL)) ||
+                    (pJrn->cnt == OSAL_NV_JRN_DEPTH) )
+          {
+            full = pg;
+          }
+          else
+          {
+            pJrn->pg = pg;
+            pJrn->off = base;
+            pJrn->rec[pJrn->cnt++] = offset;
+          }
+        }
+        offset += sz;
+      }
+    }
+
+    // Compacting the page before the journal is built folds the records by walking it.
+    if ( (full == OSAL_NV_PAGE_NULL) || !compactPage( full, OSAL_NV_ITEM_NULL ) )
+    {
+      break;
+    }
+  }
+
+  nvJrnBuilt = TRUE;
+
+  for ( tries = 0; tries < OSAL_NV_JRN_ITEMS; tries++ )
+  {
+    if ( nvJrn[tries].pg != OSAL_NV_PAGE_NULL )
+    {
+      nvJrn[tries].chk = jrnChk( &nvJrn[tries] );
+    }
+  }
+}
+#endif // OSAL_NV_JRN_ITEMS
+
+#if OSAL_NV_DEFER_CNT
+/*********************************************************************
+ * @fn      deferApply
+ *
+ * @brief   Apply the deferred writes of an item to data read from NV.
+ *
+ * @param   id - Valid NV item Id.
+ * @param   ndx - Item index of the first byte in 'buf'.
+ * @param   len - Byte count of 'buf'.
+ * @param   buf - Item data.
+ *
+ * @return  none
+ */
+static void deferApply( uint16 id, uint16 ndx, uint16 len, uint8 *buf )
+{
+  uint8 idx;
+
+  for ( idx = 0; idx < nvDeferCnt; idx++ )
+  {
+    osalNvDeferEnt_t *pEnt = &nvDefer[idx];
+
+    if ( pEnt->id == id )
+    {
+      uint16 beg = (pEnt->ndx > ndx) ? pEnt->ndx : ndx;
+      uint16 end = ((pEnt->ndx + pEnt->len) < (ndx + len)) ? (pEnt->ndx + pEnt->len) : (ndx + len);
+
+      if ( beg < end )
+      {
+        osal_memcpy( buf + (beg - ndx), pEnt->buf + (beg - pEnt->ndx), end - beg );
+      }
+    }
+  }
+}
+#endif // OSAL_NV_DEFER_CNT
+
+/*********************************************************************
+ * @fn      osal_nv_init
+ *
+ * @brief   Initialize NV service.
+ *
+ * @param   p - Not used.
+ *
+ * @return  none
+ */
+void osal_nv_init( void *p )
+{
+  (void)p;  // Suppress Lint warning.
+  (void)initNV();  // Always returns TRUE after pages have been erased.
+}
+
+/*********************************************************************
+ * @fn      osal_nv_item_init
+ *
+ * @brief   If the NV item does not already exist, it is created and
+ *          initialized with the data passed to the function, if any.
+ *          This function must be called before calling osal_nv_read() or
+ *          osal_nv_write().
+ *
+ * @param   id  - Valid NV item Id.
+ * @param   len - Item length.
+ * @param  *buf - Pointer to item initalization data. Set to NULL if none.
+ *
+ * @return  NV_ITEM_UNINIT - Id did not exist and was created successfully.
+ *          SUCCESS        - Id already existed, no action taken.
+ *          NV_OPER_FAILED - Failure to find or create Id.
+ */
+uint8 osal_nv_item_init( uint16 id, uint16 len, void *buf )
+{
+  uint16 offset;
+
+  if ( !OSAL_NV_CHECK_BUS_VOLTAGE )
+  {
+    return NV_OPER_FAILED;
+  }
+  else if ((offset = findItem(id)) != OSAL_NV_ITEM_NULL)
+  {
+    // Re-populate the NV hot item data if the corresponding items are already established.
+    hotItemUpdate(findPg, offset, id);
+
+    return SUCCESS;
+  }
+  else if ( initItem( TRUE, id, len, buf ) != OSAL_NV_PAGE_NULL )
+  {
+    return NV_ITEM_UNINIT;
+  }
+  else
+  {
+    return NV_OPER_FAILED;
+  }
+}
+
+/*********************************************************************
+ * @fn      osal_nv_item_len
+ *
+ * @brief   Get the data length of the item stored in NV memory.
+ *
+ * @param   id  - Valid NV item Id.
+ *
+ * @return  Item length, if found; zero otherwise.
+ */
+uint16 osal_nv_item_len( uint16 id )
+{
+  osalNvHdr_t hdr;
+  uint16 offset;
+  uint8 hotIdx;
+
+  if ((hotIdx = hotItem(id)) < OSAL_NV_MAX_HOT)
+  {
+    findPg = hotPg[hotIdx];
+    offset = hotOff[hotIdx];
+  }
+  else if ((offset = findItem(id)) == OSAL_NV_ITEM_NULL)
+  {
+    return 0;
+  }
+
+  HalFlashRead(findPg, (offset - OSAL_NV_HDR_SIZE), (uint8 *)(&hdr), OSAL_NV_HDR_SIZE);
+  return hdr.len;
+}
+
+/*********************************************************************
+ * @fn      osal_nv_write
+ *
+ * @brief   Write a data item to NV. Function can write an entire item to NV or
+ *          an element of an item by indexing into the item with an offset.
+ *
+ * @param   id  - Valid NV item Id.
+ * @param   ndx - Index offset into item
+ * @param   len - Length of data to write.
+ * @param  *buf - Data to write.
+ *
+ * @return  SUCCESS if successful, NV_ITEM_UNINIT if item did not
+ *          exist in NV and offset is non-zero, NV_OPER_FAILED if failure.
+ */
+uint8 osal_nv_write( uint16 id, uint16 ndx, uint16 len, void *buf )
+{
+  uint8 rtrn = SUCCESS;
+
+  if ( !OSAL_NV_CHECK_BUS_VOLTAGE )
+  {
+    return NV_OPER_FAILED;
+  }
+  else if ( len != 0 )
+  {
+    osalNvHdr_t hdr;
+    uint16 origOff, srcOff;
+    uint16 cnt, chk;
+    uint8 *ptr, srcPg;
+#if OSAL_NV_JRN_ITEMS
+    osalNvJrnEnt_t *pJrn;
+#endif
+
+#if OSAL_NV_DEFER_CNT
+    if ( nvDeferCnt != 0 )
+    {
+      osal_nv_flush();  // Deferred writes go first.
+    }
+#endif
+
+    origOff = srcOff = findItem( id );
+    srcPg = findPg;
+    if ( srcOff == OSAL_NV_ITEM_NULL )
+    {
+      return NV_ITEM_UNINIT;
+    }
+
+    HalFlashRead(srcPg, (srcOff - OSAL_NV_HDR_SIZE), (uint8 *)(&hdr), OSAL_NV_HDR_SIZE);
+    if ( hdr.len < (ndx + len) )
+    {
+      return NV_OPER_FAILED;
+    }
+
+#if OSAL_NV_JRN_ITEMS
+    if ( (pJrn = jrnFind( srcPg, origOff )) != NULL )
+    {
+      hdr.chk = pJrn->chk;  // The item data is the copy with its delta records applied.
+    }
+#endif
+
+    srcOff += ndx;
+    ptr = buf;
+    cnt = len;
+    chk = 0;
+    while ( cnt )
+    {
+      uint8 tmp[OSAL_NV_WORD_SIZE * 4];
+      uint8 idx, sz = (cnt < sizeof( tmp )) ? (uint8)cnt : sizeof( tmp );
+
+      HalFlashRead(srcPg, srcOff, tmp, sz);
+#if OSAL_NV_JRN_ITEMS
+      if ( pJrn != NULL )
+      {
+        jrnApply( pJrn, (srcOff - origOff), sz, tmp );
+      }
+#endif
+      for ( idx = 0; idx < sz; idx++ )
+      {
+        if ( tmp[idx] != *ptr )
+        {
+          chk = 1;  // Mark that at least one byte is different.
+          // Calculate expected checksum after transferring old data and writing new data.
+          hdr.chk -= tmp[idx];
+          hdr.chk += *ptr;
+        }
+        ptr++;
+      }
+      srcOff += sz;
+      cnt -= sz;
+    }
+
+    if ( (chk != 0)  // If the buffer to write is different in one or more bytes.
+#if OSAL_NV_JRN_ITEMS
+         && !jrnAppend( srcPg, origOff, id, hdr.len, ndx, len, buf, hdr.chk )
+#endif
+       )
+    {
+      uint8 comPg = OSAL_NV_PAGE_NULL;
+      uint8 dstPg = initItem( FALSE, id, hdr.len, &comPg );
+
+      if ( dstPg != OSAL_NV_PAGE_NULL )
+      {
+        uint16 tmp = OSAL_NV_DATA_SIZE( hdr.len );
+        uint16 dstOff = pgOff[dstPg-OSAL_NV_PAGE_BEG] - tmp;
+        srcOff = origOff;
+
+        /* Prevent excessive re-writes to item header caused by numerous, rapid, & successive
+         * OSAL_Nv interruptions caused by resets.
+         */
+        if ( hdr.stat == OSAL_NV_ERASED_ID )
+        {
+          setItem( srcPg, srcOff, eNvXfer );
+        }
+
+#if OSAL_NV_JRN_ITEMS
+        nvJrnStats.copies++;
+        if ( pJrn != NULL )
+        {
+          // Fold the delta records into the new copy.
+          (void)jrnXfer( srcPg, origOff, 0, dstPg, dstOff, ndx );
+          writeBuf( dstPg, dstOff + ndx, len, buf );
+          (void)jrnXfer( srcPg, origOff, ndx + len, dstPg, dstOff + ndx + len,
+                         (hdr.len-ndx-len) );
+        }
+        else
+#endif
+        {
+          xferBuf( srcPg, srcOff, dstPg, dstOff, ndx );
+          srcOff += ndx;
+          dstOff += ndx;
+
+          writeBuf( dstPg, dstOff, len, buf );
+          srcOff += len;
+          dstOff += len;
+
+          xferBuf( srcPg, srcOff, dstPg, dstOff, (hdr.len-ndx-len) );
+        }
+
+        // Calculate and write the new checksum.
+        dstOff = pgOff[dstPg-OSAL_NV_PAGE_BEG] - tmp;
+
+        if ( hdr.chk == calcChkF( dstPg, dstOff, hdr.len ) )
+        {
+          if ( hdr.chk != setChk( dstPg, dstOff, hdr.chk ) )
+          {
+            rtrn = NV_OPER_FAILED;
           }
           else
           {
@@ -1443,19 +2387,31 @@ uint8 osal_nv_read( uint16 id, uint16 ndx, uint16 len, void *buf )
 
   if ((hotIdx = hotItem(id)) < OSAL_NV_MAX_HOT)
   {
-    HalFlashRead(hotPg[hotIdx], hotOff[hotIdx]+ndx, buf, len);
-    return SUCCESS;
+    findPg = hotPg[hotIdx];
+    offset = hotOff[hotIdx];
   }
-
-  if ((offset = findItem(id)) == OSAL_NV_ITEM_NULL)
+  else if ((offset = findItem(id)) == OSAL_NV_ITEM_NULL)
   {
     return NV_OPER_FAILED;
   }
-  else
+
+  HalFlashRead(findPg, offset+ndx, buf, len);
+
+#if OSAL_NV_JRN_ITEMS
   {
-    HalFlashRead(findPg, offset+ndx, buf, len);
-    return SUCCESS;
+    osalNvJrnEnt_t *pJrn = jrnFind( findPg, offset );
+
+    if ( pJrn != NULL )
+    {
+      jrnApply( pJrn, ndx, len, buf );
+    }
   }
+#endif
+#if OSAL_NV_DEFER_CNT
+  deferApply( id, ndx, len, buf );
+#endif
+
+  return SUCCESS;
 }
 
 /*********************************************************************
@@ -1477,6 +2433,13 @@ uint8 osal_nv_delete( uint16 id, uint16 len )
   uint16 length;
   uint16 offset;
 
+#if OSAL_NV_DEFER_CNT
+  if ( nvDeferCnt != 0 )
+  {
+    osal_nv_flush();  // Deferred writes go first.
+  }
+#endif
+
   offset = findItem( id );
   if ( offset == OSAL_NV_ITEM_NULL )
   {
@@ -1508,5 +2471,156 @@ uint8 osal_nv_delete( uint16 id, uint16 len )
   }
 }
 
+/*********************************************************************
+ * @fn      osal_nv_write_defer
+ *
+ * @brief   Write a data item to NV at the next osal_nv_flush(), which OSAL makes when the
+ *          current task event handler returns. Writes to the same item in the meantime are
+ *          merged when they fit one delta record, so an item updated several times by one event
+ *          is written once. Reads see the deferred data; it is lost on a reset before the flush.
+ *          Writes larger than OSAL_NV_JRN_DATA_MAX, or without OSAL_NV_DEFER_CNT, are made by
+ *          osal_nv_write() right away.
+ *
+ * @param   id  - Valid NV item Id.
+ * @param   ndx - Index offset into item
+ * @param   len - Length of data to write.
+ * @param  *buf - Data to write.
+ *
+ * @return  SUCCESS if deferred or written, NV_ITEM_UNINIT if item did not
+ *          exist in NV, NV_OPER_FAILED if failure.
+ */
+uint8 osal_nv_write_defer( uint16 id, uint16 ndx, uint16 len, void *buf )
+{
+#if OSAL_NV_DEFER_CNT
+  uint8 cur[OSAL_NV_JRN_DATA_MAX];
+  osalNvDeferEnt_t *pEnt;
+  uint16 itemLen;
+  uint8 idx;
+
+  if ( (len == 0) || (len > OSAL_NV_JRN_DATA_MAX) )
+  {
+    return osal_nv_write( id, ndx, len, buf );
+  }
+
+  if ( (itemLen = osal_nv_item_len( id )) == 0 )
+  {
+    return NV_ITEM_UNINIT;
+  }
+  else if ( itemLen < (ndx + len) )
+  {
+    return NV_OPER_FAILED;
+  }
+
+  nvJrnStats.deferred++;
+
+  // Merge with the last deferred write to the item if both fit one record.
+  for ( idx = nvDeferCnt; idx-- > 0; )
+  {
+    pEnt = &nvDefer[idx];
+
+    if ( pEnt->id == id )
+    {
+      uint16 beg = (pEnt->ndx < ndx) ? pEnt->ndx : ndx;
+      uint16 end = ((pEnt->ndx + pEnt->len) > (ndx + len)) ? (pEnt->ndx + pEnt->len) : (ndx + len);
+
+      if ( (end - beg) <= OSAL_NV_JRN_DATA_MAX )
+      {
+        (void)osal_nv_read( id, beg, (end - beg), cur );
+        osal_memcpy( cur + (ndx - beg), buf, len );
+        osal_memcpy( pEnt->buf, cur, (end - beg) );
+        pEnt->ndx = beg;
+        pEnt->len = end - beg;
+
+        return SUCCESS;
+      }
+      break;
+    }
+  }
+
+  // Like osal_nv_write(), a write that changes nothing is dropped.
+  (void)osal_nv_read( id, ndx, len, cur );
+  if ( osal_memcmp( cur, buf, len ) )
+  {
+    return SUCCESS;
+  }
+
+  if ( nvDeferCnt == OSAL_NV_DEFER_CNT )
+  {
+    osal_nv_flush();
+  }
+
+  pEnt = &nvDefer[nvDeferCnt++];
+  pEnt->id = id;
+  pEnt->ndx = ndx;
+  pEnt->len = len;
+  osal_memcpy( pEnt->buf, buf, len );
+
+  return SUCCESS;
+#else
+  return osal_nv_write( id, ndx, len, buf );
+#endif
+}
+
+/*********************************************************************
+ * @fn      osal_nv_flush
+ *
+ * @brief   Write the data deferred by osal_nv_write_defer() to NV.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void osal_nv_flush( void )
+{
+#if OSAL_NV_DEFER_CNT
+  uint8 cnt = nvDeferCnt;
+  uint8 idx;
+
+  nvDeferCnt = 0;  // Else osal_nv_write() would flush again.
+
+  for ( idx = 0; idx < cnt; idx++ )
+  {
+    osalNvDeferEnt_t *pEnt = &nvDefer[idx];
+
+    nvJrnStats.flushed++;
+    if ( osal_nv_write( pEnt->id, pEnt->ndx, pEnt->len, pEnt->buf ) != SUCCESS )
+    {
+      nvJrnStats.failed++;
+    }
+  }
+#endif
+}
+
+#if ( OSAL_NV_JRN_ITEMS || OSAL_NV_DEFER_CNT )
+/*********************************************************************
+ * @fn      osal_nv_jrn_stats
+ *
+ * @brief   Get the delta record journal and deferred write counters.
+ *
+ * @param   pStats - Counters.
+ *
+ * @return  none
+ */
+void osal_nv_jrn_stats( osalNvJrnStats_t *pStats )
+{
+  *pStats = nvJrnStats;
+  pStats->items = 0;
+
+#if OSAL_NV_JRN_ITEMS
+  {
+    uint8 idx;
+
+    for ( idx = 0; idx < OSAL_NV_JRN_ITEMS; idx++ )
+    {
+      if ( nvJrn[idx].pg != OSAL_NV_PAGE_NULL )
+      {
+        pStats->items++;
+      }
+    }
+  }
+#endif
+}
+#endif
+
 /*********************************************************************
  */
@@ -88,12 +88,33 @@
         AF_DataRequest( (dstAddr), afFindEndPointDesc( (srcEP) ), \
                           (cID), (len), (buf), (transID), (options), (radius) )
 
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Entries of the endpoint index kept sorted next to epList, so that Rx
+// finds an endpoint by binary search. With more endpoints registered the
+// list is walked. 0 also queries pfnDescCB for the profile on every frame.
+#if !defined AF_EP_INDEX_MAX
+  #define AF_EP_INDEX_MAX  8
+#endif
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
 
 epList_t *epList;
 
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+#if AF_EP_INDEX_MAX
+static epList_t *afEpIndex[AF_EP_INDEX_MAX];
+static uint8 afEpIndexCnt;
+static uint8 afEpIndexOk = TRUE;  // FALSE while epList does not fit the index
+#endif
+
 /*********************************************************************
  * LOCAL FUNCTIONS
  */
@@ -104,6 +125,12 @@ static void afBuildMSGIncoming( aps_FrameFormat_t *aff, endPointDesc_t *epDesc,
 
 static epList_t *afFindEndPointDescList( uint8 EndPoint );
 
+static uint16 afEndPointProfileID( epList_t *pList );
+
+#if AF_EP_INDEX_MAX
+static void afEpIndexBuild( void );
+#endif
+
 static pDescCB afGetDescCB( endPointDesc_t *epDesc );
 
 /*********************************************************************
@@ -150,6 +177,10 @@ epList_t *afRegisterExtended( endPointDesc_t *epDesc, pDescCB descFn, pApplCB ap
     ep->apsfCfg.windowSize = APSF_DEFAULT_WINDOW_SIZE;
     ep->flags = eEP_AllowMatch;  // Default to allow Match Descriptor.
     ep->pfnApplCB = applFn;
+    ep->profileID = AF_PROFILE_ID_INVALID;
+#if AF_EP_INDEX_MAX
+    afEpIndexBuild();
+#endif
   }
 
   return ep;
@@ -203,6 +234,9 @@ afStatus_t afDelete( uint8 EndPoint )
     {
       epList = epCurrent->nextDesc;
       osal_mem_free( epCurrent );
+#if AF_EP_INDEX_MAX
+      afEpIndexBuild();
+#endif
 
       return ( afStatus_SUCCESS );
     }
@@ -217,6 +251,9 @@ afStatus_t afDelete( uint8 EndPoint )
         {
           epPrevious->nextDesc = epCurrent->nextDesc;
           osal_mem_free( epCurrent );
+#if AF_EP_INDEX_MAX
+          afEpIndexBuild();
+#endif
 
           // delete the entry and free the memory
           return ( afStatus_SUCCESS );
@@ -375,11 +412,11 @@ void afIncomingData( aps_FrameFormat_t *aff, zAddrType_t *SrcAddress, uint16 Src
     if ( grpEp == APS_GROUPS_EP_NOT_FOUND )
       return;   // No endpoint found
 
-    epDesc = afFindEndPointDesc( grpEp );
-    if ( epDesc == NULL )
+    pList = afFindEndPointDescList( grpEp );
+    if ( pList == NULL )
       return;   // Endpoint descriptor not found
 
-    pList = afFindEndPointDescList( epDesc->endPoint );
+    epDesc = pList->epDesc;
 #else
     return; // Not supported
 #endif
@@ -392,29 +429,14 @@ void afIncomingData( aps_FrameFormat_t *aff, zAddrType_t *SrcAddress, uint16 Src
       epDesc = pList->epDesc;
     }
   }
-  else if ( (epDesc = afFindEndPointDesc( aff->DstEndPoint )) )
+  else if ( (pList = afFindEndPointDescList( aff->DstEndPoint )) )
   {
-    pList = afFindEndPointDescList( epDesc->endPoint );
+    epDesc = pList->epDesc;
   }
 
   while ( epDesc )
   {
-    uint16 epProfileID = 0xFFFE;  // Invalid Profile ID
-
-    if ( pList->pfnDescCB )
-    {
-      uint16 *pID = (uint16 *)(pList->pfnDescCB(
-                                 AF_DESCRIPTOR_PROFILE_ID, epDesc->endPoint ));
-      if ( pID )
-      {
-        epProfileID = *pID;
-        osal_mem_free( pID );
-      }
-    }
-    else if ( epDesc->simpleDesc )
-    {
-      epProfileID = epDesc->simpleDesc->AppProfId;
-    }
+    uint16 epProfileID = afEndPointProfileID( pList );
 
     // First part of verification is to make sure that:
     // the local Endpoint ProfileID matches the received ProfileID OR
@@ -445,11 +467,11 @@ void afIncomingData( aps_FrameFormat_t *aff, zAddrType_t *SrcAddress, uint16 Src
       if ( grpEp == APS_GROUPS_EP_NOT_FOUND )
         return;   // No endpoint found
 
-      epDesc = afFindEndPointDesc( grpEp );
-      if ( epDesc == NULL )
+      pList = afFindEndPointDescList( grpEp );
+      if ( pList == NULL )
         return;   // Endpoint descriptor not found
 
-      pList = afFindEndPointDescList( epDesc->endPoint );
+      epDesc = pList->epDesc;
 #else
       return;
 #endif
@@ -778,6 +800,104 @@ afStatus_t AF_DataRequest( afAddrType_t *dstAddr, endPointDesc_t *srcEP,
   return (afStatus_t)stat;
 }
 
+/*********************************************************************
+ * @fn      AF_BufAlloc
+ *
+ * @brief   Allocate an outgoing frame in a single block: the afBuf_t,
+ *          the headroom and the payload.
+ *
+ * @param   headroom - bytes to reserve in front of the payload
+ * @param   len - payload length
+ *
+ * @return  frame with pData at the payload, NULL if out of memory
+ */
+afBuf_t *AF_BufAlloc( uint8 headroom, uint16 len )
+{
+  afBuf_t *pBuf;
+
+  pBuf = (afBuf_t *)osal_mem_alloc( sizeof( afBuf_t ) + headroom + len );
+  if ( pBuf != NULL )
+  {
+    pBuf->pData = (uint8 *)(pBuf + 1) + headroom;
+    pBuf->len = len;
+    pBuf->headroom = headroom;
+  }
+
+  return ( pBuf );
+}
+
+/*********************************************************************
+ * @fn      AF_BufPush
+ *
+ * @brief   Extend the frame to the front by len bytes of its headroom.
+ *
+ * @param   pBuf - frame from AF_BufAlloc()
+ * @param   len - number of header bytes to claim
+ *
+ * @return  pointer to the claimed bytes (the new start of the frame),
+ *          NULL if the headroom is too short
+ */
+uint8 *AF_BufPush( afBuf_t *pBuf, uint8 len )
+{
+  if ( len > pBuf->headroom )
+  {
+    return ( NULL );
+  }
+
+  pBuf->headroom -= len;
+  pBuf->pData -= len;
+  pBuf->len += len;
+
+  return ( pBuf->pData );
+}
+
+/*********************************************************************
+ * @fn      AF_BufFree
+ *
+ * @brief   Free a frame from AF_BufAlloc() that was not handed to
+ *          AF_DataRequestBuf().
+ *
+ * @param   pBuf - frame from AF_BufAlloc()
+ *
+ * @return  none
+ */
+void AF_BufFree( afBuf_t *pBuf )
+{
+  osal_mem_free( pBuf );
+}
+
+/*********************************************************************
+ * @fn      AF_DataRequestBuf
+ *
+ * @brief   AF_DataRequest() of a frame built with AF_BufAlloc() and
+ *          AF_BufPush(). The caller hands the frame over: it is sent
+ *          from where it was built and freed once APS has taken it,
+ *          whatever the outcome.
+ *
+ * @param  *dstAddr - Full ZB destination address: Nwk Addr + End Point.
+ * @param  *srcEP - Origination (i.e. respond to or ack to) End Point Descr.
+ * @param   cID - A valid cluster ID as specified by the Profile.
+ * @param  *pBuf - frame to send, freed on return
+ * @param  *transID - A pointer to a byte which can be modified and which will
+ *                    be used as the transaction sequence number of the msg.
+ * @param   options - Valid bit mask of Tx options.
+ * @param   radius - Normally set to AF_DEFAULT_RADIUS.
+ *
+ * @return  afStatus_t - See previous definition of afStatus_... types.
+ */
+afStatus_t AF_DataRequestBuf( afAddrType_t *dstAddr, endPointDesc_t *srcEP,
+                              uint16 cID, afBuf_t *pBuf, uint8 *transID,
+                              uint8 options, uint8 radius )
+{
+  afStatus_t stat;
+
+  stat = AF_DataRequest( dstAddr, srcEP, cID, pBuf->len, pBuf->pData,
+                         transID, options, radius );
+  osal_mem_free( pBuf );
+
+  return ( stat );
+}
+
 #if defined ( ZIGBEEPRO )
 /*********************************************************************
  * @fn      AF_DataRequestSrcRtg
@@ -850,6 +970,36 @@ static epList_t *afFindEndPointDescList( uint8 EndPoint )
 {
   epList_t *epSearch;
 
+#if AF_EP_INDEX_MAX
+  if ( afEpIndexOk )
+  {
+    uint8 low = 0;
+    uint8 high = afEpIndexCnt;
+    uint8 mid;
+
+    // First entry not below EndPoint, the newest of duplicates as in the list
+    while ( low < high )
+    {
+      mid = (low + high) / 2;
+      if ( afEpIndex[mid]->epDesc->endPoint < EndPoint )
+      {
+        low = mid + 1;
+      }
+      else
+      {
+        high = mid;
+      }
+    }
+
+    if ( (low < afEpIndexCnt) && (afEpIndex[low]->epDesc->endPoint == EndPoint) )
+    {
+      return ( afEpIndex[low] );
+    }
+
+    return ( (epList_t *)NULL );
+  }
+#endif
+
   for (epSearch = epList; epSearch != NULL; epSearch = epSearch->nextDesc)
   {
     if (epSearch->epDesc->endPoint == EndPoint)
@@ -861,6 +1011,89 @@ static epList_t *afFindEndPointDescList( uint8 EndPoint )
   return epSearch;
 }
 
+#if AF_EP_INDEX_MAX
+/*********************************************************************
+ * @fn      afEpIndexBuild
+ *
+ * @brief   Rebuild the sorted endpoint index from epList, called when
+ *          an endpoint is registered or deleted.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void afEpIndexBuild( void )
+{
+  epList_t *epSearch;
+  uint8 idx;
+
+  afEpIndexCnt = 0;
+  afEpIndexOk = TRUE;
+
+  for ( epSearch = epList; epSearch != NULL; epSearch = epSearch->nextDesc )
+  {
+    if ( afEpIndexCnt == AF_EP_INDEX_MAX )
+    {
+      afEpIndexOk = FALSE;
+      return;
+    }
+
+    // Insertion sort, a duplicate goes after the newer one already in
+    idx = afEpIndexCnt++;
+    while ( (idx > 0) && (afEpIndex[idx - 1]->epDesc->endPoint > epSearch->epDesc->endPoint) )
+    {
+      afEpIndex[idx] = afEpIndex[idx - 1];
+      idx--;
+    }
+    afEpIndex[idx] = epSearch;
+  }
+}
+#endif
+
+/*********************************************************************
+ * @fn      afEndPointProfileID
+ *
+ * @brief   Profile ID of an endpoint. An endpoint registered with a
+ *          descriptor callback is asked once, the answer is kept in
+ *          its list entry.
+ *
+ * @param   pList - endpoint list entry
+ *
+ * @return  profile ID, AF_PROFILE_ID_INVALID if unknown
+ */
+static uint16 afEndPointProfileID( epList_t *pList )
+{
+  uint16 profileID = AF_PROFILE_ID_INVALID;
+  uint16 *pID;
+
+  if ( pList->pfnDescCB )
+  {
+#if AF_EP_INDEX_MAX
+    if ( pList->profileID != AF_PROFILE_ID_INVALID )
+    {
+      return ( pList->profileID );
+    }
+#endif
+
+    pID = (uint16 *)(pList->pfnDescCB( AF_DESCRIPTOR_PROFILE_ID, pList->epDesc->endPoint ));
+    if ( pID )
+    {
+      profileID = *pID;
+      osal_mem_free( pID );
+    }
+
+#if AF_EP_INDEX_MAX
+    pList->profileID = profileID;
+#endif
+  }
+  else if ( pList->epDesc->simpleDesc )
+  {
+    profileID = pList->epDesc->simpleDesc->AppProfId;
+  }
+
+  return ( profileID );
+}
+
 /*********************************************************************
  * @fn      afFindEndPointDesc
  *
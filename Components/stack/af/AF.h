@@ -334,8 +334,11 @@ typedef struct _epList_t {
   afAPSF_Config_t apsfCfg;
   eEP_Flags flags;
   pApplCB pfnApplCB;    // Don't use it if it has not been set to a valid function pointer by the application
+  uint16 profileID;     // pfnDescCB profile ID, queried on first Rx (AF_PROFILE_ID_INVALID until then)
 } epList_t;
 
+#define AF_PROFILE_ID_INVALID      0xFFFE
+
 /*********************************************************************
  * TYPEDEFS
  */
@@ -354,6 +357,17 @@ typedef struct
   APSDE_DataReqMTU_t aps;
 } afDataReqMTU_t;
 
+// Outgoing frame built in one allocation, back to front: the payload is
+// written first and each header is then pushed into the headroom in
+// front of it (AF_BufPush), so no layer has to copy the frame to
+// prepend its own header. The storage follows this header in the block.
+typedef struct
+{
+  uint8 *pData;     // Start of the frame built so far
+  uint16 len;       // Bytes from pData to the end of the frame
+  uint8  headroom;  // Bytes still free in front of pData
+} afBuf_t;
+
 /*********************************************************************
  * Globals
  */
@@ -414,6 +428,30 @@ extern epList_t *epList;
                              uint16 cID, uint16 len, uint8 *buf, uint8 *transID,
                              uint8 options, uint8 radius );
 
+ /*
+  * AF_BufAlloc - Allocate an outgoing frame of len payload bytes with
+  *               headroom bytes reserved in front of it for headers.
+  */
+  extern afBuf_t *AF_BufAlloc( uint8 headroom, uint16 len );
+
+ /*
+  * AF_BufPush - Claim len bytes of headroom in front of the frame.
+  */
+  extern uint8 *AF_BufPush( afBuf_t *pBuf, uint8 len );
+
+ /*
+  * AF_BufFree - Free a frame that was not passed to AF_DataRequestBuf().
+  */
+  extern void AF_BufFree( afBuf_t *pBuf );
+
+ /*
+  * AF_DataRequestBuf - AF_DataRequest() of an AF_BufAlloc() frame. The
+  *                     frame is freed, whatever the outcome.
+  */
+  extern afStatus_t AF_DataRequestBuf( afAddrType_t *dstAddr, endPointDesc_t *srcEP,
+                                       uint16 cID, afBuf_t *pBuf, uint8 *transID,
+                                       uint8 options, uint8 radius );
+
 
 /*********************************************************************
  * @fn      AF_DataRequestSrcRtg
@@ -1320,10 +1320,10 @@ void BindWriteNV( void )
 
     osal_memcpy( &bind, pBind, gBIND_REC_SIZE );
 
-    // Save the record to NV
-    osal_nv_write( ZCD_NV_BINDING_TABLE,
-                   (uint16)((sizeof(nvBindingHdr_t)) + (x * NV_BIND_REC_SIZE)),
-                   NV_BIND_REC_SIZE, &bind );
+    // Save the record to NV; the changed records are written together when the task returns
+    osal_nv_write_defer( ZCD_NV_BINDING_TABLE,
+                         (uint16)((sizeof(nvBindingHdr_t)) + (x * NV_BIND_REC_SIZE)),
+                         NV_BIND_REC_SIZE, &bind );
 
     if ( pBind->srcEP != NV_BIND_EMPTY )
     {
@@ -1332,7 +1332,7 @@ void BindWriteNV( void )
   }
 
   // Save off the header
-  osal_nv_write( ZCD_NV_BINDING_TABLE, 0, sizeof(nvBindingHdr_t), &hdr );
+  osal_nv_write_defer( ZCD_NV_BINDING_TABLE, 0, sizeof(nvBindingHdr_t), &hdr );
 }
 
 #else // !BINDINGTABLE_NV_SINGLES
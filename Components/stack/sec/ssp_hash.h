@@ -59,10 +59,22 @@ extern "C"
  * CONSTANTS
  */
 
+// Length of an MMO hash block and of the digest
+#define SSP_MMO_HASH_LEN  16
+
 /*********************************************************************
  * TYPEDEFS
  */
 
+// MMO hash computed a piece at a time (sspMMOHashInit/Update/Final)
+typedef struct
+{
+  uint8  hash[SSP_MMO_HASH_LEN];  // Hash of the whole blocks so far
+  uint8  buf[SSP_MMO_HASH_LEN];   // Incomplete block
+  uint8  pos;                     // Bytes in buf
+  uint32 length;                  // Bytes hashed so far
+} sspMMOHash_t;
+
 /*********************************************************************
  * GLOBAL VARIABLES
  */
@@ -72,6 +84,10 @@ extern "C"
  */
 
 void sspMMOHash (uint8 *, uint8, uint8 *, uint16, uint8 *);
+
+void sspMMOHashInit( sspMMOHash_t *pCtx );
+void sspMMOHashUpdate( sspMMOHash_t *pCtx, uint8 *pData, uint16 len );
+void sspMMOHashFinal( sspMMOHash_t *pCtx, uint8 *pDigest );
 void SSP_KeyedHash (uint8 *M, uint16 bitlen, uint8 *AesKey, uint8 *Cstate);
 
 void sspAesDecrypt( uint8 *key, uint8 *buf );
@@ -0,0 +1,179 @@
+/**************************************************************************************************
+  Filename:       ssp_mmo.c
+
+  Description:    Matyas-Meyer-Oseas (MMO) hash of the ZigBee specification (Annex B.6) computed
+                  a piece at a time, so a message that arrives in blocks, such as an OTA image,
+                  is hashed as it comes in. Each block is run through the AES engine with the
+                  hash so far as the key.
+
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "ZComDef.h"
+#include "OSAL.h"
+#include "hal_aes.h"
+#include "ssp_hash.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Bit lengths from 2^16 on are padded with a 32 bit length and 16 zero bits
+#define SSP_MMO_LONG_BITS  0x00010000
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+static void sspMMOHashBlock( uint8 *pHash, uint8 *pData );
+
+/*********************************************************************
+ * @fn      sspMMOHashBlock
+ *
+ * @brief   Hash one block: H(i) = E(H(i-1), M(i)) ^ M(i).
+ *
+ * @param   pHash - hash so far, replaced by the new one
+ * @param   pData - SSP_MMO_HASH_LEN bytes of the message
+ *
+ * @return  none
+ */
+static void sspMMOHashBlock( uint8 *pHash, uint8 *pData )
+{
+  uint8 buf[SSP_MMO_HASH_LEN];
+  uint8 i;
+
+  // The engine holds the key once it is loaded, the old hash is only
+  // overwritten after the block is encrypted
+  osal_memcpy( buf, pData, SSP_MMO_HASH_LEN );
+  ssp_HW_KeyInit( pHash );
+  sspAesEncryptHW( pHash, buf );
+
+  for ( i = 0; i < SSP_MMO_HASH_LEN; i++ )
+  {
+    pHash[i] = buf[i] ^ pData[i];
+  }
+}
+
+/*********************************************************************
+ * @fn      sspMMOHashInit
+ *
+ * @brief   Start an MMO hash.
+ *
+ * @param   pCtx - hash state
+ *
+ * @return  none
+ */
+void sspMMOHashInit( sspMMOHash_t *pCtx )
+{
+  osal_memset( pCtx, 0, sizeof( sspMMOHash_t ) );
+}
+
+/*********************************************************************
+ * @fn      sspMMOHashUpdate
+ *
+ * @brief   Add the next part of the message to an MMO hash. Whole blocks
+ *          are hashed straight from pData; only a block split between two
+ *          updates is put together in the hash state.
+ *
+ * @param   pCtx - hash state
+ * @param   pData - next part of the message
+ * @param   len - its length in bytes
+ *
+ * @return  none
+ */
+void sspMMOHashUpdate( sspMMOHash_t *pCtx, uint8 *pData, uint16 len )
+{
+  uint8 cnt;
+
+  pCtx->length += len;
+
+  // Complete the block the last update left
+  if ( pCtx->pos )
+  {
+    cnt = SSP_MMO_HASH_LEN - pCtx->pos;
+    if ( cnt > len )
+    {
+      cnt = (uint8)len;
+    }
+
+    osal_memcpy( &pCtx->buf[pCtx->pos], pData, cnt );
+    pCtx->pos += cnt;
+    pData += cnt;
+    len -= cnt;
+
+    if ( pCtx->pos < SSP_MMO_HASH_LEN )
+    {
+      return;
+    }
+
+    sspMMOHashBlock( pCtx->hash, pCtx->buf );
+    pCtx->pos = 0;
+  }
+
+  while ( len >= SSP_MMO_HASH_LEN )
+  {
+    sspMMOHashBlock( pCtx->hash, pData );
+    pData += SSP_MMO_HASH_LEN;
+    len -= SSP_MMO_HASH_LEN;
+  }
+
+  if ( len )
+  {
+    osal_memcpy( pCtx->buf, pData, len );
+    pCtx->pos = (uint8)len;
+  }
+}
+
+/*********************************************************************
+ * @fn      sspMMOHashFinal
+ *
+ * @brief   Pad the message and get its MMO hash: a 1 bit, then zero bits
+ *          up to the bit length at the end of the last block, 16 bits long
+ *          below 2^16 bits and 32 bits followed by 16 zero bits from there.
+ *
+ * @param   pCtx - hash state, to be started again before it is reused
+ * @param   pDigest - where to put the SSP_MMO_HASH_LEN byte hash
+ *
+ * @return  none
+ */
+void sspMMOHashFinal( sspMMOHash_t *pCtx, uint8 *pDigest )
+{
+  uint32 bits = pCtx->length << 3;
+  uint8 *pBuf = pCtx->buf;
+  uint8 lenPos;
+
+  lenPos = ( bits < SSP_MMO_LONG_BITS ) ? SSP_MMO_HASH_LEN - 2 : SSP_MMO_HASH_LEN - 6;
+
+  pBuf[pCtx->pos++] = 0x80;
+  osal_memset( &pBuf[pCtx->pos], 0, SSP_MMO_HASH_LEN - pCtx->pos );
+
+  // No room left for the length in this block
+  if ( pCtx->pos > lenPos )
+  {
+    sspMMOHashBlock( pCtx->hash, pBuf );
+    osal_memset( pBuf, 0, SSP_MMO_HASH_LEN );
+  }
+
+  if ( bits < SSP_MMO_LONG_BITS )
+  {
+    pBuf[14] = HI_UINT16( bits );
+    pBuf[15] = LO_UINT16( bits );
+  }
+  else
+  {
+    pBuf[10] = BREAK_UINT32( bits, 3 );
+    pBuf[11] = BREAK_UINT32( bits, 2 );
+    pBuf[12] = BREAK_UINT32( bits, 1 );
+    pBuf[13] = BREAK_UINT32( bits, 0 );
+  }
+
+  sspMMOHashBlock( pCtx->hash, pBuf );
+  pCtx->pos = 0;
+
+  osal_memcpy( pDigest, pCtx->hash, SSP_MMO_HASH_LEN );
+}
+
+/*********************************************************************
+*********************************************************************/
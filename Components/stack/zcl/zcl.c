@@ -50,6 +50,10 @@
   #include "stub_aps.h"
 #endif
 
+#if defined ( ZCL_REPORTING )
+  #include "zcl_reporting.h"
+#endif
+
 /*********************************************************************
  * MACROS
  */
@@ -66,6 +70,12 @@
 #define zcl_AccessCtrlAuthRead( a )   ( (a) & ACCESS_CONTROL_AUTH_READ )
 #define zcl_AccessCtrlAuthWrite( a )  ( (a) & ACCESS_CONTROL_AUTH_WRITE )
 
+// Attribute and command record lists up to this long are scanned rather than
+// binary searched (see zclBuildAttrIdx)
+#if !defined ( ZCL_FIND_LINEAR_MAX )
+  #define ZCL_FIND_LINEAR_MAX         8
+#endif
+
 #define zclParseCmd( a, b )           zclCmdTable[(a)].pfnParseInProfile( (b) )
 #define zclProcessCmd( a, b )         zclCmdTable[(a)].pfnProcessInProfile( (b) )
 
@@ -108,6 +118,8 @@ typedef struct zclCmdRecsList
   uint8                 endpoint;
   uint8                 numCommands;
   CONST zclCommandRec_t *pCmdRecs;
+  uint8                 bsearch;        // TRUE: sorted, binary search (through pIdx if set)
+  uint8                 *pIdx;          // pCmdRecs[] positions by cluster ID, command ID
 } zclCmdRecsList_t;
 
 // Attribute record list item
@@ -117,8 +129,13 @@ typedef struct zclAttrRecsList
   uint8                  endpoint;      // Used to link it into the endpoint descriptor
   zclReadWriteCB_t       pfnReadWriteCB;// Read or Write attribute value callback function
   zclAuthorizeCB_t       pfnAuthorizeCB;// Authorize Read or Write operation
+#ifdef ZCL_REPORT
+  zclReportCB_t          pfnReportCB;   // In place Report Attributes Command handler
+#endif
   uint8                  numAttributes; // Number of the following records
   CONST zclAttrRec_t     *attrs;        // attribute records
+  uint8                  bsearch;       // TRUE: sorted, binary search (through pIdx if set)
+  uint8                  *pIdx;         // attrs[] positions by cluster ID, attribute ID
 } zclAttrRecsList;
 
 // Cluster option list item
@@ -180,11 +197,16 @@ static uint8 savedZCLTransSeqNum = 0;
  */
 static zclLibPlugin_t *plugins = (zclLibPlugin_t *)NULL;
 
+// Registered plugins by ascending start cluster ID, for zclFindPlugin()
+static zclLibPlugin_t **pluginIdx = (zclLibPlugin_t **)NULL;
+static uint8 pluginCnt = 0;
+
 #if defined ( ZCL_DISCOVER )
   static zclCmdRecsList_t *gpCmdList = (zclCmdRecsList_t *)NULL;
 #endif
 
 static zclAttrRecsList *attrList = (zclAttrRecsList *)NULL;
+static zclAttrRecsList *attrListMRU = (zclAttrRecsList *)NULL;  // last one found
 static zclClusterOptionList *clusterOptionList = (zclClusterOptionList *)NULL;
 
 static afIncomingMSGPacket_t *rawAFMsg = (afIncomingMSGPacket_t *)NULL;
@@ -207,9 +229,11 @@ static uint8 zcl_getExternalFoundationHandler( afIncomingMSGPacket_t *pInMsg );
 
 #if defined ( ZCL_DISCOVER )
   static zclCmdRecsList_t *zclFindCmdRecsList( uint8 endpoint );
+  static uint8 zclBuildCmdIdx( uint8 numCmds, CONST zclCommandRec_t cmds[], uint8 **ppIdx );
 #endif
 
 static zclAttrRecsList *zclFindAttrRecsList( uint8 endpoint );
+static uint8 zclBuildAttrIdx( uint8 numAttr, CONST zclAttrRec_t attrs[], uint8 **ppIdx );
 static zclOptionRec_t *zclFindClusterOption( uint8 endpoint, uint16 clusterID );
 static uint8 zclGetClusterOption( uint8 endpoint, uint16 clusterID );
 static void zclSetSecurityOption( uint8 endpoint, uint16 clusterID, uint8 enable );
@@ -221,6 +245,10 @@ static zclReadWriteCB_t zclGetReadWriteCB( uint8 endpoint );
 static zclAuthorizeCB_t zclGetAuthorizeCB( uint8 endpoint );
 #endif // ZCL_READ || ZCL_WRITE
 
+#ifdef ZCL_REPORT
+static zclReportCB_t zclGetReportCB( uint8 endpoint );
+#endif // ZCL_REPORT
+
 #ifdef ZCL_READ
 ZStatus_t zclReadAttrData( uint8 *pAttrData, zclAttrRec_t *pAttr, uint16 *pDataLen );
 static uint16 zclGetAttrDataLengthUsingCB( uint8 endpoint, uint16 clusterID, uint16 attrId );
@@ -287,7 +315,13 @@ static CONST zclCmdItems_t zclCmdTable[] =
   /* ZCL_CMD_WRITE_NO_RSP */        { (zclParseInProfileCmd_t)NULL,  (zclProcessInProfileCmd_t)NULL  },
 #endif // ZCL_WRITE
 
-#ifdef ZCL_REPORT
+#if defined ( ZCL_REPORTING )
+  /* ZCL_CMD_CONFIG_REPORT */       { zclParseInConfigReportCmd,     zclReporting_ProcessInConfigReportCmd  },
+  /* ZCL_CMD_CONFIG_REPORT_RSP */   { zclParseInConfigReportRspCmd,  zcl_HandleExternal              },
+  /* ZCL_CMD_READ_REPORT_CFG */     { zclParseInReadReportCfgCmd,    zclReporting_ProcessInReadReportCfgCmd },
+  /* ZCL_CMD_READ_REPORT_CFG_RSP */ { zclParseInReadReportCfgRspCmd, zcl_HandleExternal              },
+  /* ZCL_CMD_REPORT */              { zclParseInReportCmd,           zcl_HandleExternal              },
+#elif defined ( ZCL_REPORT )
   /* ZCL_CMD_CONFIG_REPORT */       { zclParseInConfigReportCmd,     zcl_HandleExternal              },
   /* ZCL_CMD_CONFIG_REPORT_RSP */   { zclParseInConfigReportRspCmd,  zcl_HandleExternal              },
   /* ZCL_CMD_READ_REPORT_CFG */     { zclParseInReadReportCfgCmd,    zcl_HandleExternal              },
@@ -405,6 +439,15 @@ uint16 zcl_event_loop( uint8 task_id, uint16 events )
     return (events ^ SYS_EVENT_MSG);
   }
 
+#if defined ( ZCL_REPORTING )
+  if ( events & ZCL_REPORTING_EVT )
+  {
+    zclReporting_Process();
+
+    return ( events ^ ZCL_REPORTING_EVT );
+  }
+#endif // ZCL_REPORTING
+
   // Discard unknown events
   return 0;
 }
@@ -650,6 +693,8 @@ ZStatus_t zcl_registerPlugin( uint16 startClusterID,
 {
   zclLibPlugin_t *pNewItem;
   zclLibPlugin_t *pLoop;
+  zclLibPlugin_t **pNewIdx;
+  uint8 i;
 
   // Fill in the new profile list
   pNewItem = zcl_mem_alloc( sizeof( zclLibPlugin_t ) );
@@ -658,6 +703,13 @@ ZStatus_t zcl_registerPlugin( uint16 startClusterID,
     return (ZMemError);
   }
 
+  pNewIdx = zcl_mem_alloc( ( pluginCnt + 1 ) * sizeof( zclLibPlugin_t * ) );
+  if ( pNewIdx == NULL )
+  {
+    zcl_mem_free( pNewItem );
+    return (ZMemError);
+  }
+
   // Fill in the plugin record.
   pNewItem->next = (zclLibPlugin_t *)NULL;
   pNewItem->startClusterID = startClusterID;
@@ -682,6 +734,25 @@ ZStatus_t zcl_registerPlugin( uint16 startClusterID,
     pLoop->next = pNewItem;
   }
 
+  // Insert it in the index ahead of any plugin with the same start cluster ID,
+  // so that zclFindPlugin() still finds the first one registered
+  for ( i = 0; ( i < pluginCnt ) && ( pluginIdx[i]->startClusterID < startClusterID ); i++ )
+  {
+    pNewIdx[i] = pluginIdx[i];
+  }
+  pNewIdx[i] = pNewItem;
+  for ( ; i < pluginCnt; i++ )
+  {
+    pNewIdx[i+1] = pluginIdx[i];
+  }
+
+  if ( pluginIdx != NULL )
+  {
+    zcl_mem_free( pluginIdx );
+  }
+  pluginIdx = pNewIdx;
+  pluginCnt++;
+
   return ( ZSuccess );
 }
 
@@ -712,6 +783,7 @@ ZStatus_t zcl_registerCmdList( uint8 endpoint, CONST uint8 cmdListSize, CONST zc
   pNewItem->endpoint = endpoint;
   pNewItem->numCommands = cmdListSize;
   pNewItem->pCmdRecs = newCmdList;
+  pNewItem->bsearch = zclBuildCmdIdx( cmdListSize, newCmdList, &(pNewItem->pIdx) );
 
   // Find spot in list
   if ( gpCmdList == NULL )
@@ -738,7 +810,9 @@ ZStatus_t zcl_registerCmdList( uint8 endpoint, CONST uint8 cmdListSize, CONST zc
 /*********************************************************************
  * @fn          zcl_registerAttrList
  *
- * @brief       Register an Attribute List with ZCL Foundation
+ * @brief       Register an Attribute List with ZCL Foundation. Lists longer
+ *              than ZCL_FIND_LINEAR_MAX are binary searched by zclFindAttrRec(),
+ *              through an allocated index if not in cluster/attribute order.
  *
  * @param       endpoint - endpoint the attribute list belongs to
  * @param       numAttr - number of attributes in list
@@ -764,8 +838,12 @@ ZStatus_t zcl_registerAttrList( uint8 endpoint, uint8 numAttr, CONST zclAttrRec_
   pNewItem->next = (zclAttrRecsList *)NULL;
   pNewItem->endpoint = endpoint;
   pNewItem->pfnReadWriteCB = NULL;
+#ifdef ZCL_REPORT
+  pNewItem->pfnReportCB = NULL;
+#endif
   pNewItem->numAttributes = numAttr;
   pNewItem->attrs = newAttrList;
+  pNewItem->bsearch = zclBuildAttrIdx( numAttr, newAttrList, &(pNewItem->pIdx) );
 
   // Find spot in list
   if ( attrList == NULL )
@@ -899,6 +977,43 @@ ZStatus_t zcl_registerReadWriteCB( uint8 endpoint, zclReadWriteCB_t pfnReadWrite
   return ( ZFailure );
 }
 
+#ifdef ZCL_REPORT
+/*********************************************************************
+ * @fn          zcl_registerReportCB
+ *
+ * @brief       Register the application's callback function to process
+ *              Report Attributes Commands received on an endpoint.
+ *
+ *              With a callback registered, reports are neither parsed
+ *              into an allocated zclReportCmd_t nor sent to the task
+ *              registered with zcl_registerForMsg(); the callback walks
+ *              the attribute reports in the received frame with
+ *              zclReportIterNext() instead. Registering NULL restores
+ *              the ZCL_INCOMING_MSG delivery.
+ *
+ *              Note: The attribute list of the endpoint must already
+ *                    be registered.
+ *
+ * @param       endpoint - application's endpoint
+ * @param       pfnReportCB - function pointer to report routine
+ *
+ * @return      ZSuccess if successful. ZFailure, otherwise.
+ */
+ZStatus_t zcl_registerReportCB( uint8 endpoint, zclReportCB_t pfnReportCB )
+{
+  zclAttrRecsList *pRec = zclFindAttrRecsList( endpoint );
+
+  if ( pRec != NULL )
+  {
+    pRec->pfnReportCB = pfnReportCB;
+
+    return ( ZSuccess );
+  }
+
+  return ( ZFailure );
+}
+#endif // ZCL_REPORT
+
 /*********************************************************************
  * @fn      zcl_DeviceOperational
  *
@@ -972,18 +1087,61 @@ ZStatus_t zcl_SendCommand( uint8 srcEP, afAddrType_t *destAddr,
                            uint16 clusterID, uint8 cmd, uint8 specific, uint8 direction,
                            uint8 disableDefaultRsp, uint16 manuCode, uint8 seqNum,
                            uint16 cmdFormatLen, uint8 *cmdFormat )
+{
+  afBuf_t *pBuf;
+
+  // Allocate the buffer needed, with room for the ZCL header
+  pBuf = AF_BufAlloc( ZCL_HDR_LEN_MAX, cmdFormatLen );
+  if ( pBuf == NULL )
+  {
+    return ( ZMemError ); // EMBEDDED RETURN
+  }
+
+  // Fill in the command frame
+  zcl_memcpy( pBuf->pData, cmdFormat, cmdFormatLen );
+
+  return ( zcl_SendCommandBuf( srcEP, destAddr, clusterID, cmd, specific, direction,
+                               disableDefaultRsp, manuCode, seqNum, pBuf ) );
+}
+
+/*********************************************************************
+ * @fn      zcl_SendCommandBuf
+ *
+ * @brief   Send a command whose payload has already been built in
+ *          an AF_BufAlloc() frame with ZCL_HDR_LEN_MAX bytes of
+ *          headroom. The ZCL header is written into the headroom and
+ *          the frame is handed to AF as is, so senders that serialise
+ *          straight into the frame need no second buffer and no copy.
+ *
+ *          NOTE: The frame is freed, whatever the outcome.
+ *
+ * @param   srcEp - source endpoint
+ * @param   destAddr - destination address
+ * @param   clusterID - cluster ID
+ * @param   cmd - command ID
+ * @param   specific - whether the command is Cluster Specific
+ * @param   direction - client/server direction of the command
+ * @param   disableDefaultRsp - disable Default Response command
+ * @param   manuCode - manufacturer code for proprietary extensions to a profile
+ * @param   seqNumber - identification number for the transaction
+ * @param   pBuf - frame holding the command payload
+ *
+ * @return  ZSuccess if OK
+ */
+ZStatus_t zcl_SendCommandBuf( uint8 srcEP, afAddrType_t *destAddr,
+                              uint16 clusterID, uint8 cmd, uint8 specific, uint8 direction,
+                              uint8 disableDefaultRsp, uint16 manuCode, uint8 seqNum,
+                              afBuf_t *pBuf )
 {
   endPointDesc_t *epDesc;
   zclFrameHdr_t hdr;
-  uint8 *msgBuf;
-  uint16 msgLen;
-  uint8 *pBuf;
+  uint8 *pHdr;
   uint8 options;
-  ZStatus_t status;
 
   epDesc = afFindEndPointDesc( srcEP );
   if ( epDesc == NULL )
   {
+    AF_BufFree( pBuf );
     return ( ZInvalidParameter ); // EMBEDDED RETURN
   }
 
@@ -1027,6 +1185,7 @@ ZStatus_t zcl_SendCommand( uint8 srcEP, afAddrType_t *destAddr,
        ( zcl_DeviceOperational( srcEP, clusterID, hdr.fc.type,
                                 cmd, epDesc->simpleDesc->AppProfId ) == FALSE ) )
   {
+    AF_BufFree( pBuf );
     return ( ZFailure ); // EMBEDDED RETURN
   }
 
@@ -1063,30 +1222,17 @@ ZStatus_t zcl_SendCommand( uint8 srcEP, afAddrType_t *destAddr,
   // Fill in the command
   hdr.commandID = cmd;
 
-  // calculate the needed buffer size
-  msgLen = zclCalcHdrSize( &hdr );
-  msgLen += cmdFormatLen;
-
-  // Allocate the buffer needed
-  msgBuf = zcl_mem_alloc( msgLen );
-  if ( msgBuf != NULL )
-  {
-    // Fill in the ZCL Header
-    pBuf = zclBuildHdr( &hdr, msgBuf );
-
-    // Fill in the command frame
-    zcl_memcpy( pBuf, cmdFormat, cmdFormatLen );
-
-    status = AF_DataRequest( destAddr, epDesc, clusterID, msgLen, msgBuf,
-                             &zcl_TransID, options, AF_DEFAULT_RADIUS );
-    zcl_mem_free ( msgBuf );
-  }
-  else
+  // Fill in the ZCL Header, in front of the command frame
+  pHdr = AF_BufPush( pBuf, zclCalcHdrSize( &hdr ) );
+  if ( pHdr == NULL )
   {
-    status = ZMemError;
+    AF_BufFree( pBuf );
+    return ( ZInvalidParameter ); // EMBEDDED RETURN
   }
+  (void)zclBuildHdr( &hdr, pHdr );
 
-  return ( status );
+  return ( AF_DataRequestBuf( destAddr, epDesc, clusterID, pBuf,
+                              &zcl_TransID, options, AF_DEFAULT_RADIUS ) );
 }
 
 #ifdef ZCL_READ
@@ -1158,7 +1304,7 @@ ZStatus_t zcl_SendReadRsp( uint8 srcEP, afAddrType_t *dstAddr,
                            uint16 clusterID, zclReadRspCmd_t *readRspCmd,
                            uint8 direction, uint8 disableDefaultRsp, uint8 seqNum )
 {
-  uint8 *buf;
+  afBuf_t *buf;
   uint16 len = 0;
   ZStatus_t status;
   uint8 i;
@@ -1186,11 +1332,12 @@ ZStatus_t zcl_SendReadRsp( uint8 srcEP, afAddrType_t *dstAddr,
     }
   }
 
-  buf = zcl_mem_alloc( len );
+  // One frame for the whole message: the ZCL header goes into the headroom
+  buf = AF_BufAlloc( ZCL_HDR_LEN_MAX, len );
   if ( buf != NULL )
   {
     // Load the buffer - serially
-    uint8 *pBuf = buf;
+    uint8 *pBuf = buf->pData;
 
     for ( i = 0; i < readRspCmd->numAttr; i++ )
     {
@@ -1220,9 +1367,8 @@ ZStatus_t zcl_SendReadRsp( uint8 srcEP, afAddrType_t *dstAddr,
       }
     } // for loop
 
-    status = zcl_SendCommand( srcEP, dstAddr, clusterID, ZCL_CMD_READ_RSP, FALSE,
-                              direction, disableDefaultRsp, 0, seqNum, len, buf );
-    zcl_mem_free( buf );
+    status = zcl_SendCommandBuf( srcEP, dstAddr, clusterID, ZCL_CMD_READ_RSP, FALSE,
+                                 direction, disableDefaultRsp, 0, seqNum, buf );
   }
   else
   {
@@ -1669,7 +1815,7 @@ ZStatus_t zcl_SendReportCmd( uint8 srcEP, afAddrType_t *dstAddr,
                              uint8 direction, uint8 disableDefaultRsp, uint8 seqNum )
 {
   uint16 dataLen = 0;
-  uint8 *buf;
+  afBuf_t *buf;
   ZStatus_t status;
   uint8 i;
 
@@ -1684,11 +1830,12 @@ ZStatus_t zcl_SendReportCmd( uint8 srcEP, afAddrType_t *dstAddr,
     dataLen += zclGetAttrDataLength( reportRec->dataType, reportRec->attrData );
   }
 
-  buf = zcl_mem_alloc( dataLen );
+  // One frame for the whole message: the ZCL header goes into the headroom
+  buf = AF_BufAlloc( ZCL_HDR_LEN_MAX, dataLen );
   if ( buf != NULL )
   {
     // Load the buffer - serially
-    uint8 *pBuf = buf;
+    uint8 *pBuf = buf->pData;
 
     for ( i = 0; i < reportCmd->numAttr; i++ )
     {
@@ -1701,9 +1848,8 @@ ZStatus_t zcl_SendReportCmd( uint8 srcEP, afAddrType_t *dstAddr,
       pBuf = zclSerializeData( reportRec->dataType, reportRec->attrData, pBuf );
     }
 
-    status = zcl_SendCommand( srcEP, dstAddr, clusterID, ZCL_CMD_REPORT, FALSE,
-                              direction, disableDefaultRsp, 0, seqNum, dataLen, buf );
-    zcl_mem_free( buf );
+    status = zcl_SendCommandBuf( srcEP, dstAddr, clusterID, ZCL_CMD_REPORT, FALSE,
+                                 direction, disableDefaultRsp, 0, seqNum, buf );
   }
   else
   {
@@ -2048,6 +2194,9 @@ zclProcMsgStatus_t zcl_ProcessMessageMSG( afIncomingMSGPacket_t *pkt )
   uint8 interPanMsg;
   ZStatus_t status = ZFailure;
   uint8 defaultResponseSent = FALSE;
+#ifdef ZCL_REPORT
+  zclReportCB_t pfnReportCB;
+#endif
 
   if ( pkt->cmd.DataLength < ZCL_VALID_MIN_HEADER_LEN  )
   {
@@ -2149,6 +2298,19 @@ zclProcMsgStatus_t zcl_ProcessMessageMSG( afIncomingMSGPacket_t *pkt )
       // We don't support any manufacturer specific command
       status = ZCL_STATUS_UNSUP_MANU_GENERAL_COMMAND;
     }
+#ifdef ZCL_REPORT
+    else if ( ( inMsg.hdr.commandID == ZCL_CMD_REPORT ) &&
+              ( ( pfnReportCB = zclGetReportCB( pkt->endPoint ) ) != NULL ) )
+    {
+      zclReportIter_t iter;
+
+      // Hand the reports to the application in place, nothing to parse or free
+      zclReportIterInit( &iter, inMsg.pData, inMsg.pDataLen );
+      pfnReportCB( &inMsg, &iter );
+
+      status = ZSuccess;
+    }
+#endif // ZCL_REPORT
     else if ( ( inMsg.hdr.commandID <= ZCL_CMD_MAX ) &&
               ( zclCmdTable[inMsg.hdr.commandID].pfnParseInProfile != NULL ) )
     {
@@ -2385,18 +2547,34 @@ static uint8 zclCalcHdrSize( zclFrameHdr_t *hdr )
  */
 static zclLibPlugin_t *zclFindPlugin( uint16 clusterID, uint16 profileID )
 {
-  zclLibPlugin_t *pLoop = plugins;
+  uint8 lo = 0;
+  uint8 hi = pluginCnt;
+  uint8 mid;
 
   (void)profileID;  // Intentionally unreferenced parameter
 
-  while ( pLoop != NULL )
+  // Find the first plugin starting after the cluster ID
+  while ( lo < hi )
   {
-    if ( ( clusterID >= pLoop->startClusterID ) && ( clusterID <= pLoop->endClusterID ) )
+    mid = (uint8)( ( lo + hi ) / 2 );
+    if ( pluginIdx[mid]->startClusterID <= clusterID )
     {
-      return ( pLoop );
+      lo = mid + 1;
+    }
+    else
+    {
+      hi = mid;
     }
+  }
 
-    pLoop = pLoop->next;
+  // The ranges don't normally overlap, so the one just before is the only
+  // candidate; walk back in case a wider range starts earlier
+  while ( lo-- > 0 )
+  {
+    if ( clusterID <= pluginIdx[lo]->endClusterID )
+    {
+      return ( pluginIdx[lo] );
+    }
   }
 
   return ( (zclLibPlugin_t *)NULL );
@@ -2446,8 +2624,43 @@ uint8 zclFindCmdRec( uint8 endpoint, uint16 clusterID, uint8 cmdID, zclCommandRe
   uint8 i;
   zclCmdRecsList_t *pRec = zclFindCmdRecsList( endpoint );
 
-  if ( pRec != NULL )
+  if ( ( pRec != NULL ) && pRec->bsearch )
+  {
+    uint8 hi = pRec->numCommands;
+    uint8 mid;
+    CONST zclCommandRec_t *pCmdRec;
+
+    // Binary search for the first record not below {clusterID, cmdID}
+    i = 0;
+    while ( i < hi )
+    {
+      mid = (uint8)( ( i + hi ) / 2 );
+      pCmdRec = &(pRec->pCmdRecs[( pRec->pIdx != NULL ) ? pRec->pIdx[mid] : mid]);
+      if ( ( pCmdRec->clusterID < clusterID ) ||
+           ( ( pCmdRec->clusterID == clusterID ) && ( pCmdRec->cmdID < cmdID ) ) )
+      {
+        i = mid + 1;
+      }
+      else
+      {
+        hi = mid;
+      }
+    }
+
+    if ( i < pRec->numCommands )
+    {
+      pCmdRec = &(pRec->pCmdRecs[( pRec->pIdx != NULL ) ? pRec->pIdx[i] : i]);
+      if ( pCmdRec->clusterID == clusterID && pCmdRec->cmdID == cmdID )
+      {
+        *pCmd = *pCmdRec;
+
+        return ( TRUE ); // EMBEDDED RETURN
+      }
+    }
+  }
+  else if ( pRec != NULL )
   {
+    // Short or unsorted without an index (out of memory), scan the list
     for ( i = 0; i < pRec->numCommands; i++ )
     {
       if ( pRec->pCmdRecs[i].clusterID == clusterID && pRec->pCmdRecs[i].cmdID == cmdID )
@@ -2461,6 +2674,74 @@ uint8 zclFindCmdRec( uint8 endpoint, uint16 clusterID, uint8 cmdID, zclCommandRe
 
   return ( FALSE );
 }
+/*********************************************************************
+ * @fn      zclBuildCmdIdx
+ *
+ * @brief   Work out how zclFindCmdRec() searches a command record list.
+ *          Short lists are scanned. Longer ones are binary searched by
+ *          cluster ID, then command ID: in place if the table is in that
+ *          order already (as the *_data.c tables normally are), else
+ *          through an allocated index of the record positions.
+ *
+ * @param   numCmds - number of command records
+ * @param   cmds - array of command records
+ * @param   ppIdx - where to put the index, NULL if none
+ *
+ * @return  TRUE if the list can be binary searched, FALSE to scan it
+ */
+static uint8 zclBuildCmdIdx( uint8 numCmds, CONST zclCommandRec_t cmds[], uint8 **ppIdx )
+{
+  uint8 *pIdx;
+  uint8 i, j;
+
+  *ppIdx = NULL;
+
+  if ( numCmds <= ZCL_FIND_LINEAR_MAX )
+  {
+    return ( FALSE );
+  }
+
+  for ( i = 1; i < numCmds; i++ )
+  {
+    if ( ( cmds[i-1].clusterID > cmds[i].clusterID ) ||
+         ( ( cmds[i-1].clusterID == cmds[i].clusterID ) && ( cmds[i-1].cmdID > cmds[i].cmdID ) ) )
+    {
+      break;
+    }
+  }
+
+  if ( i == numCmds )
+  {
+    return ( TRUE );
+  }
+
+  pIdx = zcl_mem_alloc( numCmds );
+  if ( pIdx == NULL )
+  {
+    return ( FALSE );
+  }
+
+  // Insertion sort, registration only. Duplicate records keep their order.
+  for ( i = 0; i < numCmds; i++ )
+  {
+    for ( j = i; j > 0; j-- )
+    {
+      CONST zclCommandRec_t *pPrev = &cmds[pIdx[j-1]];
+
+      if ( ( pPrev->clusterID < cmds[i].clusterID ) ||
+           ( ( pPrev->clusterID == cmds[i].clusterID ) && ( pPrev->cmdID <= cmds[i].cmdID ) ) )
+      {
+        break;
+      }
+      pIdx[j] = pIdx[j-1];
+    }
+    pIdx[j] = i;
+  }
+
+  *ppIdx = pIdx;
+
+  return ( TRUE );
+}
 #endif // ZCL_DISCOVER
 
 /*********************************************************************
@@ -2476,10 +2757,17 @@ static zclAttrRecsList *zclFindAttrRecsList( uint8 endpoint )
 {
   zclAttrRecsList *pLoop = attrList;
 
+  // Messages tend to come in for the same endpoint
+  if ( ( attrListMRU != NULL ) && ( attrListMRU->endpoint == endpoint ) )
+  {
+    return ( attrListMRU );
+  }
+
   while ( pLoop != NULL )
   {
     if ( pLoop->endpoint == endpoint )
     {
+      attrListMRU = pLoop;
       return ( pLoop );
     }
 
@@ -2506,8 +2794,43 @@ uint8 zclFindAttrRec( uint8 endpoint, uint16 clusterID, uint16 attrId, zclAttrRe
   uint8 x;
   zclAttrRecsList *pRec = zclFindAttrRecsList( endpoint );
 
-  if ( pRec != NULL )
+  if ( ( pRec != NULL ) && pRec->bsearch )
   {
+    uint8 hi = pRec->numAttributes;
+    uint8 mid;
+    CONST zclAttrRec_t *pAttrRec;
+
+    // Binary search for the first record not below {clusterID, attrId}
+    x = 0;
+    while ( x < hi )
+    {
+      mid = (uint8)( ( x + hi ) / 2 );
+      pAttrRec = &(pRec->attrs[( pRec->pIdx != NULL ) ? pRec->pIdx[mid] : mid]);
+      if ( ( pAttrRec->clusterID < clusterID ) ||
+           ( ( pAttrRec->clusterID == clusterID ) && ( pAttrRec->attr.attrId < attrId ) ) )
+      {
+        x = mid + 1;
+      }
+      else
+      {
+        hi = mid;
+      }
+    }
+
+    if ( x < pRec->numAttributes )
+    {
+      pAttrRec = &(pRec->attrs[( pRec->pIdx != NULL ) ? pRec->pIdx[x] : x]);
+      if ( pAttrRec->clusterID == clusterID && pAttrRec->attr.attrId == attrId )
+      {
+        *pAttr = *pAttrRec;
+
+        return ( TRUE ); // EMBEDDED RETURN
+      }
+    }
+  }
+  else if ( pRec != NULL )
+  {
+    // Short or unsorted without an index (out of memory), scan the list
     for ( x = 0; x < pRec->numAttributes; x++ )
     {
       if ( pRec->attrs[x].clusterID == clusterID && pRec->attrs[x].attr.attrId == attrId )
@@ -2522,6 +2845,75 @@ uint8 zclFindAttrRec( uint8 endpoint, uint16 clusterID, uint16 attrId, zclAttrRe
   return ( FALSE );
 }
 
+/*********************************************************************
+ * @fn      zclBuildAttrIdx
+ *
+ * @brief   Work out how zclFindAttrRec() searches a attribute record list.
+ *          Short lists are scanned. Longer ones are binary searched by
+ *          cluster ID, then attribute ID: in place if the table is in that
+ *          order already (as the *_data.c tables normally are), else
+ *          through an allocated index of the record positions.
+ *
+ * @param   numAttr - number of attribute records
+ * @param   attrs - array of attribute records
+ * @param   ppIdx - where to put the index, NULL if none
+ *
+ * @return  TRUE if the list can be binary searched, FALSE to scan it
+ */
+static uint8 zclBuildAttrIdx( uint8 numAttr, CONST zclAttrRec_t attrs[], uint8 **ppIdx )
+{
+  uint8 *pIdx;
+  uint8 i, j;
+
+  *ppIdx = NULL;
+
+  if ( numAttr <= ZCL_FIND_LINEAR_MAX )
+  {
+    return ( FALSE );
+  }
+
+  for ( i = 1; i < numAttr; i++ )
+  {
+    if ( ( attrs[i-1].clusterID > attrs[i].clusterID ) ||
+         ( ( attrs[i-1].clusterID == attrs[i].clusterID ) && ( attrs[i-1].attr.attrId > attrs[i].attr.attrId ) ) )
+    {
+      break;
+    }
+  }
+
+  if ( i == numAttr )
+  {
+    return ( TRUE );
+  }
+
+  pIdx = zcl_mem_alloc( numAttr );
+  if ( pIdx == NULL )
+  {
+    return ( FALSE );
+  }
+
+  // Insertion sort, registration only. Duplicate records keep their order.
+  for ( i = 0; i < numAttr; i++ )
+  {
+    for ( j = i; j > 0; j-- )
+    {
+      CONST zclAttrRec_t *pPrev = &attrs[pIdx[j-1]];
+
+      if ( ( pPrev->clusterID < attrs[i].clusterID ) ||
+           ( ( pPrev->clusterID == attrs[i].clusterID ) && ( pPrev->attr.attrId <= attrs[i].attr.attrId ) ) )
+      {
+        break;
+      }
+      pIdx[j] = pIdx[j-1];
+    }
+    pIdx[j] = i;
+  }
+
+  *ppIdx = pIdx;
+
+  return ( TRUE );
+}
+
 #if defined ( ZCL_STANDALONE )
 /*********************************************************************
  * @fn      zclSetAttrRecList
@@ -2544,8 +2936,13 @@ uint8 zclSetAttrRecList( uint8 endpoint, uint8 numAttr, CONST zclAttrRec_t attrL
 
   if ( pRecsList != NULL )
   {
+    if ( pRecsList->pIdx != NULL )
+    {
+      zcl_mem_free( pRecsList->pIdx );
+    }
     pRecsList->numAttributes = numAttr;
     pRecsList->attrs = attrList;
+    pRecsList->bsearch = zclBuildAttrIdx( numAttr, attrList, &(pRecsList->pIdx) );
     return ( TRUE );
   }
 
@@ -2599,6 +2996,29 @@ static zclAuthorizeCB_t zclGetAuthorizeCB( uint8 endpoint )
 }
 #endif // ZCL_READ || ZCL_WRITE
 
+#ifdef ZCL_REPORT
+/*********************************************************************
+ * @fn      zclGetReportCB
+ *
+ * @brief   Get the Report callback function pointer for a given endpoint.
+ *
+ * @param   endpoint - Application's endpoint
+ *
+ * @return  Report CB, NULL if not found
+ */
+static zclReportCB_t zclGetReportCB( uint8 endpoint )
+{
+  zclAttrRecsList *pRec = zclFindAttrRecsList( endpoint );
+
+  if ( pRec != NULL )
+  {
+    return ( pRec->pfnReportCB );
+  }
+
+  return ( NULL );
+}
+#endif // ZCL_REPORT
+
 /*********************************************************************
  * @fn      zclFindClusterOption
  *
@@ -4010,6 +4430,75 @@ static void *zclParseInReadReportCfgRspCmd( zclParseCmd_t *pCmd )
   return ( (void *)readReportCfgRspCmd );
 }
 
+/*********************************************************************
+ * @fn      zclReportIterInit
+ *
+ * @brief   Start walking the attribute reports of a Report Attributes
+ *          Command.
+ *
+ * @param   pIter - iterator to initialize
+ * @param   pData - command payload (after the ZCL header)
+ * @param   dataLen - length of the command payload
+ *
+ * @return  none
+ */
+void zclReportIterInit( zclReportIter_t *pIter, uint8 *pData, uint16 dataLen )
+{
+  pIter->pBuf = pData;
+  pIter->pEnd = pData + dataLen;
+}
+
+/*********************************************************************
+ * @fn      zclReportIterNext
+ *
+ * @brief   Get the next attribute report. The attribute data is NOT
+ *          copied, pView->attrData points into the command payload.
+ *
+ * @param   pIter - iterator
+ * @param   pView - where to put the attribute report
+ *
+ * @return  TRUE if pView was filled in, FALSE at the end of the
+ *          command or if the rest of the payload is malformed
+ */
+uint8 zclReportIterNext( zclReportIter_t *pIter, zclReportView_t *pView )
+{
+  uint8 *pBuf = pIter->pBuf;
+  uint16 remain;
+
+  // attribute id and data type
+  if ( ( pIter->pEnd - pBuf ) < 3 )
+  {
+    return ( FALSE );
+  }
+
+  pView->attrID = BUILD_UINT16( pBuf[0], pBuf[1] );
+  pView->dataType = pBuf[2];
+  pBuf += 3;
+  remain = (uint16)( pIter->pEnd - pBuf );
+
+  // a string length field must be there before it can be read
+  if ( ( ( pView->dataType == ZCL_DATATYPE_CHAR_STR || pView->dataType == ZCL_DATATYPE_OCTET_STR ) &&
+         ( remain < 1 ) ) ||
+       ( ( pView->dataType == ZCL_DATATYPE_LONG_CHAR_STR || pView->dataType == ZCL_DATATYPE_LONG_OCTET_STR ) &&
+         ( remain < 2 ) ) )
+  {
+    pIter->pBuf = pIter->pEnd;
+    return ( FALSE );
+  }
+
+  pView->dataLen = zclGetAttrDataLength( pView->dataType, pBuf );
+  if ( pView->dataLen > remain )
+  {
+    pIter->pBuf = pIter->pEnd;
+    return ( FALSE );
+  }
+
+  pView->attrData = pBuf;
+  pIter->pBuf = pBuf + pView->dataLen;
+
+  return ( TRUE );
+}
+
 /*********************************************************************
  * @fn      zclParseInReportCmd
  *
@@ -4025,33 +4514,21 @@ static void *zclParseInReadReportCfgRspCmd( zclParseCmd_t *pCmd )
 void *zclParseInReportCmd( zclParseCmd_t *pCmd )
 {
   zclReportCmd_t *reportCmd;
-  uint8 *pBuf = pCmd->pData;
-  uint16 attrDataLen;
+  zclReportIter_t iter;
+  zclReportView_t view;
   uint8 *dataPtr;
   uint8 numAttr = 0;
   uint8 hdrLen;
   uint16 dataLen = 0;
 
   // find out the number of attributes and the length of attribute data
-  while ( pBuf < ( pCmd->pData + pCmd->dataLen ) )
+  zclReportIterInit( &iter, pCmd->pData, pCmd->dataLen );
+  while ( zclReportIterNext( &iter, &view ) )
   {
-    uint8 dataType;
-
     numAttr++;
-    pBuf += 2; // move pass attribute id
-
-    dataType = *pBuf++;
-
-    attrDataLen = zclGetAttrDataLength( dataType, pBuf );
-    pBuf += attrDataLen; // move pass attribute data
 
     // add padding if needed
-    if ( PADDING_NEEDED( attrDataLen ) )
-    {
-      attrDataLen++;
-    }
-
-    dataLen += attrDataLen;
+    dataLen += view.dataLen + ( PADDING_NEEDED( view.dataLen ) ? 1 : 0 );
   }
 
   hdrLen = sizeof( zclReportCmd_t ) + ( numAttr * sizeof( zclReport_t ) );
@@ -4060,31 +4537,23 @@ void *zclParseInReportCmd( zclParseCmd_t *pCmd )
   if (reportCmd != NULL )
   {
     uint8 i;
-    pBuf = pCmd->pData;
     dataPtr = (uint8 *)( (uint8 *)reportCmd + hdrLen );
 
     reportCmd->numAttr = numAttr;
+    zclReportIterInit( &iter, pCmd->pData, pCmd->dataLen );
     for ( i = 0; i < numAttr; i++ )
     {
       zclReport_t *reportRec = &(reportCmd->attrList[i]);
 
-      reportRec->attrID = BUILD_UINT16( pBuf[0], pBuf[1] );
-      pBuf += 2;
-      reportRec->dataType = *pBuf++;
+      (void)zclReportIterNext( &iter, &view );
+      reportRec->attrID = view.attrID;
+      reportRec->dataType = view.dataType;
 
-      attrDataLen = zclGetAttrDataLength( reportRec->dataType, pBuf );
-      zcl_memcpy( dataPtr, pBuf, attrDataLen );
+      zcl_memcpy( dataPtr, view.attrData, view.dataLen );
       reportRec->attrData = dataPtr;
 
-      pBuf += attrDataLen; // move pass attribute data
-
       // advance attribute data pointer
-      if ( PADDING_NEEDED( attrDataLen ) )
-      {
-        attrDataLen++;
-      }
-
-      dataPtr += attrDataLen;
+      dataPtr += view.dataLen + ( PADDING_NEEDED( view.dataLen ) ? 1 : 0 );
     }
   }
 
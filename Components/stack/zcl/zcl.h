@@ -186,6 +186,9 @@ extern "C"
 #define ZCL_FRAME_CLIENT_SERVER_DIR                     0x00
 #define ZCL_FRAME_SERVER_CLIENT_DIR                     0x01
 
+/*** Largest ZCL header: frame control, manufacturer code, sequence number, command ID ***/
+#define ZCL_HDR_LEN_MAX                                 5
+
 /*** Chipcon Manufacturer Code ***/
 #define CC_MANUFACTURER_CODE                            0x1001
 
@@ -580,6 +583,23 @@ typedef struct
   zclReport_t attrList[];    // attribute report list
 } zclReportCmd_t;
 
+// Attribute Report iterator, walks the attribute reports of a received
+// Report Attributes Command in place (see zclReportIterNext)
+typedef struct
+{
+  uint8 *pBuf;               // next attribute report
+  uint8 *pEnd;               // end of the command payload
+} zclReportIter_t;
+
+// Attribute Report as seen through the iterator
+typedef struct
+{
+  uint16 attrID;             // atrribute ID
+  uint8  dataType;           // attribute data type
+  uint16 dataLen;            // length of the attribute data
+  uint8  *attrData;          // points into the received frame, NOT allocated
+} zclReportView_t;
+
 // Default Response Command format
 typedef struct
 {
@@ -758,6 +778,16 @@ typedef ZStatus_t (*zclReadWriteCB_t)( uint16 clusterId, uint16 attrId, uint8 op
 //           ZCL_STATUS_NOT_AUTHORIZED: Operation not authorized
 typedef ZStatus_t (*zclAuthorizeCB_t)( afAddrType_t *srcAddr, zclAttrRec_t *pAttr, uint8 oper );
 
+// Callback function prototype to process a Report Attributes Command
+//   without having it parsed into an allocated zclReportCmd_t.
+//
+//   pInMsg - incoming message, pInMsg->msg is the AF message
+//   pIter - iterator over the attribute reports in pInMsg->msg
+//
+//   The attribute data seen through the iterator is only valid
+//   until the callback returns.
+typedef void (*zclReportCB_t)( zclIncoming_t *pInMsg, zclReportIter_t *pIter );
+
 typedef struct
 {
   uint16  clusterID;      // Real cluster ID
@@ -899,6 +929,14 @@ extern ZStatus_t zcl_registerValidateAttrData( zclValidateAttrData_t pfnValidate
 extern ZStatus_t zcl_registerReadWriteCB( uint8 endpoint, zclReadWriteCB_t pfnReadWriteCB,
                                           zclAuthorizeCB_t pfnAuthorizeCB );
 
+#ifdef ZCL_REPORT
+/*
+ *  Register the application's callback function to receive Report
+ *  Attributes Commands in place instead of as a ZCL_INCOMING_MSG.
+ */
+extern ZStatus_t zcl_registerReportCB( uint8 endpoint, zclReportCB_t pfnReportCB );
+#endif // ZCL_REPORT
+
 /*
  *  Process incoming ZCL messages
  */
@@ -912,6 +950,15 @@ extern ZStatus_t zcl_SendCommand( uint8 srcEP, afAddrType_t *dstAddr,
                                   uint8 disableDefaultRsp, uint16 manuCode, uint8 seqNum,
                                   uint16 cmdFormatLen, uint8 *cmdFormat );
 
+/*
+ *  Function for Sending a Command built in an AF_BufAlloc() frame with
+ *  ZCL_HDR_LEN_MAX bytes of headroom (the frame is consumed)
+ */
+extern ZStatus_t zcl_SendCommandBuf( uint8 srcEP, afAddrType_t *dstAddr,
+                                     uint16 clusterID, uint8 cmd, uint8 specific, uint8 direction,
+                                     uint8 disableDefaultRsp, uint16 manuCode, uint8 seqNum,
+                                     afBuf_t *pBuf );
+
 #ifdef ZCL_READ
 /*
  *  Function for Reading an Attribute
@@ -1068,6 +1115,13 @@ extern void *zclParseInReadReportCfgCmd( zclParseCmd_t *pCmd );
  */
 extern void *zclParseInReportCmd( zclParseCmd_t *pCmd );
 
+/*
+ * Functions to walk the attribute reports of a Report Attributes Command
+ * without allocating memory
+ */
+extern void zclReportIterInit( zclReportIter_t *pIter, uint8 *pData, uint16 dataLen );
+extern uint8 zclReportIterNext( zclReportIter_t *pIter, zclReportView_t *pView );
+
 /*
  * Function to check to see if Data Type is Analog
  */
@@ -648,9 +648,11 @@ static int zclKE_HashFunc( unsigned char *pDigest,
                            unsigned long dataLen, 
                            unsigned char *pData )
 {
-  // Convert to bit length
-  dataLen *= 8;
-  sspMMOHash( NULL, 0, pData, ( uint16 )dataLen, pDigest );
+  sspMMOHash_t hash;
+
+  sspMMOHashInit( &hash );
+  sspMMOHashUpdate( &hash, pData, ( uint16 )dataLen );
+  sspMMOHashFinal( &hash, pDigest );
   return MCE_SUCCESS;
 }
 
@@ -660,7 +662,8 @@ static int zclKE_HashFunc( unsigned char *pDigest,
  * @brief   Key Derive Function (ANSI X9.63).
  *          Note this is not a generalized KDF. It only applies to the KDF
  *          specified in ZigBee SE profile. Only the first two hashed keys
- *          are calculated and concatenated.
+ *          are calculated and concatenated. Z is hashed once, both keys
+ *          carry on from a copy of its hash state.
  *
  * @param   pZData - input shared secret
  * @param   zDataLen - input shared secret length(ZCL_KE_PRIVATE_KEY_LEN)
@@ -671,21 +674,22 @@ static int zclKE_HashFunc( unsigned char *pDigest,
 static void zclKE_KeyDeriveFunction( uint8 *pZData, uint16 zDataLen, uint8 *pKeyData )
 {
   uint8 hashCounter[4] = {0x00, 0x00, 0x00, 0x01};
-  uint8 hashedData[ECCAPI_PRIVATE_KEY_283_LEN + 4]; // Use max ZCL_KE_PRIVATE_KEY_LEN
-  uint16 bitLen;
+  sspMMOHash_t hashZ;
+  sspMMOHash_t hash;
 
-  bitLen = ( zDataLen + 4 ) * 8;
+  sspMMOHashInit( &hashZ );
+  sspMMOHashUpdate( &hashZ, pZData, zDataLen );
 
   // Calculate K1: Ki = Hash(Z || Counter1 )
-  osal_memcpy( hashedData, pZData, zDataLen );
-  osal_memcpy( &(hashedData[zDataLen]), hashCounter, 4);
-
-  sspMMOHash(NULL, 0, hashedData, bitLen, pKeyData);
+  osal_memcpy( &hash, &hashZ, sizeof( sspMMOHash_t ) );
+  sspMMOHashUpdate( &hash, hashCounter, 4 );
+  sspMMOHashFinal( &hash, pKeyData );
 
   // Indrement the counter
-  hashedData[zDataLen + 3] = 0x02;
+  hashCounter[3] = 0x02;
 
-  sspMMOHash(NULL, 0, hashedData, bitLen, &(pKeyData[ZCL_KE_KEY_LEN]));
+  sspMMOHashUpdate( &hashZ, hashCounter, 4 );
+  sspMMOHashFinal( &hashZ, &(pKeyData[ZCL_KE_KEY_LEN]) );
 }
 
 /**************************************************************************************************
@@ -4100,7 +4104,6 @@ ZStatus_t zclKE_ECDSASign( uint16 suite, uint8 *pInBuf, uint8 inBufLen, uint8 *p
   uint8 status;
   uint8 result;
   uint8 msgDigest[ZCL_KE_MAC_LEN];
-  uint16 bitLen = inBufLen * 8;
   uint8 *pPrivateKey = NULL;
   uint16 privateKeyLen;
 
@@ -4119,7 +4122,7 @@ ZStatus_t zclKE_ECDSASign( uint16 suite, uint8 *pInBuf, uint8 inBufLen, uint8 *p
                   privateKeyLen, pPrivateKey );
 
     // First hash the input buffer
-    sspMMOHash(NULL, 0, pInBuf, bitLen, msgDigest);
+    zclKE_HashFunc( msgDigest, inBufLen, pInBuf );
 
     switch ( suite )
     {
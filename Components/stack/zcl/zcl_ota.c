@@ -61,12 +61,17 @@
 
 #if defined OTA_MMO_SIGN
 #include "ota_signature.h"
+#include "ssp_hash.h"
 #endif
 
 /******************************************************************************
  * MACROS
  */
 
+// Group or broadcast address, such as the one an image is streamed to
+#define ZCL_OTA_ADDR_IS_MCAST( pAddr ) \
+  ( ( ( pAddr )->addrMode == afAddrGroup ) || ( ( pAddr )->addrMode == afAddrBroadcast ) )
+
 /******************************************************************************
  * CONSTANTS
  */
@@ -77,6 +82,65 @@
 #define ZCL_OTA_STK_VER_OFFSET      18 // Stack version location in OTA upgrade image
 
 #define OTA_NEW_IMAGE_QUERY_RATE    30000 // ms - 5 minutes
+
+#if OTA_BLOCK_WINDOW > 1
+// Image block window slot states
+#define ZCL_OTA_BLK_FREE            0
+#define ZCL_OTA_BLK_SENT            1 // Requested, the response gives a response time sample
+#define ZCL_OTA_BLK_RESENT          2 // Requested again, no response time sample
+#define ZCL_OTA_BLK_RCVD            3 // Received, waiting for the blocks before it
+
+/******************************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+  uint32 offset;
+  uint16 sentTime;              // Low 16 bits of the system clock (ms) at the request
+  uint8 len;                    // Length requested, then length received
+  uint8 state;
+  uint8 data[OTA_MAX_MTU];
+} zclOTA_BlockSlot_t;
+#endif
+
+#if (defined OTA_SERVER) && (OTA_SERVER == TRUE) && OTA_SRV_CACHE_PAGES
+// Server image page states
+#define ZCL_OTA_PAGE_FREE           0
+#define ZCL_OTA_PAGE_READ           1 // File read sent to the console
+#define ZCL_OTA_PAGE_VALID          2
+
+#define ZCL_OTA_PAGE_NONE           0xFF
+
+#if defined MT_UART_RX_BUFF_MAX && \
+    ( OTA_SRV_CACHE_PAGE_SIZE + MT_OTA_FILE_READ_RSP_LEN + SPI_0DATA_MSG_LEN > MT_UART_RX_BUFF_MAX )
+#error "OTA_SRV_CACHE_PAGE_SIZE does not fit an MT file read response"
+#endif
+
+typedef struct
+{
+  zclOTA_FileID_t fileId;
+  uint32 offset;                // Page start in the image
+  uint16 used;                  // Cache clock at the last use
+  uint16 readTime;              // System clock (ms, low 16 bits) the read was sent at
+  uint8 len;                    // Bytes held, fewer at the end of the image
+  uint8 state;
+  uint8 data[OTA_SRV_CACHE_PAGE_SIZE];
+} zclOTA_SrvPage_t;
+
+typedef struct
+{
+  zclOTA_FileID_t fileId;
+  uint32 size;                  // Image size the console gave, 0 if unused
+} zclOTA_SrvImage_t;
+
+typedef struct
+{
+  afAddrType_t addr;
+  uint32 offset;
+  uint8 len;
+  uint8 page;                   // Page waited for, ZCL_OTA_PAGE_NONE if unused
+} zclOTA_SrvWaiter_t;
+#endif
 /******************************************************************************
  * GLOBAL VARIABLES
  */
@@ -142,6 +206,15 @@ zclOTA_QueryImageRspParams_t queryResponse;             // Global variable for s
 // Image block command field control value
 uint8 zclOTA_ImageBlockFC = OTA_BLOCK_FC_REQ_DELAY_PRESENT; // set bitmask field control value(s) for device
 
+#if OTA_BLOCK_WINDOW > 1
+// Largest number of image block requests outstanding, up to OTA_BLOCK_WINDOW
+uint8 zclOTA_BlockWindow = OTA_BLOCK_WINDOW;
+#endif
+
+#if (defined OTA_SERVER) && (OTA_SERVER == TRUE) && OTA_SRV_CACHE_PAGES
+zclOTA_SrvCacheStats_t zclOTA_SrvCacheStats;
+#endif
+
 /******************************************************************************
  * LOCAL VARIABLES
  */
@@ -156,9 +229,7 @@ static uint8 zclOTA_SeqNo = 0;
 static uint8 zclOTA_Permit = TRUE;
 
 #if defined OTA_MMO_SIGN
-static OTA_MmoCtrl_t zclOTA_MmoHash;
-static uint8 zclOTA_DataToHash[OTA_MMO_HASH_SIZE];
-static uint8 zclOTA_HashPos;
+static sspMMOHash_t zclOTA_MmoHash;
 static uint8 zclOTA_SignerIEEE[Z_EXTADDR_LEN];
 static uint8 zclOTA_SignatureData[OTA_SIGNATURE_LEN];
 static uint8 zclOTA_Certificate[OTA_CERTIFICATE_LEN];
@@ -181,6 +252,23 @@ static uint8 zclOTA_UpgradeEndRetry;
 
 static uint8 zclOTA_ClientPdState;
 
+#if OTA_BLOCK_WINDOW > 1
+// Image block window
+static zclOTA_BlockSlot_t zclOTA_BlockSlot[OTA_BLOCK_WINDOW];
+static uint32 zclOTA_BlockReqEnd;   // End of the furthest block requested
+static uint8 zclOTA_BlockWin;       // Requests allowed outstanding now
+static uint16 zclOTA_BlockRttMin;   // Lowest response time seen (ms)
+static uint16 zclOTA_BlockSrtt;     // Smoothed response time (ms)
+static uint16 zclOTA_BlockRttVar;   // Smoothed response time deviation (ms)
+#endif
+
+#if OTA_MCAST_BLOCKS
+// Blocks taken from a multicast stream ahead of the file offset, one bit each
+static uint8 zclOTA_McastMap[( OTA_MCAST_BLOCKS + 7 ) / 8];
+static uint8 zclOTA_McastOn;        // The image fits the map
+static uint8 zclOTA_McastListen;    // Stream heard, no block requested until it goes quiet
+#endif
+
 // OTA Header Magic Number Bytes
 static const uint8 zclOTA_HdrMagic[] = {0x1E, 0xF1, 0xEE, 0x0B};
 
@@ -191,6 +279,25 @@ static uint8 zclOta_OtaZDPTransSeq;
 
 #endif // (defined OTA_CLIENT) && (OTA_CLIENT == TRUE)
 
+#if (defined OTA_SERVER) && (OTA_SERVER == TRUE) && OTA_SRV_CACHE_PAGES
+// Server image page cache
+static zclOTA_SrvPage_t zclOTA_SrvPage[OTA_SRV_CACHE_PAGES];
+static zclOTA_SrvWaiter_t zclOTA_SrvWaiter[OTA_SRV_CACHE_WAITERS];
+static uint16 zclOTA_SrvCacheClock;
+
+// Sizes of the images last queried or streamed, which bound the read ahead
+static zclOTA_SrvImage_t zclOTA_SrvImage[OTA_SRV_CACHE_IMAGES];
+static uint8 zclOTA_SrvImageNext;
+#endif
+
+#if (defined OTA_SERVER) && (OTA_SERVER == TRUE) && OTA_MCAST_BLOCKS
+// Image being streamed
+static afAddrType_t zclOTA_StreamAddr;
+static zclOTA_FileID_t zclOTA_StreamFileId;
+static uint32 zclOTA_StreamOffset;
+static uint32 zclOTA_StreamEnd;
+#endif
+
 // Used by the client to correlate the Upgrade End Request and received
 // Default Response.
 static uint8 zclOta_OtaUpgradeEndReqTransSeq;
@@ -209,6 +316,23 @@ static void zclOTA_ImageBlockWaitExpired ( void );
 static void zclOTA_UpgradeComplete ( uint8 status );
 static uint8 zclOTA_CmpFileId ( zclOTA_FileID_t *f1, zclOTA_FileID_t *f2 );
 static uint8 zclOTA_ProcessImageData ( uint8 *pData, uint8 len );
+static uint8 zclOTA_DecodeImageData ( uint8 *pData, uint8 len );
+#if OTA_BLOCK_WINDOW > 1
+static void zclOTA_BlockWinReset ( void );
+static void zclOTA_BlockWinCancel ( uint8 backoff );
+static uint8 zclOTA_BlockWinGap ( uint32 *pOffset, uint8 *pLen );
+static void zclOTA_BlockWinRtt ( uint16 rtt );
+static uint16 zclOTA_BlockWinRto ( void );
+static uint8 zclOTA_BlockWinRecv ( uint32 offset, uint8 *pData, uint8 len, uint8 *pStatus );
+static void zclOTA_BlockWinDrain ( uint8 *pStatus );
+#endif
+#if OTA_MCAST_BLOCKS
+static void zclOTA_McastReset ( void );
+static uint8 zclOTA_McastHeld ( uint32 offset, uint8 *pLen );
+static uint32 zclOTA_McastNextHeld ( uint32 offset, uint32 end );
+static uint8 zclOTA_McastBlockRsp ( imageBlockRspSuccess_t *pRsp );
+static void zclOTA_McastWrite ( uint32 offset, uint8 *pData, uint8 len );
+#endif
 
 static ZStatus_t zclOTA_SendQueryNextImageReq ( afAddrType_t *dstAddr, zclOTA_QueryNextImageReqParams_t *pParams );
 static ZStatus_t zclOTA_SendImageBlockReq ( afAddrType_t *dstAddr, zclOTA_ImageBlockReqParams_t *pParams );
@@ -236,6 +360,20 @@ static void zclOTA_ServerHandleFileSysCb ( OTA_MtMsg_t* pMSGpkt );
 static ZStatus_t zclOTA_ServerHdlIncoming ( zclIncoming_t *pInMsg );
 
 static void zclOTA_InitBlockReqDelay ( void );
+#if OTA_SRV_CACHE_PAGES
+static void zclOTA_SrvCacheSetSize ( zclOTA_FileID_t *pFileId, uint32 size );
+static uint32 zclOTA_SrvCacheGetSize ( zclOTA_FileID_t *pFileId );
+static void zclOTA_SrvCacheExpire ( void );
+static zclOTA_SrvPage_t *zclOTA_SrvCacheFind ( zclOTA_FileID_t *pFileId, uint32 offset );
+static zclOTA_SrvPage_t *zclOTA_SrvCacheRead ( afAddrType_t *pAddr, zclOTA_FileID_t *pFileId, uint32 offset );
+static uint8 zclOTA_SrvCacheShort ( zclOTA_SrvPage_t *pPage, uint32 offset );
+static void zclOTA_SrvCacheSend ( afAddrType_t *pAddr, zclOTA_SrvPage_t *pPage, uint32 offset, uint8 len );
+static uint8 zclOTA_SrvCacheBlockReq ( afAddrType_t *pAddr, zclOTA_FileID_t *pFileId, uint8 len, uint32 offset );
+static void zclOTA_SrvCacheReadRsp ( uint8 *pMsg, zclOTA_FileID_t *pFileId );
+#endif
+#if OTA_MCAST_BLOCKS
+static void zclOTA_SrvStreamNext ( void );
+#endif
 #endif // (defined OTA_SERVER) && (OTA_SERVER == TRUE)
 
 /******************************************************************************
@@ -515,6 +653,11 @@ void zclOTA_Init ( uint8 task_id )
   // Initialize rate to transfer file
   zclOTA_InitBlockReqDelay();
 
+#if OTA_SRV_CACHE_PAGES
+  // No block request is waiting for a page
+  osal_memset ( zclOTA_SrvWaiter, 0xFF, sizeof ( zclOTA_SrvWaiter ) );
+#endif
+
 #endif // defined (OTA_SERVER) && (OTA_SERVER == TRUE)
 
 #if defined (OTA_CLIENT) && (OTA_CLIENT == TRUE)
@@ -726,6 +869,10 @@ uint16 zclOTA_event_loop ( uint8 task_id, uint16 events )
     }
     else
     {
+#if OTA_BLOCK_WINDOW > 1
+      // Ask again for everything outstanding, with a smaller window
+      zclOTA_BlockWinCancel ( TRUE );
+#endif
       // Send another block request
       sendImageBlockReq(&zclOTA_serverAddr);
     }
@@ -784,8 +931,32 @@ uint16 zclOTA_event_loop ( uint8 task_id, uint16 events )
     return ( events ^ ZCL_OTA_SEND_MATCH_DESCRIPTOR_EVT );
   }
 
+#if OTA_MCAST_BLOCKS
+  if ( events & ZCL_OTA_STREAM_QUIET_EVT )
+  {
+    // The stream is over, ask for what it did not bring
+    zclOTA_McastListen = FALSE;
+
+    if ( zclOTA_ImageUpgradeStatus == OTA_STATUS_IN_PROGRESS )
+    {
+      sendImageBlockReq ( &zclOTA_serverAddr );
+    }
+
+    return ( events ^ ZCL_OTA_STREAM_QUIET_EVT );
+  }
+#endif
+
 #endif // (defined OTA_CLIENT) && (OTA_CLIENT == TRUE)
 
+#if (defined OTA_SERVER) && (OTA_SERVER == TRUE) && OTA_MCAST_BLOCKS
+  if ( events & ZCL_OTA_IMAGE_STREAM_EVT )
+  {
+    zclOTA_SrvStreamNext();
+
+    return ( events ^ ZCL_OTA_IMAGE_STREAM_EVT );
+  }
+#endif
+
   // Discard unknown events
   return 0;
 }
@@ -1299,164 +1470,806 @@ static void zclOTA_StartTimer ( uint16 eventId, uint32 seconds )
  *
  * @return  ZStatus_t
  */
+#if OTA_BLOCK_WINDOW > 1
 static ZStatus_t sendImageBlockReq ( afAddrType_t *dstAddr )
 {
   zclOTA_ImageBlockReqParams_t req;
+  zclOTA_BlockSlot_t *pSlot;
+  ZStatus_t status = ZSuccess;
+  uint8 outstanding;
+  uint8 i;
+
+  if ( zclOTA_ImageUpgradeStatus != OTA_STATUS_IN_PROGRESS )
+  {
+    return ZSuccess;
+  }
+
+#if OTA_MCAST_BLOCKS
+  // Nothing is asked for while a stream is heard
+  if ( zclOTA_McastListen )
+  {
+    return ZSuccess;
+  }
+#endif
 
   req.fieldControl = zclOTA_ImageBlockFC; // Image block command field control value
   req.fileId.manufacturer = zclOTA_ManufacturerId;
   req.fileId.type = zclOTA_ImageType;
   req.fileId.version = zclOTA_DownloadedFileVersion;
-  req.fileOffset = zclOTA_FileOffset;
+  req.blockReqDelay = zclOTA_MinBlockReqDelay;
 
-  if ( zclOTA_DownloadedImageSize - zclOTA_FileOffset < OTA_MAX_MTU )
+  for ( ;; )
   {
-    req.maxDataSize = zclOTA_DownloadedImageSize - zclOTA_FileOffset;
+    // Count the requests outstanding and look for a free slot
+    outstanding = 0;
+    pSlot = NULL;
+    for ( i = 0; i < OTA_BLOCK_WINDOW; i++ )
+    {
+      if ( ( zclOTA_BlockSlot[i].state == ZCL_OTA_BLK_SENT ) ||
+           ( zclOTA_BlockSlot[i].state == ZCL_OTA_BLK_RESENT ) )
+      {
+        outstanding++;
+      }
+      else if ( zclOTA_BlockSlot[i].state == ZCL_OTA_BLK_FREE )
+      {
+        pSlot = &zclOTA_BlockSlot[i];
+      }
+    }
+
+    if ( ( pSlot == NULL ) || ( outstanding >= zclOTA_BlockWin ) ||
+         !zclOTA_BlockWinGap ( &req.fileOffset, &req.maxDataSize ) )
+    {
+      break;
+    }
+
+    pSlot->offset = req.fileOffset;
+    pSlot->len = req.maxDataSize;
+    pSlot->sentTime = ( uint16 ) osal_GetSystemClock();
+
+    // A block asked for again (after a timeout or a short response) gives no response time sample
+    if ( req.fileOffset < zclOTA_BlockReqEnd )
+    {
+      pSlot->state = ZCL_OTA_BLK_RESENT;
+    }
+    else
+    {
+      pSlot->state = ZCL_OTA_BLK_SENT;
+      zclOTA_BlockReqEnd = req.fileOffset + req.maxDataSize;
+    }
+
+    status = zclOTA_SendImageBlockReq ( dstAddr, &req );
+
+    // A server asking for rate limiting gets one request per blockReqDelay
+    if ( zclOTA_MinBlockReqDelay != 0 )
+    {
+      outstanding++;
+      osal_start_timerEx ( zclOTA_TaskID, ZCL_OTA_IMAGE_BLOCK_REQ_DELAY_EVT, zclOTA_MinBlockReqDelay );
+      break;
+    }
   }
-  else
+
+  // Start a timer waiting for the responses
+  if ( outstanding != 0 )
   {
-    req.maxDataSize = OTA_MAX_MTU;
+    osal_start_timerEx ( zclOTA_TaskID, ZCL_OTA_BLOCK_RSP_TO_EVT, zclOTA_BlockWinRto() );
   }
 
-  req.blockReqDelay = zclOTA_MinBlockReqDelay;
-
-  // Start a timer waiting for a response
-  osal_start_timerEx ( zclOTA_TaskID, ZCL_OTA_BLOCK_RSP_TO_EVT, OTA_MAX_BLOCK_RSP_WAIT_TIME );
+  return status;
+}
 
-  return zclOTA_SendImageBlockReq ( dstAddr, &req );
+/******************************************************************************
+ * @fn      zclOTA_BlockWinReset
+ *
+ * @brief   Empty the image block window for a new download.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void zclOTA_BlockWinReset ( void )
+{
+  osal_memset ( zclOTA_BlockSlot, 0, sizeof ( zclOTA_BlockSlot ) );
+  zclOTA_BlockReqEnd = 0;
+  zclOTA_BlockWin = 1;
+  zclOTA_BlockRttMin = 0;
+  zclOTA_BlockSrtt = 0;
+  zclOTA_BlockRttVar = 0;
 }
 
 /******************************************************************************
- * @fn      zclOTA_ProcessImageData
+ * @fn      zclOTA_BlockWinCancel
  *
- * @brief   Process image data as it is received from the host.
+ * @brief   Forget the outstanding block requests so they are sent again.
  *
- * @param   pData - pointer to the data
- * @param   len - length of the data
+ * @param   backoff - TRUE if they timed out: halve the window and double
+ *                    the response timeout
  *
- * @return  status of the operation
+ * @return  none
  */
-uint8 zclOTA_ProcessImageData ( uint8 *pData, uint8 len )
+static void zclOTA_BlockWinCancel ( uint8 backoff )
 {
-  int8 i;
-#if defined OTA_MMO_SIGN
-  uint8 skipHash = FALSE;
-#endif
+  uint8 i;
 
-  if ( zclOTA_ImageUpgradeStatus != OTA_STATUS_IN_PROGRESS )
+  for ( i = 0; i < OTA_BLOCK_WINDOW; i++ )
   {
-    return ZCL_STATUS_ABORT;
+    if ( zclOTA_BlockSlot[i].state != ZCL_OTA_BLK_RCVD )
+    {
+      zclOTA_BlockSlot[i].state = ZCL_OTA_BLK_FREE;
+    }
   }
 
-#if (defined HAL_LED) && (HAL_LED == TRUE)
-  // Toggle an LED to indicate we received a new block
-  HalLedSet ( HAL_LED_2, HAL_LED_MODE_TOGGLE );
-#endif
-
-  // write data to secondary storage
-  HalOTAWrite ( zclOTA_FileOffset, pData, len, HAL_OTA_DL );
-
-  for ( i=0; i<len; i++ )
+  if ( backoff )
   {
-    switch ( zclOTA_ClientPdState )
+    zclOTA_BlockWin = ( zclOTA_BlockWin + 1 ) / 2;
+
+    if ( zclOTA_BlockSrtt < OTA_MAX_BLOCK_RSP_WAIT_TIME / 2 )
     {
-        // verify header magic number
-      case ZCL_OTA_PD_MAGIC_0_STATE:
-        // Initialize control variables
-#if defined OTA_MMO_SIGN
-        osal_memset ( &zclOTA_MmoHash, 0, sizeof ( zclOTA_MmoHash ) );
-        zclOTA_HashPos = 0;
+      zclOTA_BlockSrtt *= 2;
+    }
+  }
+}
+
+/******************************************************************************
+ * @fn      zclOTA_BlockWinGap
+ *
+ * @brief   Find the first part of the image, from the current file offset
+ *          on, that is neither requested nor received, from the server or
+ *          from a multicast stream.
+ *
+ * @param   pOffset - where to put its offset
+ * @param   pLen - where to put its length, up to OTA_MAX_MTU
+ *
+ * @return  TRUE if there is one
+ */
+static uint8 zclOTA_BlockWinGap ( uint32 *pOffset, uint8 *pLen )
+{
+  uint32 offset = zclOTA_FileOffset;
+  uint32 end = zclOTA_DownloadedImageSize;
+  uint8 i;
+#if OTA_MCAST_BLOCKS
+  uint8 len;
 #endif
 
-        // Missing break intended
-      case ZCL_OTA_PD_MAGIC_1_STATE:
-      case ZCL_OTA_PD_MAGIC_2_STATE:
-      case ZCL_OTA_PD_MAGIC_3_STATE:
-        if ( pData[i] != zclOTA_HdrMagic[zclOTA_ClientPdState] )
-        {
-          return ZCL_STATUS_INVALID_IMAGE;
-        }
-        zclOTA_ClientPdState++;
+  // Walk over the blocks in the window that follow each other
+  do
+  {
+    for ( i = 0; i < OTA_BLOCK_WINDOW; i++ )
+    {
+      if ( ( zclOTA_BlockSlot[i].state != ZCL_OTA_BLK_FREE ) &&
+           ( zclOTA_BlockSlot[i].offset == offset ) )
+      {
+        offset += zclOTA_BlockSlot[i].len;
         break;
+      }
+    }
 
-      case ZCL_OTA_PD_HDR_LEN1_STATE:
-        // get header length
-        if ( zclOTA_FileOffset == ZCL_OTA_HDR_LEN_OFFSET )
-        {
-          zclOTA_HeaderLen = pData[i];
-          zclOTA_ClientPdState = ZCL_OTA_PD_HDR_LEN2_STATE;
-        }
-        break;
+#if OTA_MCAST_BLOCKS
+    if ( ( i == OTA_BLOCK_WINDOW ) && zclOTA_McastHeld ( offset, &len ) )
+    {
+      offset += len;
+      i = 0;
+    }
+#endif
+  } while ( i < OTA_BLOCK_WINDOW );
 
-      case ZCL_OTA_PD_HDR_LEN2_STATE:
-        zclOTA_HeaderLen |= ( ( ( uint16 ) pData[i] ) << 8 ) & 0xFF00;
-        zclOTA_ClientPdState = ZCL_OTA_PD_STK_VER1_STATE;
-        break;
+  if ( offset >= end )
+  {
+    return FALSE;
+  }
 
-      case ZCL_OTA_PD_STK_VER1_STATE:
-        // get stack version
-        if ( zclOTA_FileOffset == ZCL_OTA_STK_VER_OFFSET )
-        {
-          zclOTA_DownloadedZigBeeStackVersion = pData[i];
-          zclOTA_ClientPdState = ZCL_OTA_PD_STK_VER2_STATE;
-        }
-        break;
+  // The gap ends where the next block in the window starts
+  for ( i = 0; i < OTA_BLOCK_WINDOW; i++ )
+  {
+    if ( ( zclOTA_BlockSlot[i].state != ZCL_OTA_BLK_FREE ) &&
+         ( zclOTA_BlockSlot[i].offset > offset ) && ( zclOTA_BlockSlot[i].offset < end ) )
+    {
+      end = zclOTA_BlockSlot[i].offset;
+    }
+  }
 
-      case ZCL_OTA_PD_STK_VER2_STATE:
-        zclOTA_DownloadedZigBeeStackVersion |= ( ( ( uint16 ) pData[i] ) << 8 ) & 0xFF00;
-        zclOTA_ClientPdState = ZCL_OTA_PD_CONT_HDR_STATE;
+#if OTA_MCAST_BLOCKS
+  end = zclOTA_McastNextHeld ( offset, end );
+#endif
 
-        if ( zclOTA_DownloadedZigBeeStackVersion != OTA_HDR_STACK_VERSION )
-        {
-          return ZCL_STATUS_INVALID_IMAGE;
-        }
-        break;
+  *pOffset = offset;
+  *pLen = ( end - offset < OTA_MAX_MTU ) ? ( uint8 ) ( end - offset ) : OTA_MAX_MTU;
 
-      case ZCL_OTA_PD_CONT_HDR_STATE:
-        // Complete the header
-        if ( zclOTA_FileOffset == zclOTA_HeaderLen-1 )
-        {
-          zclOTA_ClientPdState = ZCL_OTA_PD_ELEM_TAG1_STATE;
-        }
-        break;
+  return TRUE;
+}
 
-      case ZCL_OTA_PD_ELEM_TAG1_STATE:
-        zclOTA_ElementTag = pData[i];
-        zclOTA_ClientPdState = ZCL_OTA_PD_ELEM_TAG2_STATE;
-        break;
+/******************************************************************************
+ * @fn      zclOTA_BlockWinRtt
+ *
+ * @brief   Take a block response time sample and adapt the window: it
+ *          grows while responses come back close to the fastest seen and
+ *          shrinks once they take twice as long, i.e. the server or the
+ *          route has started queueing requests.
+ *
+ * @param   rtt - response time (ms)
+ *
+ * @return  none
+ */
+static void zclOTA_BlockWinRtt ( uint16 rtt )
+{
+  uint16 err;
 
-      case ZCL_OTA_PD_ELEM_TAG2_STATE:
-        zclOTA_ElementTag |= ( ( ( uint16 ) pData[i] ) << 8 ) & 0xFF00;
-        zclOTA_ElementPos = 0;
-        zclOTA_ClientPdState = ZCL_OTA_PD_ELEM_LEN1_STATE;
-        break;
+  if ( zclOTA_BlockSrtt == 0 )
+  {
+    zclOTA_BlockSrtt = rtt;
+    zclOTA_BlockRttVar = rtt / 2;
+    zclOTA_BlockRttMin = rtt;
+  }
+  else
+  {
+    // srtt += (rtt - srtt) / 8, rttvar += (|rtt - srtt| - rttvar) / 4
+    if ( rtt > zclOTA_BlockSrtt )
+    {
+      err = rtt - zclOTA_BlockSrtt;
+      zclOTA_BlockSrtt += err / 8;
+    }
+    else
+    {
+      err = zclOTA_BlockSrtt - rtt;
+      zclOTA_BlockSrtt -= err / 8;
+    }
+    zclOTA_BlockRttVar = zclOTA_BlockRttVar - zclOTA_BlockRttVar / 4 + err / 4;
 
-      case ZCL_OTA_PD_ELEM_LEN1_STATE:
-        zclOTA_ElementLen = pData[i];
-        zclOTA_ClientPdState = ZCL_OTA_PD_ELEM_LEN2_STATE;
-        break;
+    if ( rtt < zclOTA_BlockRttMin )
+    {
+      zclOTA_BlockRttMin = rtt;
+    }
+  }
 
-      case ZCL_OTA_PD_ELEM_LEN2_STATE:
-        zclOTA_ElementLen |= ( ( uint32 ) pData[i] << 8 ) & 0x0000FF00;
-        zclOTA_ClientPdState = ZCL_OTA_PD_ELEM_LEN3_STATE;
-        break;
+  if ( rtt <= zclOTA_BlockRttMin + zclOTA_BlockRttMin / 2 )
+  {
+    if ( zclOTA_BlockWin < zclOTA_BlockWindow )
+    {
+      zclOTA_BlockWin++;
+    }
+  }
+  else if ( ( rtt > 2 * zclOTA_BlockRttMin ) && ( zclOTA_BlockWin > 1 ) )
+  {
+    zclOTA_BlockWin--;
+  }
 
-      case ZCL_OTA_PD_ELEM_LEN3_STATE:
-        zclOTA_ElementLen |= ( ( uint32 ) pData[i] << 16 ) & 0x00FF0000;
-        zclOTA_ClientPdState = ZCL_OTA_PD_ELEM_LEN4_STATE;
-        break;
+  if ( zclOTA_BlockWin > zclOTA_BlockWindow )
+  {
+    zclOTA_BlockWin = ( zclOTA_BlockWindow > OTA_BLOCK_WINDOW ) ? OTA_BLOCK_WINDOW : zclOTA_BlockWindow;
+  }
+}
 
-      case ZCL_OTA_PD_ELEM_LEN4_STATE:
-        zclOTA_ElementLen |= ( ( uint32 ) pData[i] << 24 ) & 0xFF000000;
-        zclOTA_ClientPdState = ZCL_OTA_PD_ELEMENT_STATE;
+/******************************************************************************
+ * @fn      zclOTA_BlockWinRto
+ *
+ * @brief   Block response timeout: smoothed response time plus four
+ *          deviations, OTA_MAX_BLOCK_RSP_WAIT_TIME until there is a sample.
+ *
+ * @param   none
+ *
+ * @return  timeout (ms)
+ */
+static uint16 zclOTA_BlockWinRto ( void )
+{
+  uint32 rto = ( uint32 ) zclOTA_BlockSrtt + 4 * ( uint32 ) zclOTA_BlockRttVar;
 
-        // Make sure the length of the element isn't bigger than the image
-        if ( zclOTA_ElementLen > ( zclOTA_DownloadedImageSize - zclOTA_FileOffset ) )
-        {
-          return ZCL_STATUS_INVALID_IMAGE;
-        }
+  if ( ( zclOTA_BlockSrtt == 0 ) || ( rto > OTA_MAX_BLOCK_RSP_WAIT_TIME ) )
+  {
+    return OTA_MAX_BLOCK_RSP_WAIT_TIME;
+  }
 
-#if defined OTA_MMO_SIGN
+  return ( rto < OTA_BLOCK_RTO_MIN ) ? OTA_BLOCK_RTO_MIN : ( uint16 ) rto;
+}
+
+/******************************************************************************
+ * @fn      zclOTA_BlockWinRecv
+ *
+ * @brief   Put a received block in its slot and hand every block that is
+ *          now in order to zclOTA_ProcessImageData, so the image is still
+ *          written and parsed sequentially.
+ *
+ * @param   offset - file offset of the block
+ * @param   pData - block data
+ * @param   len - block length
+ * @param   pStatus - where to put the image data processing status
+ *
+ * @return  FALSE if the block was not requested (e.g. a duplicate)
+ */
+static uint8 zclOTA_BlockWinRecv ( uint32 offset, uint8 *pData, uint8 len, uint8 *pStatus )
+{
+  zclOTA_BlockSlot_t *pSlot = NULL;
+  uint8 i;
+
+  for ( i = 0; i < OTA_BLOCK_WINDOW; i++ )
+  {
+    if ( ( ( zclOTA_BlockSlot[i].state == ZCL_OTA_BLK_SENT ) ||
+           ( zclOTA_BlockSlot[i].state == ZCL_OTA_BLK_RESENT ) ) &&
+         ( zclOTA_BlockSlot[i].offset == offset ) )
+    {
+      pSlot = &zclOTA_BlockSlot[i];
+      break;
+    }
+  }
+
+  if ( ( pSlot == NULL ) || ( len == 0 ) || ( len > pSlot->len ) )
+  {
+    return FALSE;
+  }
+
+  if ( pSlot->state == ZCL_OTA_BLK_SENT )
+  {
+    zclOTA_BlockWinRtt ( ( uint16 ) osal_GetSystemClock() - pSlot->sentTime );
+  }
+
+  osal_memcpy ( pSlot->data, pData, len );
+  pSlot->len = len;
+  pSlot->state = ZCL_OTA_BLK_RCVD;
+
+  *pStatus = ZSuccess;
+  zclOTA_BlockWinDrain ( pStatus );
+
+  return TRUE;
+}
+
+/******************************************************************************
+ * @fn      zclOTA_BlockWinDrain
+ *
+ * @brief   Hand every received block that is now in order to
+ *          zclOTA_ProcessImageData.
+ *
+ * @param   pStatus - image data processing status, ZSuccess to go on
+ *
+ * @return  none
+ */
+static void zclOTA_BlockWinDrain ( uint8 *pStatus )
+{
+  uint8 i;
+
+  while ( ( *pStatus == ZSuccess ) && ( zclOTA_ImageUpgradeStatus == OTA_STATUS_IN_PROGRESS ) )
+  {
+    for ( i = 0; i < OTA_BLOCK_WINDOW; i++ )
+    {
+      if ( ( zclOTA_BlockSlot[i].state == ZCL_OTA_BLK_RCVD ) &&
+           ( zclOTA_BlockSlot[i].offset == zclOTA_FileOffset ) )
+      {
+        break;
+      }
+    }
+
+    if ( i == OTA_BLOCK_WINDOW )
+    {
+      break;
+    }
+
+    *pStatus = zclOTA_ProcessImageData ( zclOTA_BlockSlot[i].data, zclOTA_BlockSlot[i].len );
+    zclOTA_BlockSlot[i].state = ZCL_OTA_BLK_FREE;
+  }
+}
+#else
+static ZStatus_t sendImageBlockReq ( afAddrType_t *dstAddr )
+{
+  zclOTA_ImageBlockReqParams_t req;
+
+#if OTA_MCAST_BLOCKS
+  // Nothing is asked for while a stream is heard
+  if ( zclOTA_McastListen )
+  {
+    return ZSuccess;
+  }
+#endif
+
+  req.fieldControl = zclOTA_ImageBlockFC; // Image block command field control value
+  req.fileId.manufacturer = zclOTA_ManufacturerId;
+  req.fileId.type = zclOTA_ImageType;
+  req.fileId.version = zclOTA_DownloadedFileVersion;
+  req.fileOffset = zclOTA_FileOffset;
+
+  if ( zclOTA_DownloadedImageSize - zclOTA_FileOffset < OTA_MAX_MTU )
+  {
+    req.maxDataSize = zclOTA_DownloadedImageSize - zclOTA_FileOffset;
+  }
+  else
+  {
+    req.maxDataSize = OTA_MAX_MTU;
+  }
+
+#if OTA_MCAST_BLOCKS
+  // Up to the next block already taken from the stream
+  req.maxDataSize = ( uint8 ) ( zclOTA_McastNextHeld ( req.fileOffset, req.fileOffset + req.maxDataSize ) -
+                                req.fileOffset );
+#endif
+
+  req.blockReqDelay = zclOTA_MinBlockReqDelay;
+
+  // Start a timer waiting for a response
+  osal_start_timerEx ( zclOTA_TaskID, ZCL_OTA_BLOCK_RSP_TO_EVT, OTA_MAX_BLOCK_RSP_WAIT_TIME );
+
+  return zclOTA_SendImageBlockReq ( dstAddr, &req );
+}
+#endif // OTA_BLOCK_WINDOW > 1
+
+#if OTA_MCAST_BLOCKS
+/******************************************************************************
+ * @fn      zclOTA_McastReset
+ *
+ * @brief   Forget the streamed blocks for a new download.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void zclOTA_McastReset ( void )
+{
+  osal_memset ( zclOTA_McastMap, 0, sizeof ( zclOTA_McastMap ) );
+  zclOTA_McastOn = ( zclOTA_DownloadedImageSize <= ( uint32 ) OTA_MCAST_BLOCKS * OTA_MAX_MTU );
+  zclOTA_McastListen = FALSE;
+  osal_stop_timerEx ( zclOTA_TaskID, ZCL_OTA_STREAM_QUIET_EVT );
+}
+
+/******************************************************************************
+ * @fn      zclOTA_McastHeld
+ *
+ * @brief   Check whether the block holding an image offset was taken from
+ *          the stream.
+ *
+ * @param   offset - file offset
+ * @param   pLen - where to put the bytes held from the offset on
+ *
+ * @return  TRUE if it is in the DL image
+ */
+static uint8 zclOTA_McastHeld ( uint32 offset, uint8 *pLen )
+{
+  uint32 blk = offset / OTA_MAX_MTU;
+  uint32 end;
+
+  if ( !zclOTA_McastOn || ( offset >= zclOTA_DownloadedImageSize ) ||
+       ( ( zclOTA_McastMap[blk / 8] & BV ( blk % 8 ) ) == 0 ) )
+  {
+    return FALSE;
+  }
+
+  end = ( blk + 1 ) * OTA_MAX_MTU;
+  if ( end > zclOTA_DownloadedImageSize )
+  {
+    end = zclOTA_DownloadedImageSize;
+  }
+
+  *pLen = ( uint8 ) ( end - offset );
+
+  return TRUE;
+}
+
+/******************************************************************************
+ * @fn      zclOTA_McastNextHeld
+ *
+ * @brief   Find the first block taken from the stream after an offset.
+ *
+ * @param   offset - file offset, in a block not held
+ * @param   end - end of the search
+ *
+ * @return  offset of the block, end if there is none before it
+ */
+static uint32 zclOTA_McastNextHeld ( uint32 offset, uint32 end )
+{
+  uint32 blk;
+
+  if ( zclOTA_McastOn )
+  {
+    for ( blk = offset / OTA_MAX_MTU + 1; blk * OTA_MAX_MTU < end; blk++ )
+    {
+      if ( zclOTA_McastMap[blk / 8] & BV ( blk % 8 ) )
+      {
+        return blk * OTA_MAX_MTU;
+      }
+    }
+  }
+
+  return end;
+}
+
+/******************************************************************************
+ * @fn      zclOTA_McastBlockRsp
+ *
+ * @brief   Take a block from the stream. A block at the file offset is
+ *          processed as if requested, one further on goes straight to the
+ *          DL image and is decoded once the file offset gets to it.
+ *
+ * @param   pRsp - the block, whole and aligned to OTA_MAX_MTU
+ *
+ * @return  image data processing status
+ */
+static uint8 zclOTA_McastBlockRsp ( imageBlockRspSuccess_t *pRsp )
+{
+  uint32 offset = pRsp->fileOffset;
+  uint32 blk = offset / OTA_MAX_MTU;
+  uint32 end = offset + OTA_MAX_MTU;
+  uint8 status = ZSuccess;
+#if OTA_BLOCK_WINDOW > 1
+  uint8 i;
+#endif
+
+  if ( end > zclOTA_DownloadedImageSize )
+  {
+    end = zclOTA_DownloadedImageSize;
+  }
+
+  // Blocks already taken, or behind the file offset, add nothing
+  if ( !zclOTA_McastOn || ( offset % OTA_MAX_MTU ) || ( offset >= zclOTA_DownloadedImageSize ) ||
+       ( pRsp->dataSize != end - offset ) || ( end <= zclOTA_FileOffset ) ||
+       ( zclOTA_McastMap[blk / 8] & BV ( blk % 8 ) ) )
+  {
+    return ZSuccess;
+  }
+
+#if OTA_BLOCK_WINDOW > 1
+  // The stream answers the requests outstanding for this block
+  for ( i = 0; i < OTA_BLOCK_WINDOW; i++ )
+  {
+    if ( ( zclOTA_BlockSlot[i].state != ZCL_OTA_BLK_FREE ) &&
+         ( zclOTA_BlockSlot[i].offset >= offset ) && ( zclOTA_BlockSlot[i].offset < end ) )
+    {
+      if ( zclOTA_BlockSlot[i].state == ZCL_OTA_BLK_RCVD )
+      {
+        return ZSuccess;
+      }
+      zclOTA_BlockSlot[i].state = ZCL_OTA_BLK_FREE;
+    }
+  }
+#endif
+
+  if ( offset > zclOTA_FileOffset )
+  {
+    zclOTA_McastWrite ( offset, pRsp->pData, pRsp->dataSize );
+    zclOTA_McastMap[blk / 8] |= BV ( blk % 8 );
+  }
+  else
+  {
+    status = zclOTA_ProcessImageData ( pRsp->pData + ( zclOTA_FileOffset - offset ),
+                                       ( uint8 ) ( end - zclOTA_FileOffset ) );
+#if OTA_BLOCK_WINDOW > 1
+    zclOTA_BlockWinDrain ( &status );
+#endif
+  }
+
+  return status;
+}
+
+/******************************************************************************
+ * @fn      zclOTA_McastWrite
+ *
+ * @brief   Write image data to the DL image. In internal flash a write to
+ *          the first word of a page erases it, so the blocks taken from the
+ *          stream into that page are forgotten and asked for again.
+ *
+ * @param   offset - file offset
+ * @param   pData - pointer to the data
+ * @param   len - length of the data
+ *
+ * @return  none
+ */
+static void zclOTA_McastWrite ( uint32 offset, uint8 *pData, uint8 len )
+{
+#if HAL_OTA_XNV_IS_INT
+  uint32 blk;
+  uint32 end;
+
+  if ( ( ( offset + HAL_OTA_RC_START + HAL_OTA_DL_OSET ) % HAL_FLASH_PAGE_SIZE ) == 0 )
+  {
+    end = offset + HAL_FLASH_PAGE_SIZE;
+    for ( blk = offset / OTA_MAX_MTU; ( blk * OTA_MAX_MTU < end ) && ( blk < OTA_MCAST_BLOCKS ); blk++ )
+    {
+      zclOTA_McastMap[blk / 8] &= ~BV ( blk % 8 );
+    }
+  }
+#endif
+
+  HalOTAWrite ( offset, pData, len, HAL_OTA_DL );
+}
+#endif // OTA_MCAST_BLOCKS
+
+/******************************************************************************
+ * @fn      zclOTA_ProcessImageData
+ *
+ * @brief   Process image data as it is received from the host: write it to
+ *          the DL image at the file offset and decode it, then decode the
+ *          blocks that a multicast stream already put in the DL image.
+ *
+ * @param   pData - pointer to the data
+ * @param   len - length of the data
+ *
+ * @return  status of the operation
+ */
+uint8 zclOTA_ProcessImageData ( uint8 *pData, uint8 len )
+{
+  uint8 status;
+#if OTA_MCAST_BLOCKS
+  uint8 buf[OTA_MAX_MTU];
+#endif
+
+  if ( zclOTA_ImageUpgradeStatus != OTA_STATUS_IN_PROGRESS )
+  {
+    return ZCL_STATUS_ABORT;
+  }
+
+#if (defined HAL_LED) && (HAL_LED == TRUE)
+  // Toggle an LED to indicate we received a new block
+  HalLedSet ( HAL_LED_2, HAL_LED_MODE_TOGGLE );
+#endif
+
+  // write data to secondary storage
+#if OTA_MCAST_BLOCKS
+  zclOTA_McastWrite ( zclOTA_FileOffset, pData, len );
+#else
+  HalOTAWrite ( zclOTA_FileOffset, pData, len, HAL_OTA_DL );
+#endif
+
+  status = zclOTA_DecodeImageData ( pData, len );
+
+#if OTA_MCAST_BLOCKS
+  while ( ( status == ZSuccess ) && ( zclOTA_ImageUpgradeStatus == OTA_STATUS_IN_PROGRESS ) &&
+          zclOTA_McastHeld ( zclOTA_FileOffset, &len ) )
+  {
+    HalOTARead ( zclOTA_FileOffset, buf, len, HAL_OTA_DL );
+    status = zclOTA_DecodeImageData ( buf, len );
+  }
+#endif
+
+  return status;
+}
+
+/******************************************************************************
+ * @fn      zclOTA_DecodeImageData
+ *
+ * @brief   Decode image data at the file offset.
+ *
+ *          Only the header fields and the element tags and lengths are
+ *          decoded a byte at a time. The bytes between them, the rest of the
+ *          header and the element contents, are taken a whole span at a time.
+ *
+ * @param   pData - pointer to the data
+ * @param   len - length of the data
+ *
+ * @return  status of the operation
+ */
+static uint8 zclOTA_DecodeImageData ( uint8 *pData, uint8 len )
+{
+  uint32 span;
+#if defined OTA_MMO_SIGN
+  uint8 hash;
+  uint8 digest[SSP_MMO_HASH_LEN];
+#endif
+
+  // Nothing beyond the end of the image is decoded
+  if ( len > zclOTA_DownloadedImageSize - zclOTA_FileOffset )
+  {
+    len = ( uint8 ) ( zclOTA_DownloadedImageSize - zclOTA_FileOffset );
+  }
+
+  while ( len )
+  {
+    span = 1;
+#if defined OTA_MMO_SIGN
+    hash = TRUE;
+#endif
+
+    switch ( zclOTA_ClientPdState )
+    {
+        // verify header magic number
+      case ZCL_OTA_PD_MAGIC_0_STATE:
+        // Initialize control variables
+#if defined OTA_MMO_SIGN
+        sspMMOHashInit ( &zclOTA_MmoHash );
+#endif
+
+        // Missing break intended
+      case ZCL_OTA_PD_MAGIC_1_STATE:
+      case ZCL_OTA_PD_MAGIC_2_STATE:
+      case ZCL_OTA_PD_MAGIC_3_STATE:
+        if ( *pData != zclOTA_HdrMagic[zclOTA_ClientPdState] )
+        {
+          return ZCL_STATUS_INVALID_IMAGE;
+        }
+        zclOTA_ClientPdState++;
+        break;
+
+      case ZCL_OTA_PD_HDR_LEN1_STATE:
+        // get header length, skipping the header version
+        if ( zclOTA_FileOffset == ZCL_OTA_HDR_LEN_OFFSET )
+        {
+          zclOTA_HeaderLen = *pData;
+          zclOTA_ClientPdState = ZCL_OTA_PD_HDR_LEN2_STATE;
+        }
+        else
+        {
+          span = ZCL_OTA_HDR_LEN_OFFSET - zclOTA_FileOffset;
+        }
+        break;
+
+      case ZCL_OTA_PD_HDR_LEN2_STATE:
+        zclOTA_HeaderLen |= ( ( ( uint16 ) *pData ) << 8 ) & 0xFF00;
+        zclOTA_ClientPdState = ZCL_OTA_PD_STK_VER1_STATE;
+
+        // The header has to hold the fields decoded here
+        if ( zclOTA_HeaderLen < OTA_HEADER_LEN_MIN )
+        {
+          return ZCL_STATUS_INVALID_IMAGE;
+        }
+        break;
+
+      case ZCL_OTA_PD_STK_VER1_STATE:
+        // get stack version, skipping the file ID
+        if ( zclOTA_FileOffset == ZCL_OTA_STK_VER_OFFSET )
+        {
+          zclOTA_DownloadedZigBeeStackVersion = *pData;
+          zclOTA_ClientPdState = ZCL_OTA_PD_STK_VER2_STATE;
+        }
+        else
+        {
+          span = ZCL_OTA_STK_VER_OFFSET - zclOTA_FileOffset;
+        }
+        break;
+
+      case ZCL_OTA_PD_STK_VER2_STATE:
+        zclOTA_DownloadedZigBeeStackVersion |= ( ( ( uint16 ) *pData ) << 8 ) & 0xFF00;
+        zclOTA_ClientPdState = ZCL_OTA_PD_CONT_HDR_STATE;
+
+        if ( zclOTA_DownloadedZigBeeStackVersion != OTA_HDR_STACK_VERSION )
+        {
+          return ZCL_STATUS_INVALID_IMAGE;
+        }
+        break;
+
+      case ZCL_OTA_PD_CONT_HDR_STATE:
+        // Complete the header
+        span = zclOTA_HeaderLen - zclOTA_FileOffset;
+        if ( span <= len )
+        {
+          zclOTA_ClientPdState = ZCL_OTA_PD_ELEM_TAG1_STATE;
+        }
+        break;
+
+      case ZCL_OTA_PD_ELEM_TAG1_STATE:
+        zclOTA_ElementTag = *pData;
+        zclOTA_ClientPdState = ZCL_OTA_PD_ELEM_TAG2_STATE;
+        break;
+
+      case ZCL_OTA_PD_ELEM_TAG2_STATE:
+        zclOTA_ElementTag |= ( ( ( uint16 ) *pData ) << 8 ) & 0xFF00;
+        zclOTA_ElementPos = 0;
+        zclOTA_ClientPdState = ZCL_OTA_PD_ELEM_LEN1_STATE;
+        break;
+
+      case ZCL_OTA_PD_ELEM_LEN1_STATE:
+        zclOTA_ElementLen = *pData;
+        zclOTA_ClientPdState = ZCL_OTA_PD_ELEM_LEN2_STATE;
+        break;
+
+      case ZCL_OTA_PD_ELEM_LEN2_STATE:
+        zclOTA_ElementLen |= ( ( uint32 ) *pData << 8 ) & 0x0000FF00;
+        zclOTA_ClientPdState = ZCL_OTA_PD_ELEM_LEN3_STATE;
+        break;
+
+      case ZCL_OTA_PD_ELEM_LEN3_STATE:
+        zclOTA_ElementLen |= ( ( uint32 ) *pData << 16 ) & 0x00FF0000;
+        zclOTA_ClientPdState = ZCL_OTA_PD_ELEM_LEN4_STATE;
+        break;
+
+      case ZCL_OTA_PD_ELEM_LEN4_STATE:
+        zclOTA_ElementLen |= ( ( uint32 ) *pData << 24 ) & 0xFF000000;
+        zclOTA_ClientPdState = ZCL_OTA_PD_ELEMENT_STATE;
+
+        // Make sure the length of the element isn't bigger than the image
+        if ( zclOTA_ElementLen > ( zclOTA_DownloadedImageSize - zclOTA_FileOffset ) )
+        {
+          return ZCL_STATUS_INVALID_IMAGE;
+        }
+
+        // An empty element has no contents to wait for
+        if ( zclOTA_ElementLen == 0 )
+        {
+          zclOTA_ClientPdState = ZCL_OTA_PD_ELEM_TAG1_STATE;
+        }
+
+#if defined OTA_MMO_SIGN
         if ( zclOTA_ElementTag == OTA_ECDSA_SIGNATURE_TAG_ID )
         {
           if ( zclOTA_ElementLen != OTA_SIGNATURE_LEN + Z_EXTADDR_LEN )
@@ -1475,25 +2288,41 @@ uint8 zclOTA_ProcessImageData ( uint8 *pData, uint8 len )
         break;
 
       case ZCL_OTA_PD_ELEMENT_STATE:
+        // As much of the element as this block holds
+        span = zclOTA_ElementLen - zclOTA_ElementPos;
+        if ( span > len )
+        {
+          span = len;
+        }
+
 #if defined OTA_MMO_SIGN
         if ( zclOTA_ElementTag == OTA_ECDSA_SIGNATURE_TAG_ID )
         {
           if ( zclOTA_ElementPos < Z_EXTADDR_LEN )
-            zclOTA_SignerIEEE[zclOTA_ElementPos] = pData[i];
+          {
+            if ( span > Z_EXTADDR_LEN - zclOTA_ElementPos )
+            {
+              span = Z_EXTADDR_LEN - zclOTA_ElementPos;
+            }
+            osal_memcpy ( &zclOTA_SignerIEEE[zclOTA_ElementPos], pData, ( uint8 ) span );
+          }
           else
           {
-            zclOTA_SignatureData[zclOTA_ElementPos - Z_EXTADDR_LEN] = pData[i];
+            osal_memcpy ( &zclOTA_SignatureData[zclOTA_ElementPos - Z_EXTADDR_LEN], pData,
+                          ( uint8 ) span );
 
-            skipHash = TRUE;
+            // The signature is not part of the hash
+            hash = FALSE;
           }
         }
         else if ( zclOTA_ElementTag == OTA_ECDSA_CERT_TAG_ID )
         {
-          zclOTA_Certificate[zclOTA_ElementPos] = pData[i];
+          osal_memcpy ( &zclOTA_Certificate[zclOTA_ElementPos], pData, ( uint8 ) span );
         }
 #endif
 
-        if ( ++zclOTA_ElementPos == zclOTA_ElementLen )
+        zclOTA_ElementPos += span;
+        if ( zclOTA_ElementPos == zclOTA_ElementLen )
         {
           // Element is complete
           if ( zclOTA_ElementTag == OTA_UPGRADE_IMAGE_TAG_ID )
@@ -1523,32 +2352,33 @@ uint8 zclOTA_ProcessImageData ( uint8 *pData, uint8 len )
         break;
     }
 
-#if defined OTA_MMO_SIGN
-    if ( !skipHash )
+    if ( span > len )
     {
-      // Maintain a buffer of data to hash
-      zclOTA_DataToHash[zclOTA_HashPos++] = pData[i];
+      span = len;
+    }
 
-      // When the buffer reaches OTA_MMO_HASH_SIZE, update the Hash
-      if ( zclOTA_HashPos == OTA_MMO_HASH_SIZE )
-      {
-        OTA_CalculateMmoR3 ( &zclOTA_MmoHash, zclOTA_DataToHash, OTA_MMO_HASH_SIZE, FALSE );
-        zclOTA_HashPos = 0;
-      }
+#if defined OTA_MMO_SIGN
+    if ( hash )
+    {
+      sspMMOHashUpdate ( &zclOTA_MmoHash, pData, ( uint16 ) span );
     }
 #endif
 
+    pData += span;
+    len -= ( uint8 ) span;
+
     // Check if the download is complete
-    if ( ++zclOTA_FileOffset >= zclOTA_DownloadedImageSize )
+    zclOTA_FileOffset += span;
+    if ( zclOTA_FileOffset >= zclOTA_DownloadedImageSize )
     {
       zclOTA_ImageUpgradeStatus = OTA_STATUS_COMPLETE;
 
 #if defined OTA_MMO_SIGN
       // Complete the hash calcualtion
-      OTA_CalculateMmoR3 ( &zclOTA_MmoHash, zclOTA_DataToHash, zclOTA_HashPos, TRUE );
+      sspMMOHashFinal ( &zclOTA_MmoHash, digest );
 
       // Validate the hash
-      if ( OTA_ValidateSignature ( zclOTA_MmoHash.hash, zclOTA_Certificate,
+      if ( OTA_ValidateSignature ( digest, zclOTA_Certificate,
                                    zclOTA_SignatureData, zclOTA_SignerIEEE ) != ZSuccess )
         return ZCL_STATUS_INVALID_IMAGE;
 #endif
@@ -1698,6 +2528,13 @@ static ZStatus_t zclOTA_ProcessQueryNextImageRsp ( zclIncoming_t *pInMsg )
       // initialize other variables
       zclOTA_FileOffset = 0;
       zclOTA_ClientPdState = ZCL_OTA_PD_MAGIC_0_STATE;
+      zclOTA_BlockRetry = 0;
+#if OTA_BLOCK_WINDOW > 1
+      zclOTA_BlockWinReset();
+#endif
+#if OTA_MCAST_BLOCKS
+      zclOTA_McastReset();
+#endif
 
       // set state to 'in progress'
       zclOTA_ImageUpgradeStatus = OTA_STATUS_IN_PROGRESS;
@@ -1766,6 +2603,14 @@ static ZStatus_t zclOTA_ProcessImageBlockRsp ( zclIncoming_t *pInMsg )
   pData = pInMsg->pData;
   param.status = *pData++;
 
+  // Only blocks are streamed: any other response sent to a group or
+  // broadcast address is not about this device's download
+  if ( ( param.status != ZCL_STATUS_SUCCESS ) &&
+       ( ( pInMsg->msg->groupId != 0 ) || pInMsg->msg->wasBroadcast ) )
+  {
+    return ZSuccess;
+  }
+
   // if status is success
   if ( param.status == ZCL_STATUS_SUCCESS )
   {
@@ -1788,6 +2633,47 @@ static ZStatus_t zclOTA_ProcessImageBlockRsp ( zclIncoming_t *pInMsg )
     param.rsp.success.dataSize = *pData++;
     param.rsp.success.pData = pData;
 
+#if OTA_MCAST_BLOCKS
+    // A block streamed to a group or broadcast address
+    if ( ( pInMsg->msg->groupId != 0 ) || pInMsg->msg->wasBroadcast )
+    {
+      // Streams of other images are not for this device
+      if ( ( param.rsp.success.fileId.type != zclOTA_ImageType ) ||
+           ( param.rsp.success.fileId.manufacturer != zclOTA_ManufacturerId ) ||
+           ( param.rsp.success.fileId.version != zclOTA_DownloadedFileVersion ) )
+      {
+        return ZSuccess;
+      }
+
+      status = zclOTA_McastBlockRsp ( &param.rsp.success );
+      if ( status == ZSuccess )
+      {
+        if ( zclOTA_ImageUpgradeStatus == OTA_STATUS_COMPLETE )
+        {
+          // Nothing is left to ask for
+          zclOTA_BlockRetry = 0;
+          osal_stop_timerEx ( zclOTA_TaskID, ZCL_OTA_BLOCK_RSP_TO_EVT );
+          osal_stop_timerEx ( zclOTA_TaskID, ZCL_OTA_IMAGE_BLOCK_REQ_DELAY_EVT );
+          osal_stop_timerEx ( zclOTA_TaskID, ZCL_OTA_STREAM_QUIET_EVT );
+          zclOTA_McastListen = FALSE;
+
+          // send upgrade end req with success status
+          osal_memcpy ( &req.fileId, &param.rsp.success.fileId, sizeof ( zclOTA_FileID_t ) );
+          req.status = ZSuccess;
+          zclOTA_SendUpgradeEndReq ( &zclOTA_serverAddr, &req );
+        }
+        else if ( zclOTA_McastOn )
+        {
+          // Listen while the stream lasts
+          zclOTA_McastListen = TRUE;
+          osal_start_timerEx ( zclOTA_TaskID, ZCL_OTA_STREAM_QUIET_EVT, OTA_MCAST_LISTEN_MS );
+        }
+
+        return ZSuccess;
+      }
+    }
+    else
+#endif
     // verify manufacturer, image type, file version, file offset
     if ( ( param.rsp.success.fileId.type != zclOTA_ImageType ) ||
          ( param.rsp.success.fileId.manufacturer != zclOTA_ManufacturerId ) ||
@@ -1797,6 +2683,14 @@ static ZStatus_t zclOTA_ProcessImageBlockRsp ( zclIncoming_t *pInMsg )
     }
     else
     {
+#if OTA_BLOCK_WINDOW > 1
+      // Drop duplicate packets (retries) and blocks that were not asked for
+      if ( !zclOTA_BlockWinRecv ( param.rsp.success.fileOffset, param.rsp.success.pData,
+                                  param.rsp.success.dataSize, &status ) )
+      {
+        return ZSuccess;
+      }
+#else
       // Drop duplicate packets (retries)
       if ( param.rsp.success.fileOffset != zclOTA_FileOffset )
       {
@@ -1804,6 +2698,7 @@ static ZStatus_t zclOTA_ProcessImageBlockRsp ( zclIncoming_t *pInMsg )
       }
 
       status = zclOTA_ProcessImageData ( param.rsp.success.pData, param.rsp.success.dataSize );
+#endif
 
       // Stop the timer and clear the retry count
       zclOTA_BlockRetry = 0;
@@ -1820,8 +2715,20 @@ static ZStatus_t zclOTA_ProcessImageBlockRsp ( zclIncoming_t *pInMsg )
         }
         else
         {
+#if OTA_BLOCK_WINDOW > 1
+          // Refill the window now, or at the pace the server asked for
+          if ( zclOTA_MinBlockReqDelay == 0 )
+          {
+            sendImageBlockReq ( &zclOTA_serverAddr );
+          }
+          else if ( osal_get_timeoutEx ( zclOTA_TaskID, ZCL_OTA_IMAGE_BLOCK_REQ_DELAY_EVT ) == 0 )
+          {
+            osal_start_timerEx ( zclOTA_TaskID, ZCL_OTA_IMAGE_BLOCK_REQ_DELAY_EVT, zclOTA_MinBlockReqDelay );
+          }
+#else
           // send image block request using rate limiting
           osal_start_timerEx ( zclOTA_TaskID, ZCL_OTA_IMAGE_BLOCK_REQ_DELAY_EVT, zclOTA_MinBlockReqDelay );
+#endif
         }
       }
     }
@@ -1843,6 +2750,11 @@ static ZStatus_t zclOTA_ProcessImageBlockRsp ( zclIncoming_t *pInMsg )
     pData += 4;
     param.rsp.wait.blockReqDelay = BUILD_UINT16 ( pData[0], pData[1] );
 
+#if OTA_BLOCK_WINDOW > 1
+    // The server is not sending blocks for now: ask again for the outstanding ones later
+    zclOTA_BlockWinCancel ( FALSE );
+#endif
+
     // check to see if device supports blockReqDelay rate limiting
     if ( ( zclOTA_ImageBlockFC & OTA_BLOCK_FC_REQ_DELAY_PRESENT ) != 0 )
     {
@@ -2278,6 +3190,10 @@ void zclOTA_ProcessNextImgRsp ( uint8* pMsg, zclOTA_FileID_t *pFileId,
 
   queryResponse = queryRsp; // save global variable for query image response. Used later in image block request check
 
+#if OTA_SRV_CACHE_PAGES
+  zclOTA_SrvCacheSetSize ( pFileId, queryRsp.imageSize );
+#endif
+
   // Send a response to the client
   if ( options & MT_OTA_QUERY_SPECIFIC_OPTION )
   {
@@ -2303,6 +3219,11 @@ void zclOTA_ProcessNextImgRsp ( uint8* pMsg, zclOTA_FileID_t *pFileId,
 void zclOTA_ProcessFileReadRsp ( uint8* pMsg, zclOTA_FileID_t *pFileId,
                                  afAddrType_t *pAddr )
 {
+#if OTA_SRV_CACHE_PAGES
+  // The read was for a page, the requests for it are held by the cache
+  (void)pAddr;
+  zclOTA_SrvCacheReadRsp ( pMsg, pFileId );
+#else
   zclOTA_ImageBlockRspParams_t blockRsp;
 
   // Set the status
@@ -2318,6 +3239,12 @@ void zclOTA_ProcessFileReadRsp ( uint8* pMsg, zclOTA_FileID_t *pFileId,
     blockRsp.rsp.success.dataSize = *pMsg++;
     blockRsp.rsp.success.pData = pMsg;
   }
+  else if ( ZCL_OTA_ADDR_IS_MCAST ( pAddr ) )
+  {
+    // An abort would reach every client; a streamed block that could not
+    // be read is left for the clients to ask for
+    return;
+  }
   else
   {
     blockRsp.status = ZOtaAbort;
@@ -2325,6 +3252,7 @@ void zclOTA_ProcessFileReadRsp ( uint8* pMsg, zclOTA_FileID_t *pFileId,
 
   // Send the block response to the peer
   zclOTA_SendImageBlockRsp ( pAddr, &blockRsp );
+#endif
 }
 
 /******************************************************************************
@@ -2466,8 +3394,13 @@ ZStatus_t zclOTA_Srv_ImageBlockReq ( afAddrType_t *pSrcAddr, zclOTA_ImageBlockRe
       }
       else
       {
+#if OTA_SRV_CACHE_PAGES
+        // Answer from the image cache, or hold the request for a page read
+        status = zclOTA_SrvCacheBlockReq ( pSrcAddr, &pParam->fileId, len, pParam->fileOffset );
+#else
         // Read the data from the OTA Console
         status = MT_OtaFileReadReq ( pSrcAddr, &pParam->fileId, len, pParam->fileOffset );
+#endif
 
         // Send a wait response to the client
         if ( status != ZSuccess )
@@ -2830,6 +3763,533 @@ static ZStatus_t zclOTA_ServerHdlIncoming ( zclIncoming_t *pInMsg )
   }
 }
 
+#if OTA_MCAST_BLOCKS
+/******************************************************************************
+ * @fn      zclOTA_SrvStreamImage
+ *
+ * @brief   Called by a server to stream an image, one block every
+ *          OTA_MCAST_BLOCK_MS, to the clients that queried it.
+ *
+ * @param   dstAddr - Group or broadcast address of the clients
+ * @param   pFileId - The image
+ * @param   imageSize - Its size, 0 to stop the stream in progress
+ *
+ * @return  ZStatus_t
+ */
+ZStatus_t zclOTA_SrvStreamImage ( afAddrType_t *dstAddr, zclOTA_FileID_t *pFileId, uint32 imageSize )
+{
+  osal_stop_timerEx ( zclOTA_TaskID, ZCL_OTA_IMAGE_STREAM_EVT );
+  zclOTA_StreamOffset = 0;
+  zclOTA_StreamEnd = 0;
+
+  if ( imageSize == 0 )
+  {
+    return ZSuccess;
+  }
+
+  if ( !zclOTA_Permit || ( dstAddr == NULL ) || ( pFileId == NULL ) )
+  {
+    return ZFailure;
+  }
+
+  zclOTA_StreamAddr = *dstAddr;
+  osal_memcpy ( &zclOTA_StreamFileId, pFileId, sizeof ( zclOTA_FileID_t ) );
+  zclOTA_StreamEnd = imageSize;
+#if OTA_SRV_CACHE_PAGES
+  zclOTA_SrvCacheSetSize ( pFileId, imageSize );
+#endif
+
+  osal_set_event ( zclOTA_TaskID, ZCL_OTA_IMAGE_STREAM_EVT );
+
+  return ZSuccess;
+}
+
+/******************************************************************************
+ * @fn      zclOTA_SrvStreamNext
+ *
+ * @brief   Stream the next block: read like a block request from the
+ *          stream address, so the response goes to every client at once.
+ *          A block the console or the cache cannot take now is tried
+ *          again on the next tick; one whose read fails is skipped, the
+ *          clients ask for it unicast.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void zclOTA_SrvStreamNext ( void )
+{
+  uint8 len = OTA_MAX_MTU;
+  uint8 status;
+
+  if ( zclOTA_StreamOffset >= zclOTA_StreamEnd )
+  {
+    return;
+  }
+
+  if ( zclOTA_StreamEnd - zclOTA_StreamOffset < OTA_MAX_MTU )
+  {
+    len = ( uint8 ) ( zclOTA_StreamEnd - zclOTA_StreamOffset );
+  }
+
+#if OTA_SRV_CACHE_PAGES
+  status = zclOTA_SrvCacheBlockReq ( &zclOTA_StreamAddr, &zclOTA_StreamFileId, len, zclOTA_StreamOffset );
+#else
+  status = MT_OtaFileReadReq ( &zclOTA_StreamAddr, &zclOTA_StreamFileId, len, zclOTA_StreamOffset );
+#endif
+
+  if ( status == ZSuccess )
+  {
+    zclOTA_StreamOffset += len;
+  }
+
+  if ( zclOTA_StreamOffset < zclOTA_StreamEnd )
+  {
+    osal_start_timerEx ( zclOTA_TaskID, ZCL_OTA_IMAGE_STREAM_EVT, OTA_MCAST_BLOCK_MS );
+  }
+}
+#endif // OTA_MCAST_BLOCKS
+
+#if OTA_SRV_CACHE_PAGES
+/*********************************************************************
+ * @fn          zclOTA_SrvCacheSetSize
+ *
+ * @brief       Keep the size of an image, in place of the oldest one kept
+ *              unless it is already there.
+ *
+ * @param       pFileId - the image
+ * @param       size - its size, 0 if the console has none
+ *
+ * @return      none
+ */
+static void zclOTA_SrvCacheSetSize ( zclOTA_FileID_t *pFileId, uint32 size )
+{
+  zclOTA_SrvImage_t *pImage;
+  uint8 i;
+
+  for ( i = 0, pImage = zclOTA_SrvImage; i < OTA_SRV_CACHE_IMAGES; i++, pImage++ )
+  {
+    if ( ( pImage->size != 0 ) &&
+         ( pImage->fileId.version == pFileId->version ) &&
+         ( pImage->fileId.type == pFileId->type ) &&
+         ( pImage->fileId.manufacturer == pFileId->manufacturer ) )
+    {
+      break;
+    }
+  }
+
+  if ( i == OTA_SRV_CACHE_IMAGES )
+  {
+    if ( size == 0 )
+    {
+      return;
+    }
+
+    pImage = &zclOTA_SrvImage[zclOTA_SrvImageNext];
+    zclOTA_SrvImageNext = ( zclOTA_SrvImageNext + 1 ) % OTA_SRV_CACHE_IMAGES;
+    osal_memcpy ( &pImage->fileId, pFileId, sizeof ( zclOTA_FileID_t ) );
+  }
+
+  pImage->size = size;
+}
+
+/*********************************************************************
+ * @fn          zclOTA_SrvCacheGetSize
+ *
+ * @brief       Size of an image, as last given by the console.
+ *
+ * @param       pFileId - the image
+ *
+ * @return      the size, 0 if not known
+ */
+static uint32 zclOTA_SrvCacheGetSize ( zclOTA_FileID_t *pFileId )
+{
+  zclOTA_SrvImage_t *pImage;
+  uint8 i;
+
+  for ( i = 0, pImage = zclOTA_SrvImage; i < OTA_SRV_CACHE_IMAGES; i++, pImage++ )
+  {
+    if ( ( pImage->size != 0 ) &&
+         ( pImage->fileId.version == pFileId->version ) &&
+         ( pImage->fileId.type == pFileId->type ) &&
+         ( pImage->fileId.manufacturer == pFileId->manufacturer ) )
+    {
+      return pImage->size;
+    }
+  }
+
+  return 0;
+}
+
+/*********************************************************************
+ * @fn          zclOTA_SrvCacheExpire
+ *
+ * @brief       Give up the page reads the console has not answered in
+ *              OTA_SRV_CACHE_READ_MS: the page is freed and the block
+ *              requests waiting for it dropped, the clients ask again.
+ *
+ * @param       none
+ *
+ * @return      none
+ */
+static void zclOTA_SrvCacheExpire ( void )
+{
+  uint16 now = (uint16)osal_GetSystemClock();
+  uint8 i;
+  uint8 j;
+
+  for ( i = 0; i < OTA_SRV_CACHE_PAGES; i++ )
+  {
+    if ( ( zclOTA_SrvPage[i].state == ZCL_OTA_PAGE_READ ) &&
+         ( (uint16)( now - zclOTA_SrvPage[i].readTime ) >= OTA_SRV_CACHE_READ_MS ) )
+    {
+      zclOTA_SrvPage[i].state = ZCL_OTA_PAGE_FREE;
+
+      for ( j = 0; j < OTA_SRV_CACHE_WAITERS; j++ )
+      {
+        if ( zclOTA_SrvWaiter[j].page == i )
+        {
+          zclOTA_SrvWaiter[j].page = ZCL_OTA_PAGE_NONE;
+        }
+      }
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn          zclOTA_SrvCacheFind
+ *
+ * @brief       Find the cached or pending page holding an image offset.
+ *
+ * @param       pFileId - the image
+ * @param       offset - offset in the image
+ *
+ * @return      the page, NULL if none
+ */
+static zclOTA_SrvPage_t *zclOTA_SrvCacheFind ( zclOTA_FileID_t *pFileId, uint32 offset )
+{
+  zclOTA_SrvPage_t *pPage;
+  uint8 i;
+
+  offset -= offset % OTA_SRV_CACHE_PAGE_SIZE;
+
+  for ( i = 0, pPage = zclOTA_SrvPage; i < OTA_SRV_CACHE_PAGES; i++, pPage++ )
+  {
+    if ( ( pPage->state != ZCL_OTA_PAGE_FREE ) &&
+         ( pPage->offset == offset ) &&
+         ( pPage->fileId.version == pFileId->version ) &&
+         ( pPage->fileId.type == pFileId->type ) &&
+         ( pPage->fileId.manufacturer == pFileId->manufacturer ) )
+    {
+      return pPage;
+    }
+  }
+
+  return NULL;
+}
+
+/*********************************************************************
+ * @fn          zclOTA_SrvCacheRead
+ *
+ * @brief       Read the page holding an image offset from the OTA Console,
+ *              into a free page or else the least recently used one.  The
+ *              page used by the current block request is never taken.
+ *
+ * @param       pAddr - device the read is made for
+ * @param       pFileId - the image
+ * @param       offset - offset in the image
+ *
+ * @return      the page, NULL if no page is free or the console is busy
+ */
+static zclOTA_SrvPage_t *zclOTA_SrvCacheRead ( afAddrType_t *pAddr, zclOTA_FileID_t *pFileId, uint32 offset )
+{
+  zclOTA_SrvPage_t *pPage = NULL;
+  uint16 age = 0;
+  uint8 i;
+
+  for ( i = 0; i < OTA_SRV_CACHE_PAGES; i++ )
+  {
+    if ( zclOTA_SrvPage[i].state == ZCL_OTA_PAGE_FREE )
+    {
+      pPage = &zclOTA_SrvPage[i];
+      break;
+    }
+
+    if ( ( zclOTA_SrvPage[i].state == ZCL_OTA_PAGE_VALID ) &&
+         ( (uint16)( zclOTA_SrvCacheClock - zclOTA_SrvPage[i].used ) > age ) )
+    {
+      age = zclOTA_SrvCacheClock - zclOTA_SrvPage[i].used;
+      pPage = &zclOTA_SrvPage[i];
+    }
+  }
+
+  if ( pPage == NULL )
+  {
+    return NULL;
+  }
+
+  offset -= offset % OTA_SRV_CACHE_PAGE_SIZE;
+
+  if ( MT_OtaFileReadReq ( pAddr, pFileId, OTA_SRV_CACHE_PAGE_SIZE, offset ) != ZSuccess )
+  {
+    return NULL;
+  }
+
+  osal_memcpy ( &pPage->fileId, pFileId, sizeof ( zclOTA_FileID_t ) );
+  pPage->offset = offset;
+  pPage->len = 0;
+  pPage->readTime = (uint16)osal_GetSystemClock();
+  pPage->state = ZCL_OTA_PAGE_READ;
+  zclOTA_SrvCacheStats.reads++;
+
+  return pPage;
+}
+
+/*********************************************************************
+ * @fn          zclOTA_SrvCacheShort
+ *
+ * @brief       Check whether a page was read short of an image offset
+ *              that is not past the end of the image, as when the
+ *              console returns fewer bytes than asked for.
+ *
+ * @param       pPage - the page
+ * @param       offset - offset in the image, within the page
+ *
+ * @return      TRUE if the page has to be read again
+ */
+static uint8 zclOTA_SrvCacheShort ( zclOTA_SrvPage_t *pPage, uint32 offset )
+{
+  uint32 size;
+
+  if ( ( pPage->state != ZCL_OTA_PAGE_VALID ) || ( offset < pPage->offset + pPage->len ) )
+  {
+    return FALSE;
+  }
+
+  size = zclOTA_SrvCacheGetSize ( &pPage->fileId );
+
+  return ( ( size == 0 ) || ( offset < size ) );
+}
+
+/*********************************************************************
+ * @fn          zclOTA_SrvCacheSend
+ *
+ * @brief       Send an image block response from a cached page.  A
+ *              unicast request for an offset the page was read short of
+ *              gets a wait response, an abort only past the end of the
+ *              image.
+ *
+ * @param       pAddr - device to send to
+ * @param       pPage - the page
+ * @param       offset - offset of the block in the image
+ * @param       len - block length, already within the page
+ *
+ * @return      none
+ */
+static void zclOTA_SrvCacheSend ( afAddrType_t *pAddr, zclOTA_SrvPage_t *pPage, uint32 offset, uint8 len )
+{
+  zclOTA_ImageBlockRspParams_t blockRsp;
+  uint8 start = (uint8)( offset - pPage->offset );
+
+  if ( ( pPage->state == ZCL_OTA_PAGE_VALID ) && ( start < pPage->len ) )
+  {
+    if ( len > pPage->len - start )
+    {
+      // Short block at the end of the image
+      len = pPage->len - start;
+    }
+
+    blockRsp.status = ZSuccess;
+    osal_memcpy ( &blockRsp.rsp.success.fileId, &pPage->fileId, sizeof ( zclOTA_FileID_t ) );
+    blockRsp.rsp.success.fileOffset = offset;
+    blockRsp.rsp.success.dataSize = len;
+    blockRsp.rsp.success.pData = &pPage->data[start];
+  }
+  else if ( ZCL_OTA_ADDR_IS_MCAST ( pAddr ) )
+  {
+    // Left for the clients of the stream to ask for
+    return;
+  }
+  else if ( zclOTA_SrvCacheShort ( pPage, offset ) )
+  {
+    // Asked again, the page is then read again
+    blockRsp.status = ZOtaWaitForData;
+    osal_memcpy ( &blockRsp.rsp.success.fileId, &pPage->fileId, sizeof ( zclOTA_FileID_t ) );
+    blockRsp.rsp.wait.currentTime = 0;
+    blockRsp.rsp.wait.requestTime = OTA_SEND_BLOCK_WAIT;
+    blockRsp.rsp.wait.blockReqDelay = zclOTA_MinBlockReqDelay;
+  }
+  else
+  {
+    blockRsp.status = ZOtaAbort;
+  }
+
+  zclOTA_SendImageBlockRsp ( pAddr, &blockRsp );
+}
+
+/*********************************************************************
+ * @fn          zclOTA_SrvCacheBlockReq
+ *
+ * @brief       Answer an image block request from the page cache.  On a
+ *              miss the request waits for the page to be read, reads of
+ *              the same page by several clients being merged, and a
+ *              request repeated while it waits keeps its place.  The page
+ *              after the requested one is read ahead of the client, up to
+ *              the end of the image.
+ *
+ * @param       pAddr - requesting device
+ * @param       pFileId - the image
+ * @param       len - block length asked for, at most OTA_MAX_MTU
+ * @param       offset - offset of the block in the image
+ *
+ * @return      ZSuccess if answered or held, ZFailure to send a wait response
+ */
+static uint8 zclOTA_SrvCacheBlockReq ( afAddrType_t *pAddr, zclOTA_FileID_t *pFileId, uint8 len, uint32 offset )
+{
+  zclOTA_SrvPage_t *pPage;
+  zclOTA_SrvWaiter_t *pWaiter;
+  uint32 next;
+  uint8 room;
+  uint8 free;
+  uint8 i;
+
+  zclOTA_SrvCacheClock++;
+  zclOTA_SrvCacheExpire();
+
+  // Blocks do not cross a page boundary, the client asks for the rest next
+  room = OTA_SRV_CACHE_PAGE_SIZE - (uint8)( offset % OTA_SRV_CACHE_PAGE_SIZE );
+  if ( len > room )
+  {
+    len = room;
+  }
+
+  pPage = zclOTA_SrvCacheFind ( pFileId, offset );
+
+  // A page read short in the middle of the image is a miss
+  if ( ( pPage != NULL ) && zclOTA_SrvCacheShort ( pPage, offset ) )
+  {
+    pPage->state = ZCL_OTA_PAGE_FREE;
+    pPage = NULL;
+  }
+
+  if ( ( pPage != NULL ) && ( pPage->state == ZCL_OTA_PAGE_VALID ) )
+  {
+    pPage->used = zclOTA_SrvCacheClock;
+    zclOTA_SrvCacheSend ( pAddr, pPage, offset, len );
+    zclOTA_SrvCacheStats.hits++;
+  }
+  else
+  {
+    // The same request from the same device waits once
+    free = OTA_SRV_CACHE_WAITERS;
+    for ( i = 0, pWaiter = zclOTA_SrvWaiter; i < OTA_SRV_CACHE_WAITERS; i++, pWaiter++ )
+    {
+      if ( pWaiter->page == ZCL_OTA_PAGE_NONE )
+      {
+        if ( free == OTA_SRV_CACHE_WAITERS )
+        {
+          free = i;
+        }
+      }
+      else if ( ( pWaiter->offset == offset ) &&
+                ( pWaiter->addr.addrMode == pAddr->addrMode ) &&
+                ( pWaiter->addr.addr.shortAddr == pAddr->addr.shortAddr ) &&
+                ( pWaiter->addr.endPoint == pAddr->endPoint ) )
+      {
+        break;
+      }
+    }
+
+    if ( i == OTA_SRV_CACHE_WAITERS )
+    {
+      i = free;
+    }
+
+    if ( ( i == OTA_SRV_CACHE_WAITERS ) ||
+         ( ( pPage == NULL ) &&
+           ( ( pPage = zclOTA_SrvCacheRead ( pAddr, pFileId, offset ) ) == NULL ) ) )
+    {
+      zclOTA_SrvCacheStats.busy++;
+      return ZFailure;
+    }
+
+    zclOTA_SrvWaiter[i].addr = *pAddr;
+    zclOTA_SrvWaiter[i].offset = offset;
+    zclOTA_SrvWaiter[i].len = len;
+    zclOTA_SrvWaiter[i].page = (uint8)( pPage - zclOTA_SrvPage );
+    zclOTA_SrvCacheStats.misses++;
+  }
+
+  // Read the next page ahead of the client
+  next = pPage->offset + OTA_SRV_CACHE_PAGE_SIZE;
+  if ( ( next < zclOTA_SrvCacheGetSize ( pFileId ) ) &&
+       ( zclOTA_SrvCacheFind ( pFileId, next ) == NULL ) &&
+       ( zclOTA_SrvCacheRead ( pAddr, pFileId, next ) != NULL ) )
+  {
+    zclOTA_SrvCacheStats.prefetches++;
+  }
+
+  return ZSuccess;
+}
+
+/*********************************************************************
+ * @fn          zclOTA_SrvCacheReadRsp
+ *
+ * @brief       Fill a page from an OTA Console file read response and
+ *              answer the block requests waiting for it.
+ *
+ * @param       pMsg - read response, from the status on
+ * @param       pFileId - the image
+ *
+ * @return      none
+ */
+static void zclOTA_SrvCacheReadRsp ( uint8 *pMsg, zclOTA_FileID_t *pFileId )
+{
+  zclOTA_SrvPage_t *pPage;
+  uint32 offset;
+  uint8 status;
+  uint8 len;
+  uint8 page;
+  uint8 i;
+
+  status = *pMsg++;
+  offset = BUILD_UINT32 ( pMsg[0], pMsg[1], pMsg[2], pMsg[3] );
+  pMsg += 4;
+  len = *pMsg++;
+
+  pPage = zclOTA_SrvCacheFind ( pFileId, offset );
+  if ( ( pPage == NULL ) || ( pPage->state != ZCL_OTA_PAGE_READ ) ||
+       ( pPage->offset != offset ) )
+  {
+    return;
+  }
+
+  if ( ( status == ZSuccess ) && ( len <= OTA_SRV_CACHE_PAGE_SIZE ) )
+  {
+    osal_memcpy ( pPage->data, pMsg, len );
+    pPage->len = len;
+    pPage->used = zclOTA_SrvCacheClock;
+    pPage->state = ZCL_OTA_PAGE_VALID;
+  }
+  else
+  {
+    pPage->state = ZCL_OTA_PAGE_FREE;
+  }
+
+  // Answer the waiters, with an abort if the read failed
+  page = (uint8)( pPage - zclOTA_SrvPage );
+  for ( i = 0; i < OTA_SRV_CACHE_WAITERS; i++ )
+  {
+    if ( zclOTA_SrvWaiter[i].page == page )
+    {
+      zclOTA_SrvWaiter[i].page = ZCL_OTA_PAGE_NONE;
+      zclOTA_SrvCacheSend ( &zclOTA_SrvWaiter[i].addr, pPage,
+                            zclOTA_SrvWaiter[i].offset, zclOTA_SrvWaiter[i].len );
+    }
+  }
+}
+#endif // OTA_SRV_CACHE_PAGES
+
 /*********************************************************************
  * @fn          zclOTA_InitBlockReqDelay
  *
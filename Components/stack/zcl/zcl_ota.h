@@ -65,6 +65,68 @@ extern "C"
 #define OTA_MAX_END_REQ_RETRIES                       2
 #define OTA_MAX_BLOCK_RSP_WAIT_TIME                   ((uint16)5000)
 
+// Image block requests the client keeps outstanding. 1 is stop-and-wait; above 1
+// the requests are pipelined, the window adapts to the observed response time and
+// responses are put back in order in OTA_BLOCK_WINDOW * OTA_MAX_MTU bytes of RAM.
+#if !defined OTA_BLOCK_WINDOW
+#define OTA_BLOCK_WINDOW                              1
+#endif
+
+// Lower bound of the block response timeout derived from the response time
+#if !defined OTA_BLOCK_RTO_MIN
+#define OTA_BLOCK_RTO_MIN                             ((uint16)250)
+#endif
+
+// Image pages the server keeps in RAM, so that block requests for the same part
+// of an image, from any client, are answered without another MT file read from
+// the OTA console. 0 reads every block over MT.
+#if !defined OTA_SRV_CACHE_PAGES
+#define OTA_SRV_CACHE_PAGES                           0
+#endif
+
+// Bytes per cached page, fetched from the console in one MT file read: whole
+// blocks, and the file read response has to fit the MT Rx buffer.
+#if !defined OTA_SRV_CACHE_PAGE_SIZE
+#define OTA_SRV_CACHE_PAGE_SIZE                       ( 2 * OTA_MAX_MTU )
+#endif
+
+// Block requests the server holds while their page is read from the console
+#if !defined OTA_SRV_CACHE_WAITERS
+#define OTA_SRV_CACHE_WAITERS                         ( 2 * OTA_SRV_CACHE_PAGES )
+#endif
+
+// Time the console has to answer a page read before the page is given up and
+// the block requests held for it are dropped
+#if !defined OTA_SRV_CACHE_READ_MS
+#define OTA_SRV_CACHE_READ_MS                         ((uint16)2000)
+#endif
+
+// Images whose size the server keeps to bound the read ahead
+#if !defined OTA_SRV_CACHE_IMAGES
+#define OTA_SRV_CACHE_IMAGES                          2
+#endif
+
+// Multicast distribution: the server streams an image once to a group or broadcast
+// address (zclOTA_SrvStreamImage). A client that hears the stream stops requesting
+// blocks, keeps one bit per block it heard and, once the stream is over, requests
+// only the blocks it missed. With the DL image in internal flash (HAL_OTA_XNV_IS_INT)
+// a page erased by a write to its start drops the blocks held in it. Largest image,
+// in blocks, a client takes from a stream; 0 downloads unicast only.
+#if !defined OTA_MCAST_BLOCKS
+#define OTA_MCAST_BLOCKS                              0
+#endif
+
+// Quiet time after which a client stops listening to the stream and requests
+// the missing blocks itself
+#if !defined OTA_MCAST_LISTEN_MS
+#define OTA_MCAST_LISTEN_MS                           ((uint16)3000)
+#endif
+
+// Interval between the blocks the server streams
+#if !defined OTA_MCAST_BLOCK_MS
+#define OTA_MCAST_BLOCK_MS                            ((uint16)100)
+#endif
+
 // Simple descriptor values
 #define ZCL_OTA_ENDPOINT                              14
 #ifdef OTA_HA
@@ -195,6 +257,10 @@ extern "C"
 #define ZCL_OTA_IMAGE_QUERY_TO_EVT                    0x0010
 #define ZCL_OTA_IMAGE_BLOCK_REQ_DELAY_EVT             0x0020
 #define ZCL_OTA_SEND_MATCH_DESCRIPTOR_EVT             0x0040
+#define ZCL_OTA_STREAM_QUIET_EVT                      0x0080
+
+// Server Task Events
+#define ZCL_OTA_IMAGE_STREAM_EVT                      0x0100
 
 
 // The OTA Upgrade delay is the number of seconds before the client
@@ -337,6 +403,16 @@ typedef struct
   uint8 ota_event;
 } zclOTA_CallbackMsg_t;
 
+// Server image page cache counters
+typedef struct
+{
+  uint32 hits;          // Block requests answered from a cached page
+  uint32 misses;        // Block requests held for a page read
+  uint32 reads;         // Page reads sent to the console
+  uint32 prefetches;    // Of those, reads ahead of a client
+  uint32 busy;          // Block requests answered with a wait, no page or waiter free
+} zclOTA_SrvCacheStats_t;
+
 /******************************************************************************
  * GLOBAL VARIABLES
  */
@@ -351,6 +427,12 @@ extern uint8 zclOTA_ImageUpgradeStatus;
 extern uint16 zclOTA_ManufacturerId;
 extern uint16 zclOTA_ImageType;
 extern uint16 zclOTA_MinBlockReqDelay;
+#if OTA_BLOCK_WINDOW > 1
+extern uint8 zclOTA_BlockWindow;
+#endif
+#if (defined OTA_SERVER) && (OTA_SERVER == TRUE) && OTA_SRV_CACHE_PAGES
+extern zclOTA_SrvCacheStats_t zclOTA_SrvCacheStats;
+#endif
 
 /******************************************************************************
  * FUNCTIONS
@@ -438,6 +520,22 @@ extern uint8 zclOTA_getStatus( void );
  * @return  ZStatus_t
  */
 extern ZStatus_t zclOTA_SendImageNotify(afAddrType_t *dstAddr, zclOTA_ImageNotifyParams_t *pParams);
+
+#if OTA_MCAST_BLOCKS
+/******************************************************************************
+ * @fn      zclOTA_SrvStreamImage
+ *
+ * @brief   Called by a server to stream an image, one block every
+ *          OTA_MCAST_BLOCK_MS, to the clients that queried it.
+ *
+ * @param   dstAddr - Group or broadcast address of the clients
+ * @param   pFileId - The image
+ * @param   imageSize - Its size, 0 to stop the stream in progress
+ *
+ * @return  ZStatus_t
+ */
+extern ZStatus_t zclOTA_SrvStreamImage(afAddrType_t *dstAddr, zclOTA_FileID_t *pFileId, uint32 imageSize);
+#endif
 #endif
 
 #ifdef __cplusplus
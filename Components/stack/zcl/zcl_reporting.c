@@ -0,0 +1,659 @@
+/**************************************************************************************************
+  Filename:       zcl_reporting.c
+
+  Description:    ZCL attribute reporting engine: Configure Reporting / Read Reporting
+                  Configuration handling, reportable change detection and the reports sent
+                  from the single reporting timer of the ZCL task.
+
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "ZComDef.h"
+#include "OSAL.h"
+#include "OSAL_Clock.h"
+#include "OSAL_Timers.h"
+#include "AF.h"
+
+#include "zcl.h"
+#include "zcl_reporting.h"
+
+#if defined ( ZCL_REPORTING )
+
+#if !defined ( ZCL_REPORT ) || defined ( ZCL_STANDALONE )
+  #error "ZCL_REPORTING needs ZCL_REPORT and the ZCL task"
+#endif
+
+/*********************************************************************
+ * MACROS
+ */
+
+// Interval in seconds to OSAL clock milliseconds
+#define ZCL_REPORTING_MS( sec )         ( (uint32)(sec) * 1000 )
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Widest value kept per configuration
+#define ZCL_REPORTING_VALUE_LEN         4
+
+#define ZCL_REPORTING_NEVER             0xFFFFFFFF
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef struct
+{
+  uint8  endpoint;           // 0 if the entry is free
+  uint8  dataType;
+  uint8  pending;            // value moved by the reportable change, waiting for minReportInt
+  uint16 clusterID;
+  uint16 attrID;
+  uint16 minReportInt;       // seconds
+  uint16 maxReportInt;       // seconds, 0 = report on change only
+  uint32 change;             // reportable change, in the attribute's native format
+  uint32 lastValue;          // value of the last report, in the attribute's native format
+  uint32 lastReport;         // osal_GetSystemClock() of the last report
+  void   *dataPtr;           // current value
+} zclReportingCfg_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static zclReportingCfg_t zclReportingCfgs[ZCL_REPORTING_MAX_CFG];
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static zclReportingCfg_t *zclReportingFind( uint8 endpoint, uint16 clusterID, uint16 attrID );
+static uint8 zclReportingSigned( uint8 dataType );
+static int32 zclReportingLoad( uint8 dataType, void *pData );
+static uint8 zclReportingChanged( zclReportingCfg_t *pCfg );
+static void zclReportingSchedule( void );
+static void zclReportingSend( uint8 first, uint8 *pDue, uint32 now );
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      zclReporting_Config
+ *
+ * @brief   Add, change or remove the reporting configuration of an
+ *          attribute. Only attributes flagged ACCESS_REPORTABLE, kept
+ *          in RAM (not through the application's callback) and of a
+ *          fixed size up to 4 octets can be reported.
+ *
+ * @param   endpoint - endpoint of the attribute
+ * @param   clusterID - cluster of the attribute
+ * @param   pCfg - configuration record, as parsed from Configure Reporting
+ *
+ * @return  ZCL_STATUS_SUCCESS or the ZCL status of the failure
+ */
+uint8 zclReporting_Config( uint8 endpoint, uint16 clusterID, zclCfgReportRec_t *pCfg )
+{
+  zclReportingCfg_t *pEntry;
+  zclAttrRec_t attrRec;
+  uint8 len;
+  uint8 i;
+
+  // Reports of other devices are not supervised
+  if ( pCfg->direction != ZCL_SEND_ATTR_REPORTS )
+  {
+    return ( ZCL_STATUS_UNSUPPORTED_ATTRIBUTE );
+  }
+
+  if ( !zclFindAttrRec( endpoint, clusterID, pCfg->attrID, &attrRec ) )
+  {
+    return ( ZCL_STATUS_UNSUPPORTED_ATTRIBUTE );
+  }
+
+  if ( attrRec.attr.dataType != pCfg->dataType )
+  {
+    return ( ZCL_STATUS_INVALID_DATA_TYPE );
+  }
+
+  len = zclGetDataTypeLength( pCfg->dataType );
+  if ( !( attrRec.attr.accessControl & ACCESS_REPORTABLE ) ||
+       ( attrRec.attr.dataPtr == NULL ) || ( len == 0 ) || ( len > ZCL_REPORTING_VALUE_LEN ) )
+  {
+    return ( ZCL_STATUS_UNREPORTABLE_ATTRIBUTE );
+  }
+
+  pEntry = zclReportingFind( endpoint, clusterID, pCfg->attrID );
+
+  if ( pCfg->maxReportInt == ZCL_REPORTING_INT_OFF )
+  {
+    if ( pEntry != NULL )
+    {
+      pEntry->endpoint = 0;
+      zclReportingSchedule();
+    }
+
+    return ( ZCL_STATUS_SUCCESS );
+  }
+
+  if ( ( pCfg->maxReportInt != 0 ) && ( pCfg->minReportInt > pCfg->maxReportInt ) )
+  {
+    return ( ZCL_STATUS_INVALID_VALUE );
+  }
+
+  if ( pEntry == NULL )
+  {
+    for ( i = 0; i < ZCL_REPORTING_MAX_CFG; i++ )
+    {
+      if ( zclReportingCfgs[i].endpoint == 0 )
+      {
+        pEntry = &zclReportingCfgs[i];
+        break;
+      }
+    }
+
+    if ( pEntry == NULL )
+    {
+      return ( ZCL_STATUS_INSUFFICIENT_SPACE );
+    }
+  }
+
+  pEntry->endpoint = endpoint;
+  pEntry->clusterID = clusterID;
+  pEntry->attrID = pCfg->attrID;
+  pEntry->dataType = pCfg->dataType;
+  pEntry->dataPtr = attrRec.attr.dataPtr;
+  pEntry->minReportInt = pCfg->minReportInt;
+  pEntry->maxReportInt = pCfg->maxReportInt;
+
+  // Values are kept as their native bytes, zero padded
+  pEntry->change = 0;
+  if ( zclAnalogDataType( pCfg->dataType ) && ( pCfg->reportableChange != NULL ) )
+  {
+    zcl_memcpy( &pEntry->change, pCfg->reportableChange, len );
+  }
+  pEntry->lastValue = 0;
+  zcl_memcpy( &pEntry->lastValue, pEntry->dataPtr, len );
+  pEntry->lastReport = osal_GetSystemClock();
+  pEntry->pending = FALSE;
+
+  zclReportingSchedule();
+
+  return ( ZCL_STATUS_SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      zclReporting_AttrChanged
+ *
+ * @brief   Called by the application after it changed the value of an
+ *          attribute. Schedules a report if the value moved by at
+ *          least its reportable change since the last report.
+ *
+ * @param   endpoint - endpoint of the attribute
+ * @param   clusterID - cluster of the attribute
+ * @param   attrID - attribute
+ *
+ * @return  none
+ */
+void zclReporting_AttrChanged( uint8 endpoint, uint16 clusterID, uint16 attrID )
+{
+  zclReportingCfg_t *pCfg = zclReportingFind( endpoint, clusterID, attrID );
+
+  if ( ( pCfg != NULL ) && !pCfg->pending && zclReportingChanged( pCfg ) )
+  {
+    pCfg->pending = TRUE;
+    zclReportingSchedule();
+  }
+}
+
+/*********************************************************************
+ * @fn      zclReporting_Process
+ *
+ * @brief   Reporting timer expired. Sends one Report Attributes command
+ *          per endpoint and cluster holding due attributes, then arms
+ *          the timer for the next one.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void zclReporting_Process( void )
+{
+  zclReportingCfg_t *pCfg;
+  uint8 due[ZCL_REPORTING_MAX_CFG];
+  uint32 now = osal_GetSystemClock();
+  uint32 elapsed;
+  uint8 i;
+
+  for ( i = 0; i < ZCL_REPORTING_MAX_CFG; i++ )
+  {
+    pCfg = &zclReportingCfgs[i];
+    due[i] = FALSE;
+
+    if ( pCfg->endpoint != 0 )
+    {
+      // The value may have come back within the reportable change
+      pCfg->pending = zclReportingChanged( pCfg );
+
+      elapsed = now - pCfg->lastReport;
+      if ( ( pCfg->pending && ( elapsed >= ZCL_REPORTING_MS( pCfg->minReportInt ) ) ) ||
+           ( ( pCfg->maxReportInt != 0 ) && ( elapsed >= ZCL_REPORTING_MS( pCfg->maxReportInt ) ) ) )
+      {
+        due[i] = TRUE;
+      }
+    }
+  }
+
+  for ( i = 0; i < ZCL_REPORTING_MAX_CFG; i++ )
+  {
+    if ( due[i] )
+    {
+      zclReportingSend( i, due, now );
+    }
+  }
+
+  zclReportingSchedule();
+}
+
+/*********************************************************************
+ * @fn      zclReporting_ProcessInConfigReportCmd
+ *
+ * @brief   Process the "Profile" Configure Reporting Command
+ *
+ * @param   pInMsg - incoming message to process
+ *
+ * @return  TRUE if command processed. FALSE, otherwise.
+ */
+uint8 zclReporting_ProcessInConfigReportCmd( zclIncoming_t *pInMsg )
+{
+  zclCfgReportCmd_t *cfgReportCmd = (zclCfgReportCmd_t *)pInMsg->attrCmd;
+  zclCfgReportRspCmd_t *cfgReportRspCmd;
+  zclCfgReportStatus_t *statusRec;
+  uint8 status;
+  uint8 i;
+
+  cfgReportRspCmd = (zclCfgReportRspCmd_t *)zcl_mem_alloc( sizeof( zclCfgReportRspCmd_t ) +
+                          ( cfgReportCmd->numAttr * sizeof( zclCfgReportStatus_t ) ) );
+  if ( cfgReportRspCmd == NULL )
+  {
+    return ( FALSE ); // EMBEDDED RETURN
+  }
+
+  // Only the failures are listed
+  cfgReportRspCmd->numAttr = 0;
+  for ( i = 0; i < cfgReportCmd->numAttr; i++ )
+  {
+    status = zclReporting_Config( pInMsg->msg->endPoint, pInMsg->msg->clusterId,
+                                  &(cfgReportCmd->attrList[i]) );
+    if ( status != ZCL_STATUS_SUCCESS )
+    {
+      statusRec = &(cfgReportRspCmd->attrList[cfgReportRspCmd->numAttr++]);
+      statusRec->status = status;
+      statusRec->direction = cfgReportCmd->attrList[i].direction;
+      statusRec->attrID = cfgReportCmd->attrList[i].attrID;
+    }
+  }
+
+  // All configured: a single SUCCESS status without attribute ID
+  if ( cfgReportRspCmd->numAttr == 0 )
+  {
+    cfgReportRspCmd->numAttr = 1;
+    cfgReportRspCmd->attrList[0].status = ZCL_STATUS_SUCCESS;
+    cfgReportRspCmd->attrList[0].direction = ZCL_SEND_ATTR_REPORTS;
+    cfgReportRspCmd->attrList[0].attrID = 0;
+  }
+
+  zcl_SendConfigReportRspCmd( pInMsg->msg->endPoint, &(pInMsg->msg->srcAddr),
+                              pInMsg->msg->clusterId, cfgReportRspCmd,
+                              !pInMsg->hdr.fc.direction, TRUE, pInMsg->hdr.transSeqNum );
+  zcl_mem_free( cfgReportRspCmd );
+
+  return ( TRUE );
+}
+
+/*********************************************************************
+ * @fn      zclReporting_ProcessInReadReportCfgCmd
+ *
+ * @brief   Process the "Profile" Read Reporting Configuration Command
+ *
+ * @param   pInMsg - incoming message to process
+ *
+ * @return  TRUE if command processed. FALSE, otherwise.
+ */
+uint8 zclReporting_ProcessInReadReportCfgCmd( zclIncoming_t *pInMsg )
+{
+  zclReadReportCfgCmd_t *readReportCfgCmd = (zclReadReportCfgCmd_t *)pInMsg->attrCmd;
+  zclReadReportCfgRspCmd_t *readReportCfgRspCmd;
+  zclReportCfgRspRec_t *rspRec;
+  zclReportingCfg_t *pCfg;
+  zclAttrRec_t attrRec;
+  uint8 i;
+
+  readReportCfgRspCmd = (zclReadReportCfgRspCmd_t *)zcl_mem_alloc( sizeof( zclReadReportCfgRspCmd_t ) +
+                          ( readReportCfgCmd->numAttr * sizeof( zclReportCfgRspRec_t ) ) );
+  if ( readReportCfgRspCmd == NULL )
+  {
+    return ( FALSE ); // EMBEDDED RETURN
+  }
+
+  readReportCfgRspCmd->numAttr = readReportCfgCmd->numAttr;
+  for ( i = 0; i < readReportCfgCmd->numAttr; i++ )
+  {
+    rspRec = &(readReportCfgRspCmd->attrList[i]);
+    zcl_memset( rspRec, 0, sizeof( zclReportCfgRspRec_t ) );
+    rspRec->direction = readReportCfgCmd->attrList[i].direction;
+    rspRec->attrID = readReportCfgCmd->attrList[i].attrID;
+
+    pCfg = zclReportingFind( pInMsg->msg->endPoint, pInMsg->msg->clusterId, rspRec->attrID );
+
+    if ( !zclFindAttrRec( pInMsg->msg->endPoint, pInMsg->msg->clusterId, rspRec->attrID, &attrRec ) )
+    {
+      rspRec->status = ZCL_STATUS_UNSUPPORTED_ATTRIBUTE;
+    }
+    else if ( !( attrRec.attr.accessControl & ACCESS_REPORTABLE ) )
+    {
+      rspRec->status = ZCL_STATUS_UNREPORTABLE_ATTRIBUTE;
+    }
+    else if ( ( rspRec->direction != ZCL_SEND_ATTR_REPORTS ) || ( pCfg == NULL ) )
+    {
+      rspRec->status = ZCL_STATUS_NOT_FOUND;
+    }
+    else
+    {
+      rspRec->status = ZCL_STATUS_SUCCESS;
+      rspRec->dataType = pCfg->dataType;
+      rspRec->minReportInt = pCfg->minReportInt;
+      rspRec->maxReportInt = pCfg->maxReportInt;
+      rspRec->reportableChange = (uint8 *)&pCfg->change;
+    }
+  }
+
+  zcl_SendReadReportCfgRspCmd( pInMsg->msg->endPoint, &(pInMsg->msg->srcAddr),
+                               pInMsg->msg->clusterId, readReportCfgRspCmd,
+                               !pInMsg->hdr.fc.direction, TRUE, pInMsg->hdr.transSeqNum );
+  zcl_mem_free( readReportCfgRspCmd );
+
+  return ( TRUE );
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      zclReportingFind
+ *
+ * @brief   Find the reporting configuration of an attribute.
+ *
+ * @param   endpoint - endpoint of the attribute
+ * @param   clusterID - cluster of the attribute
+ * @param   attrID - attribute
+ *
+ * @return  configuration, NULL if the attribute is not reported
+ */
+static zclReportingCfg_t *zclReportingFind( uint8 endpoint, uint16 clusterID, uint16 attrID )
+{
+  zclReportingCfg_t *pCfg;
+  uint8 i;
+
+  for ( i = 0; i < ZCL_REPORTING_MAX_CFG; i++ )
+  {
+    pCfg = &zclReportingCfgs[i];
+    if ( ( pCfg->endpoint == endpoint ) && ( pCfg->attrID == attrID ) &&
+         ( pCfg->clusterID == clusterID ) )
+    {
+      return ( pCfg );
+    }
+  }
+
+  return ( (zclReportingCfg_t *)NULL );
+}
+
+/*********************************************************************
+ * @fn      zclReportingSigned
+ *
+ * @brief   Checks to see if an analog Data Type is a signed integer
+ *
+ * @param   dataType - data type
+ *
+ * @return  TRUE if signed
+ */
+static uint8 zclReportingSigned( uint8 dataType )
+{
+  return ( ( dataType == ZCL_DATATYPE_INT8 ) || ( dataType == ZCL_DATATYPE_INT16 ) ||
+           ( dataType == ZCL_DATATYPE_INT24 ) || ( dataType == ZCL_DATATYPE_INT32 ) );
+}
+
+/*********************************************************************
+ * @fn      zclReportingLoad
+ *
+ * @brief   Read an integer value of up to 4 octets kept in its native
+ *          format, sign extended for the signed types.
+ *
+ * @param   dataType - data type
+ * @param   pData - value
+ *
+ * @return  value
+ */
+static int32 zclReportingLoad( uint8 dataType, void *pData )
+{
+  uint8 isSigned = zclReportingSigned( dataType );
+
+  switch ( zclGetDataTypeLength( dataType ) )
+  {
+    case 1:
+      return ( isSigned ? (int32)*((int8 *)pData) : (int32)*((uint8 *)pData) );
+
+    case 2:
+      return ( isSigned ? (int32)*((int16 *)pData) : (int32)*((uint16 *)pData) );
+
+    case 3:
+      {
+        // Kept as 3 octets, zero padded to 32 bits
+        uint32 value = 0;
+
+        zcl_memcpy( &value, pData, 3 );
+        if ( isSigned && ( value & 0x00800000 ) )
+        {
+          value |= 0xFF000000;
+        }
+        return ( (int32)value );
+      }
+
+    default:
+      return ( *((int32 *)pData) );
+  }
+}
+
+/*********************************************************************
+ * @fn      zclReportingChanged
+ *
+ * @brief   Compare the current value of an attribute with its last
+ *          report. Discrete (and semi precision) values report any
+ *          change, analog values a change of at least the reportable
+ *          change.
+ *
+ * @param   pCfg - configuration of the attribute
+ *
+ * @return  TRUE if the attribute has to be reported
+ */
+static uint8 zclReportingChanged( zclReportingCfg_t *pCfg )
+{
+  uint32 value = 0;
+  uint32 diff;
+  int32 cur;
+  int32 last;
+
+  zcl_memcpy( &value, pCfg->dataPtr, zclGetDataTypeLength( pCfg->dataType ) );
+  if ( value == pCfg->lastValue )
+  {
+    return ( FALSE );
+  }
+
+  if ( !zclAnalogDataType( pCfg->dataType ) || ( pCfg->dataType == ZCL_DATATYPE_SEMI_PREC ) )
+  {
+    return ( TRUE );
+  }
+
+  if ( pCfg->dataType == ZCL_DATATYPE_SINGLE_PREC )
+  {
+    float fCur, fLast, fChange;
+
+    zcl_memcpy( &fCur, &value, sizeof( float ) );
+    zcl_memcpy( &fLast, &pCfg->lastValue, sizeof( float ) );
+    zcl_memcpy( &fChange, &pCfg->change, sizeof( float ) );
+
+    return ( ( ( fCur > fLast ) ? ( fCur - fLast ) : ( fLast - fCur ) ) >= fChange );
+  }
+
+  cur = zclReportingLoad( pCfg->dataType, &value );
+  last = zclReportingLoad( pCfg->dataType, &pCfg->lastValue );
+
+  // Distance in unsigned arithmetic, so that it cannot overflow
+  if ( zclReportingSigned( pCfg->dataType ) ? ( cur > last ) : ( (uint32)cur > (uint32)last ) )
+  {
+    diff = (uint32)cur - (uint32)last;
+  }
+  else
+  {
+    diff = (uint32)last - (uint32)cur;
+  }
+
+  return ( diff >= (uint32)zclReportingLoad( pCfg->dataType, &pCfg->change ) );
+}
+
+/*********************************************************************
+ * @fn      zclReportingSchedule
+ *
+ * @brief   Arm the reporting timer for the first configuration due:
+ *          a pending change at its minimum interval, anything else at
+ *          its maximum interval.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+static void zclReportingSchedule( void )
+{
+  zclReportingCfg_t *pCfg;
+  uint32 now = osal_GetSystemClock();
+  uint32 next = ZCL_REPORTING_NEVER;
+  uint32 interval;
+  uint32 elapsed;
+  uint8 i;
+
+  for ( i = 0; i < ZCL_REPORTING_MAX_CFG; i++ )
+  {
+    pCfg = &zclReportingCfgs[i];
+
+    if ( pCfg->endpoint == 0 )
+    {
+      continue;
+    }
+
+    if ( pCfg->pending )
+    {
+      interval = ZCL_REPORTING_MS( pCfg->minReportInt );
+    }
+    else if ( pCfg->maxReportInt != 0 )
+    {
+      interval = ZCL_REPORTING_MS( pCfg->maxReportInt );
+    }
+    else
+    {
+      continue;
+    }
+
+    elapsed = now - pCfg->lastReport;
+    interval = ( elapsed >= interval ) ? 0 : ( interval - elapsed );
+    if ( interval < next )
+    {
+      next = interval;
+    }
+  }
+
+  if ( next == ZCL_REPORTING_NEVER )
+  {
+    osal_stop_timerEx( zcl_TaskID, ZCL_REPORTING_EVT );
+  }
+  else if ( next == 0 )
+  {
+    osal_stop_timerEx( zcl_TaskID, ZCL_REPORTING_EVT );
+    osal_set_event( zcl_TaskID, ZCL_REPORTING_EVT );
+  }
+  else
+  {
+    osal_start_timerEx( zcl_TaskID, ZCL_REPORTING_EVT, next );
+  }
+}
+
+/*********************************************************************
+ * @fn      zclReportingSend
+ *
+ * @brief   Send the due attributes of the endpoint and cluster of
+ *          configuration 'first' in one report to the bound devices.
+ *
+ * @param   first - index of the first due configuration
+ * @param   pDue - due flags, cleared for the attributes sent
+ * @param   now - time stamp of the report
+ *
+ * @return  none
+ */
+static void zclReportingSend( uint8 first, uint8 *pDue, uint32 now )
+{
+  zclReportingCfg_t *pFirst = &zclReportingCfgs[first];
+  zclReportingCfg_t *pCfg;
+  zclReportCmd_t *pReportCmd;
+  zclReport_t *pReport;
+  afAddrType_t dstAddr;
+  uint8 i;
+
+  pReportCmd = (zclReportCmd_t *)zcl_mem_alloc( sizeof( zclReportCmd_t ) +
+                                                ( ZCL_REPORTING_MAX_CFG * sizeof( zclReport_t ) ) );
+  if ( pReportCmd != NULL )
+  {
+    pReportCmd->numAttr = 0;
+  }
+
+  for ( i = first; i < ZCL_REPORTING_MAX_CFG; i++ )
+  {
+    pCfg = &zclReportingCfgs[i];
+    if ( !pDue[i] || ( pCfg->endpoint != pFirst->endpoint ) || ( pCfg->clusterID != pFirst->clusterID ) )
+    {
+      continue;
+    }
+
+    pDue[i] = FALSE;
+
+    // Without memory the report is retried after the next interval
+    pCfg->lastReport = now;
+    if ( pReportCmd != NULL )
+    {
+      pReport = &(pReportCmd->attrList[pReportCmd->numAttr++]);
+      pReport->attrID = pCfg->attrID;
+      pReport->dataType = pCfg->dataType;
+      pReport->attrData = pCfg->dataPtr;
+
+      pCfg->lastValue = 0;
+      zcl_memcpy( &pCfg->lastValue, pCfg->dataPtr, zclGetDataTypeLength( pCfg->dataType ) );
+      pCfg->pending = FALSE;
+    }
+  }
+
+  if ( pReportCmd != NULL )
+  {
+    dstAddr.addrMode = (afAddrMode_t)AddrNotPresent;
+    dstAddr.endPoint = 0;
+    dstAddr.addr.shortAddr = 0;
+
+    zcl_SendReportCmd( pFirst->endpoint, &dstAddr, pFirst->clusterID, pReportCmd,
+                       ZCL_FRAME_SERVER_CLIENT_DIR, TRUE, zcl_SeqNum++ );
+    zcl_mem_free( pReportCmd );
+  }
+}
+
+#endif // ZCL_REPORTING
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,75 @@
+/**************************************************************************************************
+  Filename:       zcl_reporting.h
+
+  Description:    ZCL attribute reporting engine. Keeps the reporting configurations set with
+                  Configure Reporting (or locally by the application), and sends Report
+                  Attributes commands to the bound devices when a value moved by more than its
+                  reportable change, no sooner than the minimum interval, and at least every
+                  maximum interval. All configurations share one OSAL timer of the ZCL task.
+
+                  Compiled with ZCL_REPORTING (requires ZCL_REPORT and the ZCL task).
+
+**************************************************************************************************/
+
+#ifndef ZCL_REPORTING_H
+#define ZCL_REPORTING_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "zcl.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Number of attribute reporting configurations kept, over all endpoints
+#if !defined ( ZCL_REPORTING_MAX_CFG )
+  #define ZCL_REPORTING_MAX_CFG         8
+#endif
+
+// ZCL task event of the reporting timer
+#define ZCL_REPORTING_EVT               0x0001
+
+// maxReportInt that removes a configuration
+#define ZCL_REPORTING_INT_OFF           0xFFFF
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * Add, change (or with maxReportInt 0xFFFF, remove) the reporting configuration of
+ * one attribute. Returns a ZCL status, as reported in the Configure Reporting Response.
+ */
+extern uint8 zclReporting_Config( uint8 endpoint, uint16 clusterID, zclCfgReportRec_t *pCfg );
+
+/*
+ * Tell the engine that the application changed the value of an attribute
+ */
+extern void zclReporting_AttrChanged( uint8 endpoint, uint16 clusterID, uint16 attrID );
+
+/*
+ * Reporting timer expired, send the reports that are due (ZCL task only)
+ */
+extern void zclReporting_Process( void );
+
+/*
+ * Configure Reporting and Read Reporting Configuration command handlers
+ */
+extern uint8 zclReporting_ProcessInConfigReportCmd( zclIncoming_t *pInMsg );
+extern uint8 zclReporting_ProcessInReadReportCfgCmd( zclIncoming_t *pInMsg );
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ZCL_REPORTING_H */
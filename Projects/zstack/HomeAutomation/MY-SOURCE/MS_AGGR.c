@@ -0,0 +1,244 @@
+/*******************************************************************************
+ *                                            INCLUDES
+ *******************************************************************************/
+#include "MS_AGGR.h"
+#include "MS_GLOBAL.h"
+#include "OSAL.h"
+#include "OSAL_Tasks.h"
+#include "zcl.h"
+#include "zcl_hvac.h"
+
+/*******************************************************************************
+ *                                             MACROS
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                            CONSTANTS
+ *******************************************************************************/
+#define AGGR_ZCL_HDR_LEN										3				// Frame control, sequence, command
+
+// Over the air size of the records: attrID(2) + dataType(1) + data
+#define AGGR_ROLL_CALL_LEN									((3 + 2) + (3 + 1))
+#define AGGR_CHILD_LEN											((3 + 2) + (3 + 2) + (3 + 1))
+
+#define AGGR_ROLL_CALL_ATTRS								2
+#define AGGR_CHILD_ATTRS										3
+#define AGGR_MAX_ATTRS											(AGGR_ROLL_CALL_ATTRS + AGGR_CHILD_ATTRS * AGGR_MAX_CHILDREN)
+
+/*******************************************************************************
+ *                                             TYPEDEFS
+ *******************************************************************************/
+typedef struct
+{
+	uint16			shortAddr;
+	uint8				endPoint;
+	uint16			sensor;				// temperature LSB, humidity MSB
+	uint16			state;				// heating LSB, cooling MSB
+} AggrChild_t;
+
+/*******************************************************************************
+ *                                         GLOBAL VARIABLES
+ *******************************************************************************/
+static uint8 aggrSrcEP;
+static uint16 aggrClusterID;
+static afAddrType_t aggrDstAddr;
+static uint8 *aggrSeqNum;
+static uint8 aggrTaskId = TASK_NO_TASK;
+static uint16 aggrEvent;
+
+static uint8 aggrPayloadMax;					// ZCL payload that fits one APS frame
+static uint8 aggrPayloadLen;					// Pending records, over the air
+static uint8 aggrArmed;
+
+static uint8 aggrRollCall;
+static uint16 aggrCoordShortAddr;
+static uint8 aggrDeviceType;
+
+static uint8 aggrNumChild;
+static AggrChild_t aggrChild[AGGR_MAX_CHILDREN];
+
+/*******************************************************************************
+ *                                          FUNCTIONS - External
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                          FUNCTIONS - Local
+ *******************************************************************************/
+static AggrChild_t *AGGR_FindChild(uint16 shortAddr, uint8 endPoint);
+static void AGGR_Arm(void);
+
+/*******************************************************************************
+ *                                          FUNCTIONS - API
+ *******************************************************************************/
+void AGGR_Init(uint8 srcEP, uint16 clusterID, afAddrType_t *dstAddr, uint8 *pSeqNum,
+							 uint8 task_id, uint16 event)
+{
+	afDataReqMTU_t mtu;
+
+	aggrSrcEP = srcEP;
+	aggrClusterID = clusterID;
+	aggrDstAddr = *dstAddr;
+	aggrSeqNum = pSeqNum;
+	aggrTaskId = task_id;
+	aggrEvent = event;
+
+	// Reports go out without APS security, see zcl_SendReportCmd
+	mtu.kvp = FALSE;
+	mtu.aps.secure = FALSE;
+	aggrPayloadMax = afDataReqMTU(&mtu) - AGGR_ZCL_HDR_LEN;
+
+	aggrPayloadLen = 0;
+	aggrArmed = FALSE;
+	aggrRollCall = FALSE;
+	aggrNumChild = 0;
+}
+
+void AGGR_AddRollCall(uint16 coordShortAddr, uint8 deviceType)
+{
+	if (!aggrRollCall)
+	{
+		if (aggrPayloadLen + AGGR_ROLL_CALL_LEN > aggrPayloadMax)
+		{
+			(void)AGGR_Flush();
+		}
+		aggrRollCall = TRUE;
+		aggrPayloadLen += AGGR_ROLL_CALL_LEN;
+	}
+
+	aggrCoordShortAddr = coordShortAddr;
+	aggrDeviceType = deviceType;
+	AGGR_Arm();
+}
+
+void AGGR_AddSensor(uint16 shortAddr, uint8 endPoint, uint16 sensor)
+{
+	AGGR_FindChild(shortAddr, endPoint)->sensor = sensor;
+	AGGR_Arm();
+}
+
+void AGGR_AddState(uint16 shortAddr, uint8 endPoint, uint16 state)
+{
+	AGGR_FindChild(shortAddr, endPoint)->state = state;
+	AGGR_Arm();
+}
+
+uint8 AGGR_Flush(void)
+{
+	zclReportCmd_t *pReportCmd;
+	zclReport_t *pAttr;
+	AggrChild_t *pChild = aggrChild;
+	uint8 numChild = aggrNumChild;
+	uint8 frames = 0;
+	uint8 len;
+
+	if (aggrArmed)
+	{
+		(void)osal_stop_timerEx(aggrTaskId, aggrEvent);
+		aggrArmed = FALSE;
+	}
+
+	if (aggrPayloadLen == 0)
+	{
+		return (0);
+	}
+
+	pReportCmd = osal_mem_alloc(sizeof(zclReportCmd_t) + AGGR_MAX_ATTRS * sizeof(zclReport_t));
+	if (pReportCmd != NULL)
+	{
+		do
+		{
+			pAttr = pReportCmd->attrList;
+			len = 0;
+
+			if (aggrRollCall)
+			{
+				pAttr[0].attrID 	= ATTRID_ROLL_CALL;
+				pAttr[0].dataType = ZCL_DATATYPE_UINT16;
+				pAttr[0].attrData = (void *)(&aggrCoordShortAddr);
+				pAttr[1].attrID 	= ATTRID_ROLL_CALL;
+				pAttr[1].dataType = ZCL_DATATYPE_UINT8;
+				pAttr[1].attrData = (void *)(&aggrDeviceType);
+				pAttr += AGGR_ROLL_CALL_ATTRS;
+				len = AGGR_ROLL_CALL_LEN;
+				aggrRollCall = FALSE;
+			}
+
+			// At least one child per frame, whatever the MTU
+			while ((numChild > 0) && ((len == 0) || (len + AGGR_CHILD_LEN <= aggrPayloadMax)))
+			{
+				pAttr[0].attrID 	= ATTRID_REPORT_DATA_COORD;
+				pAttr[0].dataType = ZCL_DATATYPE_UINT16;
+				pAttr[0].attrData = (void *)(&pChild->sensor);
+				pAttr[1].attrID 	= ATTRID_HVAC_THERMOSTAT_RUNNING_STATE;
+				pAttr[1].dataType = ZCL_DATATYPE_UINT16;
+				pAttr[1].attrData = (void *)(&pChild->state);
+				pAttr[2].attrID 	= pChild->shortAddr;
+				pAttr[2].dataType = ZCL_DATATYPE_UINT8;
+				pAttr[2].attrData = (void *)(&pChild->endPoint);
+				pAttr += AGGR_CHILD_ATTRS;
+				len += AGGR_CHILD_LEN;
+				pChild++;
+				numChild--;
+			}
+
+			pReportCmd->numAttr = (uint8)(pAttr - pReportCmd->attrList);
+			(void)zcl_SendReportCmd(aggrSrcEP, &aggrDstAddr, aggrClusterID, pReportCmd,
+															ZCL_FRAME_SERVER_CLIENT_DIR, TRUE, (*aggrSeqNum)++);
+			frames++;
+		} while (numChild > 0);
+
+		osal_mem_free(pReportCmd);
+	}
+
+	// Dropped on allocation failure, the next window carries fresh values
+	aggrRollCall = FALSE;
+	aggrNumChild = 0;
+	aggrPayloadLen = 0;
+
+	return (frames);
+}
+
+/*******************************************************************************
+ *                                          FUNCTIONS - Local
+ *******************************************************************************/
+static AggrChild_t *AGGR_FindChild(uint16 shortAddr, uint8 endPoint)
+{
+	AggrChild_t *pChild;
+	uint8 i;
+
+	for (i = 0; i < aggrNumChild; i++)
+	{
+		pChild = &aggrChild[i];
+		if ((pChild->shortAddr == shortAddr) && (pChild->endPoint == endPoint))
+		{
+			return (pChild);
+		}
+	}
+
+	// New child: send what is held first if it would not fit
+	if ((aggrNumChild == AGGR_MAX_CHILDREN) ||
+			((aggrPayloadLen > 0) && (aggrPayloadLen + AGGR_CHILD_LEN > aggrPayloadMax)))
+	{
+		(void)AGGR_Flush();
+	}
+
+	pChild = &aggrChild[aggrNumChild++];
+	pChild->shortAddr = shortAddr;
+	pChild->endPoint = endPoint;
+	pChild->sensor = AGGR_NOT_REPORTED;
+	pChild->state = AGGR_NOT_REPORTED;
+	aggrPayloadLen += AGGR_CHILD_LEN;
+
+	return (pChild);
+}
+
+static void AGGR_Arm(void)
+{
+	if (!aggrArmed && (aggrTaskId != TASK_NO_TASK))
+	{
+		aggrArmed = (osal_start_timerEx(aggrTaskId, aggrEvent, AGGR_FLUSH_WINDOW) == SUCCESS);
+	}
+}
+
+/*******************************************************************************
+*******************************************************************************/
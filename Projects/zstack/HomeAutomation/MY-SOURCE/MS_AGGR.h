@@ -0,0 +1,71 @@
+#ifndef MS_AGGR_H
+#define MS_AGGR_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/*******************************************************************************
+ *                                            INCLUDES
+ *******************************************************************************/
+#include "ZComDef.h"
+#include "AF.h"
+
+/*******************************************************************************
+ *                                             MACROS
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                            CONSTANTS
+ *******************************************************************************/
+/*
+ * Router side report aggregation. The roll call of the router and the reports
+ * of its children are held for up to AGGR_FLUSH_WINDOW ms and sent to the
+ * coordinator as one multi-attribute report, split only where a frame would
+ * no longer fit the APS payload (afDataReqMTU). Records, in this order:
+ *
+ *	ATTRID_ROLL_CALL (uint16 coordShortAddr), ATTRID_ROLL_CALL (uint8 device type)
+ *	then per child:
+ *	ATTRID_REPORT_DATA_COORD (uint16: temperature LSB, humidity MSB)
+ *	ATTRID_HVAC_THERMOSTAT_RUNNING_STATE (uint16: heating LSB, cooling MSB)
+ *	<child shortAddr> (uint8 endPoint)
+ *
+ * A child report seen again in the same window overwrites the held value.
+ */
+#if !defined AGGR_MAX_CHILDREN
+#define				AGGR_MAX_CHILDREN				8
+#endif
+
+#if !defined AGGR_FLUSH_WINDOW
+#define				AGGR_FLUSH_WINDOW				1000		// ms
+#endif
+
+#define				AGGR_NOT_REPORTED				0xFFFF	// half of a child record not heard this window
+
+/*******************************************************************************
+ *                                             TYPEDEFS
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                         GLOBAL VARIABLES
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                          FUNCTIONS - API
+ *******************************************************************************/
+extern void AGGR_Init(uint8 srcEP, uint16 clusterID, afAddrType_t *dstAddr, uint8 *pSeqNum,
+											uint8 task_id, uint16 event);
+extern void AGGR_AddRollCall(uint16 coordShortAddr, uint8 deviceType);
+extern void AGGR_AddSensor(uint16 shortAddr, uint8 endPoint, uint16 sensor);
+extern void AGGR_AddState(uint16 shortAddr, uint8 endPoint, uint16 state);
+extern uint8 AGGR_Flush(void);
+
+/*******************************************************************************
+*******************************************************************************/
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
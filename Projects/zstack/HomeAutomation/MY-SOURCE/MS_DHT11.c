@@ -3,14 +3,30 @@
  ***************************************************************************************************/
 #include "MS_DHT11.h"
 #include "hal_timer.h"
+#include "hal_key.h"
+#include "OSAL_PwrMgr.h"
 /***************************************************************************************************
  *                                             MACROS
  ***************************************************************************************************/
 
+/* Timer 1 free-running at 32MHz/32, one tick per microsecond. Reading T1CNTL latches T1CNTH. */
+#define DHT11_TIMER_START()		st( T1CNTL = 0; T1CTL = 0x09; )
+#define DHT11_TIMER_STOP()		st( T1CTL = 0; )
+
 /***************************************************************************************************
  *                                            CONSTANTS
  ***************************************************************************************************/
- 
+
+#define DHT11_STATE_IDLE			0
+#define DHT11_STATE_WAKE			1				/* start pulse is being held low */
+#define DHT11_STATE_CAPTURE		2				/* line released, timestamping falling edges */
+
+/* PICTL.P0ICON: interrupt on falling edge for all of Port 0 */
+#define DHT11_P0ICON_BIT			BV(0)
+
+/* IEN1.P0IE: Port 0 CPU interrupt enable */
+#define DHT11_P0IE_BIT				BV(5)
+
 /***************************************************************************************************
  *                                             TYPEDEFS
  ***************************************************************************************************/
@@ -22,10 +38,16 @@ uint8 OneWireDataBuffer[5] = {0,0,0,0,0};
 uint8 humidityValue =0;
 uint8 tempValue = 1;
 
-uint8 bitmask = 7;
-uint8 byteIndex = 0;
-uint8 loopCount = 0;
-uint8 _index = 0;
+static uint8 dht11TaskId;
+static uint16 dht11Event;
+static volatile uint8 dht11State = DHT11_STATE_IDLE;
+static uint8 dht11Valid;							/* last finished reading passed its checksum */
+static uint8 dht11SavedPictl;
+static uint8 dht11SavedP0ien;
+
+/* Timer 1 timestamps of the falling edges, written by the Port 0 ISR */
+static uint16 dht11Edges[DHT11_EDGE_CNT];
+static volatile uint8 dht11EdgeCnt;
 
 /***************************************************************************************************
  *                                          FUNCTIONS - External
@@ -37,6 +59,8 @@ uint8 _index = 0;
 
 void DHT11_SetDataPinInput(void);
 void DHT11_SetDataPinOutput(void);
+static void DHT11_EdgeIsr(uint8 pxifg);
+static uint8 DHT11_Decode(uint8 edges);
 
 void DHT11_SetDataPinInput(void)
 {
@@ -49,11 +73,107 @@ void DHT11_SetDataPinOutput(void)
 	P0DIR |= DHT11_Data_BIT;
 }
 
+/***************************************************************************************************
+ * @fn      DHT11_EdgeIsr
+ *
+ * @brief   Port 0 callback, runs in interrupt context. Stores the Timer 1 count of each
+ *          falling edge and wakes the owning task once the whole frame is in.
+ *
+ * @param   pxifg - pending P0IFG bits owned by this driver
+ *
+ * @return  None
+ ***************************************************************************************************/
+static void DHT11_EdgeIsr(uint8 pxifg)
+{
+	uint8 lo;
+
+	(void)pxifg;
+
+	if ((dht11State != DHT11_STATE_CAPTURE) || (dht11EdgeCnt >= DHT11_EDGE_CNT))
+	{
+		return;
+	}
+
+	lo = T1CNTL;
+	dht11Edges[dht11EdgeCnt] = BUILD_UINT16(lo, T1CNTH);
+
+	if (++dht11EdgeCnt == DHT11_EDGE_CNT)
+	{
+		osal_set_event(dht11TaskId, dht11Event);
+	}
+}
+
+/***************************************************************************************************
+ * @fn      DHT11_Decode
+ *
+ * @brief   Turn the captured edge timestamps into the 5 frame bytes. Each bit is a 50us low
+ *          followed by a 26-28us (0) or 70us (1) high, so the time between two falling edges
+ *          gives the bit without sampling the level.
+ *
+ * @param   edges - number of falling edges captured
+ *
+ * @return  DHTLIB_OK or a DHTLIB_ERROR_ code
+ ***************************************************************************************************/
+static uint8 DHT11_Decode(uint8 edges)
+{
+	uint8 i;
+
+	if (edges == 0)
+	{
+		return DHTLIB_ERROR_CONNECT;
+	}
+	if (edges == 1)
+	{
+		return DHTLIB_ERROR_ACK_L;
+	}
+	/* 80us low plus 80us high before the first bit */
+	if ((uint16)(dht11Edges[1] - dht11Edges[0]) <= DHT11_BIT_THRESHOLD)
+	{
+		return DHTLIB_ERROR_ACK_H;
+	}
+	if (edges < DHT11_EDGE_CNT)
+	{
+		return DHTLIB_ERROR_TIMEOUT;
+	}
+
+	for (i = 0; i < 40; i++)
+	{
+		OneWireDataBuffer[i >> 3] <<= 1;
+		if ((uint16)(dht11Edges[i + 2] - dht11Edges[i + 1]) > DHT11_BIT_THRESHOLD)
+		{
+			OneWireDataBuffer[i >> 3] |= 1;
+		}
+	}
+
+	if (OneWireDataBuffer[4] != (uint8)(OneWireDataBuffer[0] + OneWireDataBuffer[1] +
+	                                    OneWireDataBuffer[2] + OneWireDataBuffer[3]))
+	{
+		return DHTLIB_ERROR_CHECKSUM;
+	}
+	return DHTLIB_OK;
+}
+
 /***************************************************************************************************
  *                                          FUNCTIONS - API
  ***************************************************************************************************/
-void DHT11_Init(void)
+
+/***************************************************************************************************
+ * @fn      DHT11_Init
+ *
+ * @brief   Set up the data pin and hook the Port 0 interrupt. Readings are driven by the
+ *          given task event and delivered to that task as a DHT11_READING message.
+ *
+ * @param   taskId - task that owns the sensor
+ * @param   event  - event reserved for the driver, pass it to DHT11_ProcessEvent
+ *
+ * @return  None
+ ***************************************************************************************************/
+void DHT11_Init(uint8 taskId, uint16 event)
 {
+	dht11TaskId = taskId;
+	dht11Event = event;
+	dht11State = DHT11_STATE_IDLE;
+
 	/* Select general purpose on I/O pins. */
 	P0SEL &= ~(DHT11_Data_BIT);
 
@@ -61,110 +181,127 @@ void DHT11_Init(void)
 	DHT11_SetDataPinOutput();
 
 	DHT11_Data = 1;
+
+	HalKeyPort0Register(DHT11_Data_BIT, DHT11_EdgeIsr);
 }
 
-uint8 DHT11_ReadSensor(void)
+/***************************************************************************************************
+ * @fn      DHT11_StartRead
+ *
+ * @brief   Start a reading without blocking. The start pulse is timed by an OSAL timer and
+ *          the frame is captured by the Port 0 interrupt.
+ *
+ * @param   None
+ *
+ * @return  DHTLIB_OK, or DHTLIB_ERROR_BUSY if a reading is already in progress
+ ***************************************************************************************************/
+uint8 DHT11_StartRead(void)
 {
-	DHT11_SetDataPinOutput();
-	DHT11_Data = 0;
-	DelayMs(DHTLIB_DHT11_WAKEUP);
-	DHT11_Data = 1;
-	//disableInterrupts();
-	DelayUs(10);
-	DHT11_SetDataPinInput();
-	
-	loopCount = 0;
-	while (DHT11_Data == 0)
+	if (dht11State != DHT11_STATE_IDLE)
 	{
-		loopCount ++;
-		if (loopCount > DHTLIB_TIMEOUT)
-		{
-      //enableInterrupts();
-      return DHTLIB_ERROR_ACK_L;
-		}
+		return DHTLIB_ERROR_BUSY;
 	}
-	
-	loopCount = 0;
-	while (DHT11_Data != 0)
+
+	DHT11_SetDataPinOutput();
+	DHT11_Data = 0;
+	dht11State = DHT11_STATE_WAKE;
+
+	/* One extra tick, an OSAL timer may expire up to 1ms early */
+	osal_start_timerEx(dht11TaskId, dht11Event, DHTLIB_DHT11_WAKEUP + 1);
+
+	return DHTLIB_OK;
+}
+
+/***************************************************************************************************
+ * @fn      DHT11_ProcessEvent
+ *
+ * @brief   Advance the reading. Called by the owning task for the event given to DHT11_Init:
+ *          after the start pulse it opens the capture window, and when the frame is complete
+ *          or the window times out it decodes the bits and posts a DHT11_READING message.
+ *
+ * @param   None
+ *
+ * @return  None
+ ***************************************************************************************************/
+void DHT11_ProcessEvent(void)
+{
+	halIntState_t intState;
+	dht11Reading_t *pMsg;
+	uint8 status;
+
+	if (dht11State == DHT11_STATE_WAKE)
 	{
-		loopCount ++;
-		if (loopCount > DHTLIB_TIMEOUT)
-		{
-	    //enableInterrupts();
-	    return DHTLIB_ERROR_ACK_H;
-		}	
+		/* Keep the 32MHz clock and Timer 1 running through the frame */
+		osal_pwrmgr_task_state(dht11TaskId, PWRMGR_HOLD);
+
+		HAL_ENTER_CRITICAL_SECTION(intState);
+		dht11EdgeCnt = 0;
+		dht11SavedPictl = PICTL;
+		dht11SavedP0ien = P0IEN;
+		PICTL |= DHT11_P0ICON_BIT;
+		DHT11_TIMER_START();
+		DHT11_SetDataPinInput();
+		P0IFG = ~(DHT11_Data_BIT);
+		P0IEN |= DHT11_Data_BIT;
+		IEN1 |= DHT11_P0IE_BIT;
+		dht11State = DHT11_STATE_CAPTURE;
+		HAL_EXIT_CRITICAL_SECTION(intState);
+
+		osal_start_timerEx(dht11TaskId, dht11Event, DHT11_CAPTURE_TIMEOUT);
+		return;
 	}
-	
-	while (_index < 40)
+
+	if (dht11State != DHT11_STATE_CAPTURE)
 	{
-		loopCount = 0;
-		while (DHT11_Data == 0)
-		{
-			asm("nop");asm("nop");asm("nop");asm("nop");asm("nop");
-			loopCount ++;
-			if (loopCount > DHTLIB_TIMEOUT)
-			{
-        //enableInterrupts();
-        return DHTLIB_ERROR_TIMEOUT;
-			}
-		}
-		
-		loopCount = 0;
-		while (DHT11_Data != 0)
-		{
-			asm("nop");asm("nop");asm("nop");asm("nop");asm("nop");
-			loopCount ++;
-			if (loopCount > DHTLIB_TIMEOUT)
-			{
-        //enableInterrupts();
-        return DHTLIB_ERROR_TIMEOUT;
-			}
-		}
-		
-		if (loopCount > 20)
-		{
-			OneWireDataBuffer[byteIndex] |= (1 << bitmask);		
-		}
-		if (bitmask == 0)   // next byte			
-		{
-			bitmask = 7;
-			byteIndex++;
-		}
-		else
-		{
-			bitmask = bitmask - 1;
-		}
-		_index = _index + 1;
+		return;
 	}
-	
+
+	/* Finished early: drop the pending timeout */
+	osal_stop_timerEx(dht11TaskId, dht11Event);
+
+	HAL_ENTER_CRITICAL_SECTION(intState);
+	dht11State = DHT11_STATE_IDLE;
+	PICTL = (PICTL & ~DHT11_P0ICON_BIT) | (dht11SavedPictl & DHT11_P0ICON_BIT);
+	P0IEN = (P0IEN & ~DHT11_Data_BIT) | (dht11SavedP0ien & DHT11_Data_BIT);
+	HAL_EXIT_CRITICAL_SECTION(intState);
+
+	DHT11_TIMER_STOP();
+	osal_pwrmgr_task_state(dht11TaskId, PWRMGR_CONSERVE);
+
 	DHT11_SetDataPinOutput();
 	DHT11_Data = 1;
-	//enableInterrupts();
-	byteIndex = 0;
-	_index = 0;
-	
-	return DHTLIB_OK;
+
+	status = DHT11_Decode(dht11EdgeCnt);
+	dht11Valid = (status == DHTLIB_OK);
+	if (dht11Valid)
+	{
+		humidityValue = OneWireDataBuffer[0] & 0x7F;
+		tempValue = OneWireDataBuffer[2] & 0x7F;
+	}
+
+	pMsg = (dht11Reading_t *)osal_msg_allocate(sizeof(dht11Reading_t));
+	if (pMsg)
+	{
+		pMsg->hdr.event = DHT11_READING;
+		pMsg->hdr.status = status;
+		pMsg->humidity = humidityValue;
+		pMsg->temperature = tempValue;
+		osal_msg_send(dht11TaskId, (uint8 *)pMsg);
+	}
 }
 
+/***************************************************************************************************
+ * @fn      DHT11_GetValue
+ *
+ * @brief   Non-blocking: reports on the last finished reading, use DHT11_StartRead to refresh.
+ *
+ * @param   None
+ *
+ * @return  1 if the last reading passed its checksum, 0 otherwise
+ ***************************************************************************************************/
 uint8 DHT11_GetValue(void)
 {
-	uint8 checksum = 0;
-	uint8 ret_val;
-	ret_val = DHT11_ReadSensor();
-	
-	if (ret_val == DHTLIB_OK)
-	{	
-		if (OneWireDataBuffer[4] == ((OneWireDataBuffer[0]+ OneWireDataBuffer[2])&0xFF))
-		{
-			humidityValue = OneWireDataBuffer[0] & 0x7F;
-			tempValue = OneWireDataBuffer[2] & 0x7F;
-      checksum = 1;
-		}
-	}
-	OneWireDataBuffer[0] = 0;
-	OneWireDataBuffer[2] = 0;
-	OneWireDataBuffer[4] = 0;
-  return checksum;
+	return dht11Valid;
 }
 
 uint8 DHT11_GetHumidityValue(void)
@@ -217,4 +354,3 @@ void DelayMs(uint16 miliSecs)
 	}
 }
 	
-
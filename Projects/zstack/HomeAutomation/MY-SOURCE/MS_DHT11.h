@@ -8,6 +8,7 @@ extern "C"
 /***************************************************************************************************
  *                                            INCLUDES
  ***************************************************************************************************/
+#include "OSAL.h"
 #include "OnBoard.h"
 #include "hal_board.h"
 #include "hal_defs.h"
@@ -31,6 +32,7 @@ extern "C"
 #define DHTLIB_ERROR_CONNECT        	3
 #define DHTLIB_ERROR_ACK_L          	4
 #define DHTLIB_ERROR_ACK_H          	5
+#define DHTLIB_ERROR_BUSY           	6
 
 #define DHTLIB_DHT11_WAKEUP         	18
 #define DHTLIB_DHT_WAKEUP           	1
@@ -39,9 +41,27 @@ extern "C"
 
 #define DHTLIB_TIMEOUT 								100
 
+/* OSAL message carrying a finished reading to the registered task */
+#define DHT11_READING               	0xE1
+
+/* Falling edges in one frame: response, 40 data bits, end of frame */
+#define DHT11_EDGE_CNT              	42
+
+/* Falling edge to falling edge of a bit (us): 0 is ~76, 1 is ~120 */
+#define DHT11_BIT_THRESHOLD         	100
+
+/* Capture window opened after the start pulse (ms), a frame is ~5ms */
+#define DHT11_CAPTURE_TIMEOUT       	10
+
 /***************************************************************************************************
  *                                             TYPEDEFS
  ***************************************************************************************************/
+typedef struct
+{
+	osal_event_hdr_t hdr;						/* hdr.status is DHTLIB_OK or a DHTLIB_ERROR_ code */
+	uint8 humidity;
+	uint8 temperature;
+} dht11Reading_t;
 
 /***************************************************************************************************
  *                                         GLOBAL VARIABLES
@@ -51,8 +71,9 @@ extern "C"
  *                                          FUNCTIONS - API
  ***************************************************************************************************/
 
-extern void  DHT11_Init(void);
-extern uint8 DHT11_ReadSensor(void);
+extern void  DHT11_Init(uint8 taskId, uint16 event);
+extern uint8 DHT11_StartRead(void);
+extern void  DHT11_ProcessEvent(void);
 extern uint8 DHT11_GetValue(void);
 extern uint8 DHT11_GetHumidityValue(void);
 extern uint8 DHT11_GetTempValue(void);
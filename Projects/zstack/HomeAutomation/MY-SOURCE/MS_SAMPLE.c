@@ -0,0 +1,215 @@
+/*******************************************************************************
+ *                                            INCLUDES
+ *******************************************************************************/
+#include "MS_SAMPLE.h"
+#include "OSAL.h"
+#include "OSAL_Tasks.h"
+
+/*******************************************************************************
+ *                                             MACROS
+ *******************************************************************************/
+#define SAMPLE_ROUND(x)			((uint8)(((x) + (1 << (SAMPLE_FRAC_BITS - 1))) >> SAMPLE_FRAC_BITS))
+
+/*******************************************************************************
+ *                                            CONSTANTS
+ *******************************************************************************/
+#define SAMPLE_TEMP							0
+#define SAMPLE_HUM							1
+#define SAMPLE_CHANNELS					2
+
+/*******************************************************************************
+ *                                             TYPEDEFS
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                         GLOBAL VARIABLES
+ *******************************************************************************/
+static uint8 sampleTaskId = TASK_NO_TASK;
+static uint16 sampleEvent;
+
+static uint8 sampleDelta[SAMPLE_CHANNELS];
+static uint32 sampleMaxInterval;
+
+static uint8 sampleRing[SAMPLE_CHANNELS][SAMPLE_RING_SIZE];
+static uint8 sampleHead;
+static uint8 sampleCnt;
+
+// Filter state and value at the last report, SAMPLE_FRAC_BITS fixed point
+static int16 sampleEma[SAMPLE_CHANNELS];
+static int16 sampleLast[SAMPLE_CHANNELS];
+static uint8 sampleReportedOnce;
+
+/*******************************************************************************
+ *                                          FUNCTIONS - External
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                          FUNCTIONS - Local
+ *******************************************************************************/
+static uint8 SAMPLE_Median(uint8 ch);
+
+/*******************************************************************************
+ *                                          FUNCTIONS - API
+ *******************************************************************************/
+void SAMPLE_Init(uint8 task_id, uint16 event)
+{
+	if (sampleTaskId != TASK_NO_TASK)
+	{
+		(void)osal_stop_timerEx(sampleTaskId, sampleEvent);
+	}
+
+	sampleTaskId = task_id;
+	sampleEvent = event;
+	sampleDelta[SAMPLE_TEMP] = SAMPLE_TEMP_DELTA;
+	sampleDelta[SAMPLE_HUM] = SAMPLE_HUM_DELTA;
+	sampleMaxInterval = SAMPLE_MAX_INTERVAL;
+
+	sampleHead = 0;
+	sampleCnt = 0;
+	sampleReportedOnce = FALSE;
+}
+
+void SAMPLE_Config(uint8 tempDelta, uint8 humDelta, uint32 maxInterval)
+{
+	sampleDelta[SAMPLE_TEMP] = tempDelta;
+	sampleDelta[SAMPLE_HUM] = humDelta;
+	sampleMaxInterval = maxInterval;
+
+	if (sampleTaskId == TASK_NO_TASK)
+	{
+		return;
+	}
+
+	if (maxInterval == 0)
+	{
+		(void)osal_stop_timerEx(sampleTaskId, sampleEvent);
+	}
+	else if (sampleReportedOnce)
+	{
+		(void)osal_start_timerEx(sampleTaskId, sampleEvent, maxInterval);
+	}
+}
+
+/*
+ * Feed one reading. Returns TRUE when it requested a report, the owning task
+ * then sends SAMPLE_GetTempCenti/SAMPLE_GetHumCenti and calls SAMPLE_Reported.
+ */
+uint8 SAMPLE_Add(uint8 temperature, uint8 humidity)
+{
+	int16 median;
+	int16 diff;
+	uint8 due = !sampleReportedOnce;
+	uint8 ch;
+
+	sampleRing[SAMPLE_TEMP][sampleHead] = temperature;
+	sampleRing[SAMPLE_HUM][sampleHead] = humidity;
+	if (++sampleHead == SAMPLE_RING_SIZE)
+	{
+		sampleHead = 0;
+	}
+
+	for (ch = 0; ch < SAMPLE_CHANNELS; ch++)
+	{
+		median = (int16)SAMPLE_Median(ch) << SAMPLE_FRAC_BITS;
+
+		if (sampleCnt == 0)
+		{
+			sampleEma[ch] = median;
+		}
+		else
+		{
+			sampleEma[ch] += (median - sampleEma[ch]) / (1 << SAMPLE_EMA_SHIFT);
+		}
+
+		// Against the filter state, not the rounded value, so noise around a
+		// rounding edge does not report
+		diff = sampleEma[ch] - sampleLast[ch];
+		if (diff < 0)
+		{
+			diff = -diff;
+		}
+		if ((sampleDelta[ch] != 0) && (diff >= ((int16)sampleDelta[ch] << SAMPLE_FRAC_BITS)))
+		{
+			due = TRUE;
+		}
+	}
+
+	if (sampleCnt < SAMPLE_RING_SIZE)
+	{
+		sampleCnt++;
+	}
+
+	if (due)
+	{
+		(void)osal_set_event(sampleTaskId, sampleEvent);
+	}
+
+	return (due);
+}
+
+/*
+ * The report went out: the next one is measured from here and is sent no later
+ * than the max interval. The same event is used for both, so a report on
+ * change restarts the interval.
+ */
+void SAMPLE_Reported(void)
+{
+	sampleLast[SAMPLE_TEMP] = sampleEma[SAMPLE_TEMP];
+	sampleLast[SAMPLE_HUM] = sampleEma[SAMPLE_HUM];
+	sampleReportedOnce = TRUE;
+
+	if (sampleMaxInterval != 0)
+	{
+		(void)osal_start_timerEx(sampleTaskId, sampleEvent, sampleMaxInterval);
+	}
+}
+
+uint8 SAMPLE_GetTemp(void)
+{
+	return (SAMPLE_ROUND(sampleEma[SAMPLE_TEMP]));
+}
+
+uint8 SAMPLE_GetHum(void)
+{
+	return (SAMPLE_ROUND(sampleEma[SAMPLE_HUM]));
+}
+
+// Filtered temperature in ZCL MeasuredValue units (0.01 C)
+int16 SAMPLE_GetTempCenti(void)
+{
+	return ((int16)(((int32)sampleEma[SAMPLE_TEMP] * 100) >> SAMPLE_FRAC_BITS));
+}
+
+// Filtered humidity in ZCL MeasuredValue units (0.01 %RH)
+uint16 SAMPLE_GetHumCenti(void)
+{
+	return ((uint16)(((int32)sampleEma[SAMPLE_HUM] * 100) >> SAMPLE_FRAC_BITS));
+}
+
+/*******************************************************************************
+ *                                          FUNCTIONS - Local
+ *******************************************************************************/
+static uint8 SAMPLE_Median(uint8 ch)
+{
+	uint8 sorted[SAMPLE_RING_SIZE];
+	uint8 num = (sampleCnt < SAMPLE_RING_SIZE) ? (sampleCnt + 1) : SAMPLE_RING_SIZE;
+	uint8 first = (uint8)((sampleHead + SAMPLE_RING_SIZE - num) % SAMPLE_RING_SIZE);
+	uint8 value;
+	uint8 i, j;
+
+	// Insertion sort, the ring is a handful of samples
+	for (i = 0; i < num; i++)
+	{
+		value = sampleRing[ch][(first + i) % SAMPLE_RING_SIZE];
+		for (j = i; (j > 0) && (sorted[j - 1] > value); j--)
+		{
+			sorted[j] = sorted[j - 1];
+		}
+		sorted[j] = value;
+	}
+
+	return (sorted[num / 2]);
+}
+
+/*******************************************************************************
+*******************************************************************************/
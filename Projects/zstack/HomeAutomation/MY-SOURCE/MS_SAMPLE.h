@@ -0,0 +1,82 @@
+#ifndef MS_SAMPLE_H
+#define MS_SAMPLE_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+/*******************************************************************************
+ *                                            INCLUDES
+ *******************************************************************************/
+#include "ZComDef.h"
+
+/*******************************************************************************
+ *                                             MACROS
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                            CONSTANTS
+ *******************************************************************************/
+/*
+ * Sensor sampling pipeline. Readings are taken on their own schedule
+ * (SAMPLE_PERIOD) and pushed into a ring of the last SAMPLE_RING_SIZE samples.
+ * The median of the ring drops single-sample glitches, an EMA with weight
+ * 1/2^SAMPLE_EMA_SHIFT smooths the median. A report is requested when the
+ * filtered temperature or humidity moved by the configured delta since the
+ * last report, or when the max interval expires without one.
+ */
+#if !defined SAMPLE_RING_SIZE
+#define				SAMPLE_RING_SIZE				5				// odd, the median is the middle sample
+#endif
+
+#if !defined SAMPLE_EMA_SHIFT
+#define				SAMPLE_EMA_SHIFT				2
+#endif
+
+#if !defined SAMPLE_PERIOD
+#define				SAMPLE_PERIOD						2000		// ms, the DHT11 needs 1 s between reads
+#endif
+
+#if !defined SAMPLE_TEMP_DELTA
+#define				SAMPLE_TEMP_DELTA				1				// C
+#endif
+
+#if !defined SAMPLE_HUM_DELTA
+#define				SAMPLE_HUM_DELTA				2				// %RH
+#endif
+
+#if !defined SAMPLE_MAX_INTERVAL
+#define				SAMPLE_MAX_INTERVAL			60000		// ms, 0 reports on change only
+#endif
+
+#define				SAMPLE_FRAC_BITS				4				// fraction bits of the filter state
+
+/*******************************************************************************
+ *                                             TYPEDEFS
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                         GLOBAL VARIABLES
+ *******************************************************************************/
+
+/*******************************************************************************
+ *                                          FUNCTIONS - API
+ *******************************************************************************/
+extern void SAMPLE_Init(uint8 task_id, uint16 event);
+extern void SAMPLE_Config(uint8 tempDelta, uint8 humDelta, uint32 maxInterval);
+extern uint8 SAMPLE_Add(uint8 temperature, uint8 humidity);
+extern void SAMPLE_Reported(void);
+extern uint8 SAMPLE_GetTemp(void);
+extern uint8 SAMPLE_GetHum(void);
+extern int16 SAMPLE_GetTempCenti(void);
+extern uint16 SAMPLE_GetHumCenti(void);
+
+/*******************************************************************************
+*******************************************************************************/
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -2,6 +2,8 @@
  *                                            INCLUDES
  *******************************************************************************/
 #include "MS_UART.h"
+#include "MS_UART_CMD.h"
+#include "OSAL_Tasks.h"
 
 /*******************************************************************************
  *                                             MACROS
@@ -20,6 +22,15 @@
 #define UART1_MAX_RX_BUF_SIZE_128           128
 #define UART1_MAX_RX_BUF_SIZE_256           256
 
+// Rx frame detector states
+#define UART_RX_STATE_IDLE									0
+#define UART_RX_STATE_ASCII									1
+#define UART_RX_STATE_BIN_LEN								2
+#define UART_RX_STATE_BIN_BODY							3
+
+// Room left for the "\r\n" added by UART_ZCmdPrintLine
+#define UART_LINE_MAX												(UART_LINE_BUF_SIZE - 2)
+
 /*******************************************************************************
  *                                             TYPEDEFS
  *******************************************************************************/
@@ -29,6 +40,14 @@
  *******************************************************************************/
 static UartRxData_t Rx0_Data;
 
+// "00".."99", two digits per division
+static CONST char uartDigitPairs[200] =
+	"0001020304050607080910111213141516171819"
+	"2021222324252627282930313233343536373839"
+	"4041424344454647484950515253545556575859"
+	"6061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
 /*******************************************************************************
  *                                          FUNCTIONS - External
  *******************************************************************************/
@@ -39,9 +58,10 @@ static UartRxData_t Rx0_Data;
 static void UART0_RxProcessCB(uint8 port, uint8 event);
 static void UART1_RxProcessCB(uint8 port, uint8 event);
 
-static void UART0_WriteDataToRxBuffer(uint8* buffer, uint8 length);
-
-static long uart_pow_of(uint8 A, uint8 n);
+static void UART0_ReadRx(void);
+static void UART0_DetectFrames(uint16 length);
+static void UART0_FrameDone(void);
+static void UART0_DropFrame(void);
 
 /*******************************************************************************
  *                                          FUNCTIONS - API
@@ -61,6 +81,10 @@ void UART_Init(uint8 port)
 		uartConfig.idleTimeout = 1; 	
 		uartConfig.intEnable = TRUE;	
 		uartConfig.callBackFunc = UART0_RxProcessCB;
+
+		osal_memset(&Rx0_Data, 0, sizeof(Rx0_Data));
+		Rx0_Data.State = UART_RX_STATE_IDLE;
+		Rx0_Data.TaskId = TASK_NO_TASK;
 	}
 	else if (port == HAL_UART_PORT_1)
 	{
@@ -84,52 +108,106 @@ void UART_SendString(uint8 port, uint8 *buf)
 
 void UART_SendNum(uint8 port, long num)
 {
-	uint8 i;
-	uint8 num_flag = 0;
-	uint8 tmp_chr[1];
-	
-	if (num == 0)
+	uint8 tmp_chr[UART_NUM_STR_SIZE];
+
+	HalUARTWrite(port, tmp_chr, UART_FormatNum(tmp_chr, num));
+}
+
+uint8 UART_FormatNum(uint8 *buf, long num)
+{
+	uint8 tmp_chr[UART_NUM_STR_SIZE];
+	uint8 idx = UART_NUM_STR_SIZE;
+	uint8 length = 0;
+	uint32 value = (uint32)num;
+	uint16 value16;
+	uint8 pair;
+
+	if (num < 0)
 	{
-		HalUARTWrite(port, "0", 1);
-		return;
+		buf[length++] = '-';
+		value = 0 - value;
 	}
-	if (num < 0)
+
+	// 32-bit divisions only while they are needed
+	while (value > 0xFFFF)
 	{
-		HalUARTWrite(port, "-", 1);
-		num *= -1;
+		pair = (uint8)(value % 100) * 2;
+		value /= 100;
+		tmp_chr[--idx] = uartDigitPairs[pair + 1];
+		tmp_chr[--idx] = uartDigitPairs[pair];
 	}
 
-	for ( i = 9; i > 0; i--)
+	value16 = (uint16)value;
+	while (value16 >= 100)
 	{
-		if ((num / uart_pow_of(10, i-1)) != 0)
-		{
-			num_flag = 1;
-			tmp_chr[0] = num/uart_pow_of(10, i-1) + '0';
-			HalUARTWrite(port, tmp_chr, 1);
-		}
-		else
-		{
-			if (num_flag != 0)
-			{
-				HalUARTWrite(port, "0", 1);
-			}
-		}
-		
-		num %= uart_pow_of(10, i-1);
+		pair = (uint8)(value16 % 100) * 2;
+		value16 /= 100;
+		tmp_chr[--idx] = uartDigitPairs[pair + 1];
+		tmp_chr[--idx] = uartDigitPairs[pair];
+	}
+
+	if (value16 >= 10)
+	{
+		pair = (uint8)value16 * 2;
+		tmp_chr[--idx] = uartDigitPairs[pair + 1];
+		tmp_chr[--idx] = uartDigitPairs[pair];
+	}
+	else
+	{
+		tmp_chr[--idx] = '0' + (uint8)value16;
+	}
+
+	while (idx < UART_NUM_STR_SIZE)
+	{
+		buf[length++] = tmp_chr[idx++];
 	}
+	return length;
 }
 
-long uart_pow_of(uint8 A, uint8 n)
+void UART_LineStart(UartLine_t *pLine, uint8 *str)
 {
-	uint8 i;
-	uint32 temp = 1;
-	
-	for (i = 0; i < n; i++)
+	pLine->length = 0;
+	UART_LineAddString(pLine, str);
+}
+
+void UART_LineAddString(UartLine_t *pLine, uint8 *str)
+{
+	while (*str != '\0' && pLine->length < UART_LINE_MAX)
+	{
+		pLine->buf[pLine->length++] = *str++;
+	}
+}
+
+void UART_LineAddChar(UartLine_t *pLine, uint8 chr)
+{
+	if (pLine->length < UART_LINE_MAX)
 	{
-		temp *= A;
+		pLine->buf[pLine->length++] = chr;
 	}
-		
-	return temp;
+}
+
+void UART_LineAddNum(UartLine_t *pLine, long num)
+{
+	uint8 tmp_chr[UART_NUM_STR_SIZE];
+
+	if (pLine->length <= UART_LINE_MAX - UART_NUM_STR_SIZE)
+	{
+		pLine->length += UART_FormatNum(pLine->buf + pLine->length, num);
+	}
+	else
+	{
+		UART_LineAddBuffer(pLine, tmp_chr, UART_FormatNum(tmp_chr, num));
+	}
+}
+
+void UART_LineAddBuffer(UartLine_t *pLine, uint8 *buf, uint8 length)
+{
+	if (length > UART_LINE_MAX - pLine->length)
+	{
+		length = UART_LINE_MAX - pLine->length;
+	}
+	osal_memcpy(pLine->buf + pLine->length, buf, length);
+	pLine->length += length;
 }
 
 void UART_DebugPrint(uint8 port, uint8* buf)
@@ -176,6 +254,15 @@ void UART_ZCmdPrintString(uint8 port, uint8 *buf)
 	#endif
 }
 
+void UART_ZCmdPrintLine(uint8 port, UartLine_t *pLine)
+{
+	#if (defined UART_ZCMD) && (UART_ZCMD == TRUE)
+	pLine->buf[pLine->length++] = '\r';
+	pLine->buf[pLine->length++] = '\n';
+	HalUARTWrite(port, pLine->buf, pLine->length);
+	#endif
+}
+
 void UART_DebugPrintLCD(uint8 port, uint8 Row, uint8 Col, uint8 *buf)
 {
 	#if (defined UART_DEBUG_LCD) && (UART_DEBUG_LCD == TRUE)
@@ -235,19 +322,12 @@ void UART_DebugPrintLCDNum(uint8 port, uint8 Row, uint8 Col, long Num)
 	#endif
 }
 
-void UART0_WriteDataToRxBuffer(uint8 *buffer, uint8 length)
+void UART_RegisterForFrames(uint8 port, uint8 task_id, uint16 event)
 {
-	uint8 tmp_Length = 0;
-
-	while (tmp_Length < length)
+	if ( port == HAL_UART_PORT_0 )
 	{
-		Rx0_Data.CircularBuffer[Rx0_Data.idxWrite] = *(buffer + tmp_Length);
-		Rx0_Data.idxWrite = (Rx0_Data.idxWrite + 1) % RX_BUFFER_SIZE;
-		if (++Rx0_Data.DataAvailable == RX_BUFFER_SIZE)
-		{
-			Rx0_Data.DataAvailable = 0;
-		}
-		tmp_Length++;
+		Rx0_Data.TaskId = task_id;
+		Rx0_Data.Event = event;
 	}
 }
 
@@ -268,16 +348,11 @@ uint8* UART_GetData(uint8 port, uint8* buffer, uint8 length)
 {
 	uint8 tmp_Length = 0;
 	
-	while (tmp_Length < length)
+	while (tmp_Length < length && Rx0_Data.DataAvailable > Rx0_Data.FrameLength)
 	{
 		*(buffer + tmp_Length) = Rx0_Data.CircularBuffer[Rx0_Data.idxRead];
 		Rx0_Data.DataAvailable--;
 		Rx0_Data.idxRead = (Rx0_Data.idxRead + 1) % RX_BUFFER_SIZE;
-		if (Rx0_Data.idxRead == Rx0_Data.idxWrite)
-		{
-			Rx0_Data.DataAvailable = 0;
-			break;
-		}
 		tmp_Length++;
 	}
 	return buffer;
@@ -285,23 +360,155 @@ uint8* UART_GetData(uint8 port, uint8* buffer, uint8 length)
 
 static void UART0_RxProcessCB(uint8 port, uint8 event)
 {
-	uint16 Rx0_tmpBufLen;
-	uint8 Rx0_tmpBuffer[UART0_MAX_RX_BUF_SIZE_128];
-	
 	switch (event)
 	{
 		case HAL_UART_RX_FULL:
-			break;
 		case HAL_UART_RX_ABOUT_FULL:
-			break;
 		case HAL_UART_RX_TIMEOUT:
-			Rx0_tmpBufLen = Hal_UART_RxBufLen(port);
-			HalUARTRead(HAL_UART_PORT_0, Rx0_tmpBuffer, Rx0_tmpBufLen);
-			UART0_WriteDataToRxBuffer(Rx0_tmpBuffer, Rx0_tmpBufLen);			
+			UART0_ReadRx();
 			break;			
 	}
 }
 
+static void UART0_ReadRx(void)
+{
+	uint16 space;
+	uint16 length;
+	uint8 frameCount = Rx0_Data.FrameCount;
+
+	for (;;)
+	{
+		space = RX_BUFFER_SIZE - Rx0_Data.DataAvailable;
+		if ( space == 0 )
+		{
+			if ( Rx0_Data.FrameCount != 0 )
+			{
+				// The rest waits in the driver until the application read a frame
+				break;
+			}
+			// A package that cannot fit the buffer
+			UART0_DropFrame();
+			continue;
+		}
+
+		// Straight into the circular buffer, up to its end
+		if ( space > RX_BUFFER_SIZE - Rx0_Data.idxWrite )
+		{
+			space = RX_BUFFER_SIZE - Rx0_Data.idxWrite;
+		}
+		length = HalUARTRead(HAL_UART_PORT_0, Rx0_Data.CircularBuffer + Rx0_Data.idxWrite, space);
+		if ( length == 0 )
+		{
+			break;
+		}
+		UART0_DetectFrames(length);
+	}
+
+	if ( frameCount == 0 && Rx0_Data.FrameCount != 0 && Rx0_Data.TaskId != TASK_NO_TASK )
+	{
+		osal_set_event(Rx0_Data.TaskId, Rx0_Data.Event);
+	}
+}
+
+/*
+ * Runs over the bytes just read in at idxWrite. Package bytes are kept (and
+ * moved down over dropped bytes), everything outside a package is dropped.
+ * A package starts with '@' (ASCII, up to '!') or ZCMD_SOF (binary,
+ * SOF | LEN | OP | DATA[LEN] | FCS).
+ */
+static void UART0_DetectFrames(uint16 length)
+{
+	uint8 *pNew = Rx0_Data.CircularBuffer + Rx0_Data.idxWrite;
+	uint8 chr;
+
+	while (length--)
+	{
+		chr = *pNew++;
+
+		// '@' always starts over, an unterminated ASCII package is dropped
+		if ( chr == '@' && Rx0_Data.State == UART_RX_STATE_ASCII )
+		{
+			UART0_DropFrame();
+		}
+
+		if ( Rx0_Data.State == UART_RX_STATE_IDLE )
+		{
+			if ( chr == '@' )
+			{
+				Rx0_Data.State = UART_RX_STATE_ASCII;
+			}
+			else if ( chr == ZCMD_SOF )
+			{
+				Rx0_Data.State = UART_RX_STATE_BIN_LEN;
+			}
+			else
+			{
+				continue;
+			}
+		}
+
+		Rx0_Data.CircularBuffer[Rx0_Data.idxWrite] = chr;
+		Rx0_Data.idxWrite = (Rx0_Data.idxWrite + 1) % RX_BUFFER_SIZE;
+		Rx0_Data.DataAvailable++;
+		Rx0_Data.FrameLength++;
+
+		switch (Rx0_Data.State)
+		{
+			case UART_RX_STATE_ASCII:
+				if ( chr == '!' )
+				{
+					UART0_FrameDone();
+				}
+				break;
+
+			case UART_RX_STATE_BIN_LEN:
+				if ( Rx0_Data.FrameLength == 2 )
+				{
+					if ( chr > ZCMD_DATA_MAX )
+					{
+						UART0_DropFrame();
+					}
+					else
+					{
+						Rx0_Data.FrameNeed = chr + ZCMD_FRAME_OVERHEAD;
+						Rx0_Data.State = UART_RX_STATE_BIN_BODY;
+					}
+				}
+				break;
+
+			case UART_RX_STATE_BIN_BODY:
+				if ( Rx0_Data.FrameLength == Rx0_Data.FrameNeed )
+				{
+					UART0_FrameDone();
+				}
+				break;
+		}
+	}
+}
+
+static void UART0_FrameDone(void)
+{
+	if ( Rx0_Data.FrameCount == UART_RX_FRAME_QUEUE )
+	{
+		UART0_DropFrame();
+		return;
+	}
+
+	Rx0_Data.FrameQueue[(Rx0_Data.FrameHead + Rx0_Data.FrameCount) % UART_RX_FRAME_QUEUE] =
+		Rx0_Data.FrameLength;
+	Rx0_Data.FrameCount++;
+	Rx0_Data.FrameLength = 0;
+	Rx0_Data.State = UART_RX_STATE_IDLE;
+}
+
+static void UART0_DropFrame(void)
+{
+	Rx0_Data.idxWrite = (Rx0_Data.idxWrite + RX_BUFFER_SIZE - Rx0_Data.FrameLength) % RX_BUFFER_SIZE;
+	Rx0_Data.DataAvailable -= Rx0_Data.FrameLength;
+	Rx0_Data.FrameLength = 0;
+	Rx0_Data.State = UART_RX_STATE_IDLE;
+}
+
 static void UART1_RxProcessCB(uint8 port, uint8 event)
 {
 	switch (event)
@@ -319,35 +526,11 @@ uint8 UART_ParseRxPackage(uint8 port)
 {
 	if (port == HAL_UART_PORT_0)
 	{
-		uint8 i = 0;
-		uint8 j = 0;
-		uint16 dataAvailable = UART_DataAvailable(HAL_UART_PORT_0);
-		
-		if (dataAvailable)
+		// Packages are delimited as they arrive, see UART0_DetectFrames
+		if ( Rx0_Data.FrameCount != 0 )
 		{
-			for (i = 0; i < dataAvailable; i++)
-			{
-				if ( Rx0_Data.CircularBuffer[(Rx0_Data.idxRead + i) % RX_BUFFER_SIZE] == '@' )
-				{
-					for (j = i + 1; j < dataAvailable; j++)
-					{
-						if ( Rx0_Data.CircularBuffer[(Rx0_Data.idxRead + j) % RX_BUFFER_SIZE] == '!' )
-						{
-							Rx0_Data.ParseLength = j + 1;
-							return 1;
-						}
-					}
-				}
-				else
-				{
-					Rx0_Data.idxRead = (Rx0_Data.idxRead + 1) % RX_BUFFER_SIZE;
-					Rx0_Data.DataAvailable--;
-					if ( Rx0_Data.idxRead == Rx0_Data.idxWrite )
-					{
-						Rx0_Data.DataAvailable = 0;
-					}
-				}
-			}
+			Rx0_Data.ParseLength = Rx0_Data.FrameQueue[Rx0_Data.FrameHead];
+			return 1;
 		}
 		Rx0_Data.ParseLength = 0;
 	}
@@ -366,6 +549,11 @@ uint8 UART_ParseLength(uint8 port)
 	{
 		tmp_ParseLength = Rx0_Data.ParseLength;
 		Rx0_Data.ParseLength = 0;
+		if ( tmp_ParseLength != 0 )
+		{
+			Rx0_Data.FrameHead = (Rx0_Data.FrameHead + 1) % UART_RX_FRAME_QUEUE;
+			Rx0_Data.FrameCount--;
+		}
 		return tmp_ParseLength;
 	}
 	else if ( port == HAL_UART_PORT_1 )
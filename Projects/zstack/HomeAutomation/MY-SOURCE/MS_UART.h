@@ -25,7 +25,9 @@ extern "C"
  *                                            CONSTANTS
  *******************************************************************************/
 #define RX_BUFFER_SIZE											128
-#define UART_PARSE_RX_PACKAGE_EVT_PERIOD		10
+#define UART_RX_FRAME_QUEUE									4				// complete packages waiting
+#define UART_LINE_BUF_SIZE									64			// incl. "\r\n"
+#define UART_NUM_STR_SIZE										11			// "-2147483648"
 /*******************************************************************************
  *                                             TYPEDEFS
  *******************************************************************************/
@@ -36,9 +38,24 @@ typedef struct
 	uint16			idxWrite;
 	uint16			DataAvailable;
 	uint8				ParseLength;
+	uint8				State;				// Frame detector
+	uint8				FrameLength;	// Bytes of the package being received
+	uint8				FrameNeed;		// Binary package: total length
+	uint8				FrameHead;
+	uint8				FrameCount;
+	uint8				FrameQueue[UART_RX_FRAME_QUEUE];
+	uint8				TaskId;				// Told when a package is complete
+	uint16			Event;
 	uint8 			CircularBuffer[RX_BUFFER_SIZE];
 } UartRxData_t;
 
+// Report line, formatted in RAM and written with a single HalUARTWrite
+typedef struct
+{
+	uint8				length;
+	uint8				buf[UART_LINE_BUF_SIZE];
+} UartLine_t;
+
 /*******************************************************************************
  *                                         GLOBAL VARIABLES
  *******************************************************************************/
@@ -47,6 +64,7 @@ typedef struct
  *                                          FUNCTIONS - API
  *******************************************************************************/
 extern void UART_Init(uint8 port);
+extern void UART_RegisterForFrames(uint8 port, uint8 task_id, uint16 event);
 extern void UART_SendString(uint8 port, uint8 *buf);
 extern void UART_SendNum(uint8 port, long num);
 extern void UART_DebugPrint(uint8 port, uint8 *buf);
@@ -58,6 +76,14 @@ extern void UART_ZCmdPrint(uint8 port, uint8 *buf);
 extern void UART_ZCmdPrintNum(uint8 port, long num);
 extern void UART_ZCmdPrintBuffer(uint8 port, uint8 *buf, uint8 length);
 extern void UART_ZCmdPrintString(uint8 port, uint8 *buf);
+extern void UART_ZCmdPrintLine(uint8 port, UartLine_t *pLine);
+
+extern uint8 UART_FormatNum(uint8 *buf, long num);
+extern void UART_LineStart(UartLine_t *pLine, uint8 *str);
+extern void UART_LineAddString(UartLine_t *pLine, uint8 *str);
+extern void UART_LineAddChar(UartLine_t *pLine, uint8 chr);
+extern void UART_LineAddNum(UartLine_t *pLine, long num);
+extern void UART_LineAddBuffer(UartLine_t *pLine, uint8 *buf, uint8 length);
 
 extern uint8* UART_GetData(uint8 port, uint8* buffer, uint8 length);
 extern uint8 UART_DataAvailable(uint8 port);
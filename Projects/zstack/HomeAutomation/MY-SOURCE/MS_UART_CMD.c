@@ -3,7 +3,6 @@
  *******************************************************************************/
 #include "MS_UART_CMD.h"
 #include "MS_UART.h"
-#include "string.h"
 
 #include "zcl.h"
 #include "zcl_general.h"
@@ -40,16 +39,62 @@
 #define CMD_DISABLE_ECHO_RDATA								8
 #define CMD_SEND_FREE_DATA										10
 #define CMD_SEND_C                                12
+#define CMD_SET_MODE_ASCII												13
+#define CMD_SET_MODE_BINARY												14
+
+// zcmdEntry_t.arg: no argument byte / free-form data after the keyword
+#define ZCMD_ARG_NONE															0xFE
+#define ZCMD_ARG_DATA															0xFF
+
+// Reply in ASCII (the command came in as "@ZB...!")
+#define ZCMD_OP_NONE															0x00
+
+#define ZCMD_KW(str)															(str), (sizeof(str) - 1)
 
 /*******************************************************************************
  *                                             TYPEDEFS
  *******************************************************************************/
+// One command, in both encodings
+typedef struct
+{
+	char		*keyword;			// ASCII form, ends with '!' unless data follows
+	uint8		kwLength;
+	uint8		opcode;				// Binary form
+	uint8		arg;					// Binary argument byte, ZCMD_ARG_NONE or ZCMD_ARG_DATA
+	uint8		cmd;
+} zcmdEntry_t;
 
 /*******************************************************************************
  *                                         GLOBAL VARIABLES
  *******************************************************************************/
 static uint16 packageLength = 0;
-char* pcmdData;
+static uint8 zcmdRspOp = ZCMD_OP_NONE;
+
+static CONST zcmdEntry_t zcmdTable[] =
+{
+	{ ZCMD_KW("@ZB!"),									ZCMD_OP_ALIVE,					ZCMD_ARG_NONE,		CMD_CHECK_ALIVE },
+	{ ZCMD_KW("@ZB+BIND=0!"),						ZCMD_OP_BIND,						0,								CMD_BINDING_STOP },
+	{ ZCMD_KW("@ZB+BIND=1!"),						ZCMD_OP_BIND,						1,								CMD_BINDING_START },
+	{ ZCMD_KW("@ZB+SHORTADDR!"),				ZCMD_OP_SHORTADDR,			ZCMD_ARG_NONE,		CMD_RETURN_SHORT_ADDRESS },
+	{ ZCMD_KW("@ZB+COORDSHORTADDR!"),		ZCMD_OP_COORDSHORTADDR,	ZCMD_ARG_NONE,		CMD_RETURN_COORD_SHORT_ADDRESS },
+	{ ZCMD_KW("@ZB+ECHOSDATA=0!"),			ZCMD_OP_ECHOSDATA,			0,								CMD_DISABLE_ECHO_SDATA },
+	{ ZCMD_KW("@ZB+ECHOSDATA=1!"),			ZCMD_OP_ECHOSDATA,			1,								CMD_ENABLE_ECHO_SDATA },
+	{ ZCMD_KW("@ZB+ECHORDATA=0!"),			ZCMD_OP_ECHORDATA,			0,								CMD_DISABLE_ECHO_RDATA },
+	{ ZCMD_KW("@ZB+ECHORDATA=1!"),			ZCMD_OP_ECHORDATA,			1,								CMD_ENABLE_ECHO_RDATA },
+	{ ZCMD_KW("@ZB+DATA="),							ZCMD_OP_FREE_DATA,			ZCMD_ARG_DATA,		CMD_SEND_FREE_DATA },		// Only for ZB Coordinator
+	{ ZCMD_KW("@ZBC="),									ZCMD_OP_SEND_C,					ZCMD_ARG_DATA,		CMD_SEND_C },						// control led - only for ZBC
+	{ ZCMD_KW("@ZB+BIN=0!"),						ZCMD_OP_MODE,						ZCMD_MODE_ASCII,	CMD_SET_MODE_ASCII },
+	{ ZCMD_KW("@ZB+BIN=1!"),						ZCMD_OP_MODE,						ZCMD_MODE_BINARY,	CMD_SET_MODE_BINARY },
+};
+
+#define ZCMD_TABLE_SIZE						(sizeof(zcmdTable) / sizeof(zcmdTable[0]))
+
+// CRC-16/CCITT, one nibble at a time
+static CONST uint16 zcmdCrcTable[16] =
+{
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+	0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
 
 bool FLAG_ECHO_SDATA 	= FALSE;
 bool FLAG_ECHO_RDATA 	= FALSE;
@@ -57,6 +102,8 @@ bool FLAG_ECHO_RDATA 	= FALSE;
 char		Free_Data[FREE_DATA_BFR_SIZE + 1];
 uint8 	Free_Data_Size;
 
+uint8		ZCMD_Mode = ZCMD_MODE_ASCII;
+
 /*******************************************************************************
  *                                          FUNCTIONS - External
  *******************************************************************************/
@@ -64,110 +111,136 @@ uint8 	Free_Data_Size;
 /*******************************************************************************
  *                                          FUNCTIONS - Local
  *******************************************************************************/
-static char* ZCMD_MatchCMD(char* buf, char* str);
+static CONST zcmdEntry_t* ZCMD_MatchCMD(char* buf, uint8 length);
 static uint8 ZCMD_FindChrStr(char* buf, uint8 chr);
-static void ZCMD_ProcessCMD(uint8 CMD);
+static void ZCMD_ProcessFrame(uint8* frame, uint8 length);
+static void ZCMD_ProcessCMD(uint8 CMD, char* pData, uint8 dataLength);
+static void ZCMD_Reply(uint8 status, char* str);
+static void ZCMD_ReplyAddr(uint16 addr);
+static uint8 ZCMD_CopyFreeData(char* pData, uint8 dataLength);
 /*******************************************************************************
  *                                          FUNCTIONS - API
  *******************************************************************************/
 void ZCMD_ReplyCMD(void)
 {
-	char Rx0_tmpBuffer[UART_CMD_BUF_SIZE_128];
+	char Rx0_tmpBuffer[UART_CMD_BUF_SIZE_128 + 1];
+	CONST zcmdEntry_t *pEntry;
+
 	packageLength = UART_ParseLength(HAL_UART_PORT_0);
+	if ( packageLength == 0 || packageLength > UART_CMD_BUF_SIZE_128 )
+	{
+		return;
+	}
 	
 	UART_GetData(HAL_UART_PORT_0, (uint8*)Rx0_tmpBuffer, packageLength);
+	Rx0_tmpBuffer[packageLength] = '\0';
 	UART_DebugPrintNum(HAL_UART_PORT_0, packageLength);
 	UART_DebugPrint(HAL_UART_PORT_0, " ");
 
+	if ( (uint8)Rx0_tmpBuffer[0] == ZCMD_SOF )
+	{
+		ZCMD_ProcessFrame((uint8*)Rx0_tmpBuffer, packageLength);
+		return;
+	}
+
+	zcmdRspOp = ZCMD_OP_NONE;
+
 	if ( Rx0_tmpBuffer[0] == '@' && Rx0_tmpBuffer[1] == 'Z' &&
 		 	 Rx0_tmpBuffer[2] == 'B' && Rx0_tmpBuffer[packageLength-1] == '!' &&
 		 	 ZCMD_FindChrStr(Rx0_tmpBuffer, '!') )
 	{
-		// Check alive
-		if (ZCMD_MatchCMD(Rx0_tmpBuffer, "@ZB!"))
-		{
-			ZCMD_ProcessCMD(CMD_CHECK_ALIVE);
-			return;
-		}
-		
-		// Binding STOP
-		if (ZCMD_MatchCMD(Rx0_tmpBuffer, "@ZB+BIND=0!"))
-		{
-			ZCMD_ProcessCMD(CMD_BINDING_STOP);
-			return;
-		}
-		
-		// Binding START
-		if (ZCMD_MatchCMD(Rx0_tmpBuffer, "@ZB+BIND=1!"))
+		pEntry = ZCMD_MatchCMD(Rx0_tmpBuffer, packageLength);
+		if ( pEntry != NULL )
 		{
-			ZCMD_ProcessCMD(CMD_BINDING_START);
-			return;
-		}
-		
-		// Get Short Address
-		if (ZCMD_MatchCMD(Rx0_tmpBuffer, "@ZB+SHORTADDR!"))
-		{
-			ZCMD_ProcessCMD(CMD_RETURN_SHORT_ADDRESS);
+			// Data commands: everything between the keyword and the "!"
+			ZCMD_ProcessCMD(pEntry->cmd, Rx0_tmpBuffer + pEntry->kwLength,
+											packageLength - (pEntry->kwLength + 1));
 			return;
 		}
+	}
+	UART_ZCmdPrint(HAL_UART_PORT_0, "ERROR");		
+}
 
-		// Get Coord Short Address
-		if (ZCMD_MatchCMD(Rx0_tmpBuffer, "@ZB+COORDSHORTADDR!"))
-		{
-			ZCMD_ProcessCMD(CMD_RETURN_COORD_SHORT_ADDRESS);
-			return;
-		}
+void ZCMD_SendFrame(uint8 opcode, uint8 *pData, uint8 length)
+{
+	#if (defined UART_ZCMD) && (UART_ZCMD == TRUE)
+	uint8 frame[ZCMD_DATA_MAX + ZCMD_FRAME_OVERHEAD];
+	uint16 fcs;
 
-		// Disable Echo SEND Data
-		if (ZCMD_MatchCMD(Rx0_tmpBuffer, "@ZB+ECHOSDATA=0!"))
-		{
-			ZCMD_ProcessCMD(CMD_DISABLE_ECHO_SDATA);
-			return;
-		}
+	if ( length > ZCMD_DATA_MAX )
+	{
+		return;
+	}
 
-		// Enable Echo SEND Data
-		if (ZCMD_MatchCMD(Rx0_tmpBuffer, "@ZB+ECHOSDATA=1!"))
-		{		
-			ZCMD_ProcessCMD(CMD_ENABLE_ECHO_SDATA);
-			return;
-		}
+	frame[0] = ZCMD_SOF;
+	frame[1] = length;
+	frame[2] = opcode;
+	osal_memcpy(frame + ZCMD_FRAME_HDR_LEN, pData, length);
 
-		// Disable Echo RECEIVE Data
-		if (ZCMD_MatchCMD(Rx0_tmpBuffer, "@ZB+ECHORDATA=0!"))
-		{
-			ZCMD_ProcessCMD(CMD_DISABLE_ECHO_RDATA);
-			return;
-		}
+	fcs = ZCMD_Crc16(ZCMD_CRC_INIT, frame + 1, length + 2);
+	frame[ZCMD_FRAME_HDR_LEN + length] 		= LO_UINT16(fcs);
+	frame[ZCMD_FRAME_HDR_LEN + length + 1] = HI_UINT16(fcs);
 
-		// Enable Echo RECEIVE Data
-		if (ZCMD_MatchCMD(Rx0_tmpBuffer, "@ZB+ECHORDATA=1!"))
-		{		
-			ZCMD_ProcessCMD(CMD_ENABLE_ECHO_RDATA);
-			return;
-		}
+	HalUARTWrite(HAL_UART_PORT_0, frame, length + ZCMD_FRAME_OVERHEAD);
+	#endif
+}
 
-		// Send FREE DATA - Only for ZB Coordinator
-		if (ZCMD_MatchCMD(Rx0_tmpBuffer, "@ZB+DATA="))
-		{		
-			ZCMD_ProcessCMD(CMD_SEND_FREE_DATA);
-			return;
+uint16 ZCMD_Crc16(uint16 crc, uint8 *pData, uint8 length)
+{
+	while (length--)
+	{
+		crc = (crc << 4) ^ zcmdCrcTable[(uint8)(crc >> 12) ^ (*pData >> 4)];
+		crc = (crc << 4) ^ zcmdCrcTable[(uint8)(crc >> 12) ^ (*pData & 0x0F)];
+		pData++;
+	}
+	return crc;
+}
+
+void ZCMD_ProcessFrame(uint8* frame, uint8 length)
+{
+	uint8 i;
+	uint8 status;
+	uint8 dataLength = frame[1];
+	uint8 opcode = frame[2];
+	uint8 *pData = frame + ZCMD_FRAME_HDR_LEN;
+
+	if ( length != dataLength + ZCMD_FRAME_OVERHEAD ||
+			 ZCMD_Crc16(ZCMD_CRC_INIT, frame + 1, dataLength + 2) !=
+			 BUILD_UINT16(pData[dataLength], pData[dataLength + 1]) )
+	{
+		status = ZCMD_STATUS_BAD_FRAME;
+		ZCMD_SendFrame(ZCMD_OP_NAK, &status, 1);
+		return;
+	}
+
+	zcmdRspOp = opcode | ZCMD_OP_RSP;
+
+	for (i = 0; i < ZCMD_TABLE_SIZE; i++)
+	{
+		CONST zcmdEntry_t *pEntry = &zcmdTable[i];
+
+		if ( pEntry->opcode != opcode )
+		{
+			continue;
 		}
-		// control led -  only for ZBC
-		if (ZCMD_MatchCMD(Rx0_tmpBuffer,"@ZBC="))
+		if ( (pEntry->arg == ZCMD_ARG_DATA) ||
+				 (pEntry->arg == ZCMD_ARG_NONE && dataLength == 0) ||
+				 (dataLength == 1 && pData[0] == pEntry->arg) )
 		{
-			ZCMD_ProcessCMD(CMD_SEND_C);
+			ZCMD_ProcessCMD(pEntry->cmd, (char*)pData, dataLength);
 			return;
 		}
 	}
-	UART_ZCmdPrint(HAL_UART_PORT_0, "ERROR");		
+
+	ZCMD_Reply(ZCMD_STATUS_UNSUPPORTED, "ERROR");
 }
 
-void ZCMD_ProcessCMD(uint8 CMD)
+void ZCMD_ProcessCMD(uint8 CMD, char* pData, uint8 dataLength)
 {
 	switch (CMD)
 	{
 		case CMD_CHECK_ALIVE:
-			UART_ZCmdPrint(HAL_UART_PORT_0, "OK");
+			ZCMD_Reply(ZCMD_STATUS_OK, "OK");
 			break;
 			
 		case CMD_BINDING_STOP:
@@ -181,11 +254,11 @@ void ZCMD_ProcessCMD(uint8 CMD)
 					zclSampleHeatingCoolingUnit_BindingProcess();
 				#endif
 				FLAG_HARD_BINDING = FALSE;
-				UART_ZCmdPrint(HAL_UART_PORT_0, "BINDING STOPPED");
+				ZCMD_Reply(ZCMD_STATUS_OK, "BINDING STOPPED");
 			}
 			else
 			{
-				UART_ZCmdPrint(HAL_UART_PORT_0, "BINDING STOP ALREADY");
+				ZCMD_Reply(ZCMD_STATUS_ALREADY, "BINDING STOP ALREADY");
 			}
 			break;
 
@@ -200,129 +273,169 @@ void ZCMD_ProcessCMD(uint8 CMD)
 					zclSampleHeatingCoolingUnit_BindingProcess();
 				#endif
 				FLAG_HARD_BINDING = TRUE;
-				UART_ZCmdPrint(HAL_UART_PORT_0, "BINDING STARTED");
+				ZCMD_Reply(ZCMD_STATUS_OK, "BINDING STARTED");
 			}
 			else
 			{					
-				UART_ZCmdPrint(HAL_UART_PORT_0, "BINDING START ALREADY");
+				ZCMD_Reply(ZCMD_STATUS_ALREADY, "BINDING START ALREADY");
 			}
 			
 			break;
 
 		case CMD_RETURN_SHORT_ADDRESS:
-			UART_ZCmdPrintNum(HAL_UART_PORT_0, NLME_GetShortAddr());
-			UART_ZCmdPrintString(HAL_UART_PORT_0, "\r\n");
+			ZCMD_ReplyAddr(NLME_GetShortAddr());
 			break;
 
 		case CMD_RETURN_COORD_SHORT_ADDRESS:
 			#ifndef COORDINATOR
-				UART_ZCmdPrintNum(HAL_UART_PORT_0, NLME_GetCoordShortAddr());
-				UART_ZCmdPrintString(HAL_UART_PORT_0, "\r\n");
+				ZCMD_ReplyAddr(NLME_GetCoordShortAddr());
 			#else
-				UART_ZCmdPrint(HAL_UART_PORT_0, "COORDINATOR!");
+				ZCMD_Reply(ZCMD_STATUS_UNSUPPORTED, "COORDINATOR!");
 			#endif		
 
 			break;
 			
 		case CMD_ENABLE_ECHO_SDATA:
 			FLAG_ECHO_SDATA = TRUE;
-			UART_ZCmdPrint(HAL_UART_PORT_0, "OK");			
+			ZCMD_Reply(ZCMD_STATUS_OK, "OK");
 			break;
 
 		case CMD_DISABLE_ECHO_SDATA:
 			FLAG_ECHO_SDATA = FALSE;
-			UART_ZCmdPrint(HAL_UART_PORT_0, "OK");		
+			ZCMD_Reply(ZCMD_STATUS_OK, "OK");
 			break;
 
 		case CMD_ENABLE_ECHO_RDATA:
 			FLAG_ECHO_RDATA = TRUE;
-			UART_ZCmdPrint(HAL_UART_PORT_0, "OK");
+			ZCMD_Reply(ZCMD_STATUS_OK, "OK");
 			break;
 
 		case CMD_DISABLE_ECHO_RDATA:
 			FLAG_ECHO_RDATA = FALSE;
-			UART_ZCmdPrint(HAL_UART_PORT_0, "OK");
+			ZCMD_Reply(ZCMD_STATUS_OK, "OK");
 			break;
 
 		case CMD_SEND_FREE_DATA:
+			#ifdef COORDINATOR
+			if ( ZCMD_CopyFreeData(pData, dataLength) )
+			{	
+				zclSampleThermostat_SendFreeData();
+				ZCMD_Reply(ZCMD_STATUS_OK, "OK");
+			}
+			else
 			{
-				#ifdef COORDINATOR
-				uint8 i = 0;
-				uint8 parseStr_len = osal_strlen("@ZB+DATA=");
-				Free_Data_Size = packageLength - (parseStr_len + 1); 			// +  "!" ->  + 1
-				Free_Data[0] = '0'; 																			// DUMMY Byte
-
-				if ( Free_Data_Size <= FREE_DATA_BFR_SIZE )
-				{	
-					
-					for (i = 1; i <= FREE_DATA_BFR_SIZE; i++)
-					{
-						if (i <= Free_Data_Size)
-						{
-							Free_Data[i] = *(pcmdData + parseStr_len + i - 1);
-						}
-						else
-						{
-							Free_Data[i] = ' ';
-						}
-					}
-					zclSampleThermostat_SendFreeData();
-					
-					UART_ZCmdPrint(HAL_UART_PORT_0, "OK");
-				}
-				else
-				{
-					UART_ZCmdPrint(HAL_UART_PORT_0, "ERROR");
-				}
-				#else
-					UART_ZCmdPrint(HAL_UART_PORT_0, "NOT SUPPORT");
-				#endif
+				ZCMD_Reply(ZCMD_STATUS_ERROR, "ERROR");
 			}
+			#else
+				ZCMD_Reply(ZCMD_STATUS_UNSUPPORTED, "NOT SUPPORT");
+			#endif
 			break;
-			case CMD_SEND_C:
+
+		case CMD_SEND_C:
+			#ifdef COORDINATOR
+			if ( ZCMD_CopyFreeData(pData, dataLength) )
+			{	
+				zclSampleThermostat_SendC();
+				ZCMD_Reply(ZCMD_STATUS_OK, "DONE");
+			}
+			else
 			{
-				#ifdef COORDINATOR
-				uint8 i = 0;
-				uint8 parseStr_len = osal_strlen("@ZBC=");
-				Free_Data_Size = packageLength - (parseStr_len + 1); 			// +  "!" ->  + 1
-				Free_Data[0] = '0'; 																			// DUMMY Byte
-
-				if ( Free_Data_Size <= FREE_DATA_BFR_SIZE )
-				{	
-					
-					for (i = 1; i <= FREE_DATA_BFR_SIZE; i++)
-					{
-						if (i <= Free_Data_Size)
-						{
-							Free_Data[i] = *(pcmdData + parseStr_len + i - 1);
-						}
-						else
-						{
-							Free_Data[i] = ' ';
-						}
-					}
-					zclSampleThermostat_SendC();
-					
-					UART_ZCmdPrint(HAL_UART_PORT_0, "DONE");
-				}
-				else
-				{
-					UART_ZCmdPrint(HAL_UART_PORT_0, "ERROR");
-				}
-				#else
-					UART_ZCmdPrint(HAL_UART_PORT_0, "ONLY ZBC");
-				#endif
+				ZCMD_Reply(ZCMD_STATUS_ERROR, "ERROR");
 			}
+			#else
+				ZCMD_Reply(ZCMD_STATUS_UNSUPPORTED, "ONLY ZBC");
+			#endif
 			break;		
+
+		case CMD_SET_MODE_ASCII:
+			ZCMD_Reply(ZCMD_STATUS_OK, "OK");
+			ZCMD_Mode = ZCMD_MODE_ASCII;
+			break;
+
+		case CMD_SET_MODE_BINARY:
+			ZCMD_Reply(ZCMD_STATUS_OK, "OK");
+			ZCMD_Mode = ZCMD_MODE_BINARY;
+			break;
+
 		default:
 			break;
 	}
 }
 
-char* ZCMD_MatchCMD(char* buf, char* str)
+uint8 ZCMD_CopyFreeData(char* pData, uint8 dataLength)
 {
-	pcmdData = strstr(buf, str);
-	return pcmdData;
+	uint8 i;
+
+	if ( dataLength > FREE_DATA_BFR_SIZE )
+	{
+		return 0;
+	}
+
+	Free_Data_Size = dataLength;
+	Free_Data[0] = '0'; 																			// DUMMY Byte
+	for (i = 1; i <= FREE_DATA_BFR_SIZE; i++)
+	{
+		if (i <= Free_Data_Size)
+		{
+			Free_Data[i] = pData[i - 1];
+		}
+		else
+		{
+			Free_Data[i] = ' ';
+		}
+	}
+	return 1;
+}
+
+void ZCMD_Reply(uint8 status, char* str)
+{
+	if ( zcmdRspOp == ZCMD_OP_NONE )
+	{
+		UART_ZCmdPrint(HAL_UART_PORT_0, (uint8*)str);
+	}
+	else
+	{
+		ZCMD_SendFrame(zcmdRspOp, &status, 1);
+	}
+}
+
+void ZCMD_ReplyAddr(uint16 addr)
+{
+	if ( zcmdRspOp == ZCMD_OP_NONE )
+	{
+		UART_ZCmdPrintNum(HAL_UART_PORT_0, addr);
+		UART_ZCmdPrintString(HAL_UART_PORT_0, "\r\n");
+	}
+	else
+	{
+		uint8 rsp[3];
+
+		rsp[0] = ZCMD_STATUS_OK;
+		rsp[1] = LO_UINT16(addr);
+		rsp[2] = HI_UINT16(addr);
+		ZCMD_SendFrame(zcmdRspOp, rsp, sizeof(rsp));
+	}
+}
+
+CONST zcmdEntry_t* ZCMD_MatchCMD(char* buf, uint8 length)
+{
+	uint8 i;
+
+	for (i = 0; i < ZCMD_TABLE_SIZE; i++)
+	{
+		CONST zcmdEntry_t *pEntry = &zcmdTable[i];
+
+		// Data commands match on the keyword, the others on the whole frame
+		if ( pEntry->arg == ZCMD_ARG_DATA ? (length > pEntry->kwLength) :
+																				(length == pEntry->kwLength) )
+		{
+			if ( osal_memcmp(buf, pEntry->keyword, pEntry->kwLength) )
+			{
+				return pEntry;
+			}
+		}
+	}
+	return NULL;
 }
 
 uint8 ZCMD_FindChrStr(char* buf, uint8 chr)
@@ -23,6 +23,54 @@ extern "C"
  *                                            CONSTANTS
  *******************************************************************************/
 #define				FREE_DATA_BFR_SIZE			20
+
+/*
+ * Binary framing, negotiated with "@ZB+BIN=1!" (or ZCMD_OP_MODE) and used for
+ * the reports sent to the gateway. ASCII commands are always accepted and are
+ * answered in ASCII, binary frames are answered with binary frames.
+ *
+ *	SOF | LEN | OP | DATA[LEN] | FCS (LSB first)
+ *
+ * FCS is the CRC-16/CCITT (0x1021, initial value 0xFFFF) of LEN, OP and DATA.
+ * Multi-byte fields in DATA are little endian.
+ */
+#define				ZCMD_SOF								0xA5
+#define				ZCMD_FRAME_HDR_LEN			3				// SOF, LEN, OP
+#define				ZCMD_FRAME_FCS_LEN			2
+#define				ZCMD_FRAME_OVERHEAD			(ZCMD_FRAME_HDR_LEN + ZCMD_FRAME_FCS_LEN)
+#define				ZCMD_DATA_MAX						32
+#define				ZCMD_CRC_INIT						0xFFFF
+
+// Report format (ZCMD_Mode)
+#define				ZCMD_MODE_ASCII					0
+#define				ZCMD_MODE_BINARY				1
+
+// Opcodes: Gateway -> ZB, answered with (opcode | ZCMD_OP_RSP) and a status byte
+#define				ZCMD_OP_ALIVE						0x01
+#define				ZCMD_OP_BIND						0x02		// 0: stop, 1: start
+#define				ZCMD_OP_SHORTADDR				0x03		// rsp: status, shortAddr
+#define				ZCMD_OP_COORDSHORTADDR	0x04		// rsp: status, coordShortAddr
+#define				ZCMD_OP_ECHOSDATA				0x05		// 0: disable, 1: enable
+#define				ZCMD_OP_ECHORDATA				0x06		// 0: disable, 1: enable
+#define				ZCMD_OP_FREE_DATA				0x07		// data
+#define				ZCMD_OP_SEND_C					0x08		// data
+#define				ZCMD_OP_MODE						0x09		// ZCMD_MODE_ASCII / ZCMD_MODE_BINARY
+#define				ZCMD_OP_RSP							0x80
+#define				ZCMD_OP_NAK							0xFF		// bad length or FCS, status only
+
+// Opcodes: ZB -> Gateway reports
+#define				ZCMD_OP_RPT_ROUTER			0x40		// rssi, shortAddr, endPoint, temperature, humidity, heating, cooling
+#define				ZCMD_OP_RPT_FEEDBACK		0x41		// rssi, shortAddr, endPoint, heating, cooling
+#define				ZCMD_OP_RPT_SENSOR			0x42		// rssi, shortAddr, temperature(int16), humidity(uint16)
+#define				ZCMD_OP_RPT_STATE				0x43		// rssi, state[16], value(uint16)
+#define				ZCMD_OP_RPT_FREE_DATA		0x44		// rssi, shortAddr, endPoint, coordShortAddr, size, data[size]
+
+// Response status
+#define				ZCMD_STATUS_OK					0x00
+#define				ZCMD_STATUS_ALREADY			0x01
+#define				ZCMD_STATUS_ERROR				0x02
+#define				ZCMD_STATUS_UNSUPPORTED	0x03
+#define				ZCMD_STATUS_BAD_FRAME		0x04
 /*******************************************************************************
  *                                             TYPEDEFS
  *******************************************************************************/
@@ -36,10 +84,14 @@ extern bool FLAG_ECHO_RDATA;
 extern char 	Free_Data[];
 extern uint8 	Free_Data_Size;
 
+extern uint8	ZCMD_Mode;
+
 /*******************************************************************************
  *                                          FUNCTIONS - API
  *******************************************************************************/
 extern void ZCMD_ReplyCMD(void);
+extern void ZCMD_SendFrame(uint8 opcode, uint8 *pData, uint8 length);
+extern uint16 ZCMD_Crc16(uint16 crc, uint8 *pData, uint8 length);
 
 /*******************************************************************************
 *******************************************************************************/
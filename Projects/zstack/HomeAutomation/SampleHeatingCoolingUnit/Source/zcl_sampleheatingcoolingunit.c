@@ -288,8 +288,8 @@ void zclSampleHeatingCoolingUnit_Init( byte task_id )
 
 	UART_Init(HAL_UART_PORT_0);
 	
-	// Set timer for first UART Reply CMD event
-	osal_start_timerEx( zclSampleHeatingCoolingUnit_TaskID, SAMPLEHEATINGCOOLINGUNIT_UART_REPLY_CMD_EVT, UART_PARSE_RX_PACKAGE_EVT_PERIOD );
+	// UART commands are handled as soon as a whole package is in
+	UART_RegisterForFrames( HAL_UART_PORT_0, zclSampleHeatingCoolingUnit_TaskID, SAMPLEHEATINGCOOLINGUNIT_UART_REPLY_CMD_EVT );
 
 	// Set timer for first Check System event
 	osal_start_timerEx( zclSampleHeatingCoolingUnit_TaskID, SAMPLEHEATINGCOOLINGUNIT_CHECK_SYSTEM_EVT, CHECK_SYSTEM_EVT_PERIOD );
@@ -457,16 +457,10 @@ uint16 zclSampleHeatingCoolingUnit_event_loop( uint8 task_id, uint16 events )
 	if ( events & SAMPLEHEATINGCOOLINGUNIT_UART_REPLY_CMD_EVT )
   {
 		// My apps
-		if (UART_ParseRxPackage(HAL_UART_PORT_0))
+		while (UART_ParseRxPackage(HAL_UART_PORT_0))
 		{
 			ZCMD_ReplyCMD();
 		}
-
-		// Restart timer
-    if ( UART_PARSE_RX_PACKAGE_EVT_PERIOD )
-    {
-      osal_start_timerEx( zclSampleHeatingCoolingUnit_TaskID, SAMPLEHEATINGCOOLINGUNIT_UART_REPLY_CMD_EVT, UART_PARSE_RX_PACKAGE_EVT_PERIOD );
-    }
 		
     return (events ^ SAMPLEHEATINGCOOLINGUNIT_UART_REPLY_CMD_EVT);
   }
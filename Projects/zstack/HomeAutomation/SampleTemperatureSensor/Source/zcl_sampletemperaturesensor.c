@@ -73,6 +73,9 @@
 #include "zcl_ha.h"
 #include "zcl_ezmode.h"
 #include "zcl_ms.h"
+#ifdef ZCL_REPORTING
+#include "zcl_reporting.h"
+#endif
 
 #include "zcl_sampletemperaturesensor.h"
 
@@ -88,6 +91,7 @@
 #include "MS_UART_CMD.h"
 #include "MS_DHT11.h"
 #include "MS_GPIO.h"
+#include "MS_SAMPLE.h"
 #include "string.h"
 
 /*********************************************************************
@@ -140,9 +144,10 @@ static const zclEZMode_RegisterData_t zclSampleTemperatureSensor_RegisterEZModeD
 
 static cId_t bindingOutClusters[] =
 {
-  ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT
+  ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT,
+  ZCL_CLUSTER_ID_MS_RELATIVE_HUMIDITY
 };
-#define ZCLSAMPLETEMPERATURESENSOR_BINDINGLIST        1
+#define ZCLSAMPLETEMPERATURESENSOR_BINDINGLIST        2
 #endif
 
 devStates_t zclSampleTemperatureSensor_NwkState = DEV_INIT;
@@ -308,10 +313,14 @@ void zclSampleTemperatureSensor_Init( byte task_id )
         GPIO_init();
 	UART_Init(HAL_UART_PORT_0);
 
-	DHT11_Init();
+	DHT11_Init( zclSampleTemperatureSensor_TaskID, SAMPLETEMPERATURESENSOR_DHT11_EVT );
+
+	// Sensor is read on its own schedule, the filter decides when to report
+	SAMPLE_Init( zclSampleTemperatureSensor_TaskID, SAMPLETEMPERATURESENSOR_TEMP_SEND_EVT );
+	osal_start_timerEx( zclSampleTemperatureSensor_TaskID, SAMPLETEMPERATURESENSOR_SAMPLE_EVT, SAMPLE_PERIOD );
 	
-	// Set timer for first UART Reply CMD event
-	osal_start_timerEx( zclSampleTemperatureSensor_TaskID, SAMPLETEMPERATURESENSOR_UART_REPLY_CMD_EVT, UART_PARSE_RX_PACKAGE_EVT_PERIOD );
+	// UART commands are handled as soon as a whole package is in
+	UART_RegisterForFrames( HAL_UART_PORT_0, zclSampleTemperatureSensor_TaskID, SAMPLETEMPERATURESENSOR_UART_REPLY_CMD_EVT );
 
 	// Set timer for first Check System event
 	osal_start_timerEx( zclSampleTemperatureSensor_TaskID, SAMPLETEMPERATURESENSOR_CHECK_SYSTEM_EVT, CHECK_SYSTEM_EVT_PERIOD );
@@ -361,6 +370,20 @@ uint16 zclSampleTemperatureSensor_event_loop( uint8 task_id, uint16 events )
 					UART_DebugPrint(HAL_UART_PORT_0, "ZCL_INCOMING_MSG");
           break;
 
+        case DHT11_READING:
+          // Non-blocking DHT11 capture finished, filter it, MeasuredValue is in 0.01C.
+          // A report is requested through SAMPLETEMPERATURESENSOR_TEMP_SEND_EVT.
+          if ( ((dht11Reading_t *)MSGpkt)->hdr.status == DHTLIB_OK )
+          {
+            (void)SAMPLE_Add( ((dht11Reading_t *)MSGpkt)->temperature, ((dht11Reading_t *)MSGpkt)->humidity );
+            zclSampleTemperatureSensor_MeasuredValue = SAMPLE_GetTempCenti();
+						#ifdef ZCL_REPORTING
+            zclReporting_AttrChanged( SAMPLETEMPERATURESENSOR_ENDPOINT, ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT,
+                                      ATTRID_MS_TEMPERATURE_MEASURED_VALUE );
+						#endif
+          }
+          break;
+
         case KEY_CHANGE:
           zclSampleTemperatureSensor_HandleKeys( ((keyChange_t *)MSGpkt)->state, ((keyChange_t *)MSGpkt)->keys );
 					UART_DebugPrint(HAL_UART_PORT_0, "KEY_CHANGE");
@@ -479,10 +502,9 @@ uint16 zclSampleTemperatureSensor_event_loop( uint8 task_id, uint16 events )
   if ( events & SAMPLETEMPERATURESENSOR_TEMP_SEND_EVT )
   {
   	//UART_DebugPrint(HAL_UART_PORT_0, "SAMPLETEMPERATURESENSOR_TEMP_SEND_EVT");
-    zclSampleTemperatureSensor_SendTemp();			
-	//UART_SendString(HAL_UART_PORT_0,"Teddy_sample");	
-    // report current temperature reading every 10 seconds
-    //osal_start_timerEx( zclSampleTemperatureSensor_TaskID, SAMPLETEMPERATURESENSOR_TEMP_SEND_EVT, SAMPLETEMPERATURESENSOR_REPORT_INTERVAL );
+    // Filtered value moved by the delta, or the max interval expired
+    zclSampleTemperatureSensor_SendTemp();
+    SAMPLE_Reported();
 
     return ( events ^ SAMPLETEMPERATURESENSOR_TEMP_SEND_EVT );
   }
@@ -508,16 +530,10 @@ uint16 zclSampleTemperatureSensor_event_loop( uint8 task_id, uint16 events )
 	if ( events & SAMPLETEMPERATURESENSOR_UART_REPLY_CMD_EVT )
   {
 		// My apps
-		if (UART_ParseRxPackage(HAL_UART_PORT_0))
+		while (UART_ParseRxPackage(HAL_UART_PORT_0))
 		{
 			ZCMD_ReplyCMD();
 		}
-
-		// Restart timer
-    if ( UART_PARSE_RX_PACKAGE_EVT_PERIOD )
-    {
-      osal_start_timerEx( zclSampleTemperatureSensor_TaskID, SAMPLETEMPERATURESENSOR_UART_REPLY_CMD_EVT, UART_PARSE_RX_PACKAGE_EVT_PERIOD );
-    }		
     return (events ^ SAMPLETEMPERATURESENSOR_UART_REPLY_CMD_EVT);
   }
 	/*--------------------------------------------------------------------------*/
@@ -536,6 +552,23 @@ uint16 zclSampleTemperatureSensor_event_loop( uint8 task_id, uint16 events )
     }		
     return (events ^ SAMPLETEMPERATURESENSOR_CHECK_SYSTEM_EVT);
   }
+
+	/*--------------------------------------------------------------------------*/
+	if ( events & SAMPLETEMPERATURESENSOR_SAMPLE_EVT )
+	{
+		// The result comes back as a DHT11_READING message
+		DHT11_StartRead();
+
+		osal_start_timerEx( zclSampleTemperatureSensor_TaskID, SAMPLETEMPERATURESENSOR_SAMPLE_EVT, SAMPLE_PERIOD );
+		return (events ^ SAMPLETEMPERATURESENSOR_SAMPLE_EVT);
+	}
+
+	/*--------------------------------------------------------------------------*/
+	if ( events & SAMPLETEMPERATURESENSOR_DHT11_EVT )
+	{
+		DHT11_ProcessEvent();
+		return (events ^ SAMPLETEMPERATURESENSOR_DHT11_EVT);
+	}
 	
 	/*--------------------------------------------------------------------------*/
 
@@ -586,7 +619,8 @@ static void zclSampleTemperatureSensor_HandleKeys( byte shift, byte keys )
 			FLAG_HARD_BINDING = !FLAG_HARD_BINDING;
 		#ifdef ZCL_EZMODE
       zclEZMode_InvokeData_t ezModeData;
-      static uint16 clusterIDs[] = { ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT };   // only bind on the Temperature Measurement cluster
+      static uint16 clusterIDs[] = { ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT,
+                                     ZCL_CLUSTER_ID_MS_RELATIVE_HUMIDITY };   // only bind on the measurement clusters
 
       // Invoke EZ-Mode
       ezModeData.endpoint = SAMPLETEMPERATURESENSOR_ENDPOINT; // endpoint on which to invoke EZ-Mode
@@ -601,7 +635,7 @@ static void zclSampleTemperatureSensor_HandleKeys( byte shift, byte keys )
         ezModeData.onNetwork = FALSE;     // node is not yet on the network
       }
       ezModeData.initiator = TRUE;        // Temperature Sensor is an initiator
-      ezModeData.numActiveInClusters = 1;
+      ezModeData.numActiveInClusters = 2;
       ezModeData.pActiveInClusterIDs = clusterIDs;
       ezModeData.numActiveOutClusters = 0;   // active output cluster
       ezModeData.pActiveOutClusterIDs = NULL;
@@ -800,57 +834,36 @@ void zclSampleTemperatureSensor_LcdDisplayHelpMode( void )
  */
 static void zclSampleTemperatureSensor_SendTemp( void )
 {
-	// if (DHT11_GetValue() == 0)
-	// {
-		// zclSampleTemperatureSensor_MeasuredValue = BUILD_UINT16(69, 96);
-	// }
-	// else
-	// {
-		// zclSampleTemperatureSensor_MeasuredValue = DHT11_GetPackageValue();
-	// }
-
-	// //HalLedBlink ( HAL_LED_1, 1, 50, 500 );
-	// UART_DebugPrintNum(HAL_UART_PORT_0, NLME_GetShortAddr());
-	// UART_DebugPrint(HAL_UART_PORT_0, "");
-	// UART_DebugPrintNum(HAL_UART_PORT_0, NLME_GetCoordShortAddr());
-	// UART_DebugPrint(HAL_UART_PORT_0, "");
-	// UART_DebugPrintNum(HAL_UART_PORT_0, zclSampleTemperatureSensor_MeasuredValue);
-	
-	// UART_SendNum(HAL_UART_PORT_0,zclSampleTemperatureSensor_MeasuredValue);
-	// UART_DebugPrint(HAL_UART_PORT_0, "");
-	uint8 state1;
-	uint8 state2;
-	uint16 pos1 = 21;
-	uint16 pos2 = 22;
-	uint16 data1;
-	uint16 data2;
-
-	state1 = CheckOutputState(Output_2);
-	state2 = CheckOutputState(Output_3);
-	data1 = BUILD_UINT16(state1,pos1);
-	data2 = BUILD_UINT16(state2,pos2);
-	
+	int16 temperature = SAMPLE_GetTempCenti();
+	uint16 humidity = SAMPLE_GetHumCenti();
+
 	#ifdef ZCL_REPORT
   zclReportCmd_t *pReportCmd;
 	
-  pReportCmd = osal_mem_alloc( sizeof(zclReportCmd_t) + 2 * sizeof(zclReport_t) );
+  pReportCmd = osal_mem_alloc( sizeof(zclReportCmd_t) + sizeof(zclReport_t) );
   if ( pReportCmd != NULL )
   {
-    pReportCmd->numAttr = 2;
-		// Data
+    pReportCmd->numAttr = 1;
+		// Filtered readings in ZCL units, 0.01 C and 0.01 %RH, each on its own cluster
     pReportCmd->attrList[0].attrID = ATTRID_MS_TEMPERATURE_MEASURED_VALUE;
     pReportCmd->attrList[0].dataType = ZCL_DATATYPE_INT16;
-    pReportCmd->attrList[0].attrData = (void *)(&data1);
+    pReportCmd->attrList[0].attrData = (void *)(&temperature);
 
-    pReportCmd->attrList[1].dataType = ZCL_DATATYPE_INT16;
-    pReportCmd->attrList[1].attrData = (void *)(&data2);	
-		
     zcl_SendReportCmd( SAMPLETEMPERATURESENSOR_ENDPOINT, &zclSampleTemperatureSensor_DstAddr,
                        ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT,
                        pReportCmd, ZCL_FRAME_SERVER_CLIENT_DIR, TRUE, zclSampleTemperatureSensorSeqNum++ );
-  }
 
-  osal_mem_free( pReportCmd );
+    // The thermostat pairs this one with the temperature report just sent
+    pReportCmd->attrList[0].attrID = ATTRID_MS_RELATIVE_HUMIDITY_MEASURED_VALUE;
+    pReportCmd->attrList[0].dataType = ZCL_DATATYPE_UINT16;
+    pReportCmd->attrList[0].attrData = (void *)(&humidity);
+
+    zcl_SendReportCmd( SAMPLETEMPERATURESENSOR_ENDPOINT, &zclSampleTemperatureSensor_DstAddr,
+                       ZCL_CLUSTER_ID_MS_RELATIVE_HUMIDITY,
+                       pReportCmd, ZCL_FRAME_SERVER_CLIENT_DIR, TRUE, zclSampleTemperatureSensorSeqNum++ );
+
+    osal_mem_free( pReportCmd );
+  }
 	#endif  // ZCL_REPORT
 }
 
@@ -1432,7 +1445,8 @@ void zclSampleTemperatureSensor_BindingProcess(void)
 	
 	#ifdef ZCL_EZMODE
 		zclEZMode_InvokeData_t ezModeData;
-		static uint16 clusterIDs[] = { ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT }; 	// only bind on the Temperature Measurement cluster
+		static uint16 clusterIDs[] = { ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT,
+																	 ZCL_CLUSTER_ID_MS_RELATIVE_HUMIDITY }; 	// only bind on the measurement clusters
 	
 		// Invoke EZ-Mode
 		ezModeData.endpoint = SAMPLETEMPERATURESENSOR_ENDPOINT; // endpoint on which to invoke EZ-Mode
@@ -1447,7 +1461,7 @@ void zclSampleTemperatureSensor_BindingProcess(void)
 			ezModeData.onNetwork = FALSE; 		// node is not yet on the network
 		}
 		ezModeData.initiator = TRUE;				// Temperature Sensor is an initiator
-		ezModeData.numActiveInClusters = 1;
+		ezModeData.numActiveInClusters = 2;
 		ezModeData.pActiveInClusterIDs = clusterIDs;
 		ezModeData.numActiveOutClusters = 0;	 // active output cluster
 		ezModeData.pActiveOutClusterIDs = NULL;
@@ -74,9 +74,11 @@ extern "C"
 #define SAMPLETEMPERATURESENSOR_JOIN_SETUP_EVT				 0x0020
 #define SAMPLETEMPERATURESENSOR_UART_REPLY_CMD_EVT			 0x0040
 #define SAMPLETEMPERATURESENSOR_CHECK_SYSTEM_EVT 			 0x0080
+#define SAMPLETEMPERATURESENSOR_DHT11_EVT                    0x0100
 #define SAMPLETEMPERATURESENSOR_SW1							 0x0200
 #define SAMPLETEMPERATURESENSOR_SW2							 0x0400
 #define SAMPLETEMPERATURESENSOR_SW3                          0x0800
+#define SAMPLETEMPERATURESENSOR_SAMPLE_EVT                   0x1000
 
 // Application Display Modes
 #define TEMPSENSE_MAINMODE         0x00
@@ -84,6 +84,7 @@
 #include "hal_key.h"
 
 /* MY INCLUDES */
+#include "MS_AGGR.h"
 #include "MS_UART.h"
 #include "MS_UART_CMD.h"
 #include "MS_GPIO.h"
@@ -101,6 +102,8 @@
 /*********************************************************************
  * MACROS
  */
+// ZCL MeasuredValue (0.01 C or 0.01 %RH) to the whole units relayed on the UART
+#define CENTI_TO_WHOLE(x)   ( ( (int32)(x) + ( ( (int32)(x) < 0 ) ? -50 : 50 ) ) / 100 )
 
 /*********************************************************************
  * CONSTANTS
@@ -127,6 +130,13 @@ static byte gPermitDuration = 0x00;
  */
 afAddrType_t zclSampleThermostat_DstAddr;
 
+#ifdef ZCL_REPORT
+// Sensor temperature waiting for the humidity report the sensor sends right after it
+static uint16 zclSampleThermostat_SensorAddr = INVALID_NODE_ADDR;
+static uint8 zclSampleThermostat_SensorEP;
+static int16 zclSampleThermostat_SensorTemp;
+#endif
+
 #ifdef ZCL_EZMODE
 static void zclSampleThermostat_ProcessZDOMsgs( zdoIncomingMsg_t *pMsg );
 static void zclSampleThermostat_EZModeCB( zlcEZMode_State_t state, zclEZMode_CBData_t *pData );
@@ -152,9 +162,10 @@ static cId_t bindingOutClusters[] =
 static cId_t bindingInClusters[] =
 {
   ZCL_CLUSTER_ID_HVAC_THERMOSTAT,
-  ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT
+  ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT,
+  ZCL_CLUSTER_ID_MS_RELATIVE_HUMIDITY
 };
-#define ZCLSAMPLETHERMOSTAT_BINDINGLIST_IN      2
+#define ZCLSAMPLETHERMOSTAT_BINDINGLIST_IN      3
 #endif
 
 uint8 giThermostatScreenMode = THERMOSTAT_MAINMODE;   // display the main screen mode first
@@ -204,7 +215,10 @@ static uint8 zclSampleThermostat_ProcessInReadRspCmd( zclIncomingMsg_t *pInMsg )
 static uint8 zclSampleThermostat_ProcessInWriteRspCmd( zclIncomingMsg_t *pInMsg );
 #endif
 #ifdef ZCL_REPORT
-static void zclSampleThermostat_ProcessInReportCmd( zclIncomingMsg_t *pInMsg );
+static void zclSampleThermostat_ReportCB( zclIncoming_t *pInMsg, zclReportIter_t *pIter );
+#ifdef COORDINATOR
+static void zclSampleThermostat_ProcessRouterReport( zclReportView_t *attr, uint8 numAttr, zclReportIter_t *pIter );
+#endif
 #endif
 static uint8 zclSampleThermostat_ProcessInDefaultRspCmd( zclIncomingMsg_t *pInMsg );
 
@@ -296,6 +310,11 @@ void zclSampleThermostat_Init( byte task_id )
   // Register the Application to receive the unprocessed Foundation command/response messages
   zcl_registerForMsg( zclSampleThermostat_TaskID );
 
+#ifdef ZCL_REPORT
+  // Reports are handled in place, without a parsed copy or a task message
+  zcl_registerReportCB( SAMPLETHERMOSTAT_ENDPOINT, zclSampleThermostat_ReportCB );
+#endif
+
 	#ifdef ZCL_EZMODE
   // Register EZ-Mode
   zcl_RegisterEZMode( &zclSampleThermostat_RegisterEZModeData );
@@ -326,8 +345,21 @@ void zclSampleThermostat_Init( byte task_id )
 	// cho nay khai bao gpio
 	GPIO_init();
 	
-	// Set timer for first UART Reply CMD event
-	osal_start_timerEx( zclSampleThermostat_TaskID, SAMPLETHERMOSTAT_UART_REPLY_CMD_EVT, UART_PARSE_RX_PACKAGE_EVT_PERIOD );
+	// UART commands are handled as soon as a whole package is in
+	UART_RegisterForFrames( HAL_UART_PORT_0, zclSampleThermostat_TaskID, SAMPLETHERMOSTAT_UART_REPLY_CMD_EVT );
+
+	#ifdef ROUTER
+	{
+		// Roll call and children reports go to the coordinator in batches
+		afAddrType_t coordAddr;
+
+		coordAddr.addrMode = (afAddrMode_t)Addr16Bit;
+		coordAddr.endPoint = APP_COORDINATOR_ENDPOINT;
+		coordAddr.addr.shortAddr = 0;
+		AGGR_Init( SAMPLETHERMOSTAT_ENDPOINT, ZCL_CLUSTER_ID_HVAC_THERMOSTAT, &coordAddr,
+							 &zclSampleThermostatSeqNum, zclSampleThermostat_TaskID, SAMPLETHERMOSTAT_RPT_FLUSH_EVT );
+	}
+	#endif
 
 	// Set timer for first Check System event
 	osal_start_timerEx( zclSampleThermostat_TaskID, SAMPLETHERMOSTAT_CHECK_SYSTEM_EVT, CHECK_SYSTEM_EVT_PERIOD );
@@ -504,17 +536,11 @@ uint16 zclSampleThermostat_event_loop( uint8 task_id, uint16 events )
 	if ( events & SAMPLETHERMOSTAT_UART_REPLY_CMD_EVT )
   {
 		// My apps
-		if (UART_ParseRxPackage(HAL_UART_PORT_0))
+		while (UART_ParseRxPackage(HAL_UART_PORT_0))
 		{
 			ZCMD_ReplyCMD();
 		}
 		
-		// Restart timer
-    if ( UART_PARSE_RX_PACKAGE_EVT_PERIOD )
-    {
-      osal_start_timerEx( zclSampleThermostat_TaskID, SAMPLETHERMOSTAT_UART_REPLY_CMD_EVT, UART_PARSE_RX_PACKAGE_EVT_PERIOD );
-    }
-		
     return (events ^ SAMPLETHERMOSTAT_UART_REPLY_CMD_EVT);
   }
 
@@ -539,6 +565,16 @@ uint16 zclSampleThermostat_event_loop( uint8 task_id, uint16 events )
 			 
     return (events ^ SAMPLETHERMOSTAT_CHECK_SYSTEM_EVT);
   }
+
+	/*--------------------------------------------------------------------------*/
+	#ifdef ROUTER
+	if ( events & SAMPLETHERMOSTAT_RPT_FLUSH_EVT )
+  {
+		(void)AGGR_Flush();
+
+    return (events ^ SAMPLETHERMOSTAT_RPT_FLUSH_EVT);
+  }
+	#endif
 	
 	/*--------------------------------------------------------------------------*/
 
@@ -1238,9 +1274,7 @@ static void zclSampleThermostat_ProcessIncomingMsg( zclIncomingMsg_t *pInMsg)
       //zclSampleThermostat_ProcessInReadReportCfgRspCmd( pInMsg );
       break;
 
-    case ZCL_CMD_REPORT:
-      zclSampleThermostat_ProcessInReportCmd( pInMsg );
-      break;
+    // ZCL_CMD_REPORT goes to zclSampleThermostat_ReportCB
 #endif
     case ZCL_CMD_DEFAULT_RSP:
       zclSampleThermostat_ProcessInDefaultRspCmd( pInMsg );
@@ -1311,148 +1345,318 @@ static uint8 zclSampleThermostat_ProcessInWriteRspCmd( zclIncomingMsg_t *pInMsg
 
 #ifdef ZCL_REPORT
 /*********************************************************************
- * @fn      zclSampleThermostat_ProcessInReportCmd
+ * @fn      zclSampleThermostat_ReportCB
  *
- * @brief   Process the "Profile" Report Command
+ * @brief   Process the "Profile" Report Command. Called by the ZCL with
+ *          the attribute reports still in the received frame, so
+ *          nothing is allocated or copied for the common reports.
  *
  * @param   pInMsg - incoming message to process
+ * @param   pIter - iterator over the attribute reports
  *
  * @return  none
  */
-static void zclSampleThermostat_ProcessInReportCmd( zclIncomingMsg_t *pInMsg )
+static void zclSampleThermostat_ReportCB( zclIncoming_t *pInMsg, zclReportIter_t *pIter )
 {
-	uint8 src_EndPoint;
-	
-  zclReportCmd_t *pInReportCmd;
-	
-  zclReportCmd_t *pOutDemandReport;
-  uint8 outDemandBuffer[sizeof( zclReportCmd_t ) + ( 3 * sizeof( zclReport_t ) )];
-  bool send = TRUE;
+  zclReportView_t attr[3];
+  UartLine_t line;
+  uint8 numAttr = 0;
 
-  pInReportCmd = (zclReportCmd_t *)pInMsg->attrCmd;
+  // Only the first three attribute reports are ever looked at
+  while ( ( numAttr < 3 ) && zclReportIterNext( pIter, &attr[numAttr] ) )
+  {
+    numAttr++;
+  }
+
+  if ( numAttr == 0 )
+  {
+    return;
+  }
+
+  msg_RSSI = pInMsg->msg->rssi;
 
 	/*- Router: Data report ----------------------------------------------------*/
 	#ifdef COORDINATOR
-	if ( pInReportCmd->attrList[0].attrID == ATTRID_REPORT_DATA_COORD)
+	if ( ( attr[0].attrID == ATTRID_ROLL_CALL ) || ( attr[0].attrID == ATTRID_REPORT_DATA_COORD ) )
 	{
 		HalLedBlink ( HAL_LED_2, 1, 50, 500 );
-		
-		UART_ZCmdPrintString(HAL_UART_PORT_0, "@ZBR:");
-		UART_ZCmdPrintNum 	(HAL_UART_PORT_0, msg_RSSI);																			// RSSI
-		UART_ZCmdPrintString(HAL_UART_PORT_0, ";");
-		UART_ZCmdPrintNum 	(HAL_UART_PORT_0, pInReportCmd->attrList[2].attrID);							// shortAddr
-		UART_ZCmdPrintString(HAL_UART_PORT_0, ";");
-		UART_ZCmdPrintNum 	(HAL_UART_PORT_0, pInReportCmd->attrList[2].attrData[0]);						// endPoint
-		UART_ZCmdPrintString(HAL_UART_PORT_0, ";");
-		UART_ZCmdPrintNum 	(HAL_UART_PORT_0, pInReportCmd->attrList[0].attrData[0]);					// temperature
-		UART_ZCmdPrintString(HAL_UART_PORT_0, ";");
-		UART_ZCmdPrintNum 	(HAL_UART_PORT_0, pInReportCmd->attrList[0].attrData[1]);					// humidity
-		UART_ZCmdPrintString(HAL_UART_PORT_0, ";");
-		UART_ZCmdPrintNum 	(HAL_UART_PORT_0, pInReportCmd->attrList[1].attrData[0]);					// heating
-		UART_ZCmdPrintString(HAL_UART_PORT_0, ";");
-		UART_ZCmdPrintNum 	(HAL_UART_PORT_0, pInReportCmd->attrList[1].attrData[1]);					// cooling
-		UART_ZCmdPrint		(HAL_UART_PORT_0, "!");
+		zclSampleThermostat_ProcessRouterReport( attr, numAttr, pIter );
 		return;
 	}
 	#endif
 	
 	/*- endDev Engine: Feedback ------------------------------------------------*/
-	if ( pInReportCmd->attrList[0].attrID == ATTRID_HVAC_THERMOSTAT_RUNNING_STATE )
+	if ( attr[0].attrID == ATTRID_HVAC_THERMOSTAT_RUNNING_STATE )
 	{
 		HalLedBlink ( HAL_LED_2, 1, 50, 500 );
 
-		if (FLAG_ECHO_RDATA)
+		#ifdef ROUTER
+		AGGR_AddState( pInMsg->msg->srcAddr.addr.shortAddr, pInMsg->msg->srcAddr.endPoint,
+									 BUILD_UINT16( attr[0].attrData[0], attr[0].attrData[1] ) );
+		#endif
+
+		if ( FLAG_ECHO_RDATA && ( ZCMD_Mode == ZCMD_MODE_BINARY ) )
 		{
-			UART_ZCmdPrintString(HAL_UART_PORT_0, "@ZBF:");
-			UART_ZCmdPrintNum 	(HAL_UART_PORT_0, msg_RSSI);																		// RSSI
-			UART_ZCmdPrintString(HAL_UART_PORT_0, ";");
-			UART_ZCmdPrintNum 	(HAL_UART_PORT_0, pInMsg->srcAddr.addr.shortAddr);							// shortAddr
-			UART_ZCmdPrintString(HAL_UART_PORT_0, ";");
-			UART_ZCmdPrintNum 	(HAL_UART_PORT_0, pInMsg->srcAddr.endPoint);										// endPoint
-			UART_ZCmdPrintString(HAL_UART_PORT_0, ";");
-			UART_ZCmdPrintNum 	(HAL_UART_PORT_0, pInReportCmd->attrList[0].attrData[0]); 			// Feedback Heating
-			UART_ZCmdPrintString(HAL_UART_PORT_0, ";");
-			UART_ZCmdPrintNum 	(HAL_UART_PORT_0, pInReportCmd->attrList[0].attrData[1]); 			// Feedback Cooling
-			UART_ZCmdPrint			(HAL_UART_PORT_0, "!");
+			uint8 rpt[6];
+
+			rpt[0] = (uint8)msg_RSSI;
+			rpt[1] = LO_UINT16( pInMsg->msg->srcAddr.addr.shortAddr );
+			rpt[2] = HI_UINT16( pInMsg->msg->srcAddr.addr.shortAddr );
+			rpt[3] = pInMsg->msg->srcAddr.endPoint;
+			rpt[4] = attr[0].attrData[0];																	// Feedback Heating
+			rpt[5] = attr[0].attrData[1];																	// Feedback Cooling
+			ZCMD_SendFrame( ZCMD_OP_RPT_FEEDBACK, rpt, sizeof( rpt ) );
+		}
+		else if (FLAG_ECHO_RDATA)
+		{
+			UART_LineStart			(&line, "@ZBF:");
+			UART_LineAddNum			(&line, msg_RSSI);																		// RSSI
+			UART_LineAddChar		(&line, ';');
+			UART_LineAddNum			(&line, pInMsg->msg->srcAddr.addr.shortAddr);							// shortAddr
+			UART_LineAddChar		(&line, ';');
+			UART_LineAddNum			(&line, pInMsg->msg->srcAddr.endPoint);										// endPoint
+			UART_LineAddChar		(&line, ';');
+			UART_LineAddNum			(&line, attr[0].attrData[0]); 			// Feedback Heating
+			UART_LineAddChar		(&line, ';');
+			UART_LineAddNum			(&line, attr[0].attrData[1]); 			// Feedback Cooling
+			UART_LineAddChar		(&line, '!');
+			UART_ZCmdPrintLine	(HAL_UART_PORT_0, &line);
 		}
 		
 		return;
 	}
 
 	/*- endDev Sensor: Value Process -------------------------------------------*/
-  if ( pInReportCmd->attrList[0].attrID == ATTRID_MS_TEMPERATURE_MEASURED_VALUE )
-  {		
+	// Temperature and humidity come in two reports, printed together once both are in
+	if ( ( pInMsg->msg->clusterId == ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT ) &&
+			 ( attr[0].attrID == ATTRID_MS_TEMPERATURE_MEASURED_VALUE ) )
+	{
+		zclSampleThermostat_SensorAddr = pInMsg->msg->srcAddr.addr.shortAddr;
+		zclSampleThermostat_SensorEP = pInMsg->msg->srcAddr.endPoint;
+		zclSampleThermostat_SensorTemp = (int16)BUILD_UINT16( attr[0].attrData[0], attr[0].attrData[1] );
+		return;
+	}
+
+  if ( ( pInMsg->msg->clusterId == ZCL_CLUSTER_ID_MS_RELATIVE_HUMIDITY ) &&
+       ( attr[0].attrID == ATTRID_MS_RELATIVE_HUMIDITY_MEASURED_VALUE ) )
+  {
+		uint16 temperature;
+		uint16 humidity;
+
+		// The temperature report of this reading was lost
+		if ( ( zclSampleThermostat_SensorAddr != pInMsg->msg->srcAddr.addr.shortAddr ) ||
+				 ( zclSampleThermostat_SensorEP != pInMsg->msg->srcAddr.endPoint ) )
+		{
+			return;
+		}
+		zclSampleThermostat_SensorAddr = INVALID_NODE_ADDR;
+
+		temperature = (uint16)CENTI_TO_WHOLE( zclSampleThermostat_SensorTemp );
+		humidity = (uint16)CENTI_TO_WHOLE( BUILD_UINT16( attr[0].attrData[0], attr[0].attrData[1] ) );
+
+		#ifdef ROUTER
+		AGGR_AddSensor( pInMsg->msg->srcAddr.addr.shortAddr, pInMsg->msg->srcAddr.endPoint,
+										BUILD_UINT16( LO_UINT16( temperature ), LO_UINT16( humidity ) ) );
+		#endif
+
+		if ( ZCMD_Mode == ZCMD_MODE_BINARY )
+		{
+			uint8 rpt[7];
+
+			rpt[0] = (uint8)msg_RSSI;
+			rpt[1] = LO_UINT16( pInMsg->msg->srcAddr.addr.shortAddr );
+			rpt[2] = HI_UINT16( pInMsg->msg->srcAddr.addr.shortAddr );
+			rpt[3] = LO_UINT16( temperature );														// temperature, LSB first
+			rpt[4] = HI_UINT16( temperature );
+			rpt[5] = LO_UINT16( humidity );																// humidity, LSB first
+			rpt[6] = HI_UINT16( humidity );
+			ZCMD_SendFrame( ZCMD_OP_RPT_SENSOR, rpt, sizeof( rpt ) );
+			return;
+		}
 	
-			UART_ZCmdPrintString(HAL_UART_PORT_0, "@ZBS:");
-			UART_ZCmdPrintNum 	(HAL_UART_PORT_0, msg_RSSI);																	
-			UART_ZCmdPrintString(HAL_UART_PORT_0, ";");
-			UART_ZCmdPrintNum 	(HAL_UART_PORT_0, pInMsg->srcAddr.addr.shortAddr);
-			UART_ZCmdPrintString(HAL_UART_PORT_0, ";");
-			UART_ZCmdPrintNum 	(HAL_UART_PORT_0, pInReportCmd->attrList[0].attrData[1]);
-			UART_ZCmdPrintString(HAL_UART_PORT_0, ";");
-			UART_ZCmdPrintNum 	(HAL_UART_PORT_0, pInReportCmd->attrList[0].attrData[0]);	
-			UART_ZCmdPrintString(HAL_UART_PORT_0, ";");
-			UART_ZCmdPrintNum 	(HAL_UART_PORT_0, pInReportCmd->attrList[1].attrData[1]);
-			UART_ZCmdPrintString(HAL_UART_PORT_0, ";");
-			UART_ZCmdPrintNum 	(HAL_UART_PORT_0, pInReportCmd->attrList[1].attrData[0]);
-			UART_ZCmdPrint		(HAL_UART_PORT_0, "!");
+			UART_LineStart			(&line, "@ZBS:");
+			UART_LineAddNum			(&line, msg_RSSI);																	
+			UART_LineAddChar		(&line, ';');
+			UART_LineAddNum			(&line, pInMsg->msg->srcAddr.addr.shortAddr);
+			UART_LineAddChar		(&line, ';');
+			UART_LineAddNum			(&line, HI_UINT16( temperature ));
+			UART_LineAddChar		(&line, ';');
+			UART_LineAddNum			(&line, LO_UINT16( temperature ));	
+			UART_LineAddChar		(&line, ';');
+			UART_LineAddNum			(&line, HI_UINT16( humidity ));
+			UART_LineAddChar		(&line, ';');
+			UART_LineAddNum			(&line, LO_UINT16( humidity ));
+			UART_LineAddChar		(&line, '!');
+			UART_ZCmdPrintLine	(HAL_UART_PORT_0, &line);
   }
 	
-	if (pInReportCmd->attrList[0].attrID == ATTRID_SENDSTATE)
+	if ( ( attr[0].attrID == ATTRID_SENDSTATE ) && ( numAttr >= 2 ) )
 	{	
-		int i;
-		uint8 add[16];
-		UART_ZCmdPrintString(HAL_UART_PORT_0, "@ZBR:");
-		UART_ZCmdPrintNum 	(HAL_UART_PORT_0, msg_RSSI);																	
-		UART_ZCmdPrintString(HAL_UART_PORT_0, ";"); 
-		for(i = 0;i<16;i++)
+		if ( ZCMD_Mode == ZCMD_MODE_BINARY )
 		{
-			add[i] = pInReportCmd->attrList[0].attrData[i];
+			uint8 rpt[19];
+
+			rpt[0] = (uint8)msg_RSSI;
+			osal_memcpy( rpt + 1, attr[0].attrData, 16 );
+			rpt[17] = attr[1].attrData[0];
+			rpt[18] = attr[1].attrData[1];
+			ZCMD_SendFrame( ZCMD_OP_RPT_STATE, rpt, sizeof( rpt ) );
+			return;
 		}
-		add[16] == '\0';
-		HalUARTWrite(HAL_UART_PORT_0, add,16); 
-		UART_ZCmdPrintString(HAL_UART_PORT_0, ";");
-		UART_ZCmdPrintNum 	(HAL_UART_PORT_0, pInReportCmd->attrList[1].attrData[0]);
-		UART_ZCmdPrintNum 	(HAL_UART_PORT_0, pInReportCmd->attrList[1].attrData[1]);
-		UART_ZCmdPrint		(HAL_UART_PORT_0, "!");
+
+		UART_LineStart			(&line, "@ZBR:");
+		UART_LineAddNum			(&line, msg_RSSI);																	
+		UART_LineAddChar		(&line, ';');
+		UART_LineAddBuffer	(&line, attr[0].attrData, 16);
+		UART_LineAddChar		(&line, ';');
+		UART_LineAddNum			(&line, attr[1].attrData[0]);
+		UART_LineAddNum			(&line, attr[1].attrData[1]);
+		UART_LineAddChar		(&line, '!');
+		UART_ZCmdPrintLine	(HAL_UART_PORT_0, &line);
 		return;
 	}
 
 	// freedata
-	if ( pInReportCmd->attrList[0].attrID == ATTRID_FREE_DATA )
+	if ( ( attr[0].attrID == ATTRID_FREE_DATA ) && ( numAttr >= 2 ) )
 	{
-		uint8 i;
-		uint8 tmp_Data[20];
+		uint8 size = attr[1].attrData[0];
 		
 		HalLedBlink ( HAL_LED_2, 1, 50, 500 );
 		
-		if (FLAG_ECHO_RDATA)
+		// eliminate DUMMY byte index[0], sent straight out of the frame
+		if ( size >= attr[0].dataLen )
+		{
+			size = ( attr[0].dataLen > 0 ) ? attr[0].dataLen - 1 : 0;
+		}
+
+		if ( FLAG_ECHO_RDATA && ( ZCMD_Mode == ZCMD_MODE_BINARY ) )
 		{
-			UART_ZCmdPrintString(HAL_UART_PORT_0, "@ZBR:");
-			UART_ZCmdPrintNum 	(HAL_UART_PORT_0, msg_RSSI);																// RSSI
-			UART_ZCmdPrintString(HAL_UART_PORT_0, ";");
-			UART_ZCmdPrintNum 	(HAL_UART_PORT_0, pInMsg->srcAddr.addr.shortAddr);					// shortAddr
-			UART_ZCmdPrintString(HAL_UART_PORT_0, ";");
-			UART_ZCmdPrintNum 	(HAL_UART_PORT_0, pInMsg->srcAddr.endPoint);								// endPoint
-			UART_ZCmdPrintString(HAL_UART_PORT_0, ";");
-			UART_ZCmdPrintNum 	(HAL_UART_PORT_0, pInReportCmd->attrList[1].attrID); 				// coordShortAddr
-			UART_ZCmdPrintString(HAL_UART_PORT_0, ";"); 
-			UART_ZCmdPrintNum 	(HAL_UART_PORT_0, pInReportCmd->attrList[1].attrData[0]); 	// data size
-			UART_ZCmdPrintString(HAL_UART_PORT_0, ";");
-			
-			// eliminate DUMMY byte index[0]
-			for (i = 1; i <= pInReportCmd->attrList[1].attrData[0]; i++)
+			uint8 rpt[7 + FREE_DATA_BFR_SIZE];
+
+			if ( size > FREE_DATA_BFR_SIZE )
 			{
-				tmp_Data[i-1] = pInReportCmd->attrList[0].attrData[i];
+				size = FREE_DATA_BFR_SIZE;
 			}
-			UART_ZCmdPrintBuffer(HAL_UART_PORT_0, tmp_Data, pInReportCmd->attrList[1].attrData[0]); 	// Free Data
-			UART_ZCmdPrint			(HAL_UART_PORT_0, "!");
+			rpt[0] = (uint8)msg_RSSI;
+			rpt[1] = LO_UINT16( pInMsg->msg->srcAddr.addr.shortAddr );
+			rpt[2] = HI_UINT16( pInMsg->msg->srcAddr.addr.shortAddr );
+			rpt[3] = pInMsg->msg->srcAddr.endPoint;
+			rpt[4] = LO_UINT16( attr[1].attrID );													// coordShortAddr
+			rpt[5] = HI_UINT16( attr[1].attrID );
+			rpt[6] = size;
+			osal_memcpy( rpt + 7, attr[0].attrData + 1, size );
+			ZCMD_SendFrame( ZCMD_OP_RPT_FREE_DATA, rpt, 7 + size );
+		}
+		else if (FLAG_ECHO_RDATA)
+		{
+			UART_LineStart			(&line, "@ZBR:");
+			UART_LineAddNum			(&line, msg_RSSI);																// RSSI
+			UART_LineAddChar		(&line, ';');
+			UART_LineAddNum			(&line, pInMsg->msg->srcAddr.addr.shortAddr);					// shortAddr
+			UART_LineAddChar		(&line, ';');
+			UART_LineAddNum			(&line, pInMsg->msg->srcAddr.endPoint);								// endPoint
+			UART_LineAddChar		(&line, ';');
+			UART_LineAddNum			(&line, attr[1].attrID); 				// coordShortAddr
+			UART_LineAddChar		(&line, ';');
+			UART_LineAddNum			(&line, attr[1].attrData[0]); 	// data size
+			UART_LineAddChar		(&line, ';');
+			UART_LineAddBuffer	(&line, attr[0].attrData + 1, size); 	// Free Data
+			UART_LineAddChar		(&line, '!');
+			UART_ZCmdPrintLine	(HAL_UART_PORT_0, &line);
 		}
 		return;
 	}
 
 
 }
+
+#ifdef COORDINATOR
+/*********************************************************************
+ * @fn      zclSampleThermostat_ProcessRouterReport
+ *
+ * @brief   Walk a report aggregated by a router: its roll call, then
+ *          one sensor / running state / address triple per child,
+ *          each printed like a single router data report.
+ *
+ * @param   attr - the first attribute reports, room for three
+ * @param   numAttr - number of reports in attr
+ * @param   pIter - iterator over the rest of the reports
+ *
+ * @return  none
+ */
+static void zclSampleThermostat_ProcessRouterReport( zclReportView_t *attr, uint8 numAttr, zclReportIter_t *pIter )
+{
+	UartLine_t line;
+	uint8 used;
+	uint8 i;
+
+	for ( ;; )
+	{
+		if ( attr[0].attrID == ATTRID_ROLL_CALL )
+		{
+			used = 1;
+		}
+		else if ( ( attr[0].attrID == ATTRID_REPORT_DATA_COORD ) && ( numAttr >= 3 ) )
+		{
+			used = 3;
+
+			if ( ZCMD_Mode == ZCMD_MODE_BINARY )
+			{
+				uint8 rpt[8];
+
+				rpt[0] = (uint8)msg_RSSI;
+				rpt[1] = LO_UINT16( attr[2].attrID );													// shortAddr
+				rpt[2] = HI_UINT16( attr[2].attrID );
+				rpt[3] = attr[2].attrData[0];																	// endPoint
+				rpt[4] = attr[0].attrData[0];																	// temperature
+				rpt[5] = attr[0].attrData[1];																	// humidity
+				rpt[6] = attr[1].attrData[0];																	// heating
+				rpt[7] = attr[1].attrData[1];																	// cooling
+				ZCMD_SendFrame( ZCMD_OP_RPT_ROUTER, rpt, sizeof( rpt ) );
+			}
+			else
+			{
+				UART_LineStart			(&line, "@ZBR:");
+				UART_LineAddNum			(&line, msg_RSSI);																			// RSSI
+				UART_LineAddChar		(&line, ';');
+				UART_LineAddNum			(&line, attr[2].attrID);							// shortAddr
+				UART_LineAddChar		(&line, ';');
+				UART_LineAddNum			(&line, attr[2].attrData[0]);						// endPoint
+				UART_LineAddChar		(&line, ';');
+				UART_LineAddNum			(&line, attr[0].attrData[0]);					// temperature
+				UART_LineAddChar		(&line, ';');
+				UART_LineAddNum			(&line, attr[0].attrData[1]);					// humidity
+				UART_LineAddChar		(&line, ';');
+				UART_LineAddNum			(&line, attr[1].attrData[0]);					// heating
+				UART_LineAddChar		(&line, ';');
+				UART_LineAddNum			(&line, attr[1].attrData[1]);					// cooling
+				UART_LineAddChar		(&line, '!');
+				UART_ZCmdPrintLine	(HAL_UART_PORT_0, &line);
+			}
+		}
+		else
+		{
+			return;
+		}
+
+		// Slide the window past the records just handled and top it up
+		numAttr -= used;
+		for ( i = 0; i < numAttr; i++ )
+		{
+			attr[i] = attr[i + used];
+		}
+		while ( ( numAttr < 3 ) && zclReportIterNext( pIter, &attr[numAttr] ) )
+		{
+			numAttr++;
+		}
+
+		if ( numAttr == 0 )
+		{
+			return;
+		}
+	}
+}
+#endif
 #endif  // ZCL_REPORT
 
 /*********************************************************************
@@ -1656,13 +1860,6 @@ void zclSampleThermostat_BindingProcess(void)
 static void zclSampleThermostat_RollCall(void)
 {
 
-	afAddrType_t RollCall_DstAddr;
-	// Set destination address to ZB Coordinator
-  RollCall_DstAddr.addrMode = (afAddrMode_t)Addr16Bit;
-  RollCall_DstAddr.endPoint = 8;
-  RollCall_DstAddr.addr.shortAddr = 0;
-	
-	zclReportCmd_t *pReportCmd;
 	uint16 src_coordShortAddr = NLME_GetCoordShortAddr();
 	uint8 device_type = 0;
 
@@ -1685,6 +1882,17 @@ static void zclSampleThermostat_RollCall(void)
 			break;
 	}
 	
+	#ifdef ROUTER
+	// Rides along with the children reports of this window
+	AGGR_AddRollCall( src_coordShortAddr, device_type );
+	#else
+	afAddrType_t RollCall_DstAddr;
+	// Set destination address to ZB Coordinator
+  RollCall_DstAddr.addrMode = (afAddrMode_t)Addr16Bit;
+  RollCall_DstAddr.endPoint = 8;
+  RollCall_DstAddr.addr.shortAddr = 0;
+	
+	zclReportCmd_t *pReportCmd;
 	pReportCmd = osal_mem_alloc( sizeof(zclReportCmd_t) + 2 * sizeof(zclReport_t) );
 	if ( pReportCmd != NULL )
 	{
@@ -1703,6 +1911,7 @@ static void zclSampleThermostat_RollCall(void)
 	}
 
 	osal_mem_free( pReportCmd );
+	#endif
 }
 #endif
 
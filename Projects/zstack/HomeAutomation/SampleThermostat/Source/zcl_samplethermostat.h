@@ -78,6 +78,7 @@ extern "C"
 #define SAMPLETHERMOSTAT_JOIN_SETUP_EVT								0x0020
 #define SAMPLETHERMOSTAT_UART_REPLY_CMD_EVT						0x0040
 #define SAMPLETHERMOSTAT_CHECK_SYSTEM_EVT								0x0080
+#define SAMPLETHERMOSTAT_RPT_FLUSH_EVT									0x0100		// Router: report aggregation window closed
 
 
 // Application Display Modes
@@ -341,10 +341,11 @@ const cId_t zclSampleThermostat_InClusterList[ZCLSAMPLETHERMOSTAT_MAX_INCLUSTERS
   ZCL_CLUSTER_ID_HVAC_THERMOSTAT
 };
 
-#define ZCLSAMPLETHERMOSTAT_MAX_OUTCLUSTERS       1
+#define ZCLSAMPLETHERMOSTAT_MAX_OUTCLUSTERS       2
 const cId_t zclSampleThermostat_OutClusterList[ZCLSAMPLETHERMOSTAT_MAX_OUTCLUSTERS] =
 {
-  ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT
+  ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT,
+  ZCL_CLUSTER_ID_MS_RELATIVE_HUMIDITY
 };
 
 SimpleDescriptionFormat_t zclSampleThermostat_SimpleDesc =
@@ -0,0 +1,109 @@
+/**************************************************************************************************
+  Filename:       OSAL_Host.c
+
+  Description:    This file contains all the settings and other functions that the user should
+                  set and change for the host simulation build.
+
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+#include "ZComDef.h"
+#include "hal_drivers.h"
+#include "OSAL.h"
+#include "OSAL_Tasks.h"
+
+#include "MT.h"
+#include "MT_UART.h"
+
+#include "zcl.h"
+#include "zcl_ota.h"
+#include "host_app.h"
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+static uint16 hostMt_ProcessEvent( uint8 task_id, uint16 events );
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+// The order in this table must be identical to the task initialization calls below in osalInitTask.
+const pTaskEventHandlerFn tasksArr[] = {
+  Hal_ProcessEvent,
+  zcl_event_loop,
+  hostApp_event_loop,
+  hostMt_ProcessEvent,
+  zclOTA_event_loop
+};
+
+const uint8 tasksCnt = sizeof( tasksArr ) / sizeof( tasksArr[0] );
+uint16 *tasksEvents;
+
+// MT task stand-in: MT_TASK.c is not built, its timers still need a task of their own
+uint8 MT_TaskID;
+
+/*********************************************************************
+ * FUNCTIONS
+ *********************************************************************/
+
+/*********************************************************************
+ * @fn      osalInitTasks
+ *
+ * @brief   This function invokes the initialization function for each task.
+ *
+ * @param   void
+ *
+ * @return  none
+ */
+void osalInitTasks( void )
+{
+  uint8 taskID = 0;
+
+  tasksEvents = (uint16 *)osal_mem_alloc( sizeof( uint16 ) * tasksCnt);
+  osal_memset( tasksEvents, 0, (sizeof( uint16 ) * tasksCnt));
+
+  Hal_Init( taskID++ );
+  zcl_Init( taskID++ );
+  hostApp_Init( taskID++ );
+  MT_TaskID = taskID++;
+  zclOTA_Init( taskID );
+
+  // There is no OTA server to discover or poll: downloads are started by the driver.
+  osal_stop_timerEx( taskID, ZCL_OTA_SEND_MATCH_DESCRIPTOR_EVT );
+  osal_stop_timerEx( taskID, ZCL_OTA_QUERY_SERVER_EVT );
+}
+
+/*********************************************************************
+ * @fn      hostMt_ProcessEvent
+ *
+ * @brief   Stands in for MT_ProcessEvent: handles the MT UART Tx flush
+ *          timer, the only MT event the host build raises.
+ *
+ * @param   task_id - MT_TaskID
+ * @param   events - events to process
+ *
+ * @return  unprocessed events
+ */
+static uint16 hostMt_ProcessEvent( uint8 task_id, uint16 events )
+{
+  (void)task_id;
+
+#if MT_UART_TX_COALESCE
+  if ( events & MT_UART_TX_FLUSH_EVT )
+  {
+    MT_UartTxFlush();
+    return (events ^ MT_UART_TX_FLUSH_EVT);
+  }
+#endif
+
+  // Discard unknown events
+  return 0;
+}
+
+/*********************************************************************
+*********************************************************************/
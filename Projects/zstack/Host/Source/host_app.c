@@ -0,0 +1,363 @@
+/**************************************************************************************************
+  Filename:       host_app.c
+
+  Description:    Application task of the host simulation build: a thermostat-like HA
+                  endpoint that serves a few attributes and consumes incoming reports.
+
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "ZComDef.h"
+#include "OSAL.h"
+#include "AF.h"
+
+#include "zcl.h"
+#include "zcl_general.h"
+#include "zcl_hvac.h"
+#include "zcl_ms.h"
+#include "zcl_ha.h"
+#include "zcl_ota.h"
+
+#include "zcl_samplethermostat.h"
+#include "MS_AGGR.h"
+#include "MS_SAMPLE.h"
+#include "MS_UART.h"
+#include "MS_UART_CMD.h"
+#include "MT.h"
+#include "MT_RPC.h"
+#include "MT_UART.h"
+
+#include "host_app.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define HOSTAPP_DEVICE_VERSION     0
+#define HOSTAPP_FLAGS              0
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+uint8 hostApp_TaskID;
+hostAppStats_t hostAppStats;
+
+int16 hostApp_MeasuredValue = 2150;     // 21.50 C
+int16 hostApp_LocalTemperature = 2150;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+static const uint8 hostApp_ZCLVersion = 1;
+static const int16 hostApp_MinMeasuredValue = -4000;
+static const int16 hostApp_MaxMeasuredValue = 12500;
+
+static CONST zclAttrRec_t hostApp_Attrs[HOSTAPP_MAX_ATTRIBUTES] =
+{
+  {
+    ZCL_CLUSTER_ID_GEN_BASIC,
+    { ATTRID_BASIC_ZCL_VERSION, ZCL_DATATYPE_UINT8, ACCESS_CONTROL_READ,
+      (void *)&hostApp_ZCLVersion }
+  },
+  {
+    ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT,
+    { ATTRID_MS_TEMPERATURE_MEASURED_VALUE, ZCL_DATATYPE_INT16,
+      ACCESS_CONTROL_READ | ACCESS_REPORTABLE, (void *)&hostApp_MeasuredValue }
+  },
+  {
+    ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT,
+    { ATTRID_MS_TEMPERATURE_MIN_MEASURED_VALUE, ZCL_DATATYPE_INT16, ACCESS_CONTROL_READ,
+      (void *)&hostApp_MinMeasuredValue }
+  },
+  {
+    ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT,
+    { ATTRID_MS_TEMPERATURE_MAX_MEASURED_VALUE, ZCL_DATATYPE_INT16, ACCESS_CONTROL_READ,
+      (void *)&hostApp_MaxMeasuredValue }
+  },
+  {
+    ZCL_CLUSTER_ID_HVAC_THERMOSTAT,
+    { ATTRID_HVAC_THERMOSTAT_LOCAL_TEMPERATURE, ZCL_DATATYPE_INT16,
+      ACCESS_CONTROL_READ | ACCESS_REPORTABLE, (void *)&hostApp_LocalTemperature }
+  },
+};
+
+static const cId_t hostApp_InClusterList[] =
+{
+  ZCL_CLUSTER_ID_GEN_BASIC,
+  ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT,
+  ZCL_CLUSTER_ID_HVAC_THERMOSTAT
+};
+
+static SimpleDescriptionFormat_t hostApp_SimpleDesc =
+{
+  HOSTAPP_ENDPOINT,                                           //  int Endpoint;
+  ZCL_HA_PROFILE_ID,                                          //  uint16 AppProfId[2];
+  ZCL_HA_DEVICEID_THERMOSTAT,                                 //  uint16 AppDeviceId[2];
+  HOSTAPP_DEVICE_VERSION,                                     //  int   AppDevVer:4;
+  HOSTAPP_FLAGS,                                              //  int   AppFlags:4;
+  sizeof( hostApp_InClusterList ) / sizeof( cId_t ),          //  byte  AppNumInClusters;
+  (cId_t *)hostApp_InClusterList,                             //  byte *pAppInClusterList;
+  sizeof( hostApp_InClusterList ) / sizeof( cId_t ),          //  byte  AppNumOutClusters;
+  (cId_t *)hostApp_InClusterList                              //  byte *pAppOutClusterList;
+};
+
+static endPointDesc_t hostApp_EpDesc;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+static void hostApp_ProcessIncomingMsg( zclIncomingMsg_t *pInMsg );
+static void hostApp_ProcessInReportCmd( zclIncomingMsg_t *pInMsg );
+
+/*********************************************************************
+ * @fn          hostApp_Init
+ *
+ * @brief       Initialization function for the host application task.
+ *
+ * @param       task_id - OSAL task id
+ *
+ * @return      none
+ */
+void hostApp_Init( byte task_id )
+{
+  hostApp_TaskID = task_id;
+
+  // All messages for the endpoint go through the ZCL first
+  hostApp_EpDesc.endPoint = HOSTAPP_ENDPOINT;
+  hostApp_EpDesc.task_id = &zcl_TaskID;
+  hostApp_EpDesc.simpleDesc = &hostApp_SimpleDesc;
+  hostApp_EpDesc.latencyReq = noLatencyReqs;
+  afRegister( &hostApp_EpDesc );
+
+  zcl_registerAttrList( HOSTAPP_ENDPOINT, HOSTAPP_MAX_ATTRIBUTES, hostApp_Attrs );
+
+  // Unprocessed foundation commands (e.g. reports) come here
+  zcl_registerForMsg( hostApp_TaskID );
+
+  // UART command set of the coordinator, woken up per received package
+  UART_Init( HAL_UART_PORT_0 );
+  UART_RegisterForFrames( HAL_UART_PORT_0, hostApp_TaskID, HOSTAPP_UART_CMD_EVT );
+
+  // OTA download results come here instead of resetting into the new image
+  zclOTA_Register( hostApp_TaskID );
+}
+
+/*********************************************************************
+ * @fn          hostApp_event_loop
+ *
+ * @brief       Event Loop Processor for the host application task.
+ *
+ * @param       task_id - task id
+ * @param       events - event bitmap
+ *
+ * @return      unprocessed events
+ */
+uint16 hostApp_event_loop( uint8 task_id, uint16 events )
+{
+  afIncomingMSGPacket_t *MSGpkt;
+
+  (void)task_id;  // Intentionally unreferenced parameter
+
+  if ( events & SYS_EVENT_MSG )
+  {
+    while ( (MSGpkt = (afIncomingMSGPacket_t *)osal_msg_receive( hostApp_TaskID )) )
+    {
+      switch ( MSGpkt->hdr.event )
+      {
+        case ZCL_INCOMING_MSG:
+          hostApp_ProcessIncomingMsg( (zclIncomingMsg_t *)MSGpkt );
+          break;
+
+        case AF_INCOMING_MSG_CMD:
+          hostAppStats.afMsgCnt++;
+          break;
+
+        case CMD_SERIAL_MSG:
+          {
+            uint8 *pFrame = ((mtOSALSerialData_t *)MSGpkt)->msg;
+
+            hostAppStats.mtFrameCnt++;
+            hostAppStats.mtFcsSum += MT_UartCalcFCS( pFrame, MT_RPC_FRAME_HDR_SZ + pFrame[MT_RPC_POS_LEN] );
+          }
+          break;
+
+        case ZCL_OTA_CALLBACK_IND:
+          if ( ((zclOTA_CallbackMsg_t *)MSGpkt)->ota_event == ZCL_OTA_START_CALLBACK )
+          {
+            hostAppStats.otaStartCnt++;
+          }
+          else if ( MSGpkt->hdr.status == ZSuccess )
+          {
+            hostAppStats.otaDoneCnt++;
+          }
+          else
+          {
+            hostAppStats.otaFailCnt++;
+          }
+          break;
+
+        default:
+          break;
+      }
+
+      // Release the memory
+      osal_msg_deallocate( (uint8 *)MSGpkt );
+    }
+
+    // return unprocessed events
+    return (events ^ SYS_EVENT_MSG);
+  }
+
+  if ( events & HOSTAPP_UART_CMD_EVT )
+  {
+    hostAppStats.uartEvtCnt++;
+
+    while ( UART_ParseRxPackage( HAL_UART_PORT_0 ) )
+    {
+      ZCMD_ReplyCMD();
+    }
+
+    return (events ^ HOSTAPP_UART_CMD_EVT);
+  }
+
+  if ( events & HOSTAPP_RPT_FLUSH_EVT )
+  {
+    hostAppStats.flushCnt += AGGR_Flush();
+
+    return (events ^ HOSTAPP_RPT_FLUSH_EVT);
+  }
+
+  if ( events & HOSTAPP_SENSOR_RPT_EVT )
+  {
+    // Stands in for the sensor's report, as zclSampleTemperatureSensor_SendTemp
+    hostAppStats.sensorRptCnt++;
+    SAMPLE_Reported();
+
+    return (events ^ HOSTAPP_SENSOR_RPT_EVT);
+  }
+
+  // Discard unknown events
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      hostApp_ProcessIncomingMsg
+ *
+ * @brief   Process ZCL Foundation incoming message
+ *
+ * @param   pInMsg - pointer to the received message
+ *
+ * @return  none
+ */
+static void hostApp_ProcessIncomingMsg( zclIncomingMsg_t *pInMsg )
+{
+  hostAppStats.msgCnt++;
+
+  switch ( pInMsg->zclHdr.commandID )
+  {
+#ifdef ZCL_REPORT
+    case ZCL_CMD_REPORT:
+      hostApp_ProcessInReportCmd( pInMsg );
+      break;
+#endif
+
+    default:
+      break;
+  }
+
+  if ( pInMsg->attrCmd )
+  {
+    osal_mem_free( pInMsg->attrCmd );
+  }
+}
+
+/*********************************************************************
+ * @fn      hostApp_ProcessInReportCmd
+ *
+ * @brief   Process the "Profile" Report Command
+ *
+ * @param   pInMsg - incoming message to process
+ *
+ * @return  none
+ */
+static void hostApp_ProcessInReportCmd( zclIncomingMsg_t *pInMsg )
+{
+  zclReportCmd_t *pInReportCmd = (zclReportCmd_t *)pInMsg->attrCmd;
+  uint8 i;
+
+  hostAppStats.reportCnt++;
+
+  for ( i = 0; i < pInReportCmd->numAttr; i++ )
+  {
+    zclReport_t *pRpt = &pInReportCmd->attrList[i];
+
+    hostAppStats.attrCnt++;
+
+    // MeasuredValue and LocalTemperature share attribute ID 0x0000
+    if ( (pRpt->attrID == ATTRID_MS_TEMPERATURE_MEASURED_VALUE) &&
+         (pRpt->dataType == ZCL_DATATYPE_INT16) && (pRpt->attrData != NULL) )
+    {
+      hostAppStats.lastTemp = (int16)BUILD_UINT16( pRpt->attrData[0], pRpt->attrData[1] );
+    }
+  }
+}
+
+#ifdef ZCL_REPORT
+/*********************************************************************
+ * @fn      hostApp_ReportCB
+ *
+ * @brief   Same as hostApp_ProcessInReportCmd, for reports handed over
+ *          in place by the ZCL once registered with zcl_registerReportCB.
+ *
+ * @param   pInMsg - incoming message to process
+ * @param   pIter - iterator over the attribute reports
+ *
+ * @return  none
+ */
+void hostApp_ReportCB( zclIncoming_t *pInMsg, zclReportIter_t *pIter )
+{
+  zclReportView_t rpt;
+
+  (void)pInMsg;  // Intentionally unreferenced parameter
+
+  hostAppStats.reportCnt++;
+
+  while ( zclReportIterNext( pIter, &rpt ) )
+  {
+    hostAppStats.attrCnt++;
+
+    // MeasuredValue and LocalTemperature share attribute ID 0x0000
+    if ( (rpt.attrID == ATTRID_MS_TEMPERATURE_MEASURED_VALUE) &&
+         (rpt.dataType == ZCL_DATATYPE_INT16) && (rpt.dataLen == 2) )
+    {
+      hostAppStats.lastTemp = (int16)BUILD_UINT16( rpt.attrData[0], rpt.attrData[1] );
+    }
+  }
+}
+#endif
+
+/*********************************************************************
+ * SAMPLE THERMOSTAT HOOKS
+ *
+ * The UART command handler in MY-SOURCE calls into the coordinator
+ * application; these count the calls instead of sending anything.
+ */
+
+void zclSampleThermostat_BindingProcess( void )
+{
+  hostAppStats.bindCnt++;
+}
+
+void zclSampleThermostat_SendFreeData( void )
+{
+  hostAppStats.freeDataCnt++;
+}
+
+void zclSampleThermostat_SendC( void )
+{
+  hostAppStats.freeDataCnt++;
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,93 @@
+/**************************************************************************************************
+  Filename:       host_app.h
+
+  Description:    Application task of the host simulation build: a thermostat-like HA
+                  endpoint that serves a few attributes and consumes incoming reports.
+
+**************************************************************************************************/
+
+#ifndef HOST_APP_H
+#define HOST_APP_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "zcl.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+#define HOSTAPP_ENDPOINT            8
+
+#define HOSTAPP_MAX_ATTRIBUTES      5
+
+// Task events
+#define HOSTAPP_UART_CMD_EVT        0x0001    // UART command package received
+#define HOSTAPP_RPT_FLUSH_EVT       0x0002    // Report aggregation window closed
+#define HOSTAPP_SENSOR_RPT_EVT      0x0004    // Filtered sensor reading due for a report
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+typedef struct
+{
+  uint32 msgCnt;        // ZCL_INCOMING_MSG messages handled
+  uint32 reportCnt;     // Report commands handled
+  uint32 attrCnt;       // Attribute records seen in reports
+  int16  lastTemp;      // Last reported MeasuredValue / LocalTemperature
+  uint32 bindCnt;       // zclSampleThermostat_BindingProcess calls
+  uint32 freeDataCnt;   // zclSampleThermostat_SendFreeData / SendC calls
+  uint32 uartEvtCnt;    // HOSTAPP_UART_CMD_EVT wake ups
+  uint32 flushCnt;      // Aggregated report frames sent on HOSTAPP_RPT_FLUSH_EVT
+  uint32 sensorRptCnt;  // Sensor reports requested by the sampling pipeline
+  uint32 afMsgCnt;      // AF_INCOMING_MSG_CMD for endpoints bound straight to the task
+  uint32 mtFrameCnt;    // MT frames (CMD_SERIAL_MSG) from the UART parser
+  uint32 mtFcsSum;      // Sum of the FCS of those frames, recomputed
+  uint32 otaStartCnt;   // OTA downloads started
+  uint32 otaDoneCnt;    // OTA downloads completed with a good image
+  uint32 otaFailCnt;    // OTA downloads aborted or with a bad image
+} hostAppStats_t;
+
+/*********************************************************************
+ * VARIABLES
+ */
+extern uint8 hostApp_TaskID;
+extern hostAppStats_t hostAppStats;
+
+extern int16 hostApp_MeasuredValue;
+extern int16 hostApp_LocalTemperature;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * Initialization for the task
+ */
+extern void hostApp_Init( byte task_id );
+
+/*
+ *  Event Process for the task
+ */
+extern UINT16 hostApp_event_loop( byte task_id, UINT16 events );
+
+#ifdef ZCL_REPORT
+/*
+ * In place report handler, for zcl_registerReportCB()
+ */
+extern void hostApp_ReportCB( zclIncoming_t *pInMsg, zclReportIter_t *pIter );
+#endif
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_APP_H */
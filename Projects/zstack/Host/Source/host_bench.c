@@ -0,0 +1,3426 @@
+/**************************************************************************************************
+  Filename:       host_bench.c
+
+  Description:    Micro-benchmarks of OSAL, AF and ZCL hot paths built natively for the host.
+                  Every benchmark runs the unmodified stack code against the simulated HAL and
+                  NWK, reports nanoseconds per operation and the OSAL heap figures, and checks
+                  that the operation actually had its effect so a broken path cannot look fast.
+
+                  Usage: host_bench [-n iterations] [-f flash_image] [-b name]
+
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ZComDef.h"
+#include "OSAL.h"
+#include "OSAL_Clock.h"
+#include "OSAL_Nv.h"
+#include "OSAL_Tasks.h"
+#include "OSAL_Timers.h"
+#include "AF.h"
+
+#include "zcl.h"
+#include "zcl_general.h"
+#include "zcl_hvac.h"
+#include "zcl_ms.h"
+#include "zcl_ha.h"
+#include "zcl_reporting.h"
+#include "zcl_ota.h"
+
+#include "MT.h"
+#include "MT_RPC.h"
+#include "MT_UART.h"
+
+#include "hal_drivers.h"
+#include "hal_host.h"
+#include "hal_ota.h"
+#include "hal_uart.h"
+
+#include "MS_AGGR.h"
+#include "MS_GLOBAL.h"
+#include "MS_SAMPLE.h"
+#include "MS_UART.h"
+#include "MS_UART_CMD.h"
+
+#include "host_app.h"
+#include "host_bench.h"
+#include "host_mtota.h"
+#include "host_nwk.h"
+
+#include "hal_aes.h"
+#include "ota_common.h"
+#include "ssp_hash.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+#define BENCH_DEFAULT_ITERATIONS   200000
+
+// Address and endpoint of the simulated remote sensor
+#define BENCH_PEER_ADDR            0x796F
+#define BENCH_PEER_EP              8
+
+// MT capture: frames that pass their FCS, and the sum of those FCS bytes
+#define BENCH_MT_FRAMES            6
+#define BENCH_MT_FCS_SUM           447
+
+// Bytes per UART callback for the split MT capture
+#define BENCH_MT_PIECE             7
+
+// AF incoming message indications per MT Tx burst
+#define BENCH_MT_IND_CNT           6
+
+// User NV item used by the NV benchmark (0x0401 - 0x0FFF is for applications)
+#define BENCH_NV_ITEM              0x0401
+#define BENCH_NV_LEN               8
+
+// Items rotated through by the NV directory benchmark, one written every BENCH_NVDIR_WR_RATE
+// reads so the pages fill up and get compacted, and an Id that is never created
+#define BENCH_NVDIR_ITEM           0x0410
+#define BENCH_NVDIR_CNT            24
+#define BENCH_NVDIR_LEN            16
+#define BENCH_NVDIR_WR_RATE        4
+#define BENCH_NVDIR_ABSENT         0x0FFE
+
+// Item of the NV journal benchmarks: a 4 byte counter followed by 14 byte records, as in the
+// binding table, and the app task event whose handler makes deferred writes to it
+#define BENCH_NVJRN_ITEM           0x0440
+#define BENCH_NVJRN_LEN            64
+#define BENCH_NVJRN_REC            14
+#define BENCH_NVJRN_RECS           3
+#define BENCH_NVJRN_BUMPS          4
+#define BENCH_NVJRN_EVT            0x0100
+
+// Endpoint of the attribute list of the lookup benchmark
+#define BENCH_FIND_EP              0xF0
+
+// Messages left waiting for the HAL and ZCL tasks by the message backlog benchmark
+#define BENCH_MSGQ_BACKLOG         48
+
+// Number of timers kept running by the timer benchmarks (one per app event bit)
+#define BENCH_TIMER_CNT            16
+
+// Events of the app task run from the event handler table benchmark
+#define BENCH_TABLE_EVTS           0x0F00
+
+// Event used for the extra start/stop timer of the timer operations benchmark
+#define BENCH_TIMER_EXTRA_EVT      0x4000
+
+// Children behind the router of the aggregation benchmarks, each sending
+// a sensor and a running state report per roll call window
+#define BENCH_AGGR_CHILDREN        8
+#define BENCH_AGGR_REPORTS         (1 + 2 * BENCH_AGGR_CHILDREN)
+
+// Endpoints registered with a descriptor callback by the AF Rx benchmark,
+// the first BENCH_AF_GRP_CNT of them members of BENCH_AF_GROUP
+#define BENCH_AF_EP                0x20
+#define BENCH_AF_EP_CNT            6
+#define BENCH_AF_GROUP             0x0B0B
+#define BENCH_AF_GRP_CNT           4
+
+// Sensor stream of the sampling benchmark: 1 C of jitter and a glitched read
+// every 16 samples, around a temperature stepping by 3 C every 64 samples
+#define BENCH_SAMPLE_STEP          64
+#define BENCH_SAMPLE_GLITCH        16
+
+// OTA server of the download benchmark: a 4 KB image over a 20 ms each way
+// link, 6 ms of server time per block and every 50th block response lost
+#define BENCH_OTA_SRV_ADDR         0x4F2A
+#define BENCH_OTA_SRV_EP           1
+#define BENCH_OTA_VERSION          2
+#define BENCH_OTA_IMG_LEN          4096
+#define BENCH_OTA_BLOCKS           ( BENCH_OTA_IMG_LEN / OTA_MAX_MTU )
+#define BENCH_OTA_LINK_MS          20
+#define BENCH_OTA_SRV_MS           6
+#define BENCH_OTA_LOSS             50
+#define BENCH_OTA_QUEUE            16
+#define BENCH_OTA_MAX_MS           600000
+#define BENCH_OTA_CAPS             9
+
+// Clients of the OTA server benchmark: the same image to each, downloads
+// started BENCH_OTA_SRV_STAGGER_MS apart, one block request at a time and
+// asked again if not answered in BENCH_OTA_SRV_RETRY_MS
+#define BENCH_OTA_SRV_CLIENTS      4
+#define BENCH_OTA_SRV_CLIENT       0x2201
+#define BENCH_OTA_SRV_STAGGER_MS   30
+#define BENCH_OTA_SRV_RETRY_MS     1000
+
+// ... and again with every 5th console reply to a file read lost
+#define BENCH_OTA_SRV_LOSE         5
+
+// ... and with every 7th console file read returning half the bytes asked for
+#define BENCH_OTA_SRV_CUT          7
+
+// Multicast download: the image streamed by the OTA server to a group with
+// every 8th block lost, then the gaps filled unicast by the simulated server;
+// air time is reported for a fleet of BENCH_OTA_MCAST_FLEET devices
+#define BENCH_OTA_GROUP            0x0A7A
+#define BENCH_OTA_MCAST_LOSS       8
+#define BENCH_OTA_MCAST_FLEET      20
+
+// ... and again with 3 blocks the console cannot read and aborts sent to the group
+#define BENCH_OTA_MCAST_BAD_OFFSET ( BENCH_OTA_IMG_LEN / 2 )
+#define BENCH_OTA_MCAST_BAD_LEN    ( 3 * OTA_MAX_MTU )
+
+// MMO hash benchmark: a 128 byte message in 3 updates, the middle one an
+// OTA block; lengths checked against the reference around the end of the
+// short length padding (2^16 bits) as well as from 0 on
+#define BENCH_MMO_MSG_LEN          128
+#define BENCH_MMO_UPD_1            40
+#define BENCH_MMO_UPD_2            OTA_MAX_MTU
+#define BENCH_MMO_CHK_LEN          300
+#define BENCH_MMO_CHK_LONG         8184
+#define BENCH_MMO_CHK_LONG_END     8200
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef struct
+{
+  const char *name;
+  const char *desc;
+  uint8 (*run)( uint32 iterations );   // Returns FALSE if the effect check failed
+} benchItem_t;
+
+// Response of the simulated OTA server still on its way to the client
+typedef struct
+{
+  uint32 due;                          // System clock (ms) at which it arrives
+  uint32 offset;
+  uint16 group;                        // Group it was streamed to, 0 if unicast
+  uint8 len;
+  uint8 cmd;                           // COMMAND_IMAGE_BLOCK_RSP or COMMAND_UPGRADE_END_RSP
+  uint8 status;                        // Of a block response
+} benchOtaRsp_t;
+
+// Known answer of the MMO hash, ZigBee spec Annex C.5 and a 65528 / 65536 bit
+// message of bytes counting up from 0
+typedef struct
+{
+  uint16 len;
+  uint8 first;                         // Value of the first byte, the rest count up from it
+  uint8 digest[SSP_MMO_HASH_LEN];
+} benchMmoVector_t;
+
+// Client of the simulated OTA server
+typedef struct
+{
+  uint32 due;                          // System clock (ms) at which its next request, or
+                                       // the retry of an unanswered one, arrives
+  uint32 offset;                       // Next block wanted, 0 until the query is answered
+  uint8 queried;
+} benchOtaClient_t;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Report of MeasuredValue and MinMeasuredValue from a temperature sensor
+static uint8 benchReportFrame[] =
+{
+  0x18,                         // Profile wide, server to client, no default response
+  0x00,                         // Sequence number
+  ZCL_CMD_REPORT,
+  LO_UINT16( ATTRID_MS_TEMPERATURE_MEASURED_VALUE ), HI_UINT16( ATTRID_MS_TEMPERATURE_MEASURED_VALUE ),
+  ZCL_DATATYPE_INT16, 0x66, 0x08,                 // 21.50 C
+  LO_UINT16( ATTRID_MS_TEMPERATURE_MIN_MEASURED_VALUE ), HI_UINT16( ATTRID_MS_TEMPERATURE_MIN_MEASURED_VALUE ),
+  ZCL_DATATYPE_INT16, 0x60, 0xF0,                 // -40.00 C
+};
+
+// Read of MeasuredValue, MinMeasuredValue and MaxMeasuredValue
+static uint8 benchReadFrame[] =
+{
+  0x00,                         // Profile wide, client to server
+  0x00,                         // Sequence number
+  ZCL_CMD_READ,
+  LO_UINT16( ATTRID_MS_TEMPERATURE_MEASURED_VALUE ), HI_UINT16( ATTRID_MS_TEMPERATURE_MEASURED_VALUE ),
+  LO_UINT16( ATTRID_MS_TEMPERATURE_MIN_MEASURED_VALUE ), HI_UINT16( ATTRID_MS_TEMPERATURE_MIN_MEASURED_VALUE ),
+  LO_UINT16( ATTRID_MS_TEMPERATURE_MAX_MEASURED_VALUE ), HI_UINT16( ATTRID_MS_TEMPERATURE_MAX_MEASURED_VALUE ),
+};
+
+// Configure Reporting of MeasuredValue: 1 s min, 60 s max, 0.50 C change
+static uint8 benchCfgReportFrame[] =
+{
+  0x00,                         // Profile wide, client to server
+  0x00,                         // Sequence number
+  ZCL_CMD_CONFIG_REPORT,
+  ZCL_SEND_ATTR_REPORTS,
+  LO_UINT16( ATTRID_MS_TEMPERATURE_MEASURED_VALUE ), HI_UINT16( ATTRID_MS_TEMPERATURE_MEASURED_VALUE ),
+  ZCL_DATATYPE_INT16,
+  LO_UINT16( 1 ), HI_UINT16( 1 ),
+  LO_UINT16( 60 ), HI_UINT16( 60 ),
+  LO_UINT16( 50 ), HI_UINT16( 50 ),
+};
+
+// Router data report line as printed by the coordinator
+static const char benchUartRptText[] = "@ZBR:-67;31087;8;21;54;1;0!\r\n";
+
+// UART command with data, the last one of the old keyword chain
+static const uint8 benchUartAsciiCmd[] = "@ZBC=LED1ON!";
+
+// Same command in the binary framing, FCS filled in by benchUartBin
+static uint8 benchUartBinCmd[ZCMD_FRAME_OVERHEAD + 6] =
+{
+  ZCMD_SOF, 6, ZCMD_OP_SEND_C, 'L', 'E', 'D', '1', 'O', 'N', 0x00, 0x00
+};
+
+// MT traffic recorded from a host tool on the ZTool port: line noise,
+// a burst of requests and a corrupted copy of one of them
+static const uint8 benchMtCapture[] =
+{
+  // Line noise
+  0x00, 0x55,
+  // SYS_PING
+  0xFE, 0x00, 0x21, 0x01, 0x20,
+  // AF_DATA_REQUEST, report to 0x796F
+  0xFE, 0x17, 0x24, 0x01, 0x6F, 0x79, 0x08, 0x08, 0x02, 0x04, 0x07, 0x00,
+  0x0F, 0x0D, 0x18, 0x07, 0x0A, 0x00, 0x00, 0x29, 0x6A, 0x08, 0x12, 0x00,
+  0x21, 0x36, 0x00, 0x7C,
+  // SYS_OSAL_NV_READ 0x0401
+  0xFE, 0x03, 0x21, 0x08, 0x01, 0x04, 0x00, 0x2F,
+  // Same, FCS corrupted: dropped
+  0xFE, 0x03, 0x21, 0x08, 0x01, 0x04, 0x00, 0x2E,
+  // SYS_OSAL_NV_WRITE 0x0401, 16 bytes
+  0xFE, 0x14, 0x21, 0x09, 0x01, 0x04, 0x00, 0x10, 0x30, 0x31, 0x32, 0x33,
+  0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0x3E, 0x3F,
+  0x29,
+  // ZDO_MGMT_LQI_REQ 0x796F
+  0xFE, 0x03, 0x25, 0x31, 0x6F, 0x79, 0x00, 0x01,
+  // AF_DATA_REQUEST_EXT, 64 bytes
+  0xFE, 0x54, 0x24, 0x02, 0x02, 0x6F, 0x79, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x08, 0x34, 0x12, 0x08, 0x00, 0x02, 0x07, 0x00, 0x0F, 0x40, 0x00,
+  0x00, 0x07, 0x0E, 0x15, 0x1C, 0x23, 0x2A, 0x31, 0x38, 0x3F, 0x46, 0x4D,
+  0x54, 0x5B, 0x62, 0x69, 0x70, 0x77, 0x7E, 0x85, 0x8C, 0x93, 0x9A, 0xA1,
+  0xA8, 0xAF, 0xB6, 0xBD, 0xC4, 0xCB, 0xD2, 0xD9, 0xE0, 0xE7, 0xEE, 0xF5,
+  0xFC, 0x03, 0x0A, 0x11, 0x18, 0x1F, 0x26, 0x2D, 0x34, 0x3B, 0x42, 0x49,
+  0x50, 0x57, 0x5E, 0x65, 0x6C, 0x73, 0x7A, 0x81, 0x88, 0x8F, 0x96, 0x9D,
+  0xA4, 0xAB, 0xB2, 0xB9, 0xCA,
+};
+
+// AF_INCOMING_MSG indication of a temperature report, FCS filled in by benchMtTx
+static uint8 benchMtAfInd[] =
+{
+  MT_UART_SOF, 28, 0x44, 0x81,
+  0x00, 0x00,                   // Group ID
+  0x02, 0x04,                   // Cluster ID
+  0x6F, 0x79,                   // Source address
+  0x08, 0x08,                   // Source, destination endpoint
+  0x00, 0xD4, 0x00,             // Broadcast, LQI, security
+  0x00, 0x00, 0x00, 0x00,       // Timestamp
+  0x00, 0x08,                   // Transaction sequence number, data length
+  0x18, 0x07, 0x0A, 0x00, 0x00, 0x29, 0x6A, 0x08,
+  0x6F, 0x79,                   // MAC source address
+  0x0F,                         // Radius
+  0x00                          // FCS
+};
+
+// OTA image served by the download benchmark, built by benchOtaImageInit
+static uint8 benchOtaImage[BENCH_OTA_IMG_LEN];
+
+// Responses in flight, server busy until, block requests seen
+static benchOtaRsp_t benchOtaQueue[BENCH_OTA_QUEUE];
+static uint8 benchOtaQueued;
+static uint32 benchOtaSrvFree;
+static uint32 benchOtaReqCnt;
+
+// Throughput (bytes per simulated second) per block window cap
+static uint8 benchOtaWin[BENCH_OTA_CAPS];
+static uint32 benchOtaRate[BENCH_OTA_CAPS];
+static uint8 benchOtaWinCnt;
+
+// OTA server benchmark: clients, answers gone wrong, waits, aggregate
+// throughput (bytes per simulated second) and console reads per round
+static benchOtaClient_t benchOtaClient[BENCH_OTA_SRV_CLIENTS];
+static uint8 benchOtaSrvBad;
+static uint32 benchOtaSrvWaits;
+static uint32 benchOtaSrvRate;
+static uint32 benchOtaSrvReads;
+
+// Multicast download: blocks streamed, lost and asked for unicast, per download
+static uint8 benchOtaMcastBad;
+static uint32 benchOtaMcastSent;
+static uint32 benchOtaMcastLost;
+static uint32 benchOtaMcastReqs;
+
+// Lost streamed blocks come back as aborts sent to the group
+static uint8 benchOtaMcastAbort;
+
+// FIPS-197 Appendix C.1 AES-128 key, plaintext and ciphertext
+static const uint8 benchAesKey[KEY_BLENGTH] =
+{
+  0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F
+};
+static const uint8 benchAesPlain[STATE_BLENGTH] =
+{
+  0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF
+};
+static const uint8 benchAesCipher[STATE_BLENGTH] =
+{
+  0x69, 0xC4, 0xE0, 0xD8, 0x6A, 0x7B, 0x04, 0x30, 0xD8, 0xCD, 0xB7, 0x80, 0x70, 0xB4, 0xC5, 0x5A
+};
+
+static const benchMmoVector_t benchMmoVectors[] =
+{
+  { 0,    0x00, { 0xBA, 0xD7, 0x8E, 0x72, 0x6C, 0x1E, 0xC0, 0x2B,
+                  0x7E, 0xBF, 0xE9, 0x2B, 0x23, 0xD9, 0xEC, 0x34 } },
+  { 1,    0xC0, { 0xAE, 0x3A, 0x10, 0x2A, 0x28, 0xD4, 0x3E, 0xE0,
+                  0xD4, 0xA0, 0x9E, 0x22, 0x78, 0x8B, 0x20, 0x6C } },
+  { 16,   0xC0, { 0xA7, 0x97, 0x7E, 0x88, 0xBC, 0x0B, 0x61, 0xE8,
+                  0x21, 0x08, 0x27, 0x10, 0x9A, 0x22, 0x8F, 0x2D } },
+  { 8191, 0x00, { 0x24, 0xEC, 0x2F, 0xE7, 0x5B, 0xBF, 0xFC, 0xB3,
+                  0x47, 0x89, 0xBC, 0x06, 0x10, 0xE7, 0xF1, 0x65 } },
+  { 8192, 0x00, { 0xDC, 0x6B, 0x06, 0x87, 0xF0, 0x9F, 0x86, 0x07,
+                  0x13, 0x1C, 0x17, 0x0B, 0x3B, 0xD3, 0x15, 0x91 } },
+};
+
+// Message of the MMO benchmarks and buffers for the checks
+static uint8 benchMmoMsg[BENCH_MMO_CHK_LONG_END];
+static uint8 benchMmoPad[BENCH_MMO_CHK_LONG_END + 2 * SSP_MMO_HASH_LEN];
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+static uint8 benchMsg( uint32 iterations );
+static uint8 benchMsgBacklog( uint32 iterations );
+static uint8 benchMem( uint32 iterations );
+static uint8 benchTimers( uint32 iterations );
+static uint8 benchTimerOps( uint32 iterations );
+static uint8 benchEvent( uint32 iterations );
+static uint8 benchEventTable( uint32 iterations );
+static uint8 benchNv( uint32 iterations );
+static uint8 benchNvDir( uint32 iterations );
+static uint8 benchNvJrn( uint32 iterations );
+static uint8 benchNvDefer( uint32 iterations );
+static uint8 benchZclParse( uint32 iterations );
+static uint8 benchZclIter( uint32 iterations );
+static uint8 benchZclReport( uint32 iterations );
+static uint8 benchZclReportView( uint32 iterations );
+static uint8 benchZclRead( uint32 iterations );
+static uint8 benchZclSend( uint32 iterations );
+static uint8 benchZclFind( uint32 iterations );
+static uint8 benchZclReporting( uint32 iterations );
+static uint8 benchAfRx( uint32 iterations );
+static uint8 benchUartCmd( uint32 iterations );
+static uint8 benchUartBin( uint32 iterations );
+static uint8 benchUartSplit( uint32 iterations );
+static uint8 benchUartRptCalls( uint32 iterations );
+static uint8 benchUartRptLine( uint32 iterations );
+static uint8 benchMtBurst( uint32 iterations );
+static uint8 benchMtSplit( uint32 iterations );
+static uint8 benchMtTx( uint32 iterations );
+static uint8 benchRptDirect( uint32 iterations );
+static uint8 benchRptAggr( uint32 iterations );
+static uint8 benchSample( uint32 iterations );
+static uint8 benchOtaDl( uint32 iterations );
+static uint8 benchOtaBlocks( uint32 iterations );
+static uint8 benchOtaSrv( uint32 iterations );
+static uint8 benchOtaSrvLost( uint32 iterations );
+static uint8 benchOtaSrvCut( uint32 iterations );
+static uint8 benchOtaMcast( uint32 iterations );
+static uint8 benchOtaMcastErr( uint32 iterations );
+static uint8 benchMmo( uint32 iterations );
+static uint8 benchMmoRef( uint32 iterations );
+
+static const benchItem_t benchItems[] =
+{
+  { "osal_msg",    "allocate/send/receive/deallocate a 16 byte message",  benchMsg },
+  { "osal_msgq",   "same round trip behind 48 messages for other tasks",  benchMsgBacklog },
+  { "osal_mem",    "mixed size alloc/free, 8 blocks live",                benchMem },
+  { "osal_timer",  "1 ms clock tick, 16 timers armed, half reloading",   benchTimers },
+  { "osal_tmr_ops", "restart 1 of 16 armed timers + start/stop another", benchTimerOps },
+  { "osal_event",  "set event + osal_run_system dispatch",                benchEvent },
+  { "osal_evt_tbl", "4 events + 1 HAL event, handler table, 2 dispatches", benchEventTable },
+  { "osal_nv",     "8 byte osal_nv_write + osal_nv_read",                 benchNv },
+  { "nv_dir",      "read 1 of 24 items + 1 absent Id, write 1 in 4, reboot", benchNvDir },
+  { "nv_jrn",      "4 byte counter write + read in a 64 byte item, reboot", benchNvJrn },
+  { "nv_defer",    "event: 4 counter bumps + 1 record, deferred writes",  benchNvDefer },
+  { "zcl_parse",   "zclParseInReportCmd, 2 attributes",                   benchZclParse },
+  { "zcl_iter",    "zclReportIterNext over the same 2 attributes",        benchZclIter },
+  { "zcl_report",  "AF ingress of a report up to the app task",           benchZclReport },
+  { "zcl_rpt_view", "AF ingress of a report to the app's report callback", benchZclReportView },
+  { "zcl_read",    "AF ingress of a read + read response out",            benchZclRead },
+  { "zcl_send",    "zcl_SendReportCmd, 2 int16 attributes, to the network", benchZclSend },
+  { "zcl_find",    "zclFindAttrRec, 5 of 22 attributes + 1 unknown",      benchZclFind },
+  { "zcl_rpt_cfg", "1 s of sensor noise, a reportable step every 4 s",    benchZclReporting },
+  { "af_rx",       "unicast to the 1st of 7 endpoints + group of 4, desc CB", benchAfRx },
+  { "uart_cmd",    "UART Rx of an ASCII \"@ZBC=...!\" command + reply",    benchUartCmd },
+  { "uart_bin",    "UART Rx of the same command as a binary frame + reply", benchUartBin },
+  { "uart_split",  "ASCII command arriving in 3 byte pieces, 1 wake up",  benchUartSplit },
+  { "uart_fields", "@ZBR report line, one UART call per field",          benchUartRptCalls },
+  { "uart_line",   "@ZBR report line formatted into one buffer",         benchUartRptLine },
+  { "mt_burst",    "MT capture, 7 frames + noise, in one UART callback",  benchMtBurst },
+  { "mt_split",    "same capture arriving in 7 byte pieces",              benchMtSplit },
+  { "mt_tx",       "6 AF incoming indications out on the MT UART",        benchMtTx },
+  { "rpt_direct",  "roll call + 8 children x 2 reports, one unicast each", benchRptDirect },
+  { "rpt_aggr",    "same window aggregated into MTU bounded reports",     benchRptAggr },
+  { "sensor_filt", "noisy DHT11 read, median + EMA, report on delta/max", benchSample },
+  { "ota_dl",      "4 KB OTA image, 46 ms round trip, 1 in 50 lost",      benchOtaDl },
+  { "ota_blocks",  "same image, in order block responses, per block",    benchOtaBlocks },
+  { "ota_srv",     "OTA server, 4 clients fetching the same 4 KB image",  benchOtaSrv },
+  { "ota_srv_lost", "same, 1 in 5 console read replies lost",             benchOtaSrvLost },
+  { "ota_srv_cut",  "same, 1 in 7 console reads cut to half",             benchOtaSrvCut },
+  { "ota_mcast",   "4 KB image streamed to a group, 1 in 8 lost, gaps unicast", benchOtaMcast },
+  { "ota_mc_err",  "same, 3 blocks unreadable, 1 in 8 replaced by an abort", benchOtaMcastErr },
+  { "mmo",         "MMO hash of 128 bytes in 3 updates, init to digest",   benchMmo },
+  { "mmo_ref",     "same hash, padded copy of the message, one shot",      benchMmoRef },
+};
+
+#define BENCH_ITEM_CNT  (sizeof( benchItems ) / sizeof( benchItems[0] ))
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      hostBenchNow
+ *
+ * @brief   Monotonic wall clock in nanoseconds.
+ *
+ * @param   none
+ *
+ * @return  time stamp
+ */
+uint64_t hostBenchNow( void )
+{
+  struct timespec ts;
+
+  (void)clock_gettime( CLOCK_MONOTONIC, &ts );
+
+  return ( (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec );
+}
+
+/*********************************************************************
+ * @fn      hostBenchRunUntilIdle
+ *
+ * @brief   Run the OSAL scheduler until no task has an event pending.
+ *
+ * @param   none
+ *
+ * @return  Number of task invocations made
+ */
+uint32 hostBenchRunUntilIdle( void )
+{
+  uint32 runs = 0;
+  uint8 idx;
+
+  for ( ;; )
+  {
+    for ( idx = 0; idx < tasksCnt; idx++ )
+    {
+      if ( tasksEvents[idx] )
+      {
+        break;
+      }
+    }
+
+    if ( idx == tasksCnt )
+    {
+      return ( runs );
+    }
+
+    osal_run_system();
+    runs++;
+  }
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      benchMsg
+ *
+ * @brief   Message round trip through the OSAL queue.
+ */
+static uint8 benchMsg( uint32 iterations )
+{
+  uint32 cnt = 0;
+  uint8 *pMsg;
+
+  while ( iterations-- )
+  {
+    pMsg = osal_msg_allocate( 16 );
+    if ( pMsg == NULL )
+    {
+      return ( FALSE );
+    }
+    (void)osal_msg_send( hostApp_TaskID, pMsg );
+
+    pMsg = osal_msg_receive( hostApp_TaskID );
+    if ( pMsg != NULL )
+    {
+      cnt++;
+      (void)osal_msg_deallocate( pMsg );
+    }
+  }
+  (void)osal_clear_event( hostApp_TaskID, SYS_EVENT_MSG );
+
+  return ( cnt != 0 );
+}
+
+/*********************************************************************
+ * @fn      benchMsgBacklog
+ *
+ * @brief   Message round trip of the app task while the HAL and ZCL
+ *          tasks have a backlog of ZCL_INCOMING_MSG, AF_DATA_CONFIRM_CMD
+ *          and CMD_SERIAL_MSG messages they did not get to yet. The
+ *          backlog is then checked with osal_msg_count/osal_msg_find and
+ *          drained in the order it was sent.
+ */
+static uint8 benchMsgBacklog( uint32 iterations )
+{
+  static const uint8 events[] = { ZCL_INCOMING_MSG, AF_DATA_CONFIRM_CMD, CMD_SERIAL_MSG };
+  uint8 tasks[2];
+  uint32 cnt = 0;
+  uint32 expect = iterations;
+  osal_event_hdr_t *pEvt;
+  uint8 *pMsg;
+  uint8 seq[2] = { 0, 0 };
+  uint8 idx;
+  uint8 ok = TRUE;
+
+  tasks[0] = Hal_TaskID;
+  tasks[1] = zcl_TaskID;
+
+  // Backlog sent round robin: task idx & 1, event idx % 3, sequence number
+  for ( idx = 0; idx < BENCH_MSGQ_BACKLOG; idx++ )
+  {
+    pEvt = (osal_event_hdr_t *)osal_msg_allocate( sizeof( osal_event_hdr_t ) + 1 );
+    if ( pEvt == NULL )
+    {
+      return ( FALSE );
+    }
+    pEvt->event = events[idx % 3];
+    pEvt->status = 0;
+    ((uint8 *)( pEvt + 1 ))[0] = idx;
+    (void)osal_msg_send( tasks[idx & 1], (uint8 *)pEvt );
+  }
+
+  while ( iterations-- )
+  {
+    pEvt = (osal_event_hdr_t *)osal_msg_allocate( sizeof( osal_event_hdr_t ) );
+    if ( pEvt == NULL )
+    {
+      return ( FALSE );
+    }
+    pEvt->event = ZCL_INCOMING_MSG;
+    (void)osal_msg_send( hostApp_TaskID, (uint8 *)pEvt );
+
+    pMsg = osal_msg_receive( hostApp_TaskID );
+    if ( pMsg != NULL )
+    {
+      cnt++;
+      (void)osal_msg_deallocate( pMsg );
+    }
+  }
+
+  // 48 messages, 24 per task, 8 of each event per task
+  for ( idx = 0; idx < 2; idx++ )
+  {
+    if ( ( osal_msg_count( tasks[idx], 0xFF ) != BENCH_MSGQ_BACKLOG / 2 ) ||
+         ( osal_msg_count( tasks[idx], CMD_SERIAL_MSG ) != BENCH_MSGQ_BACKLOG / 6 ) ||
+         ( osal_msg_find( tasks[idx], AF_DATA_CONFIRM_CMD ) == NULL ) )
+    {
+      ok = FALSE;
+    }
+  }
+
+  for ( idx = 0; idx < 2; idx++ )
+  {
+    seq[idx] = idx;
+    while ( ( pMsg = osal_msg_receive( tasks[idx] ) ) != NULL )
+    {
+      if ( ( pMsg[sizeof( osal_event_hdr_t )] != seq[idx] ) ||
+           ( ((osal_event_hdr_t *)pMsg)->event != events[seq[idx] % 3] ) )
+      {
+        ok = FALSE;
+      }
+      seq[idx] += 2;
+      (void)osal_msg_deallocate( pMsg );
+    }
+  }
+
+  (void)osal_clear_event( hostApp_TaskID, SYS_EVENT_MSG );
+
+  return ( ok && ( cnt == expect ) && ( seq[0] == BENCH_MSGQ_BACKLOG ) &&
+           ( seq[1] == BENCH_MSGQ_BACKLOG + 1 ) && ( osal_msg_count( hostApp_TaskID, 0xFF ) == 0 ) );
+}
+
+/*********************************************************************
+ * @fn      benchMem
+ *
+ * @brief   Allocation pattern typical of the stack: short lived
+ *          blocks of 8..96 bytes with a few kept alive.
+ */
+static uint8 benchMem( uint32 iterations )
+{
+  static const uint16 sizes[] = { 12, 24, 8, 40, 16, 96, 20, 64, 10, 32 };
+  void *live[8];
+  uint32 idx;
+  uint8 ok = TRUE;
+
+  osal_memset( live, 0, sizeof( live ) );
+
+  for ( idx = 0; idx < iterations; idx++ )
+  {
+    uint8 slot = (uint8)(idx & 7);
+
+    if ( live[slot] )
+    {
+      osal_mem_free( live[slot] );
+    }
+
+    live[slot] = osal_mem_alloc( sizes[idx % (sizeof( sizes ) / sizeof( sizes[0] ))] );
+    if ( live[slot] == NULL )
+    {
+      ok = FALSE;
+    }
+  }
+
+  for ( idx = 0; idx < 8; idx++ )
+  {
+    if ( live[idx] )
+    {
+      osal_mem_free( live[idx] );
+    }
+  }
+
+  return ( ok );
+}
+
+/*********************************************************************
+ * @fn      benchTimers
+ *
+ * @brief   Cost of one millisecond of simulated time with a realistic
+ *          set of timers armed (the 8051 does this on every loop).
+ *          Every one-shot timer must fire exactly once and every
+ *          reload timer as often as its period allows, while one armed
+ *          for longer than OSAL_TIMERS_MAX_TIMEOUT must not fire.
+ */
+static uint8 benchTimers( uint32 iterations )
+{
+  uint32 fired[BENCH_TIMER_CNT];
+  uint32 elapsed = iterations;
+  uint16 events;
+  uint8 idx;
+  uint8 ok = TRUE;
+
+  osal_memset( fired, 0, sizeof( fired ) );
+
+  for ( idx = 0; idx < BENCH_TIMER_CNT; idx++ )
+  {
+    // Event bit idx on the app task, periods 10..160 ms, odd ones reloading.
+    if ( idx & 1 )
+    {
+      (void)osal_start_reload_timer( hostApp_TaskID, BV( idx ), 10 * (idx + 1) );
+    }
+    else
+    {
+      (void)osal_start_timerEx( hostApp_TaskID, BV( idx ), 10 * (idx + 1) );
+    }
+  }
+  (void)osal_start_timerEx( Hal_TaskID, BENCH_TIMER_EXTRA_EVT, 0xFFFFFFFF );
+
+  while ( iterations-- )
+  {
+    halHostClockAdvanceMs( 1 );
+    osalTimeUpdate();
+
+    events = tasksEvents[hostApp_TaskID];
+    if ( events )
+    {
+      tasksEvents[hostApp_TaskID] = 0;
+      for ( idx = 0; idx < BENCH_TIMER_CNT; idx++ )
+      {
+        if ( events & BV( idx ) )
+        {
+          fired[idx]++;
+        }
+      }
+    }
+  }
+
+  for ( idx = 0; idx < BENCH_TIMER_CNT; idx++ )
+  {
+    (void)osal_stop_timerEx( hostApp_TaskID, BV( idx ) );
+
+    if ( elapsed > 10 * (idx + 1) + 2 )
+    {
+      // Reload timers restart from the tick that expired them, so allow drift.
+      if ( (idx & 1) ? (fired[idx] < elapsed / (10 * (idx + 1) + 2)) : (fired[idx] != 1) )
+      {
+        ok = FALSE;
+      }
+    }
+  }
+
+  ok = ok && !(tasksEvents[Hal_TaskID] & BENCH_TIMER_EXTRA_EVT) &&
+       (osal_get_timeoutEx( Hal_TaskID, BENCH_TIMER_EXTRA_EVT ) != 0);
+  (void)osal_stop_timerEx( Hal_TaskID, BENCH_TIMER_EXTRA_EVT );
+
+  // Let the list implementation reclaim the stopped records.
+  osalTimerUpdate( 0 );
+
+  return ( ok && (osal_timer_num_active() == 0) );
+}
+
+/*********************************************************************
+ * @fn      benchTimerOps
+ *
+ * @brief   Timer API cost with 16 timers armed: restart one of them
+ *          and start then stop one more. The OSAL main loop reclaims
+ *          stopped list records on its next tick, so one is run
+ *          every 32 operations.
+ */
+static uint8 benchTimerOps( uint32 iterations )
+{
+  uint32 idx;
+  uint8 ok = TRUE;
+
+  for ( idx = 0; idx < BENCH_TIMER_CNT; idx++ )
+  {
+    (void)osal_start_timerEx( hostApp_TaskID, BV( idx ), 60000 + idx );
+  }
+
+  for ( idx = 0; idx < iterations; idx++ )
+  {
+    if ( (osal_start_timerEx( hostApp_TaskID, BV( idx % BENCH_TIMER_CNT ), 60000 + (idx & 0xFF) ) != SUCCESS) ||
+         (osal_start_timerEx( Hal_TaskID, BENCH_TIMER_EXTRA_EVT, 1000 ) != SUCCESS) ||
+         (osal_stop_timerEx( Hal_TaskID, BENCH_TIMER_EXTRA_EVT ) != SUCCESS) )
+    {
+      ok = FALSE;
+    }
+
+    if ( (idx & 31) == 31 )
+    {
+      osalTimerUpdate( 0 );
+    }
+  }
+
+  osalTimerUpdate( 0 );
+  ok = ok && (osal_timer_num_active() == BENCH_TIMER_CNT);
+
+  for ( idx = 0; idx < BENCH_TIMER_CNT; idx++ )
+  {
+    (void)osal_stop_timerEx( hostApp_TaskID, BV( idx ) );
+  }
+  osalTimerUpdate( 0 );
+
+  return ( ok && (osal_timer_num_active() == 0) && (tasksEvents[Hal_TaskID] == 0) );
+}
+
+/*********************************************************************
+ * @fn      benchEvent
+ *
+ * @brief   Scheduler dispatch of a single event to the last task.
+ */
+static uint8 benchEvent( uint32 iterations )
+{
+  uint32 runs = 0;
+
+  while ( iterations-- )
+  {
+    (void)osal_set_event( hostApp_TaskID, 0x0001 );
+    runs += hostBenchRunUntilIdle();
+  }
+
+  return ( runs != 0 );
+}
+
+/*********************************************************************
+ * @fn      benchEventTable
+ *
+ * @brief   Four events of the app task run from its event handler
+ *          table in a single dispatch, while a HAL event set at the same
+ *          time goes first and makes the app task wait one dispatch.
+ */
+static uint32 benchTableCnt;
+
+static void benchTableHandler( uint8 task_id )
+{
+  (void)task_id;
+  benchTableCnt++;
+}
+
+static CONST osalEventHandlerRec_t benchTable[] =
+{
+  { 0x0100, benchTableHandler },
+  { 0x0200, benchTableHandler },
+  { 0x0400, benchTableHandler },
+  { 0x0800, benchTableHandler },
+};
+
+static uint8 benchEventTable( uint32 iterations )
+{
+#if ( OSAL_RUN_METRICS )
+  osalTaskStats_t before;
+  osalTaskStats_t after;
+#endif
+  uint32 expect = iterations;
+  uint32 runs = 0;
+  uint8 ok;
+
+  benchTableCnt = 0;
+  if ( osal_register_event_handlers( hostApp_TaskID, benchTable,
+                                     sizeof( benchTable ) / sizeof( benchTable[0] ) ) != SUCCESS )
+  {
+    return ( FALSE );
+  }
+#if ( OSAL_RUN_METRICS )
+  (void)osal_task_stats( hostApp_TaskID, &before );
+#endif
+
+  while ( iterations-- )
+  {
+    (void)osal_set_event( hostApp_TaskID, BENCH_TABLE_EVTS );
+    (void)osal_set_event( Hal_TaskID, HAL_LED_BLINK_EVENT );
+    runs += hostBenchRunUntilIdle();
+  }
+
+  ok = ( runs == 2 * expect ) && ( benchTableCnt == 4 * expect );
+
+#if ( OSAL_RUN_METRICS )
+  ok = ok && ( osal_task_stats( hostApp_TaskID, &after ) == SUCCESS ) &&
+       ( after.runs - before.runs == expect ) && ( after.handled - before.handled == 4 * expect ) &&
+       ( ( expect == 0 ) || ( after.passMax >= 1 ) );
+#endif
+
+  (void)osal_register_event_handlers( hostApp_TaskID, NULL, 0 );
+
+  return ( ok );
+}
+
+/*********************************************************************
+ * @fn      benchNv
+ *
+ * @brief   Write and read back a small application NV item.
+ */
+static uint8 benchNv( uint32 iterations )
+{
+  uint8 buf[BENCH_NV_LEN];
+  uint8 chk[BENCH_NV_LEN];
+  uint32 val = 0;
+
+  osal_memset( buf, 0, sizeof( buf ) );
+  if ( osal_nv_item_init( BENCH_NV_ITEM, BENCH_NV_LEN, buf ) > NV_ITEM_UNINIT )
+  {
+    return ( FALSE );
+  }
+
+  while ( iterations-- )
+  {
+    val++;
+    osal_memcpy( buf, &val, sizeof( val ) );
+    if ( (osal_nv_write( BENCH_NV_ITEM, 0, BENCH_NV_LEN, buf ) != SUCCESS) ||
+         (osal_nv_read( BENCH_NV_ITEM, 0, BENCH_NV_LEN, chk ) != SUCCESS) ||
+         !osal_memcmp( buf, chk, BENCH_NV_LEN ) )
+    {
+      return ( FALSE );
+    }
+  }
+
+  return ( TRUE );
+}
+
+/*********************************************************************
+ * @fn      benchNvDir
+ *
+ * @brief   Look up items spread over the NV pages while writes keep moving them and
+ *          compacting pages, then re-initialize NV as after a reset and read them all back.
+ */
+static uint8 benchNvDir( uint32 iterations )
+{
+  uint8 vals[BENCH_NVDIR_CNT][BENCH_NVDIR_LEN];
+  uint8 buf[BENCH_NVDIR_LEN];
+  uint32 cnt;
+  uint8 idx;
+
+  osal_memset( vals, 0, sizeof( vals ) );
+  for ( idx = 0; idx < BENCH_NVDIR_CNT; idx++ )
+  {
+    if ( (osal_nv_item_init( BENCH_NVDIR_ITEM + idx, BENCH_NVDIR_LEN, NULL ) > NV_ITEM_UNINIT) ||
+         (osal_nv_write( BENCH_NVDIR_ITEM + idx, 0, BENCH_NVDIR_LEN, vals[idx] ) != SUCCESS) )
+    {
+      return ( FALSE );
+    }
+  }
+
+  for ( cnt = 0; cnt < iterations; cnt++ )
+  {
+    idx = (uint8)(cnt % BENCH_NVDIR_CNT);
+
+    if ( (cnt % BENCH_NVDIR_WR_RATE) == 0 )
+    {
+      osal_memcpy( vals[idx], &cnt, sizeof( cnt ) );
+      if ( osal_nv_write( BENCH_NVDIR_ITEM + idx, 0, BENCH_NVDIR_LEN, vals[idx] ) != SUCCESS )
+      {
+        return ( FALSE );
+      }
+    }
+
+    if ( (osal_nv_read( BENCH_NVDIR_ITEM + idx, 0, BENCH_NVDIR_LEN, buf ) != SUCCESS) ||
+         !osal_memcmp( buf, vals[idx], BENCH_NVDIR_LEN ) ||
+         (osal_nv_item_len( BENCH_NVDIR_ABSENT ) != 0) )
+    {
+      return ( FALSE );
+    }
+  }
+
+  // The directory is rebuilt from the pages, which must still hold every last write.
+  osal_nv_init( NULL );
+
+  for ( idx = 0; idx < BENCH_NVDIR_CNT; idx++ )
+  {
+    if ( (osal_nv_item_len( BENCH_NVDIR_ITEM + idx ) != BENCH_NVDIR_LEN) ||
+         (osal_nv_read( BENCH_NVDIR_ITEM + idx, 0, BENCH_NVDIR_LEN, buf ) != SUCCESS) ||
+         !osal_memcmp( buf, vals[idx], BENCH_NVDIR_LEN ) )
+    {
+      return ( FALSE );
+    }
+  }
+
+#if ( OSAL_NV_DIR_MAX )
+  {
+    osalNvDirStats_t stats;
+
+    osal_nv_dir_stats( &stats );
+    if ( (stats.cnt < BENCH_NVDIR_CNT) && (stats.cnt < stats.max) )
+    {
+      return ( FALSE );
+    }
+  }
+#endif
+
+  return ( TRUE );
+}
+
+/*********************************************************************
+ * @fn      benchNvJrnInit
+ *
+ * @brief   Create the journal benchmark item, or reset it, with a known pattern.
+ */
+static uint8 benchNvJrnInit( uint8 *img )
+{
+  uint8 idx;
+
+  for ( idx = 0; idx < BENCH_NVJRN_LEN; idx++ )
+  {
+    img[idx] = idx;
+  }
+
+  return ( (osal_nv_item_init( BENCH_NVJRN_ITEM, BENCH_NVJRN_LEN, img ) <= NV_ITEM_UNINIT) &&
+           (osal_nv_write( BENCH_NVJRN_ITEM, 0, BENCH_NVJRN_LEN, img ) == SUCCESS) );
+}
+
+/*********************************************************************
+ * @fn      benchNvJrnCheck
+ *
+ * @brief   Re-initialize NV as after a reset and compare the item with its expected image.
+ */
+static uint8 benchNvJrnCheck( const uint8 *img )
+{
+  uint8 buf[BENCH_NVJRN_LEN];
+
+  osal_nv_init( NULL );
+
+  return ( (osal_nv_read( BENCH_NVJRN_ITEM, 0, BENCH_NVJRN_LEN, buf ) == SUCCESS) &&
+           osal_memcmp( buf, img, BENCH_NVJRN_LEN ) );
+}
+
+/*********************************************************************
+ * @fn      benchNvJrn
+ *
+ * @brief   Update a counter at the start of a larger item, the way a frame counter
+ *          or a binding table header is written, and read it back.
+ */
+static uint8 benchNvJrn( uint32 iterations )
+{
+  uint8 img[BENCH_NVJRN_LEN];
+#if ( OSAL_NV_JRN_ITEMS )
+  osalNvJrnStats_t before, after;
+#endif
+  uint32 cnt = 0;
+  uint32 chk;
+
+  if ( !benchNvJrnInit( img ) )
+  {
+    return ( FALSE );
+  }
+#if ( OSAL_NV_JRN_ITEMS )
+  osal_nv_jrn_stats( &before );
+#endif
+
+  while ( iterations-- )
+  {
+    cnt++;
+    if ( (osal_nv_write( BENCH_NVJRN_ITEM, 0, sizeof( cnt ), &cnt ) != SUCCESS) ||
+         (osal_nv_read( BENCH_NVJRN_ITEM, 0, sizeof( chk ), &chk ) != SUCCESS) ||
+         (chk != cnt) )
+    {
+      return ( FALSE );
+    }
+  }
+
+#if ( OSAL_NV_JRN_ITEMS )
+  osal_nv_jrn_stats( &after );
+  if ( (cnt != 0) && (after.appends == before.appends) )
+  {
+    return ( FALSE );
+  }
+#endif
+
+  osal_memcpy( img, &cnt, sizeof( cnt ) );
+
+  return ( benchNvJrnCheck( img ) );
+}
+
+/*********************************************************************
+ * @fn      benchNvDefer
+ *
+ * @brief   An app task event bumps a counter several times and changes one record of
+ *          the item. The deferred writes are flushed when the handler returns.
+ */
+static uint32 benchNvDeferCnt;
+static uint8 benchNvDeferOk;
+
+static void benchNvDeferHandler( uint8 task_id )
+{
+  uint8 rec[BENCH_NVJRN_REC];
+  uint32 chk;
+  uint8 idx;
+
+  (void)task_id;
+
+  for ( idx = 0; idx < BENCH_NVJRN_BUMPS; idx++ )
+  {
+    benchNvDeferCnt++;
+    if ( osal_nv_write_defer( BENCH_NVJRN_ITEM, 0, sizeof( benchNvDeferCnt ),
+                              &benchNvDeferCnt ) != SUCCESS )
+    {
+      benchNvDeferOk = FALSE;
+    }
+  }
+
+  osal_memset( rec, (uint8)benchNvDeferCnt, sizeof( rec ) );
+  if ( (osal_nv_write_defer( BENCH_NVJRN_ITEM,
+                             sizeof( uint32 ) + (benchNvDeferCnt % BENCH_NVJRN_RECS) * sizeof( rec ),
+                             sizeof( rec ), rec ) != SUCCESS) ||
+       (osal_nv_read( BENCH_NVJRN_ITEM, 0, sizeof( chk ), &chk ) != SUCCESS) ||
+       (chk != benchNvDeferCnt) )
+  {
+    benchNvDeferOk = FALSE;
+  }
+}
+
+static CONST osalEventHandlerRec_t benchNvDeferTable[] =
+{
+  { BENCH_NVJRN_EVT, benchNvDeferHandler },
+};
+
+static uint8 benchNvDefer( uint32 iterations )
+{
+  uint8 img[BENCH_NVJRN_LEN];
+#if ( OSAL_NV_DEFER_CNT )
+  osalNvJrnStats_t before, after;
+#endif
+  uint32 expect = iterations;
+  uint32 chk;
+
+  if ( !benchNvJrnInit( img ) ||
+       (osal_register_event_handlers( hostApp_TaskID, benchNvDeferTable, 1 ) != SUCCESS) )
+  {
+    return ( FALSE );
+  }
+#if ( OSAL_NV_DEFER_CNT )
+  osal_nv_jrn_stats( &before );
+#endif
+
+  benchNvDeferCnt = 0;
+  benchNvDeferOk = TRUE;
+  while ( iterations-- && benchNvDeferOk )
+  {
+    uint8 rec = (uint8)(benchNvDeferCnt + BENCH_NVJRN_BUMPS);
+
+    (void)osal_set_event( hostApp_TaskID, BENCH_NVJRN_EVT );
+    (void)hostBenchRunUntilIdle();
+
+    // On flash once the task has returned.
+    osal_memcpy( img, &benchNvDeferCnt, sizeof( benchNvDeferCnt ) );
+    osal_memset( img + sizeof( uint32 ) + (benchNvDeferCnt % BENCH_NVJRN_RECS) * BENCH_NVJRN_REC,
+                 rec, BENCH_NVJRN_REC );
+    if ( (osal_nv_read( BENCH_NVJRN_ITEM, 0, sizeof( chk ), &chk ) != SUCCESS) ||
+         (chk != benchNvDeferCnt) )
+    {
+      benchNvDeferOk = FALSE;
+    }
+  }
+
+  (void)osal_register_event_handlers( hostApp_TaskID, NULL, 0 );
+
+#if ( OSAL_NV_DEFER_CNT )
+  // The counter bumps of an event are merged: two item writes per event.
+  osal_nv_jrn_stats( &after );
+  if ( (after.flushed - before.flushed != 2 * expect) || (after.failed != before.failed) )
+  {
+    return ( FALSE );
+  }
+#endif
+
+  return ( benchNvDeferOk && (benchNvDeferCnt == BENCH_NVJRN_BUMPS * expect) &&
+           benchNvJrnCheck( img ) );
+}
+
+/*********************************************************************
+ * @fn      benchZclParse
+ *
+ * @brief   Parse the payload of a two attribute report.
+ */
+static uint8 benchZclParse( uint32 iterations )
+{
+  zclParseCmd_t parse;
+  zclReportCmd_t *pReport;
+  uint8 ok = TRUE;
+
+  parse.endpoint = HOSTAPP_ENDPOINT;
+  parse.dataLen = sizeof( benchReportFrame ) - 3;
+  parse.pData = benchReportFrame + 3;
+
+  while ( iterations-- )
+  {
+    pReport = (zclReportCmd_t *)zclParseInReportCmd( &parse );
+    if ( (pReport == NULL) || (pReport->numAttr != 2) )
+    {
+      ok = FALSE;
+    }
+    if ( pReport )
+    {
+      osal_mem_free( pReport );
+    }
+  }
+
+  return ( ok );
+}
+
+/*********************************************************************
+ * @fn      benchZclIter
+ *
+ * @brief   Walk the payload of a two attribute report in place.
+ */
+static uint8 benchZclIter( uint32 iterations )
+{
+  zclReportIter_t iter;
+  zclReportView_t rpt;
+  uint8 ok = TRUE;
+  uint8 cnt;
+
+  while ( iterations-- )
+  {
+    cnt = 0;
+    zclReportIterInit( &iter, benchReportFrame + 3, sizeof( benchReportFrame ) - 3 );
+    while ( zclReportIterNext( &iter, &rpt ) )
+    {
+      cnt++;
+    }
+    if ( (cnt != 2) || (rpt.dataLen != 2) )
+    {
+      ok = FALSE;
+    }
+  }
+
+  return ( ok );
+}
+
+/*********************************************************************
+ * @fn      benchZclReport
+ *
+ * @brief   A report arriving from the network: AF builds the incoming
+ *          message, the ZCL task parses it, the app task consumes it.
+ */
+static uint8 benchZclReport( uint32 iterations )
+{
+  uint32 before = hostAppStats.reportCnt;
+  uint32 expect = iterations;
+
+  while ( iterations-- )
+  {
+    benchReportFrame[1]++;
+    hostNwkDeliver( BENCH_PEER_ADDR, BENCH_PEER_EP, HOSTAPP_ENDPOINT,
+                    ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT, ZCL_HA_PROFILE_ID,
+                    benchReportFrame, sizeof( benchReportFrame ) );
+    (void)hostBenchRunUntilIdle();
+  }
+
+  return ( (hostAppStats.reportCnt - before == expect) && (hostAppStats.lastTemp == 2150) );
+}
+
+/*********************************************************************
+ * @fn      benchZclReportView
+ *
+ * @brief   Same as benchZclReport with the app's report callback
+ *          registered: no parse buffer and no message to the app task.
+ */
+static uint8 benchZclReportView( uint32 iterations )
+{
+  uint32 before = hostAppStats.reportCnt;
+  uint32 msgCnt = hostAppStats.msgCnt;
+  uint32 expect = iterations;
+  uint8 ok;
+
+  hostAppStats.lastTemp = 0;
+  if ( zcl_registerReportCB( HOSTAPP_ENDPOINT, hostApp_ReportCB ) != ZSuccess )
+  {
+    return ( FALSE );
+  }
+
+  while ( iterations-- )
+  {
+    benchReportFrame[1]++;
+    hostNwkDeliver( BENCH_PEER_ADDR, BENCH_PEER_EP, HOSTAPP_ENDPOINT,
+                    ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT, ZCL_HA_PROFILE_ID,
+                    benchReportFrame, sizeof( benchReportFrame ) );
+    (void)hostBenchRunUntilIdle();
+  }
+
+  ok = (hostAppStats.reportCnt - before == expect) && (hostAppStats.lastTemp == 2150) &&
+       (hostAppStats.msgCnt == msgCnt);
+
+  (void)zcl_registerReportCB( HOSTAPP_ENDPOINT, NULL );
+
+  return ( ok );
+}
+
+/*********************************************************************
+ * @fn      benchZclRead
+ *
+ * @brief   A read request arriving from the network and the read
+ *          response going back out through AF_DataRequest.
+ */
+static uint8 benchZclRead( uint32 iterations )
+{
+  uint32 before = hostNwkStats.txCount;
+  uint32 expect = iterations;
+
+  while ( iterations-- )
+  {
+    benchReadFrame[1]++;
+    hostNwkDeliver( BENCH_PEER_ADDR, BENCH_PEER_EP, HOSTAPP_ENDPOINT,
+                    ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT, ZCL_HA_PROFILE_ID,
+                    benchReadFrame, sizeof( benchReadFrame ) );
+    (void)hostBenchRunUntilIdle();
+  }
+
+  // Read response: header (3) + 3 x (attrID, status, type, int16)
+  return ( (hostNwkStats.txCount - before == expect) &&
+           (hostNwkStats.lastTxLen == 3 + 3 * 6) &&
+           (hostNwkStats.lastTx[2] == ZCL_CMD_READ_RSP) );
+}
+
+/*********************************************************************
+ * @fn      benchZclFind
+ *
+ * @brief   Attribute record lookups as done for every read, write and
+ *          report of an attribute, in a list laid out like the one of
+ *          the thermostat sample (22 records, not in attribute order).
+ */
+#define BENCH_FIND_ATTR( cluster, attr ) \
+  { cluster, { attr, ZCL_DATATYPE_UINT8, ACCESS_CONTROL_READ, (void *)&benchFindValue } }
+
+static uint8 benchFindValue;
+
+static CONST zclAttrRec_t benchFindAttrs[] =
+{
+  BENCH_FIND_ATTR( ZCL_CLUSTER_ID_GEN_BASIC, ATTRID_BASIC_HW_VERSION ),
+  BENCH_FIND_ATTR( ZCL_CLUSTER_ID_GEN_BASIC, ATTRID_BASIC_ZCL_VERSION ),
+  BENCH_FIND_ATTR( ZCL_CLUSTER_ID_GEN_BASIC, ATTRID_BASIC_MANUFACTURER_NAME ),
+  BENCH_FIND_ATTR( ZCL_CLUSTER_ID_GEN_BASIC, ATTRID_BASIC_MODEL_ID ),
+  BENCH_FIND_ATTR( ZCL_CLUSTER_ID_GEN_BASIC, ATTRID_BASIC_DATE_CODE ),
+  BENCH_FIND_ATTR( ZCL_CLUSTER_ID_GEN_BASIC, ATTRID_BASIC_POWER_SOURCE ),
+  BENCH_FIND_ATTR( ZCL_CLUSTER_ID_GEN_BASIC, ATTRID_BASIC_LOCATION_DESC ),
+  BENCH_FIND_ATTR( ZCL_CLUSTER_ID_GEN_BASIC, ATTRID_BASIC_PHYSICAL_ENV ),
+  BENCH_FIND_ATTR( ZCL_CLUSTER_ID_GEN_BASIC, ATTRID_BASIC_DEVICE_ENABLED ),
+  BENCH_FIND_ATTR( ZCL_CLUSTER_ID_GEN_IDENTIFY, ATTRID_IDENTIFY_TIME ),
+  BENCH_FIND_ATTR( ZCL_CLUSTER_ID_GEN_ON_OFF, ATTRID_ON_OFF ),
+  BENCH_FIND_ATTR( ZCL_CLUSTER_ID_HVAC_THERMOSTAT, ATTRID_HVAC_THERMOSTAT_OCCUPIED_COOLING_SETPOINT ),
+  BENCH_FIND_ATTR( ZCL_CLUSTER_ID_HVAC_THERMOSTAT, ATTRID_HVAC_THERMOSTAT_OCCUPIED_HEATING_SETPOINT ),
+  BENCH_FIND_ATTR( ZCL_CLUSTER_ID_HVAC_THERMOSTAT, ATTRID_HVAC_THERMOSTAT_LOCAL_TEMPERATURE ),
+  BENCH_FIND_ATTR( ZCL_CLUSTER_ID_HVAC_THERMOSTAT, ATTRID_HVAC_THERMOSTAT_MIN_HEAT_SETPOINT_LIMIT ),
+  BENCH_FIND_ATTR( ZCL_CLUSTER_ID_HVAC_THERMOSTAT, ATTRID_HVAC_THERMOSTAT_MAX_HEAT_SETPOINT_LIMIT ),
+  BENCH_FIND_ATTR( ZCL_CLUSTER_ID_HVAC_THERMOSTAT, ATTRID_HVAC_THERMOSTAT_MIN_COOL_SETPOINT_LIMIT ),
+  BENCH_FIND_ATTR( ZCL_CLUSTER_ID_HVAC_THERMOSTAT, ATTRID_HVAC_THERMOSTAT_MAX_COOL_SETPOINT_LIMIT ),
+  BENCH_FIND_ATTR( ZCL_CLUSTER_ID_HVAC_THERMOSTAT, ATTRID_HVAC_THERMOSTAT_PI_COOLING_DEMAND ),
+  BENCH_FIND_ATTR( ZCL_CLUSTER_ID_HVAC_THERMOSTAT, ATTRID_HVAC_THERMOSTAT_PI_HEATING_DEMAND ),
+  BENCH_FIND_ATTR( ZCL_CLUSTER_ID_HVAC_THERMOSTAT, ATTRID_HVAC_THERMOSTAT_CTRL_SEQ_OF_OPER ),
+  BENCH_FIND_ATTR( ZCL_CLUSTER_ID_HVAC_THERMOSTAT, ATTRID_HVAC_THERMOSTAT_SYSTEM_MODE ),
+};
+
+static uint8 benchZclFind( uint32 iterations )
+{
+  static const struct
+  {
+    uint16 clusterID;
+    uint16 attrID;
+  } keys[] =
+  {
+    { ZCL_CLUSTER_ID_HVAC_THERMOSTAT, ATTRID_HVAC_THERMOSTAT_LOCAL_TEMPERATURE },
+    { ZCL_CLUSTER_ID_HVAC_THERMOSTAT, ATTRID_HVAC_THERMOSTAT_SYSTEM_MODE },
+    { ZCL_CLUSTER_ID_HVAC_THERMOSTAT, ATTRID_HVAC_THERMOSTAT_PI_HEATING_DEMAND },
+    { ZCL_CLUSTER_ID_GEN_ON_OFF,      ATTRID_ON_OFF },
+    { ZCL_CLUSTER_ID_GEN_BASIC,       ATTRID_BASIC_ZCL_VERSION },
+    { ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT, ATTRID_MS_TEMPERATURE_MEASURED_VALUE },
+  };
+  static uint8 registered = FALSE;
+  zclAttrRec_t attr;
+  uint8 found;
+  uint8 idx;
+  uint8 ok = TRUE;
+
+  // A second attribute list on an endpoint nobody sends to
+  if ( !registered )
+  {
+    if ( zcl_registerAttrList( BENCH_FIND_EP, sizeof( benchFindAttrs ) / sizeof( benchFindAttrs[0] ),
+                               benchFindAttrs ) != ZSuccess )
+    {
+      return ( FALSE );
+    }
+    registered = TRUE;
+  }
+
+  while ( iterations-- )
+  {
+    found = 0;
+    for ( idx = 0; idx < sizeof( keys ) / sizeof( keys[0] ); idx++ )
+    {
+      if ( zclFindAttrRec( BENCH_FIND_EP, keys[idx].clusterID, keys[idx].attrID, &attr ) &&
+           ( attr.attr.attrId == keys[idx].attrID ) )
+      {
+        found++;
+      }
+    }
+    if ( found != 5 )
+    {
+      ok = FALSE;
+    }
+  }
+
+  return ( ok );
+}
+
+/*********************************************************************
+ * @fn      benchZclReporting
+ *
+ * @brief   MeasuredValue reported by the reporting engine after a
+ *          Configure Reporting from the network. Every iteration is one
+ *          second of sensor noise below the reportable change, and every
+ *          fourth one a step above it that has to go out as one report.
+ */
+static uint8 benchZclReporting( uint32 iterations )
+{
+  uint32 before;
+  uint32 expect = iterations ? ( iterations - 1 ) / 4 : 0;
+  uint32 idx;
+  int16 value = hostApp_MeasuredValue;
+  zclCfgReportRec_t off;
+  uint8 ok;
+
+  hostApp_MeasuredValue = 2150;
+  benchCfgReportFrame[1]++;
+  hostNwkDeliver( BENCH_PEER_ADDR, BENCH_PEER_EP, HOSTAPP_ENDPOINT,
+                  ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT, ZCL_HA_PROFILE_ID,
+                  benchCfgReportFrame, sizeof( benchCfgReportFrame ) );
+  (void)hostBenchRunUntilIdle();
+
+  if ( (hostNwkStats.lastTx[2] != ZCL_CMD_CONFIG_REPORT_RSP) ||
+       (hostNwkStats.lastTx[3] != ZCL_STATUS_SUCCESS) )
+  {
+    return ( FALSE );
+  }
+
+  before = hostNwkStats.txCount;
+  for ( idx = 0; idx < iterations; idx++ )
+  {
+    halHostClockAdvanceMs( 1000 );
+    osalTimeUpdate();
+
+    // +-0.20 C of noise around a base moving by 1.00 C every 4 s
+    hostApp_MeasuredValue = 2150 + ( ( ( idx / 4 ) & 1 ) ? 100 : 0 ) + ( ( idx & 1 ) ? 20 : -20 );
+    zclReporting_AttrChanged( HOSTAPP_ENDPOINT, ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT,
+                              ATTRID_MS_TEMPERATURE_MEASURED_VALUE );
+    (void)hostBenchRunUntilIdle();
+  }
+
+  ok = (hostNwkStats.txCount - before == expect) &&
+       ( (expect == 0) || ( (hostNwkStats.lastTx[2] == ZCL_CMD_REPORT) &&
+                            (hostNwkStats.lastTxCluster == ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT) ) );
+
+  off.direction = ZCL_SEND_ATTR_REPORTS;
+  off.attrID = ATTRID_MS_TEMPERATURE_MEASURED_VALUE;
+  off.dataType = ZCL_DATATYPE_INT16;
+  off.minReportInt = 0;
+  off.maxReportInt = ZCL_REPORTING_INT_OFF;
+  off.reportableChange = NULL;
+  ok = ok && ( zclReporting_Config( HOSTAPP_ENDPOINT, ZCL_CLUSTER_ID_MS_TEMPERATURE_MEASUREMENT,
+                                    &off ) == ZCL_STATUS_SUCCESS );
+
+  hostApp_MeasuredValue = value;
+
+  return ( ok );
+}
+
+/*********************************************************************
+ * @fn      benchAfDescCB
+ *
+ * @brief   Descriptor callback of the AF Rx benchmark endpoints, built
+ *          like ZDO's: the profile ID comes back in allocated memory.
+ */
+static uint32 benchAfDescCalls;
+
+static void *benchAfDescCB( uint8 type, uint8 endpoint )
+{
+  uint16 *pID = NULL;
+
+  (void)endpoint;
+
+  benchAfDescCalls++;
+  if ( type == AF_DESCRIPTOR_PROFILE_ID )
+  {
+    pID = (uint16 *)osal_mem_alloc( sizeof( uint16 ) );
+    if ( pID )
+    {
+      *pID = ZCL_HA_PROFILE_ID;
+    }
+  }
+
+  return ( pID );
+}
+
+/*********************************************************************
+ * @fn      benchAfRx
+ *
+ * @brief   AF ingress with the app endpoint plus BENCH_AF_EP_CNT
+ *          endpoints registered by descriptor callback: a unicast to
+ *          the first of them registered, deepest in the endpoint list,
+ *          and a group frame for BENCH_AF_GRP_CNT of them. Every frame
+ *          must reach the task once per endpoint, and the endpoints go
+ *          away again at the end.
+ */
+static uint8 benchAfRx( uint32 iterations )
+{
+  static endPointDesc_t epDesc[BENCH_AF_EP_CNT];
+  uint32 before = hostAppStats.afMsgCnt;
+  uint32 expect = iterations * ( 1 + BENCH_AF_GRP_CNT );
+  uint8 ok = TRUE;
+  uint8 idx;
+
+  for ( idx = 0; idx < BENCH_AF_EP_CNT; idx++ )
+  {
+    epDesc[idx].endPoint = BENCH_AF_EP + idx;
+    epDesc[idx].task_id = &hostApp_TaskID;
+    epDesc[idx].simpleDesc = NULL;
+    epDesc[idx].latencyReq = noLatencyReqs;
+    if ( afRegisterExtended( &epDesc[idx], benchAfDescCB, NULL ) == NULL )
+    {
+      ok = FALSE;
+    }
+    if ( idx < BENCH_AF_GRP_CNT )
+    {
+      (void)hostNwkAddGroup( BENCH_AF_GROUP, BENCH_AF_EP + idx );
+    }
+  }
+
+  while ( iterations-- )
+  {
+    hostNwkDeliver( BENCH_PEER_ADDR, BENCH_PEER_EP, BENCH_AF_EP, ZCL_CLUSTER_ID_GEN_ON_OFF,
+                    ZCL_HA_PROFILE_ID, benchReportFrame, sizeof( benchReportFrame ) );
+    hostNwkDeliverGroup( BENCH_PEER_ADDR, BENCH_PEER_EP, BENCH_AF_GROUP, ZCL_CLUSTER_ID_GEN_ON_OFF,
+                         ZCL_HA_PROFILE_ID, benchReportFrame, sizeof( benchReportFrame ) );
+    (void)hostBenchRunUntilIdle();
+  }
+
+  hostNwkRemoveGroups();
+  for ( idx = 0; idx < BENCH_AF_EP_CNT; idx++ )
+  {
+    if ( afDelete( BENCH_AF_EP + idx ) != afStatus_SUCCESS )
+    {
+      ok = FALSE;
+    }
+  }
+
+  return ( ok && (hostAppStats.afMsgCnt - before == expect) &&
+           (afFindEndPointDesc( BENCH_AF_EP ) == NULL) &&
+           (afFindEndPointDesc( HOSTAPP_ENDPOINT ) != NULL) );
+}
+
+/*********************************************************************
+ * @fn      benchUartCmd
+ *
+ * @brief   An ASCII command arriving on UART0, found in the command
+ *          table, handed to the application and answered.
+ */
+static uint8 benchUartCmd( uint32 iterations )
+{
+  uint32 before = hostAppStats.freeDataCnt;
+  uint32 expect = iterations;
+  uint8 rsp[16];
+  uint8 ok = TRUE;
+
+  while ( iterations-- )
+  {
+    (void)halHostUartInject( HAL_UART_PORT_0, benchUartAsciiCmd, sizeof( benchUartAsciiCmd ) - 1 );
+    HalUARTPoll();
+    (void)hostBenchRunUntilIdle();
+
+    if ( (halHostUartDrain( HAL_UART_PORT_0, rsp, sizeof( rsp ) ) != 6) ||
+         memcmp( rsp, "DONE\r\n", 6 ) )
+    {
+      ok = FALSE;
+    }
+  }
+
+  return ( ok && (hostAppStats.freeDataCnt - before == expect) &&
+           (Free_Data_Size == 6) && !memcmp( &Free_Data[1], "LED1ON", 6 ) );
+}
+
+/*********************************************************************
+ * @fn      benchUartBin
+ *
+ * @brief   Same as benchUartCmd with the command and its reply in the
+ *          binary framing.
+ */
+static uint8 benchUartBin( uint32 iterations )
+{
+  uint32 before = hostAppStats.freeDataCnt;
+  uint32 expect = iterations;
+  uint8 *pFcs = &benchUartBinCmd[sizeof( benchUartBinCmd ) - ZCMD_FRAME_FCS_LEN];
+  uint16 fcs;
+  uint8 rsp[16];
+  uint8 ok;
+
+  // CRC-16/CCITT check value
+  ok = (ZCMD_Crc16( ZCMD_CRC_INIT, (uint8 *)"123456789", 9 ) == 0x29B1);
+
+  fcs = ZCMD_Crc16( ZCMD_CRC_INIT, &benchUartBinCmd[1], benchUartBinCmd[1] + 2 );
+  pFcs[0] = LO_UINT16( fcs );
+  pFcs[1] = HI_UINT16( fcs );
+
+  while ( iterations-- )
+  {
+    (void)halHostUartInject( HAL_UART_PORT_0, benchUartBinCmd, sizeof( benchUartBinCmd ) );
+    HalUARTPoll();
+    (void)hostBenchRunUntilIdle();
+
+    // SOF | 1 | SEND_C rsp | OK | FCS
+    if ( (halHostUartDrain( HAL_UART_PORT_0, rsp, sizeof( rsp ) ) != ZCMD_FRAME_OVERHEAD + 1) ||
+         (rsp[0] != ZCMD_SOF) || (rsp[2] != (ZCMD_OP_SEND_C | ZCMD_OP_RSP)) ||
+         (rsp[3] != ZCMD_STATUS_OK) ||
+         (ZCMD_Crc16( ZCMD_CRC_INIT, &rsp[1], 3 ) != BUILD_UINT16( rsp[4], rsp[5] )) )
+    {
+      ok = FALSE;
+    }
+  }
+
+  return ( ok && (hostAppStats.freeDataCnt - before == expect) &&
+           (Free_Data_Size == 6) && !memcmp( &Free_Data[1], "LED1ON", 6 ) );
+}
+
+/*********************************************************************
+ * @fn      benchUartSplit
+ *
+ * @brief   The ASCII command of benchUartCmd arriving in pieces with
+ *          a driver poll after each, behind a byte of line noise. The
+ *          application must be woken up exactly once per command.
+ */
+static uint8 benchUartSplit( uint32 iterations )
+{
+  uint32 before = hostAppStats.freeDataCnt;
+  uint32 evtCnt = hostAppStats.uartEvtCnt;
+  uint32 expect = iterations;
+  uint8 rsp[16];
+  uint8 ok = TRUE;
+  uint8 idx;
+
+  while ( iterations-- )
+  {
+    (void)halHostUartInject( HAL_UART_PORT_0, (uint8 *)"\n", 1 );
+    for ( idx = 0; idx < sizeof( benchUartAsciiCmd ) - 1; idx += 3 )
+    {
+      (void)halHostUartInject( HAL_UART_PORT_0, &benchUartAsciiCmd[idx],
+                               MIN( 3, sizeof( benchUartAsciiCmd ) - 1 - idx ) );
+      HalUARTPoll();
+      (void)hostBenchRunUntilIdle();
+    }
+
+    if ( (halHostUartDrain( HAL_UART_PORT_0, rsp, sizeof( rsp ) ) != 6) ||
+         memcmp( rsp, "DONE\r\n", 6 ) )
+    {
+      ok = FALSE;
+    }
+  }
+
+  return ( ok && (hostAppStats.freeDataCnt - before == expect) &&
+           (hostAppStats.uartEvtCnt - evtCnt == expect) );
+}
+
+/*********************************************************************
+ * @fn      benchUartRptCheck
+ *
+ * @brief   Collect what a report benchmark printed and compare it to
+ *          benchUartRptText.
+ */
+static uint8 benchUartRptCheck( void )
+{
+  uint8 out[64];
+  uint16 len = halHostUartDrain( HAL_UART_PORT_0, out, sizeof( out ) );
+
+  return ( (len == sizeof( benchUartRptText ) - 1) && !memcmp( out, benchUartRptText, len ) );
+}
+
+/*********************************************************************
+ * @fn      benchUartRptCalls
+ *
+ * @brief   "@ZBR:" report line written field by field, the way the
+ *          application used to print it.
+ */
+static uint8 benchUartRptCalls( uint32 iterations )
+{
+  int8 rssi = -67;
+  uint8 ok = TRUE;
+
+  while ( iterations-- )
+  {
+    UART_ZCmdPrintString( HAL_UART_PORT_0, "@ZBR:" );
+    UART_ZCmdPrintNum( HAL_UART_PORT_0, rssi );
+    UART_ZCmdPrintString( HAL_UART_PORT_0, ";" );
+    UART_ZCmdPrintNum( HAL_UART_PORT_0, BENCH_PEER_ADDR );
+    UART_ZCmdPrintString( HAL_UART_PORT_0, ";" );
+    UART_ZCmdPrintNum( HAL_UART_PORT_0, BENCH_PEER_EP );
+    UART_ZCmdPrintString( HAL_UART_PORT_0, ";" );
+    UART_ZCmdPrintNum( HAL_UART_PORT_0, 21 );
+    UART_ZCmdPrintString( HAL_UART_PORT_0, ";" );
+    UART_ZCmdPrintNum( HAL_UART_PORT_0, 54 );
+    UART_ZCmdPrintString( HAL_UART_PORT_0, ";" );
+    UART_ZCmdPrintNum( HAL_UART_PORT_0, 1 );
+    UART_ZCmdPrintString( HAL_UART_PORT_0, ";" );
+    UART_ZCmdPrintNum( HAL_UART_PORT_0, 0 );
+    UART_ZCmdPrint( HAL_UART_PORT_0, "!" );
+
+    ok &= benchUartRptCheck();
+  }
+
+  return ( ok );
+}
+
+/*********************************************************************
+ * @fn      benchUartRptLine
+ *
+ * @brief   Same line formatted into a UartLine_t and written once.
+ */
+static uint8 benchUartRptLine( uint32 iterations )
+{
+  UartLine_t line;
+  int8 rssi = -67;
+  uint8 ok = TRUE;
+
+  while ( iterations-- )
+  {
+    UART_LineStart( &line, "@ZBR:" );
+    UART_LineAddNum( &line, rssi );
+    UART_LineAddChar( &line, ';' );
+    UART_LineAddNum( &line, BENCH_PEER_ADDR );
+    UART_LineAddChar( &line, ';' );
+    UART_LineAddNum( &line, BENCH_PEER_EP );
+    UART_LineAddChar( &line, ';' );
+    UART_LineAddNum( &line, 21 );
+    UART_LineAddChar( &line, ';' );
+    UART_LineAddNum( &line, 54 );
+    UART_LineAddChar( &line, ';' );
+    UART_LineAddNum( &line, 1 );
+    UART_LineAddChar( &line, ';' );
+    UART_LineAddNum( &line, 0 );
+    UART_LineAddChar( &line, '!' );
+    UART_ZCmdPrintLine( HAL_UART_PORT_0, &line );
+
+    ok &= benchUartRptCheck();
+  }
+
+  return ( ok );
+}
+
+/*********************************************************************
+ * @fn      benchMtOpen
+ *
+ * @brief   Put the MT frame parser on UART1 (UART0 carries the "@ZB"
+ *          commands) and have the frames it accepts sent to the host
+ *          application task.
+ */
+static void benchMtOpen( void )
+{
+  halUARTCfg_t uartConfig;
+
+  osal_memset( &uartConfig, 0, sizeof( uartConfig ) );
+  uartConfig.configured = TRUE;
+  uartConfig.intEnable = TRUE;
+  uartConfig.callBackFunc = MT_UartProcessZToolData;
+  (void)HalUARTOpen( HAL_UART_PORT_1, &uartConfig );
+
+  MT_UartRegisterTaskID( hostApp_TaskID );
+}
+
+/*********************************************************************
+ * @fn      benchMtBurst
+ *
+ * @brief   A burst of MT traffic waiting in the Rx buffer when the
+ *          UART callback runs. Every frame that passes its FCS must
+ *          reach the application, the corrupted one must not.
+ */
+static uint8 benchMtBurst( uint32 iterations )
+{
+  uint32 before = hostAppStats.mtFrameCnt;
+  uint32 fcsSum = hostAppStats.mtFcsSum;
+  uint32 expect = iterations;
+
+  benchMtOpen();
+
+  while ( iterations-- )
+  {
+    (void)halHostUartInject( HAL_UART_PORT_1, benchMtCapture, sizeof( benchMtCapture ) );
+    HalUARTPoll();
+    (void)hostBenchRunUntilIdle();
+  }
+
+  return ( (hostAppStats.mtFrameCnt - before == expect * BENCH_MT_FRAMES) &&
+           (hostAppStats.mtFcsSum - fcsSum == expect * BENCH_MT_FCS_SUM) );
+}
+
+/*********************************************************************
+ * @fn      benchMtSplit
+ *
+ * @brief   Same capture trickling in, one UART callback per piece, so
+ *          frames start and end anywhere in a callback.
+ */
+static uint8 benchMtSplit( uint32 iterations )
+{
+  uint32 before = hostAppStats.mtFrameCnt;
+  uint32 fcsSum = hostAppStats.mtFcsSum;
+  uint32 expect = iterations;
+  uint16 idx;
+
+  benchMtOpen();
+
+  while ( iterations-- )
+  {
+    for ( idx = 0; idx < sizeof( benchMtCapture ); idx += BENCH_MT_PIECE )
+    {
+      (void)halHostUartInject( HAL_UART_PORT_1, &benchMtCapture[idx],
+                               MIN( BENCH_MT_PIECE, sizeof( benchMtCapture ) - idx ) );
+      HalUARTPoll();
+    }
+    (void)hostBenchRunUntilIdle();
+  }
+
+  return ( (hostAppStats.mtFrameCnt - before == expect * BENCH_MT_FRAMES) &&
+           (hostAppStats.mtFcsSum - fcsSum == expect * BENCH_MT_FCS_SUM) );
+}
+
+/*********************************************************************
+ * @fn      benchMtTx
+ *
+ * @brief   A burst of AF incoming message indications for the host
+ *          tool, followed by a quiet period as long as the latency
+ *          cap. Every frame must come out whole and in order; with
+ *          MT_UART_TX_COALESCE, three fit a write and the flush timer
+ *          sends the rest, so a burst costs two UART writes.
+ */
+static uint8 benchMtTx( uint32 iterations )
+{
+  uint8 out[BENCH_MT_IND_CNT * sizeof( benchMtAfInd ) + 1];
+  uint32 expect = iterations;
+#if MT_UART_TX_COALESCE
+  mtUartTxStats_t before = MT_UartTxStats;
+#endif
+  uint8 ok = TRUE;
+  uint8 idx;
+
+  benchMtAfInd[sizeof( benchMtAfInd ) - 1] =
+    MT_UartCalcFCS( &benchMtAfInd[1], sizeof( benchMtAfInd ) - MT_UART_FRAME_OVHD );
+  MT_UartRegisterTaskID( hostApp_TaskID );
+
+  while ( iterations-- )
+  {
+    for ( idx = 0; idx < BENCH_MT_IND_CNT; idx++ )
+    {
+      MT_UartWrite( benchMtAfInd, sizeof( benchMtAfInd ) );
+    }
+
+    // Quiet for longer than the latency cap, on the 320 us tick
+    halHostClockAdvanceMs( MT_UART_TX_COALESCE_DELAY + 1 );
+    osalTimeUpdate();
+    (void)hostBenchRunUntilIdle();
+
+    if ( halHostUartDrain( HAL_UART_PORT_0, out, sizeof( out ) ) != sizeof( out ) - 1 )
+    {
+      ok = FALSE;
+    }
+    for ( idx = 0; idx < BENCH_MT_IND_CNT; idx++ )
+    {
+      if ( memcmp( &out[idx * sizeof( benchMtAfInd )], benchMtAfInd, sizeof( benchMtAfInd ) ) )
+      {
+        ok = FALSE;
+      }
+    }
+  }
+
+#if MT_UART_TX_COALESCE
+  ok = ok && (MT_UartTxStats.writeCnt - before.writeCnt == 2 * expect) &&
+       (MT_UartTxStats.frameCnt[MT_RPC_CMD_AREQ >> 5] - before.frameCnt[MT_RPC_CMD_AREQ >> 5] ==
+        BENCH_MT_IND_CNT * expect) &&
+       (MT_UartTxStats.dropCnt == before.dropCnt);
+#else
+  (void)expect;
+#endif
+
+  return ( ok );
+}
+
+/*********************************************************************
+ * @fn      benchRptSend
+ *
+ * @brief   One two-attribute report to the coordinator, built the
+ *          way the applications send them.
+ */
+static void benchRptSend( afAddrType_t *dstAddr, uint16 attrID, uint8 dataType,
+                          void *pData0, void *pData1 )
+{
+  zclReportCmd_t *pReportCmd;
+
+  pReportCmd = osal_mem_alloc( sizeof( zclReportCmd_t ) + 2 * sizeof( zclReport_t ) );
+  if ( pReportCmd != NULL )
+  {
+    pReportCmd->numAttr = 2;
+    pReportCmd->attrList[0].attrID = attrID;
+    pReportCmd->attrList[0].dataType = dataType;
+    pReportCmd->attrList[0].attrData = pData0;
+    pReportCmd->attrList[1].attrID = attrID;
+    pReportCmd->attrList[1].dataType = dataType;
+    pReportCmd->attrList[1].attrData = pData1;
+
+    (void)zcl_SendReportCmd( HOSTAPP_ENDPOINT, dstAddr, ZCL_CLUSTER_ID_HVAC_THERMOSTAT,
+                             pReportCmd, ZCL_FRAME_SERVER_CLIENT_DIR, TRUE, 0 );
+    osal_mem_free( pReportCmd );
+  }
+}
+
+/*********************************************************************
+ * @fn      benchZclSend
+ *
+ * @brief   The outbound half of every report: zcl_SendReportCmd down
+ *          to APSDE_DataReq. The frame must come out intact and the
+ *          heap must be back where it was once it has been sent.
+ */
+static uint8 benchZclSend( uint32 iterations )
+{
+  uint32 before = hostNwkStats.txCount;
+  uint32 expect = iterations;
+  uint16 memUsed = osal_heap_mem_used();
+  afAddrType_t dstAddr;
+  int16 value = 2154;
+  uint8 *pLast = hostNwkStats.lastTx;
+
+  dstAddr.addrMode = (afAddrMode_t)Addr16Bit;
+  dstAddr.endPoint = BENCH_PEER_EP;
+  dstAddr.addr.shortAddr = BENCH_PEER_ADDR;
+
+  while ( iterations-- )
+  {
+    benchRptSend( &dstAddr, ATTRID_MS_TEMPERATURE_MEASURED_VALUE, ZCL_DATATYPE_INT16,
+                  &value, &value );
+  }
+
+  // Header (3) + 2 x (attrID, type, int16)
+  return ( (hostNwkStats.txCount - before == expect) &&
+           (osal_heap_mem_used() == memUsed) &&
+           (hostNwkStats.lastTxLen == 3 + 2 * 5) &&
+           (pLast[0] == (ZCL_FRAME_TYPE_PROFILE_CMD | ZCL_FRAME_CONTROL_DIRECTION |
+                         ZCL_FRAME_CONTROL_DISABLE_DEFAULT_RSP)) &&
+           (pLast[2] == ZCL_CMD_REPORT) &&
+           (pLast[3] == LO_UINT16( ATTRID_MS_TEMPERATURE_MEASURED_VALUE )) &&
+           (pLast[5] == ZCL_DATATYPE_INT16) &&
+           (BUILD_UINT16( pLast[11], pLast[12] ) == (uint16)value) );
+}
+
+/*********************************************************************
+ * @fn      benchRptDirect
+ *
+ * @brief   A roll call window of a router without aggregation: its
+ *          own roll call and every child report sent on its own.
+ */
+static uint8 benchRptDirect( uint32 iterations )
+{
+  uint32 before = hostNwkStats.txCount;
+  uint32 expect = iterations * BENCH_AGGR_REPORTS;
+  afAddrType_t dstAddr;
+  uint16 coordAddr = 0x0000;
+  uint16 value = BUILD_UINT16( 21, 54 );
+  uint8 idx;
+
+  dstAddr.addrMode = (afAddrMode_t)Addr16Bit;
+  dstAddr.endPoint = BENCH_PEER_EP;
+  dstAddr.addr.shortAddr = BENCH_PEER_ADDR;
+
+  while ( iterations-- )
+  {
+    benchRptSend( &dstAddr, ATTRID_ROLL_CALL, ZCL_DATATYPE_UINT16, &coordAddr, &coordAddr );
+    for ( idx = 0; idx < BENCH_AGGR_CHILDREN; idx++ )
+    {
+      benchRptSend( &dstAddr, ATTRID_MS_TEMPERATURE_MEASURED_VALUE, ZCL_DATATYPE_INT16, &value, &value );
+      benchRptSend( &dstAddr, ATTRID_HVAC_THERMOSTAT_RUNNING_STATE, ZCL_DATATYPE_UINT16, &value, &value );
+    }
+  }
+
+  return ( hostNwkStats.txCount - before == expect );
+}
+
+/*********************************************************************
+ * @fn      benchRptAggr
+ *
+ * @brief   Same window through the router aggregation, closed by its
+ *          flush timer. The records do not fit one frame, so each
+ *          window must cost exactly two, the last one holding the
+ *          children that did not fit the first.
+ */
+static uint8 benchRptAggr( uint32 iterations )
+{
+  uint32 before = hostNwkStats.txCount;
+  uint32 flushCnt = hostAppStats.flushCnt;
+  uint32 expect = iterations;
+  afAddrType_t dstAddr;
+  uint8 seqNum = 0;
+  uint8 *pLast = hostNwkStats.lastTx;
+  uint8 ok = TRUE;
+  uint8 idx;
+
+  dstAddr.addrMode = (afAddrMode_t)Addr16Bit;
+  dstAddr.endPoint = BENCH_PEER_EP;
+  dstAddr.addr.shortAddr = BENCH_PEER_ADDR;
+
+  AGGR_Init( HOSTAPP_ENDPOINT, ZCL_CLUSTER_ID_HVAC_THERMOSTAT, &dstAddr, &seqNum,
+             hostApp_TaskID, HOSTAPP_RPT_FLUSH_EVT );
+
+  while ( iterations-- )
+  {
+    AGGR_AddRollCall( 0x0000, 2 );
+    for ( idx = 0; idx < BENCH_AGGR_CHILDREN; idx++ )
+    {
+      AGGR_AddSensor( BENCH_PEER_ADDR + idx, BENCH_PEER_EP, BUILD_UINT16( 21, 54 ) );
+      AGGR_AddState( BENCH_PEER_ADDR + idx, BENCH_PEER_EP, BUILD_UINT16( 1, 0 ) );
+    }
+
+    // Window closes
+    osalTimerUpdate( AGGR_FLUSH_WINDOW );
+    (void)hostBenchRunUntilIdle();
+
+    // Header, then sensor, running state and address of the first child left
+    if ( (pLast[2] != ZCL_CMD_REPORT) ||
+         (BUILD_UINT16( pLast[3], pLast[4] ) != ATTRID_REPORT_DATA_COORD) ||
+         (pLast[6] != 21) || (pLast[7] != 54) ||
+         (BUILD_UINT16( pLast[8], pLast[9] ) != ATTRID_HVAC_THERMOSTAT_RUNNING_STATE) ||
+         (BUILD_UINT16( pLast[13], pLast[14] ) < BENCH_PEER_ADDR) || (pLast[16] != BENCH_PEER_EP) )
+    {
+      ok = FALSE;
+    }
+  }
+
+  return ( ok && (hostNwkStats.txCount - before == 2 * expect) &&
+           (hostAppStats.flushCnt - flushCnt == expect) &&
+           (osal_get_timeoutEx( hostApp_TaskID, HOSTAPP_RPT_FLUSH_EVT ) == 0) );
+}
+
+/*********************************************************************
+ * @fn      benchSample
+ *
+ * @brief   One sensor read per SAMPLE_PERIOD through the sampling
+ *          pipeline, reports going out on the app task event. Glitches
+ *          and jitter must never be reported, the steps must, and a
+ *          flat reading still reports every SAMPLE_MAX_INTERVAL, while
+ *          the report count stays far below one per read.
+ */
+static uint8 benchSample( uint32 iterations )
+{
+  uint32 before = hostAppStats.sensorRptCnt;
+  uint32 minRpt = iterations * SAMPLE_PERIOD / ( SAMPLE_MAX_INTERVAL + SAMPLE_PERIOD );
+  uint32 rptCnt = before;
+  uint32 idx;
+  uint8 base;
+  uint8 temp;
+  uint8 hum;
+  uint8 ok = TRUE;
+
+  SAMPLE_Init( hostApp_TaskID, HOSTAPP_SENSOR_RPT_EVT );
+
+  for ( idx = 0; idx < iterations; idx++ )
+  {
+    halHostClockAdvanceMs( SAMPLE_PERIOD );
+    osalTimeUpdate();
+
+    base = ( ( idx / BENCH_SAMPLE_STEP ) & 1 ) ? 25 : 22;
+    temp = base + ( idx & 1 );
+    hum = 55 + ( ( idx % 3 ) == 0 );
+    if ( ( idx % BENCH_SAMPLE_GLITCH ) == ( BENCH_SAMPLE_GLITCH / 2 ) )
+    {
+      temp = 85;
+      hum = 0;
+    }
+
+    (void)SAMPLE_Add( temp, hum );
+    (void)hostBenchRunUntilIdle();
+
+    if ( hostAppStats.sensorRptCnt != rptCnt )
+    {
+      rptCnt = hostAppStats.sensorRptCnt;
+      if ( (SAMPLE_GetTemp() < 22) || (SAMPLE_GetTemp() > 26) ||
+           (SAMPLE_GetHum() < 55) || (SAMPLE_GetHum() > 56) )
+      {
+        ok = FALSE;
+      }
+    }
+
+    // Settled on the step well before the next one
+    if ( ( ( idx % BENCH_SAMPLE_STEP ) == BENCH_SAMPLE_STEP - 1 ) &&
+         ( (SAMPLE_GetTemp() < base) || (SAMPLE_GetTemp() > base + 1) ) )
+    {
+      ok = FALSE;
+    }
+  }
+
+  (void)osal_stop_timerEx( hostApp_TaskID, HOSTAPP_SENSOR_RPT_EVT );
+
+  rptCnt -= before;
+  return ( ok && (rptCnt >= minRpt) && (rptCnt <= iterations / 8 + 1) );
+}
+
+/*********************************************************************
+ * @fn      benchOtaCrc
+ *
+ * @brief   The boot code CRC16 over one byte of the run code image.
+ */
+static uint16 benchOtaCrc( uint16 crc, uint8 val )
+{
+  uint8 cnt;
+
+  for ( cnt = 0; cnt < 8; cnt++, val <<= 1 )
+  {
+    uint8 msb = (crc & 0x8000) ? 1 : 0;
+
+    crc <<= 1;
+    if ( val & 0x80 )  crc |= 0x0001;
+    if ( msb )         crc ^= 0x1021;
+  }
+
+  return ( crc );
+}
+
+/*********************************************************************
+ * @fn      benchOtaImageInit
+ *
+ * @brief   A minimal OTA file for this device: the 56 byte header and
+ *          one upgrade image sub-element holding a run code image
+ *          with a valid CRC control block.
+ */
+static void benchOtaImageInit( void )
+{
+  uint8 *pHdr = benchOtaImage;
+  uint8 *pProg = &benchOtaImage[OTA_HEADER_LEN_MIN + OTA_SUB_ELEMENT_HDR_LEN];
+  uint32 progLen = BENCH_OTA_IMG_LEN - OTA_HEADER_LEN_MIN - OTA_SUB_ELEMENT_HDR_LEN;
+  uint16 crc = 0;
+  uint32 idx;
+
+  (void)memset( benchOtaImage, 0, sizeof( benchOtaImage ) );
+
+  (void)osal_buffer_uint32( pHdr, OTA_HDR_MAGIC_NUMBER );
+  pHdr[4] = LO_UINT16( OTA_HDR_HEADER_VERSION );
+  pHdr[5] = HI_UINT16( OTA_HDR_HEADER_VERSION );
+  pHdr[6] = OTA_HEADER_LEN_MIN;
+  pHdr[OTA_HEADER_FILE_ID_POS] = LO_UINT16( zclOTA_ManufacturerId );
+  pHdr[OTA_HEADER_FILE_ID_POS + 1] = HI_UINT16( zclOTA_ManufacturerId );
+  pHdr[OTA_HEADER_FILE_ID_POS + 2] = LO_UINT16( zclOTA_ImageType );
+  pHdr[OTA_HEADER_FILE_ID_POS + 3] = HI_UINT16( zclOTA_ImageType );
+  (void)osal_buffer_uint32( &pHdr[OTA_HEADER_FILE_ID_POS + 4], BENCH_OTA_VERSION );
+  pHdr[18] = OTA_HDR_STACK_VERSION;
+  (void)osal_buffer_uint32( &pHdr[OTA_HEADER_IMAGE_SIZE_POS], BENCH_OTA_IMG_LEN );
+
+  // Sub-element tag 0 (upgrade image) and its length
+  (void)osal_buffer_uint32( &pHdr[OTA_HEADER_LEN_MIN + 2], progLen );
+
+  for ( idx = 0; idx < progLen; idx++ )
+  {
+    pProg[idx] = (uint8)( idx * 7 + ( idx >> 8 ) );
+  }
+
+  // CRC control block: CRC, erased shadow, program size, the CRC
+  // covering everything but the first two
+  pProg[HAL_OTA_CRC_OSET + 2] = 0xFF;
+  pProg[HAL_OTA_CRC_OSET + 3] = 0xFF;
+  (void)osal_buffer_uint32( &pProg[HAL_OTA_CRC_OSET + 4], progLen );
+  for ( idx = 0; idx < progLen; idx++ )
+  {
+    if ( (idx < HAL_OTA_CRC_OSET) || (idx >= HAL_OTA_CRC_OSET + 4) )
+    {
+      crc = benchOtaCrc( crc, pProg[idx] );
+    }
+  }
+  pProg[HAL_OTA_CRC_OSET] = LO_UINT16( crc );
+  pProg[HAL_OTA_CRC_OSET + 1] = HI_UINT16( crc );
+}
+
+/*********************************************************************
+ * @fn      benchOtaTxHook
+ *
+ * @brief   The OTA server: queues the response to each block request
+ *          behind the link delay and the requests before it, loses
+ *          every BENCH_OTA_LOSS-th one, and answers a successful
+ *          upgrade end request.
+ */
+static void benchOtaTxHook( APSDE_DataReq_t *req )
+{
+  uint8 *pPayload = &req->asdu[3];
+  benchOtaRsp_t *pRsp = &benchOtaQueue[benchOtaQueued];
+  uint32 now = osal_GetSystemClock();
+  uint32 start;
+
+  if ( (req->clusterID != ZCL_CLUSTER_ID_OTA) || (req->asduLen < 4) ||
+       (benchOtaQueued == BENCH_OTA_QUEUE) )
+  {
+    return;
+  }
+
+  if ( req->asdu[2] == COMMAND_IMAGE_BLOCK_REQ )
+  {
+    if ( ( ++benchOtaReqCnt % BENCH_OTA_LOSS ) == 0 )
+    {
+      return;
+    }
+
+    // One block at a time through the server
+    start = now + BENCH_OTA_LINK_MS;
+    if ( start < benchOtaSrvFree )
+    {
+      start = benchOtaSrvFree;
+    }
+    benchOtaSrvFree = start + BENCH_OTA_SRV_MS;
+
+    pRsp->due = benchOtaSrvFree + BENCH_OTA_LINK_MS;
+    pRsp->offset = osal_build_uint32( &pPayload[9], 4 );
+    pRsp->len = pPayload[13];
+    if ( pRsp->offset + pRsp->len > BENCH_OTA_IMG_LEN )
+    {
+      pRsp->len = (uint8)( BENCH_OTA_IMG_LEN - pRsp->offset );
+    }
+    pRsp->group = 0;
+    pRsp->cmd = COMMAND_IMAGE_BLOCK_RSP;
+    pRsp->status = ZCL_STATUS_SUCCESS;
+    benchOtaQueued++;
+  }
+  else if ( (req->asdu[2] == COMMAND_UPGRADE_END_REQ) && (pPayload[0] == ZSuccess) )
+  {
+    pRsp->due = now + 2 * BENCH_OTA_LINK_MS;
+    pRsp->group = 0;
+    pRsp->cmd = COMMAND_UPGRADE_END_RSP;
+    pRsp->status = ZCL_STATUS_SUCCESS;
+    benchOtaQueued++;
+  }
+}
+
+/*********************************************************************
+ * @fn      benchOtaDeliver
+ *
+ * @brief   Deliver a server command to the OTA client: a query next
+ *          image or block response (status first, nothing after it if
+ *          not a success), or an upgrade end response telling it to
+ *          upgrade now. Unicast if group is 0.
+ */
+static void benchOtaDeliver( uint8 cmd, uint8 status, uint32 offset, uint8 len, uint16 group )
+{
+  uint8 frame[3 + PAYLOAD_MAX_LEN_IMAGE_BLOCK_RSP + OTA_MAX_MTU];
+  uint8 *p = &frame[3];
+
+  frame[0] = 0x19;              // Cluster specific, server to client, no default response
+  frame[1] = 0x00;              // Sequence number
+  frame[2] = cmd;
+
+  if ( cmd != COMMAND_UPGRADE_END_RSP )
+  {
+    *p++ = status;
+  }
+
+  if ( status == ZCL_STATUS_SUCCESS )
+  {
+    *p++ = LO_UINT16( zclOTA_ManufacturerId );
+    *p++ = HI_UINT16( zclOTA_ManufacturerId );
+    *p++ = LO_UINT16( zclOTA_ImageType );
+    *p++ = HI_UINT16( zclOTA_ImageType );
+    p = osal_buffer_uint32( p, BENCH_OTA_VERSION );
+
+    if ( cmd == COMMAND_QUERY_NEXT_IMAGE_RSP )
+    {
+      p = osal_buffer_uint32( p, BENCH_OTA_IMG_LEN );
+    }
+    else if ( cmd == COMMAND_IMAGE_BLOCK_RSP )
+    {
+      p = osal_buffer_uint32( p, offset );
+      *p++ = len;
+      (void)memcpy( p, &benchOtaImage[offset], len );
+      p += len;
+    }
+    else
+    {
+      p = osal_buffer_uint32( p, 0 );     // Current time
+      p = osal_buffer_uint32( p, 0 );     // Upgrade time: now
+    }
+  }
+
+  if ( group )
+  {
+    hostNwkDeliverGroup( BENCH_OTA_SRV_ADDR, BENCH_OTA_SRV_EP, group, ZCL_CLUSTER_ID_OTA,
+                         ZCL_HA_PROFILE_ID, frame, (uint8)( p - frame ) );
+  }
+  else
+  {
+    hostNwkDeliver( BENCH_OTA_SRV_ADDR, BENCH_OTA_SRV_EP, ZCL_OTA_ENDPOINT, ZCL_CLUSTER_ID_OTA,
+                    ZCL_HA_PROFILE_ID, frame, (uint8)( p - frame ) );
+  }
+}
+
+/*********************************************************************
+ * @fn      benchOtaDownload
+ *
+ * @brief   One download, from the query next image response to the
+ *          upgrade complete callback, with the clock stepped from one
+ *          server response, console reply or OSAL timer to the next.
+ *
+ * @return  Simulated milliseconds taken, 0 if the download failed
+ */
+static uint32 benchOtaDownload( void )
+{
+  uint32 start = osal_GetSystemClock();
+  uint32 doneCnt = hostAppStats.otaDoneCnt;
+  uint32 failCnt = hostAppStats.otaFailCnt;
+  benchOtaRsp_t rsp;
+  uint32 now;
+  uint32 next;
+  uint16 evt;
+  uint8 idx;
+
+  halHostOtaFormat();
+  benchOtaQueued = 0;
+  benchOtaSrvFree = 0;
+
+  benchOtaDeliver( COMMAND_QUERY_NEXT_IMAGE_RSP, ZCL_STATUS_SUCCESS, 0, 0, 0 );
+  (void)hostBenchRunUntilIdle();
+
+  while ( hostAppStats.otaDoneCnt == doneCnt )
+  {
+    now = osal_GetSystemClock();
+    if ( (hostAppStats.otaFailCnt != failCnt) || (now - start > BENCH_OTA_MAX_MS) )
+    {
+      return ( 0 );
+    }
+
+    for ( idx = 0; idx < benchOtaQueued; )
+    {
+      if ( (int32)( benchOtaQueue[idx].due - now ) > 0 )
+      {
+        idx++;
+        continue;
+      }
+
+      // The client may queue more requests while this one is handled
+      rsp = benchOtaQueue[idx];
+      benchOtaQueue[idx] = benchOtaQueue[--benchOtaQueued];
+      benchOtaDeliver( rsp.cmd, rsp.status, rsp.offset, rsp.len, rsp.group );
+      (void)hostBenchRunUntilIdle();
+    }
+
+    // Replies of the console to a streaming server
+    if ( hostMtOtaPoll() )
+    {
+      (void)hostBenchRunUntilIdle();
+      continue;
+    }
+
+    next = hostMtOtaNextDue();
+    if ( next > BENCH_OTA_MAX_MS )
+    {
+      next = BENCH_OTA_MAX_MS;
+    }
+    for ( idx = 0; idx < benchOtaQueued; idx++ )
+    {
+      if ( benchOtaQueue[idx].due - now < next )
+      {
+        next = benchOtaQueue[idx].due - now;
+      }
+    }
+    // zclOTA_Init takes the last task ID (OSAL_Host.c)
+    for ( evt = ZCL_OTA_IMAGE_BLOCK_WAIT_EVT; evt <= ZCL_OTA_IMAGE_STREAM_EVT; evt <<= 1 )
+    {
+      uint32 timeout = osal_get_timeoutEx( tasksCnt - 1, evt );
+
+      if ( timeout && (timeout < next) )
+      {
+        next = timeout;
+      }
+    }
+
+    // A timer that is already due reads as no timer at all
+    if ( (next == 0) || (next == BENCH_OTA_MAX_MS) )
+    {
+      next = 1;
+    }
+
+    halHostClockAdvanceMs( next );
+    osalTimeUpdate();
+    (void)hostBenchRunUntilIdle();
+  }
+
+  return ( osal_GetSystemClock() - start );
+}
+
+/*********************************************************************
+ * @fn      benchOtaDl
+ *
+ * @brief   Image downloads from a server one link delay away, under
+ *          each block window cap up to OTA_BLOCK_WINDOW. Every
+ *          download must complete with the image intact in the DL
+ *          area, written strictly in order, and a full window must
+ *          beat stop-and-wait by a wide margin.
+ */
+static uint8 benchOtaDl( uint32 iterations )
+{
+  uint32 failCnt = hostAppStats.otaFailCnt;
+  uint8 buf[OTA_MAX_MTU];
+  uint32 downloads;
+  uint32 ms;
+  uint32 oset;
+  uint32 cnt;
+  uint8 win;
+  uint8 ok = TRUE;
+
+  benchOtaImageInit();
+  hostNwkSetTxHook( benchOtaTxHook );
+
+  // Caps of 1, 2, 4, ... up to OTA_BLOCK_WINDOW
+  benchOtaWinCnt = 0;
+  for ( win = 1; win < OTA_BLOCK_WINDOW; win <<= 1 )
+  {
+    benchOtaWin[benchOtaWinCnt++] = win;
+  }
+  benchOtaWin[benchOtaWinCnt++] = OTA_BLOCK_WINDOW;
+  downloads = iterations / ( BENCH_OTA_BLOCKS * benchOtaWinCnt );
+  if ( downloads == 0 )
+  {
+    downloads = 1;
+  }
+
+  for ( win = 0; ok && (win < benchOtaWinCnt); win++ )
+  {
+#if OTA_BLOCK_WINDOW > 1
+    zclOTA_BlockWindow = benchOtaWin[win];
+#endif
+    ms = 0;
+
+    for ( cnt = 0; ok && (cnt < downloads); cnt++ )
+    {
+      uint32 t = benchOtaDownload();
+
+      ok = (t != 0) && (halHostOtaSeekCount() == 0) &&
+           (halHostOtaWriteCount() == BENCH_OTA_BLOCKS);
+      for ( oset = 0; ok && (oset < BENCH_OTA_IMG_LEN); oset += sizeof( buf ) )
+      {
+        HalOTARead( oset, buf, sizeof( buf ), HAL_OTA_DL );
+        ok = !memcmp( buf, &benchOtaImage[oset], sizeof( buf ) );
+      }
+      ms += t;
+    }
+
+    benchOtaRate[win] = ms ? (uint32)( (uint64_t)downloads * BENCH_OTA_IMG_LEN * 1000 / ms ) : 0;
+  }
+
+  hostNwkSetTxHook( NULL );
+#if OTA_BLOCK_WINDOW > 1
+  zclOTA_BlockWindow = OTA_BLOCK_WINDOW;
+
+  // Pipelining has to pay off on this link
+  ok = ok && ( benchOtaRate[benchOtaWinCnt - 1] > 2 * benchOtaRate[0] );
+#endif
+
+  return ( ok && (hostAppStats.otaFailCnt == failCnt) );
+}
+
+/*********************************************************************
+ * @fn      benchOtaBlocks
+ *
+ * @brief   Block responses arriving back to back and in order, so the
+ *          cost is the client's own: ZCL parse, image decode and the
+ *          write to the DL image. Every download must complete with
+ *          the image intact.
+ */
+static uint8 benchOtaBlocks( uint32 iterations )
+{
+  uint32 doneCnt = hostAppStats.otaDoneCnt;
+  uint32 failCnt = hostAppStats.otaFailCnt;
+  uint32 downloads = iterations / BENCH_OTA_BLOCKS;
+  uint32 oset;
+  uint32 cnt;
+  uint8 buf[OTA_MAX_MTU];
+  uint8 ok = TRUE;
+
+  if ( downloads == 0 )
+  {
+    downloads = 1;
+  }
+
+  benchOtaImageInit();
+
+  for ( cnt = 0; ok && (cnt < downloads); cnt++ )
+  {
+    halHostOtaFormat();
+
+    // The first requests go out on a zero delay timer, on the 320 us tick
+    benchOtaDeliver( COMMAND_QUERY_NEXT_IMAGE_RSP, ZCL_STATUS_SUCCESS, 0, 0, 0 );
+    (void)hostBenchRunUntilIdle();
+    halHostClockAdvanceMs( 2 );
+    osalTimeUpdate();
+    (void)hostBenchRunUntilIdle();
+
+    for ( oset = 0; oset < BENCH_OTA_IMG_LEN; oset += OTA_MAX_MTU )
+    {
+      benchOtaDeliver( COMMAND_IMAGE_BLOCK_RSP, ZCL_STATUS_SUCCESS, oset, OTA_MAX_MTU, 0 );
+      (void)hostBenchRunUntilIdle();
+    }
+
+    ok = ( zclOTA_ImageUpgradeStatus == OTA_STATUS_COMPLETE );
+    for ( oset = 0; ok && (oset < BENCH_OTA_IMG_LEN); oset += sizeof( buf ) )
+    {
+      HalOTARead( oset, buf, sizeof( buf ), HAL_OTA_DL );
+      ok = !memcmp( buf, &benchOtaImage[oset], sizeof( buf ) );
+    }
+
+    // Upgrade now
+    benchOtaDeliver( COMMAND_UPGRADE_END_RSP, ZCL_STATUS_SUCCESS, 0, 0, 0 );
+    (void)hostBenchRunUntilIdle();
+    halHostClockAdvanceMs( 2 );
+    osalTimeUpdate();
+    (void)hostBenchRunUntilIdle();
+  }
+
+  return ( ok && (hostAppStats.otaDoneCnt - doneCnt == downloads) &&
+           (hostAppStats.otaFailCnt == failCnt) );
+}
+
+/*********************************************************************
+ * @fn      benchOtaSrvTxHook
+ *
+ * @brief   The clients of the OTA server: checks each answer against
+ *          the image and schedules the client's next request one round
+ *          trip later.
+ */
+static void benchOtaSrvTxHook( APSDE_DataReq_t *req )
+{
+  uint8 *pPayload = &req->asdu[3];
+  benchOtaClient_t *pClient;
+  uint16 idx = req->dstAddr.addr.shortAddr - BENCH_OTA_SRV_CLIENT;
+  uint32 offset;
+  uint8 len;
+
+  if ( (req->clusterID != ZCL_CLUSTER_ID_OTA) || (req->asduLen < 4) ||
+       (idx >= BENCH_OTA_SRV_CLIENTS) )
+  {
+    return;
+  }
+
+  pClient = &benchOtaClient[idx];
+  pClient->due = osal_GetSystemClock() + 2 * BENCH_OTA_LINK_MS;
+
+  if ( req->asdu[2] == COMMAND_QUERY_NEXT_IMAGE_RSP )
+  {
+    pClient->queried = (pPayload[0] == ZSuccess) &&
+                       (osal_build_uint32( &pPayload[9], 4 ) == BENCH_OTA_IMG_LEN);
+    benchOtaSrvBad |= !pClient->queried;
+  }
+  else if ( (req->asdu[2] == COMMAND_IMAGE_BLOCK_RSP) && (pPayload[0] == ZOtaWaitForData) )
+  {
+    benchOtaSrvWaits++;
+  }
+  else if ( (req->asdu[2] == COMMAND_IMAGE_BLOCK_RSP) && (pPayload[0] == ZSuccess) )
+  {
+    offset = osal_build_uint32( &pPayload[9], 4 );
+    len = pPayload[13];
+
+    if ( (offset != pClient->offset) || (len == 0) || (len > OTA_MAX_MTU) ||
+         (offset + len > BENCH_OTA_IMG_LEN) ||
+         memcmp( &pPayload[14], &benchOtaImage[offset], len ) )
+    {
+      benchOtaSrvBad = TRUE;
+    }
+    else
+    {
+      pClient->offset += len;
+    }
+  }
+  else
+  {
+    benchOtaSrvBad = TRUE;
+  }
+}
+
+/*********************************************************************
+ * @fn      benchOtaSrvRequest
+ *
+ * @brief   Deliver a client's next request to the OTA server: a query
+ *          next image until it is answered, then an image block
+ *          request.
+ */
+static void benchOtaSrvRequest( uint8 idx )
+{
+  benchOtaClient_t *pClient = &benchOtaClient[idx];
+  uint8 frame[3 + PAYLOAD_MIN_LEN_IMAGE_BLOCK_REQ];
+  uint8 *p = &frame[3];
+
+  frame[0] = 0x11;              // Cluster specific, client to server, no default response
+  frame[1] = 0x00;              // Sequence number
+  frame[2] = pClient->queried ? COMMAND_IMAGE_BLOCK_REQ : COMMAND_QUERY_NEXT_IMAGE_REQ;
+
+  *p++ = 0x00;                  // Field control: nothing optional
+  *p++ = LO_UINT16( zclOTA_ManufacturerId );
+  *p++ = HI_UINT16( zclOTA_ManufacturerId );
+  *p++ = LO_UINT16( zclOTA_ImageType );
+  *p++ = HI_UINT16( zclOTA_ImageType );
+
+  if ( pClient->queried )
+  {
+    p = osal_buffer_uint32( p, BENCH_OTA_VERSION );
+    p = osal_buffer_uint32( p, pClient->offset );
+    *p++ = OTA_MAX_MTU;
+  }
+  else
+  {
+    p = osal_buffer_uint32( p, BENCH_OTA_VERSION - 1 );
+  }
+
+  pClient->due = osal_GetSystemClock() + BENCH_OTA_SRV_RETRY_MS;
+  hostNwkDeliver( BENCH_OTA_SRV_CLIENT + idx, BENCH_OTA_SRV_EP, ZCL_OTA_ENDPOINT,
+                  ZCL_CLUSTER_ID_OTA, ZCL_HA_PROFILE_ID, frame, (uint8)( p - frame ) );
+}
+
+/*********************************************************************
+ * @fn      benchOtaSrvRound
+ *
+ * @brief   Every client downloads the image once, with the clock
+ *          stepped from one client request or console reply to the
+ *          next.
+ *
+ * @return  Simulated milliseconds taken, 0 if a download failed
+ */
+static uint32 benchOtaSrvRound( void )
+{
+  uint32 start = osal_GetSystemClock();
+  uint32 now;
+  uint32 next;
+  uint8 left;
+  uint8 idx;
+
+  benchOtaSrvBad = FALSE;
+  for ( idx = 0; idx < BENCH_OTA_SRV_CLIENTS; idx++ )
+  {
+    benchOtaClient[idx].due = start + idx * BENCH_OTA_SRV_STAGGER_MS + BENCH_OTA_LINK_MS;
+    benchOtaClient[idx].offset = 0;
+    benchOtaClient[idx].queried = FALSE;
+  }
+
+  do
+  {
+    now = osal_GetSystemClock();
+    if ( benchOtaSrvBad || (now - start > BENCH_OTA_MAX_MS) )
+    {
+      return ( 0 );
+    }
+
+    left = 0;
+    next = HOST_MTOTA_NONE;
+    for ( idx = 0; idx < BENCH_OTA_SRV_CLIENTS; idx++ )
+    {
+      benchOtaClient_t *pClient = &benchOtaClient[idx];
+
+      if ( pClient->offset == BENCH_OTA_IMG_LEN )
+      {
+        continue;
+      }
+      left++;
+
+      if ( (int32)( pClient->due - now ) <= 0 )
+      {
+        benchOtaSrvRequest( idx );
+        (void)hostBenchRunUntilIdle();
+      }
+      if ( pClient->due - now < next )
+      {
+        next = pClient->due - now;
+      }
+    }
+
+    // Including the replies to the requests just made
+    if ( hostMtOtaNextDue() < next )
+    {
+      next = hostMtOtaNextDue();
+    }
+
+    if ( hostMtOtaPoll() )
+    {
+      (void)hostBenchRunUntilIdle();
+    }
+    else if ( left )
+    {
+      halHostClockAdvanceMs( ((next == 0) || (next == HOST_MTOTA_NONE)) ? 1 : next );
+      osalTimeUpdate();
+      (void)hostBenchRunUntilIdle();
+    }
+  } while ( left );
+
+  return ( osal_GetSystemClock() - start );
+}
+
+/*********************************************************************
+ * @fn      benchOtaSrvRun
+ *
+ * @brief   Rounds of the OTA server serving the same image to every
+ *          client (benchOtaSrvRound).
+ *
+ * @param   rounds - number of rounds
+ *
+ * @return  Simulated milliseconds taken, 0 if a round failed
+ */
+static uint32 benchOtaSrvRun( uint32 rounds )
+{
+  zclOTA_FileID_t fileId;
+  uint32 ms = 0;
+  uint32 t = 1;
+  uint32 cnt;
+
+  benchOtaImageInit();
+  fileId.manufacturer = zclOTA_ManufacturerId;
+  fileId.type = zclOTA_ImageType;
+  fileId.version = BENCH_OTA_VERSION;
+  hostMtOtaSetImage( &fileId, benchOtaImage, BENCH_OTA_IMG_LEN );
+  hostNwkSetTxHook( benchOtaSrvTxHook );
+
+  for ( cnt = 0; (t != 0) && (cnt < rounds); cnt++ )
+  {
+    t = benchOtaSrvRound();
+    ms += t;
+  }
+
+  hostNwkSetTxHook( NULL );
+
+  return ( (t != 0) ? ms : 0 );
+}
+
+/*********************************************************************
+ * @fn      benchOtaSrv
+ *
+ * @brief   The OTA server behind a serial console serving the same
+ *          image to several clients at once. Every client must get
+ *          the image intact, and with the page cache the console
+ *          must be read less than once per block.
+ */
+static uint8 benchOtaSrv( uint32 iterations )
+{
+  uint32 rounds = iterations / ( BENCH_OTA_BLOCKS * BENCH_OTA_SRV_CLIENTS );
+  uint32 reads = hostMtOtaStats.readCnt;
+  uint32 ms;
+  uint8 ok;
+
+  if ( rounds == 0 )
+  {
+    rounds = 1;
+  }
+
+  benchOtaSrvWaits = 0;
+  ms = benchOtaSrvRun( rounds );
+  ok = ( ms != 0 );
+
+  benchOtaSrvReads = ( hostMtOtaStats.readCnt - reads ) / rounds;
+  benchOtaSrvRate = ms ? (uint32)( (uint64_t)rounds * BENCH_OTA_SRV_CLIENTS *
+                                   BENCH_OTA_IMG_LEN * 1000 / ms ) : 0;
+#if OTA_SRV_CACHE_PAGES
+  ok = ok && ( benchOtaSrvReads < BENCH_OTA_BLOCKS * BENCH_OTA_SRV_CLIENTS / 2 );
+#endif
+
+  return ( ok );
+}
+
+/*********************************************************************
+ * @fn      benchOtaSrvLost
+ *
+ * @brief   The OTA server benchmark with every BENCH_OTA_SRV_LOSE-th
+ *          console reply to a file read lost. The server must give up
+ *          the reads that are never answered, and every client must
+ *          still get the image intact by asking again.
+ */
+static uint8 benchOtaSrvLost( uint32 iterations )
+{
+  uint32 rounds = iterations / ( BENCH_OTA_BLOCKS * BENCH_OTA_SRV_CLIENTS );
+  uint32 waits = benchOtaSrvWaits;
+  uint32 lost = hostMtOtaStats.lostCnt;
+  uint8 ok;
+
+  if ( rounds == 0 )
+  {
+    rounds = 1;
+  }
+
+  hostMtOtaLoseReads( BENCH_OTA_SRV_LOSE );
+  ok = ( benchOtaSrvRun( rounds ) != 0 ) && ( hostMtOtaStats.lostCnt != lost );
+  hostMtOtaLoseReads( 0 );
+
+  // The figures reported are those of ota_srv
+  benchOtaSrvWaits = waits;
+
+  return ( ok );
+}
+
+/*********************************************************************
+ * @fn      benchOtaSrvCut
+ *
+ * @brief   The OTA server benchmark with every BENCH_OTA_SRV_CUT-th
+ *          console file read returning half the bytes asked for, in the
+ *          middle of the image. The server must not take a short read
+ *          for the end of the image, and every client must still get
+ *          the image intact.
+ */
+static uint8 benchOtaSrvCut( uint32 iterations )
+{
+  uint32 rounds = iterations / ( BENCH_OTA_BLOCKS * BENCH_OTA_SRV_CLIENTS );
+  uint32 waits = benchOtaSrvWaits;
+  uint32 cut = hostMtOtaStats.cutCnt;
+  uint8 ok;
+
+  if ( rounds == 0 )
+  {
+    rounds = 1;
+  }
+
+  hostMtOtaCutReads( BENCH_OTA_SRV_CUT );
+  ok = ( benchOtaSrvRun( rounds ) != 0 ) && ( hostMtOtaStats.cutCnt != cut );
+  hostMtOtaCutReads( 0 );
+
+  // The figures reported are those of ota_srv
+  benchOtaSrvWaits = waits;
+
+  return ( ok );
+}
+
+/*********************************************************************
+ * @fn      benchOtaMcastTxHook
+ *
+ * @brief   Blocks the OTA server streams to the group come back to the
+ *          client one link delay later, but for every
+ *          BENCH_OTA_MCAST_LOSS-th, which is lost or, with
+ *          benchOtaMcastAbort set, replaced by an abort; unicast
+ *          requests go to the simulated server of benchOtaTxHook.
+ */
+static void benchOtaMcastTxHook( APSDE_DataReq_t *req )
+{
+  uint8 *pPayload = &req->asdu[3];
+  benchOtaRsp_t *pRsp = &benchOtaQueue[benchOtaQueued];
+  uint32 offset;
+  uint8 len;
+
+  if ( req->dstAddr.addrMode != AddrGroup )
+  {
+    benchOtaTxHook( req );
+    return;
+  }
+
+  if ( (req->clusterID != ZCL_CLUSTER_ID_OTA) || (req->asduLen < 3 + 14) ||
+       (req->asdu[2] != COMMAND_IMAGE_BLOCK_RSP) || (pPayload[0] != ZSuccess) )
+  {
+    benchOtaMcastBad = TRUE;
+    return;
+  }
+
+  offset = osal_build_uint32( &pPayload[9], 4 );
+  len = pPayload[13];
+  if ( (offset + len > BENCH_OTA_IMG_LEN) || memcmp( &pPayload[14], &benchOtaImage[offset], len ) )
+  {
+    benchOtaMcastBad = TRUE;
+    return;
+  }
+
+  if ( ( ++benchOtaMcastSent % BENCH_OTA_MCAST_LOSS ) == 0 )
+  {
+    benchOtaMcastLost++;
+    if ( !benchOtaMcastAbort || (benchOtaQueued == BENCH_OTA_QUEUE) )
+    {
+      return;
+    }
+
+    // Some other server aborting whatever the group downloads
+    pRsp->status = ZCL_STATUS_ABORT;
+  }
+  else
+  {
+    pRsp->status = ZCL_STATUS_SUCCESS;
+  }
+
+  if ( benchOtaQueued < BENCH_OTA_QUEUE )
+  {
+    pRsp->due = osal_GetSystemClock() + BENCH_OTA_LINK_MS;
+    pRsp->offset = offset;
+    pRsp->len = len;
+    pRsp->group = req->dstAddr.addr.shortAddr;
+    pRsp->cmd = COMMAND_IMAGE_BLOCK_RSP;
+    benchOtaQueued++;
+  }
+}
+
+/*********************************************************************
+ * @fn      benchOtaMcastRun
+ *
+ * @brief   Image downloads with the OTA server streaming the image to a
+ *          group the client is in. Every download must complete with
+ *          the image intact in the DL area and the server must stream
+ *          nothing but blocks.
+ *
+ * @param   downloads - number of downloads
+ *
+ * @return  TRUE if they all did
+ */
+static uint8 benchOtaMcastRun( uint32 downloads )
+{
+  uint32 failCnt = hostAppStats.otaFailCnt;
+  uint8 buf[OTA_MAX_MTU];
+  zclOTA_FileID_t fileId;
+  uint32 oset;
+  uint32 cnt;
+  uint8 ok = TRUE;
+#if OTA_MCAST_BLOCKS
+  afAddrType_t dstAddr;
+
+  dstAddr.addrMode = (afAddrMode_t)AddrGroup;
+  dstAddr.addr.shortAddr = BENCH_OTA_GROUP;
+  dstAddr.endPoint = ZCL_OTA_ENDPOINT;
+  dstAddr.panId = 0;
+#endif
+
+  benchOtaImageInit();
+  fileId.manufacturer = zclOTA_ManufacturerId;
+  fileId.type = zclOTA_ImageType;
+  fileId.version = BENCH_OTA_VERSION;
+  hostMtOtaSetImage( &fileId, benchOtaImage, BENCH_OTA_IMG_LEN );
+  (void)hostNwkAddGroup( BENCH_OTA_GROUP, ZCL_OTA_ENDPOINT );
+  hostNwkSetTxHook( benchOtaMcastTxHook );
+
+  benchOtaMcastBad = FALSE;
+  benchOtaMcastSent = 0;
+  benchOtaMcastLost = 0;
+
+  for ( cnt = 0; ok && (cnt < downloads); cnt++ )
+  {
+#if OTA_MCAST_BLOCKS
+    ok = ( zclOTA_SrvStreamImage( &dstAddr, &fileId, BENCH_OTA_IMG_LEN ) == ZSuccess );
+#endif
+    ok = ok && ( benchOtaDownload() != 0 ) && !benchOtaMcastBad;
+    for ( oset = 0; ok && (oset < BENCH_OTA_IMG_LEN); oset += sizeof( buf ) )
+    {
+      HalOTARead( oset, buf, sizeof( buf ), HAL_OTA_DL );
+      ok = !memcmp( buf, &benchOtaImage[oset], sizeof( buf ) );
+    }
+#if OTA_MCAST_BLOCKS
+    (void)zclOTA_SrvStreamImage( NULL, NULL, 0 );
+#endif
+  }
+
+  hostNwkSetTxHook( NULL );
+  hostNwkRemoveGroups();
+
+  return ( ok && (hostAppStats.otaFailCnt == failCnt) );
+}
+
+/*********************************************************************
+ * @fn      benchOtaMcast
+ *
+ * @brief   Streamed downloads (benchOtaMcastRun). With multicast on the
+ *          client must ask for no more than the lost blocks, allowing
+ *          for the block requests the simulated server loses itself.
+ */
+static uint8 benchOtaMcast( uint32 iterations )
+{
+  uint32 downloads = iterations / BENCH_OTA_BLOCKS;
+  uint32 reqCnt = benchOtaReqCnt;
+  uint8 ok;
+
+  if ( downloads == 0 )
+  {
+    downloads = 1;
+  }
+
+  ok = benchOtaMcastRun( downloads );
+
+  benchOtaMcastSent /= downloads;
+  benchOtaMcastLost /= downloads;
+  benchOtaMcastReqs = ( benchOtaReqCnt - reqCnt ) / downloads;
+#if OTA_MCAST_BLOCKS
+  ok = ok && ( benchOtaMcastSent == BENCH_OTA_BLOCKS ) &&
+       ( benchOtaMcastReqs <= benchOtaMcastLost + benchOtaMcastLost / 4 + 2 );
+#endif
+
+  return ( ok );
+}
+
+/*********************************************************************
+ * @fn      benchOtaMcastErr
+ *
+ * @brief   Streamed downloads (benchOtaMcastRun) with console reads
+ *          failing around BENCH_OTA_MCAST_BAD_OFFSET and the lost blocks
+ *          replaced by aborts sent to the group: the server must skip
+ *          the blocks it could not read rather than abort the group, and
+ *          the client must ignore the aborts. The offset is a page start:
+ *          with HAL_OTA_XNV_IS_INT, filling it erases the blocks held in
+ *          that page, which the client must then ask for again.
+ */
+static uint8 benchOtaMcastErr( uint32 iterations )
+{
+  uint32 downloads = iterations / BENCH_OTA_BLOCKS;
+  uint32 readFails = hostMtOtaStats.failCnt;
+  uint32 sent = benchOtaMcastSent;
+  uint32 lost = benchOtaMcastLost;
+  uint8 ok;
+
+  if ( downloads == 0 )
+  {
+    downloads = 1;
+  }
+
+  hostMtOtaFailReads( BENCH_OTA_MCAST_BAD_OFFSET, BENCH_OTA_MCAST_BAD_LEN );
+  benchOtaMcastAbort = TRUE;
+
+  ok = benchOtaMcastRun( downloads );
+
+  hostMtOtaFailReads( 0, 0 );
+  benchOtaMcastAbort = FALSE;
+#if OTA_MCAST_BLOCKS
+  ok = ok && ( hostMtOtaStats.failCnt != readFails ) &&
+       ( benchOtaMcastSent < downloads * BENCH_OTA_BLOCKS );
+#else
+  (void)readFails;
+#endif
+
+  // The figures reported are those of ota_mcast
+  benchOtaMcastSent = sent;
+  benchOtaMcastLost = lost;
+
+  return ( ok );
+}
+
+/*********************************************************************
+ * @fn      benchMmoRefHash
+ *
+ * @brief   Reference MMO hash: the message is copied and padded as the
+ *          ZigBee spec (Annex B.6) lays it out, then hashed a block at a
+ *          time, H(i) = E(H(i-1), M(i)) ^ M(i).
+ */
+static void benchMmoRefHash( const uint8 *pMsg, uint16 len, uint8 *pDigest )
+{
+  uint32 bits = (uint32)len * 8;
+  uint8 key[SSP_MMO_HASH_LEN];
+  uint16 padLen;
+  uint16 blk;
+  uint8 i;
+
+  memcpy( benchMmoPad, pMsg, len );
+  benchMmoPad[len] = 0x80;
+  padLen = len + 1;
+
+  if ( bits < 0x10000 )
+  {
+    while ( padLen % SSP_MMO_HASH_LEN != SSP_MMO_HASH_LEN - 2 )
+    {
+      benchMmoPad[padLen++] = 0;
+    }
+    benchMmoPad[padLen++] = (uint8)( bits >> 8 );
+    benchMmoPad[padLen++] = (uint8)bits;
+  }
+  else
+  {
+    while ( padLen % SSP_MMO_HASH_LEN != SSP_MMO_HASH_LEN - 6 )
+    {
+      benchMmoPad[padLen++] = 0;
+    }
+    benchMmoPad[padLen++] = (uint8)( bits >> 24 );
+    benchMmoPad[padLen++] = (uint8)( bits >> 16 );
+    benchMmoPad[padLen++] = (uint8)( bits >> 8 );
+    benchMmoPad[padLen++] = (uint8)bits;
+    benchMmoPad[padLen++] = 0;
+    benchMmoPad[padLen++] = 0;
+  }
+
+  memset( pDigest, 0, SSP_MMO_HASH_LEN );
+  for ( blk = 0; blk < padLen; blk += SSP_MMO_HASH_LEN )
+  {
+    memcpy( key, pDigest, SSP_MMO_HASH_LEN );
+    memcpy( pDigest, &benchMmoPad[blk], SSP_MMO_HASH_LEN );
+    ssp_HW_KeyInit( key );
+    sspAesEncryptHW( key, pDigest );
+    for ( i = 0; i < SSP_MMO_HASH_LEN; i++ )
+    {
+      pDigest[i] ^= benchMmoPad[blk + i];
+    }
+  }
+}
+
+/*********************************************************************
+ * @fn      benchMmoStream
+ *
+ * @brief   Hash a message with sspMMOHashUpdate calls of 0 to 37 bytes,
+ *          the sizes drawn from a seeded generator so every run is the
+ *          same, and check it against the reference hash.
+ */
+static uint8 benchMmoStream( uint16 len, uint32 *pSeed )
+{
+  sspMMOHash_t hash;
+  uint8 digest[SSP_MMO_HASH_LEN];
+  uint8 ref[SSP_MMO_HASH_LEN];
+  uint16 pos = 0;
+  uint16 cnt;
+
+  sspMMOHashInit( &hash );
+  while ( pos < len )
+  {
+    *pSeed = *pSeed * 1103515245 + 12345;
+    cnt = (uint16)( ( *pSeed >> 16 ) % 38 );
+    if ( cnt > len - pos )
+    {
+      cnt = len - pos;
+    }
+    sspMMOHashUpdate( &hash, &benchMmoMsg[pos], cnt );
+    pos += cnt;
+  }
+  sspMMOHashFinal( &hash, digest );
+
+  benchMmoRefHash( benchMmoMsg, len, ref );
+
+  return ( !memcmp( digest, ref, SSP_MMO_HASH_LEN ) );
+}
+
+/*********************************************************************
+ * @fn      benchMmoCheck
+ *
+ * @brief   Check the simulated AES engine and the MMO hash against their
+ *          known answers, then the piecewise hash against the reference
+ *          one over every message length up to BENCH_MMO_CHK_LEN and
+ *          either side of the switch to the long length padding.
+ */
+static uint8 benchMmoCheck( void )
+{
+  const benchMmoVector_t *pVec;
+  sspMMOHash_t hash;
+  uint8 digest[SSP_MMO_HASH_LEN];
+  uint8 buf[STATE_BLENGTH];
+  uint32 seed = 1;
+  uint16 len;
+  uint16 idx;
+
+  memcpy( buf, benchAesPlain, STATE_BLENGTH );
+  ssp_HW_KeyInit( (uint8 *)benchAesKey );
+  sspAesEncryptHW( (uint8 *)benchAesKey, buf );
+  if ( memcmp( buf, benchAesCipher, STATE_BLENGTH ) )
+  {
+    return ( FALSE );
+  }
+
+  for ( pVec = benchMmoVectors; pVec < &benchMmoVectors[sizeof( benchMmoVectors ) /
+                                                        sizeof( benchMmoVectors[0] )]; pVec++ )
+  {
+    for ( idx = 0; idx < pVec->len; idx++ )
+    {
+      benchMmoMsg[idx] = (uint8)( pVec->first + idx );
+    }
+
+    sspMMOHashInit( &hash );
+    sspMMOHashUpdate( &hash, benchMmoMsg, pVec->len );
+    sspMMOHashFinal( &hash, digest );
+    if ( memcmp( digest, pVec->digest, SSP_MMO_HASH_LEN ) )
+    {
+      return ( FALSE );
+    }
+
+    benchMmoRefHash( benchMmoMsg, pVec->len, digest );
+    if ( memcmp( digest, pVec->digest, SSP_MMO_HASH_LEN ) )
+    {
+      return ( FALSE );
+    }
+  }
+
+  for ( idx = 0; idx < BENCH_MMO_CHK_LONG_END; idx++ )
+  {
+    benchMmoMsg[idx] = (uint8)( idx * 31 + 7 );
+  }
+
+  for ( len = 0; len <= BENCH_MMO_CHK_LEN; len++ )
+  {
+    if ( !benchMmoStream( len, &seed ) )
+    {
+      return ( FALSE );
+    }
+  }
+
+  for ( len = BENCH_MMO_CHK_LONG; len < BENCH_MMO_CHK_LONG_END; len++ )
+  {
+    if ( !benchMmoStream( len, &seed ) )
+    {
+      return ( FALSE );
+    }
+  }
+
+  return ( TRUE );
+}
+
+/*********************************************************************
+ * @fn      benchMmo
+ *
+ * @brief   MMO hash of a message that arrives in pieces, as an OTA image
+ *          does, with sspMMOHashInit/Update/Final. Checked against the
+ *          reference hash.
+ */
+static uint8 benchMmo( uint32 iterations )
+{
+  sspMMOHash_t hash;
+  uint8 digest[SSP_MMO_HASH_LEN];
+  uint8 ref[SSP_MMO_HASH_LEN];
+  uint16 idx;
+
+  if ( !benchMmoCheck() )
+  {
+    return ( FALSE );
+  }
+
+  for ( idx = 0; idx < BENCH_MMO_MSG_LEN; idx++ )
+  {
+    benchMmoMsg[idx] = (uint8)( idx * 7 );
+  }
+
+  while ( iterations-- )
+  {
+    sspMMOHashInit( &hash );
+    sspMMOHashUpdate( &hash, benchMmoMsg, BENCH_MMO_UPD_1 );
+    sspMMOHashUpdate( &hash, &benchMmoMsg[BENCH_MMO_UPD_1], BENCH_MMO_UPD_2 );
+    sspMMOHashUpdate( &hash, &benchMmoMsg[BENCH_MMO_UPD_1 + BENCH_MMO_UPD_2],
+                      BENCH_MMO_MSG_LEN - BENCH_MMO_UPD_1 - BENCH_MMO_UPD_2 );
+    sspMMOHashFinal( &hash, digest );
+  }
+
+  benchMmoRefHash( benchMmoMsg, BENCH_MMO_MSG_LEN, ref );
+
+  return ( !memcmp( digest, ref, SSP_MMO_HASH_LEN ) );
+}
+
+/*********************************************************************
+ * @fn      benchMmoRef
+ *
+ * @brief   The same hash with the reference implementation.
+ */
+static uint8 benchMmoRef( uint32 iterations )
+{
+  sspMMOHash_t hash;
+  uint8 digest[SSP_MMO_HASH_LEN];
+  uint8 ref[SSP_MMO_HASH_LEN];
+  uint16 idx;
+
+  for ( idx = 0; idx < BENCH_MMO_MSG_LEN; idx++ )
+  {
+    benchMmoMsg[idx] = (uint8)( idx * 7 );
+  }
+
+  while ( iterations-- )
+  {
+    benchMmoRefHash( benchMmoMsg, BENCH_MMO_MSG_LEN, ref );
+  }
+
+  sspMMOHashInit( &hash );
+  sspMMOHashUpdate( &hash, benchMmoMsg, BENCH_MMO_MSG_LEN );
+  sspMMOHashFinal( &hash, digest );
+
+  return ( !memcmp( digest, ref, SSP_MMO_HASH_LEN ) );
+}
+
+/*********************************************************************
+ * @fn      main
+ *
+ * @brief   Bring up OSAL the way ZMain does, then run the benchmarks.
+ */
+int main( int argc, char *argv[] )
+{
+  uint32 iterations = BENCH_DEFAULT_ITERATIONS;
+  const char *flashFile = NULL;
+  const char *only = NULL;
+  uint8 failed = 0;
+  uint8 idx;
+  int arg;
+
+  for ( arg = 1; arg < argc; arg++ )
+  {
+    if ( !strcmp( argv[arg], "-n" ) && (arg + 1 < argc) )
+    {
+      iterations = (uint32)strtoul( argv[++arg], NULL, 0 );
+    }
+    else if ( !strcmp( argv[arg], "-f" ) && (arg + 1 < argc) )
+    {
+      flashFile = argv[++arg];
+    }
+    else if ( !strcmp( argv[arg], "-b" ) && (arg + 1 < argc) )
+    {
+      only = argv[++arg];
+    }
+    else
+    {
+      fprintf( stderr, "usage: %s [-n iterations] [-f flash_image] [-b name]\n", argv[0] );
+      return ( EXIT_FAILURE );
+    }
+  }
+
+  if ( flashFile && !halHostFlashAttach( flashFile ) )
+  {
+    fprintf( stderr, "cannot open flash image %s\n", flashFile );
+    return ( EXIT_FAILURE );
+  }
+
+  // Same order as ZMain: interrupts off, NV, then OSAL and its tasks.
+  osal_int_disable( INTS_ALL );
+  osal_nv_init( NULL );
+  osal_init_system();
+  osal_int_enable( INTS_ALL );
+  hostNwkReset();
+
+  printf( "%-12s %10s %10s %8s %8s %8s  %s\n",
+          "benchmark", "iter", "ns/op", "heap_hw", "heap_use", "blk_max", "description" );
+
+  for ( idx = 0; idx < BENCH_ITEM_CNT; idx++ )
+  {
+    const benchItem_t *pItem = &benchItems[idx];
+    uint64_t start, elapsed;
+    uint8 ok;
+
+    if ( only && strcmp( only, pItem->name ) )
+    {
+      continue;
+    }
+
+    start = hostBenchNow();
+    ok = pItem->run( iterations );
+    elapsed = hostBenchNow() - start;
+
+    printf( "%-12s %10u %10.1f %8u %8u %8u  %s%s\n",
+            pItem->name, (unsigned)iterations,
+            iterations ? (double)elapsed / iterations : 0.0,
+            (unsigned)osal_heap_high_water(), (unsigned)osal_heap_mem_used(),
+            (unsigned)osal_heap_block_max(),
+            pItem->desc, ok ? "" : "  ** FAILED **" );
+
+    if ( !ok )
+    {
+      failed++;
+    }
+  }
+
+  printf( "flash: %u writes, %u erases; aps: %u tx, %u rx\n",
+          (unsigned)halHostFlashWriteCount(), (unsigned)halHostFlashEraseCount(),
+          (unsigned)hostNwkStats.txCount, (unsigned)hostNwkStats.rxCount );
+
+#if ( OSAL_NV_DIR_MAX )
+  {
+    osalNvDirStats_t stats;
+
+    osal_nv_dir_stats( &stats );
+    printf( "nv dir: %lu hit %lu absent %lu scan, %u of %u items%s\n",
+            (unsigned long)stats.hits, (unsigned long)stats.absent, (unsigned long)stats.scans,
+            (unsigned)stats.cnt, (unsigned)stats.max, stats.complete ? "" : ", partial" );
+  }
+#endif
+
+#if ( OSAL_NV_JRN_ITEMS || OSAL_NV_DEFER_CNT )
+  {
+    osalNvJrnStats_t stats;
+
+    osal_nv_jrn_stats( &stats );
+    printf( "nv jrn: %lu append %lu copy, %lu deferred %lu flushed %lu failed, %u items\n",
+            (unsigned long)stats.appends, (unsigned long)stats.copies,
+            (unsigned long)stats.deferred, (unsigned long)stats.flushed,
+            (unsigned long)stats.failed, (unsigned)stats.items );
+  }
+#endif
+
+#if ( OSALMEM_SLAB && OSALMEM_METRICS )
+  {
+    osalMemSlabStats_t stats;
+
+    for ( idx = 0; osal_heap_slab_stats( idx, &stats ); idx++ )
+    {
+      printf( "slab %3u: %10lu hit %10lu miss, %3u cached, %3u max live\n",
+              (unsigned)stats.blkSz, (unsigned long)stats.hit, (unsigned long)stats.miss,
+              (unsigned)stats.cached, (unsigned)stats.max );
+    }
+  }
+#endif
+
+  if ( benchOtaWinCnt )
+  {
+    printf( "ota:" );
+    for ( idx = 0; idx < benchOtaWinCnt; idx++ )
+    {
+      printf( "%s window %u %lu B/s", idx ? "," : "", (unsigned)benchOtaWin[idx],
+              (unsigned long)benchOtaRate[idx] );
+    }
+    printf( "\n" );
+  }
+
+  if ( benchOtaSrvRate )
+  {
+    printf( "ota srv: %u clients %lu B/s, %lu console reads per round, %lu waits",
+            (unsigned)BENCH_OTA_SRV_CLIENTS, (unsigned long)benchOtaSrvRate,
+            (unsigned long)benchOtaSrvReads, (unsigned long)benchOtaSrvWaits );
+#if (defined OTA_SERVER) && (OTA_SERVER == TRUE) && OTA_SRV_CACHE_PAGES
+    printf( "; cache %lu hit %lu miss %lu read %lu prefetch %lu busy",
+            (unsigned long)zclOTA_SrvCacheStats.hits, (unsigned long)zclOTA_SrvCacheStats.misses,
+            (unsigned long)zclOTA_SrvCacheStats.reads,
+            (unsigned long)zclOTA_SrvCacheStats.prefetches,
+            (unsigned long)zclOTA_SrvCacheStats.busy );
+#endif
+    printf( "\n" );
+  }
+
+  if ( benchOtaMcastSent || benchOtaMcastReqs )
+  {
+    // Air time of a fleet upgrade: the stream once, then a request and a response per gap
+    printf( "ota mcast: %lu streamed %lu lost, %lu block requests per download; "
+            "%u devices: %lu frames, %lu unicast\n",
+            (unsigned long)benchOtaMcastSent, (unsigned long)benchOtaMcastLost,
+            (unsigned long)benchOtaMcastReqs, (unsigned)BENCH_OTA_MCAST_FLEET,
+            (unsigned long)( benchOtaMcastSent + 2 * BENCH_OTA_MCAST_FLEET * benchOtaMcastReqs ),
+            (unsigned long)( 2 * BENCH_OTA_MCAST_FLEET * BENCH_OTA_BLOCKS ) );
+  }
+
+  halHostFlashDetach();
+
+  return ( failed ? EXIT_FAILURE : EXIT_SUCCESS );
+}
+
+/*********************************************************************
+*********************************************************************/
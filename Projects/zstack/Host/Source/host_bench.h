@@ -0,0 +1,44 @@
+/**************************************************************************************************
+  Filename:       host_bench.h
+
+  Description:    Helpers shared by the host benchmarks.
+
+**************************************************************************************************/
+
+#ifndef HOST_BENCH_H
+#define HOST_BENCH_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include <stdint.h>
+
+#include "ZComDef.h"
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * Monotonic wall clock in nanoseconds
+ */
+extern uint64_t hostBenchNow( void );
+
+/*
+ * Run the OSAL scheduler until no task has an event pending
+ */
+extern uint32 hostBenchRunUntilIdle( void );
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_BENCH_H */
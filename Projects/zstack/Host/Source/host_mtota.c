@@ -0,0 +1,439 @@
+/**************************************************************************************************
+  Filename:       host_mtota.c
+
+  Description:    Host stand-in for the OTA console behind the MT OTA file system: replaces
+                  MT_OTA.c. Requests and replies cross a simulated serial link one frame at a
+                  time in each direction, so a busy server queues behind it just as the dongle
+                  does behind its UART.
+
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+#include "ZComDef.h"
+#include "OSAL.h"
+#include "OSAL_Clock.h"
+#include "MT.h"
+#include "MT_OTA.h"
+
+#include "ota_common.h"
+
+#include "host_mtota.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// MT frame overhead: SOF, length, command (2) and FCS
+#define HOST_MTOTA_FRAME_OVHD     5
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef struct
+{
+  uint32 due;                 // System clock (us) at which the reply is in
+  zclOTA_FileID_t fileId;
+  afAddrType_t addr;
+  uint32 offset;
+  uint8 cmd;                  // MT_OTA_FILE_READ_RSP or MT_OTA_NEXT_IMG_RSP
+  uint8 len;
+  uint8 options;
+  uint8 fail;                 // Read answered with a failure
+  uint8 lost;                 // Reply never comes back
+  uint8 cut;                  // Reply carries half the bytes read
+} hostMtOtaReq_t;
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+hostMtOtaStats_t hostMtOtaStats;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static uint8 hostMtOtaTask = 0xFF;
+
+static zclOTA_FileID_t hostMtOtaFileId;
+static const uint8 *hostMtOtaImage;
+static uint32 hostMtOtaImageLen;
+
+// File reads that touch these bytes fail
+static uint32 hostMtOtaFailOffset;
+static uint32 hostMtOtaFailLen;
+
+// Every hostMtOtaLoseEvery-th file read reply is lost, none if 0
+static uint16 hostMtOtaLoseEvery;
+static uint16 hostMtOtaLoseCnt;
+
+// Every hostMtOtaCutEvery-th file read reply is cut short, none if 0
+static uint16 hostMtOtaCutEvery;
+static uint16 hostMtOtaCutCnt;
+
+// Replies in flight, due in queue order
+static hostMtOtaReq_t hostMtOtaQueue[HOST_MTOTA_QUEUE];
+static uint8 hostMtOtaHead;
+static uint8 hostMtOtaCnt;
+
+// Serial link busy until (us), towards the console and back
+static uint32 hostMtOtaTxFree;
+static uint32 hostMtOtaRxFree;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+static uint32 hostMtOtaNow( void );
+static hostMtOtaReq_t *hostMtOtaQueueReq( afAddrType_t *pAddr, zclOTA_FileID_t *pFileId,
+                                          uint8 reqLen, uint8 rspLen );
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      hostMtOtaSetImage
+ *
+ * @brief   Serve an image for the given file ID.
+ *
+ * @param   pFileId - ID the image is served under
+ * @param   pImage - the OTA file, kept by reference
+ * @param   len - its length
+ *
+ * @return  none
+ */
+void hostMtOtaSetImage( zclOTA_FileID_t *pFileId, const uint8 *pImage, uint32 len )
+{
+  hostMtOtaFileId = *pFileId;
+  hostMtOtaImage = pImage;
+  hostMtOtaImageLen = len;
+
+  // The link is idle from now on, wherever the clock is
+  hostMtOtaHead = 0;
+  hostMtOtaCnt = 0;
+  hostMtOtaTxFree = hostMtOtaNow();
+  hostMtOtaRxFree = hostMtOtaTxFree;
+}
+
+/*********************************************************************
+ * @fn      hostMtOtaFailReads
+ *
+ * @brief   Have the console fail the file reads that touch part of
+ *          the image, as it does when that part cannot be read.
+ *
+ * @param   offset - first byte that cannot be read
+ * @param   len - number of bytes, 0 for none
+ *
+ * @return  none
+ */
+void hostMtOtaFailReads( uint32 offset, uint32 len )
+{
+  hostMtOtaFailOffset = offset;
+  hostMtOtaFailLen = len;
+}
+
+/*********************************************************************
+ * @fn      hostMtOtaLoseReads
+ *
+ * @brief   Have the replies to some file reads get lost on the way back
+ *          from the console.
+ *
+ * @param   every - every how many replies is lost, 0 for none
+ *
+ * @return  none
+ */
+void hostMtOtaLoseReads( uint16 every )
+{
+  hostMtOtaLoseEvery = every;
+  hostMtOtaLoseCnt = 0;
+}
+
+/*********************************************************************
+ * @fn      hostMtOtaCutReads
+ *
+ * @brief   Have the console return half the bytes asked for by some
+ *          file reads, wherever they are in the image.
+ *
+ * @param   every - every how many replies is cut short, 0 for none
+ *
+ * @return  none
+ */
+void hostMtOtaCutReads( uint16 every )
+{
+  hostMtOtaCutEvery = every;
+  hostMtOtaCutCnt = 0;
+}
+
+/*********************************************************************
+ * @fn      hostMtOtaNextDue
+ *
+ * @brief   Time until the next reply is in.
+ *
+ * @param   none
+ *
+ * @return  Milliseconds, 0 if already due, HOST_MTOTA_NONE if none
+ */
+uint32 hostMtOtaNextDue( void )
+{
+  int32 left;
+
+  if ( hostMtOtaCnt == 0 )
+  {
+    return ( HOST_MTOTA_NONE );
+  }
+
+  left = (int32)( hostMtOtaQueue[hostMtOtaHead].due - hostMtOtaNow() );
+
+  return ( (left > 0) ? ((uint32)left + 999) / 1000 : 0 );
+}
+
+/*********************************************************************
+ * @fn      hostMtOtaPoll
+ *
+ * @brief   Deliver the replies that are due to the registered task,
+ *          formatted as the console sends them.
+ *
+ * @param   none
+ *
+ * @return  Number of replies delivered
+ */
+uint8 hostMtOtaPoll( void )
+{
+  uint32 now = hostMtOtaNow();
+  hostMtOtaReq_t *pReq;
+  OTA_MtMsg_t *pMsg;
+  uint8 *p;
+  uint8 cnt = 0;
+  uint8 status;
+
+  while ( hostMtOtaCnt && ((int32)(hostMtOtaQueue[hostMtOtaHead].due - now) <= 0) )
+  {
+    pReq = &hostMtOtaQueue[hostMtOtaHead];
+    hostMtOtaHead = (hostMtOtaHead + 1) % HOST_MTOTA_QUEUE;
+    hostMtOtaCnt--;
+
+    if ( pReq->lost )
+    {
+      continue;
+    }
+
+    status = ( (hostMtOtaImage != NULL) &&
+               (pReq->fileId.manufacturer == hostMtOtaFileId.manufacturer) &&
+               (pReq->fileId.type == hostMtOtaFileId.type) &&
+               (pReq->fileId.version == hostMtOtaFileId.version) ) ? ZSuccess : ZFailure;
+
+    pMsg = (OTA_MtMsg_t *)osal_msg_allocate( sizeof( OTA_MtMsg_t ) + MT_OTA_FILE_READ_RSP_LEN +
+                                             pReq->len );
+    if ( (pMsg == NULL) || (hostMtOtaTask == 0xFF) )
+    {
+      if ( pMsg != NULL )
+      {
+        osal_msg_deallocate( (uint8 *)pMsg );
+      }
+      continue;
+    }
+
+    pMsg->hdr.event = MT_SYS_OTA_MSG;
+    pMsg->cmd = pReq->cmd;
+
+    p = OTA_FileIdToStream( &pReq->fileId, pMsg->data );
+    p = OTA_AfAddrToStream( &pReq->addr, p );
+
+    if ( pReq->cmd == MT_OTA_FILE_READ_RSP )
+    {
+      if ( (status == ZSuccess) && !pReq->fail && (pReq->offset < hostMtOtaImageLen) )
+      {
+        if ( pReq->len > hostMtOtaImageLen - pReq->offset )
+        {
+          pReq->len = (uint8)( hostMtOtaImageLen - pReq->offset );
+        }
+        if ( pReq->cut )
+        {
+          pReq->len /= 2;
+        }
+      }
+      else
+      {
+        status = ZFailure;
+        pReq->len = 0;
+      }
+
+      *p++ = status;
+      p = osal_buffer_uint32( p, pReq->offset );
+      *p++ = pReq->len;
+      osal_memcpy( p, &hostMtOtaImage[pReq->offset], pReq->len );
+      hostMtOtaStats.readBytes += pReq->len;
+    }
+    else
+    {
+      *p++ = status;
+      *p++ = pReq->options;
+      p = osal_buffer_uint32( p, hostMtOtaImageLen );
+    }
+
+    osal_msg_send( hostMtOtaTask, (uint8 *)pMsg );
+    cnt++;
+  }
+
+  return ( cnt );
+}
+
+/*********************************************************************
+ * MT OTA (MT_OTA.c)
+ */
+
+void MT_OtaRegister( uint8 taskId )
+{
+  hostMtOtaTask = taskId;
+}
+
+uint8 MT_OtaFileReadReq( afAddrType_t *pAddr, zclOTA_FileID_t *pFileId, uint8 len, uint32 offset )
+{
+  hostMtOtaReq_t *pReq;
+
+  pReq = hostMtOtaQueueReq( pAddr, pFileId, MT_OTA_FILE_READ_REQ_LEN,
+                            MT_OTA_FILE_READ_RSP_LEN + len );
+  if ( pReq == NULL )
+  {
+    return ( ZMemError );
+  }
+
+  pReq->cmd = MT_OTA_FILE_READ_RSP;
+  pReq->offset = offset;
+  pReq->len = len;
+  hostMtOtaStats.readCnt++;
+
+  pReq->fail = ( (offset < hostMtOtaFailOffset + hostMtOtaFailLen) &&
+                 (offset + len > hostMtOtaFailOffset) );
+  if ( pReq->fail )
+  {
+    hostMtOtaStats.failCnt++;
+  }
+
+  pReq->lost = ( hostMtOtaLoseEvery && ( ++hostMtOtaLoseCnt % hostMtOtaLoseEvery ) == 0 );
+  if ( pReq->lost )
+  {
+    hostMtOtaStats.lostCnt++;
+  }
+
+  pReq->cut = ( hostMtOtaCutEvery && ( ++hostMtOtaCutCnt % hostMtOtaCutEvery ) == 0 );
+  if ( pReq->cut )
+  {
+    hostMtOtaStats.cutCnt++;
+  }
+
+  return ( ZSuccess );
+}
+
+uint8 MT_OtaGetImage( afAddrType_t *pAddr, zclOTA_FileID_t *pFileId, uint16 hwVer,
+                      uint8 *ieee, uint8 options )
+{
+  hostMtOtaReq_t *pReq;
+
+  (void)hwVer;
+  (void)ieee;
+
+  pReq = hostMtOtaQueueReq( pAddr, pFileId, MT_OTA_GET_IMG_MSG_LEN, MT_OTA_FILE_READ_RSP_LEN );
+  if ( pReq == NULL )
+  {
+    return ( ZMemError );
+  }
+
+  // The console offers its image whatever version the device runs
+  pReq->fileId = hostMtOtaFileId;
+  pReq->cmd = MT_OTA_NEXT_IMG_RSP;
+  pReq->options = options;
+  hostMtOtaStats.imgReqCnt++;
+
+  return ( ZSuccess );
+}
+
+uint8 MT_OtaSendStatus( uint16 shortAddr, uint8 type, uint8 status, uint8 optional )
+{
+  (void)shortAddr;
+  (void)type;
+  (void)status;
+  (void)optional;
+
+  hostMtOtaStats.statusCnt++;
+
+  return ( ZSuccess );
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      hostMtOtaNow
+ *
+ * @brief   OSAL system clock in microseconds.
+ */
+static uint32 hostMtOtaNow( void )
+{
+  return ( osal_GetSystemClock() * 1000 );
+}
+
+/*********************************************************************
+ * @fn      hostMtOtaQueueReq
+ *
+ * @brief   Queue a request: its frame follows the frames already
+ *          going to the console, the console takes its turnaround,
+ *          and the reply follows the replies already coming back.
+ *
+ * @param   pAddr - device the request is for
+ * @param   pFileId - file requested
+ * @param   reqLen - MT payload length of the request
+ * @param   rspLen - MT payload length of the reply
+ *
+ * @return  Queue entry, NULL if the console is busy
+ */
+static hostMtOtaReq_t *hostMtOtaQueueReq( afAddrType_t *pAddr, zclOTA_FileID_t *pFileId,
+                                          uint8 reqLen, uint8 rspLen )
+{
+  hostMtOtaReq_t *pReq;
+  uint32 now = hostMtOtaNow();
+  uint32 ready;
+
+  if ( hostMtOtaCnt == HOST_MTOTA_QUEUE )
+  {
+    hostMtOtaStats.busyCnt++;
+    return ( NULL );
+  }
+
+  pReq = &hostMtOtaQueue[(hostMtOtaHead + hostMtOtaCnt) % HOST_MTOTA_QUEUE];
+  hostMtOtaCnt++;
+
+  if ( (int32)(hostMtOtaTxFree - now) < 0 )
+  {
+    hostMtOtaTxFree = now;
+  }
+  hostMtOtaTxFree += ( reqLen + HOST_MTOTA_FRAME_OVHD ) * HOST_MTOTA_BYTE_US;
+
+  ready = hostMtOtaTxFree + HOST_MTOTA_TURN_US;
+  if ( (int32)(hostMtOtaRxFree - ready) < 0 )
+  {
+    hostMtOtaRxFree = ready;
+  }
+  hostMtOtaRxFree += ( rspLen + HOST_MTOTA_FRAME_OVHD ) * HOST_MTOTA_BYTE_US;
+
+  pReq->due = hostMtOtaRxFree;
+  pReq->fileId = *pFileId;
+  pReq->addr = *pAddr;
+  pReq->offset = 0;
+  pReq->len = 0;
+  pReq->options = 0;
+  pReq->fail = FALSE;
+  pReq->lost = FALSE;
+  pReq->cut = FALSE;
+
+  return ( pReq );
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,102 @@
+/**************************************************************************************************
+  Filename:       host_mtota.h
+
+  Description:    Host stand-in for the OTA console behind the MT OTA file system. The MT OTA
+                  requests of the ZCL OTA server are answered from one image held in RAM, the
+                  replies queued behind a simulated serial link and delivered to the registered
+                  task as MT_SYS_OTA_MSG messages, as MT_OtaCommandProcessing() would.
+
+**************************************************************************************************/
+
+#ifndef HOST_MTOTA_H
+#define HOST_MTOTA_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "ZComDef.h"
+#include "zcl_ota.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Serial link to the console: byte time at 115200 baud and the
+// console's turnaround per request, both in microseconds
+#define HOST_MTOTA_BYTE_US        87
+#define HOST_MTOTA_TURN_US        4000
+
+// Requests the console holds before MT_OtaFileReadReq() fails
+#define HOST_MTOTA_QUEUE          16
+
+#define HOST_MTOTA_NONE           0xFFFFFFFF
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+typedef struct
+{
+  uint32 imgReqCnt;       // MT_OTA_NEXT_IMG_REQ frames
+  uint32 readCnt;         // MT_OTA_FILE_READ_REQ frames
+  uint32 readBytes;       // Image bytes returned by the reads
+  uint32 statusCnt;       // MT_OTA_STATUS_IND frames
+  uint32 busyCnt;         // Requests refused with the queue full
+  uint32 failCnt;         // Reads answered with a failure
+  uint32 lostCnt;         // Read replies lost
+  uint32 cutCnt;          // Read replies cut short
+} hostMtOtaStats_t;
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+extern hostMtOtaStats_t hostMtOtaStats;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * Serve an image (not copied) for the given file ID, dropping the replies in flight
+ */
+extern void hostMtOtaSetImage( zclOTA_FileID_t *pFileId, const uint8 *pImage, uint32 len );
+
+/*
+ * Fail the file reads that touch len bytes from offset, none if len is 0
+ */
+extern void hostMtOtaFailReads( uint32 offset, uint32 len );
+
+/*
+ * Lose every given-th file read reply from now on, none if 0
+ */
+extern void hostMtOtaLoseReads( uint16 every );
+
+/*
+ * Return half the bytes asked for by every given-th file read from now on, none if 0
+ */
+extern void hostMtOtaCutReads( uint16 every );
+
+/*
+ * Milliseconds until the next reply is due, HOST_MTOTA_NONE if none is in flight
+ */
+extern uint32 hostMtOtaNextDue( void );
+
+/*
+ * Deliver the replies that are due, returns how many were delivered
+ */
+extern uint8 hostMtOtaPoll( void );
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_MTOTA_H */
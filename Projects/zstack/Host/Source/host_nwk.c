@@ -0,0 +1,477 @@
+/**************************************************************************************************
+  Filename:       host_nwk.c
+
+  Description:    Host simulation of the layers below AF (APS, NWK, routing). Only the entry
+                  points referenced by AF.c and the ZCL (including the few ZDO calls of the
+                  OTA client) are provided; the behaviour is that of a formed network with
+                  every destination one hop away.
+
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+#include "ZComDef.h"
+#include "OSAL.h"
+#include "AF.h"
+#include "APSMEDE.h"
+#include "aps_frag.h"
+#include "aps_groups.h"
+#include "NLMEDE.h"
+#include "nwk_util.h"
+#include "rtg.h"
+#include "ZDObject.h"
+#include "ZDProfile.h"
+
+#include "host_nwk.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Frame budget of a CC2530 frame, used to derive the same MTU the real APS reports.
+#define HOST_PHY_MAX_FRAME        127
+#define HOST_MAC_OVERHEAD         (9 + 2)  // Header with short addresses + FCS
+#define HOST_NWK_HDR              8
+#define HOST_NWK_SEC_OVERHEAD     (14 + 4) // Auxiliary header + MIC
+#define HOST_APS_HDR              8
+#define HOST_APS_SEC_OVERHEAD     (5 + 4)  // Auxiliary header + MIC
+
+#define HOST_APS_MTU              (HOST_PHY_MAX_FRAME - HOST_MAC_OVERHEAD - HOST_NWK_HDR - \
+                                   HOST_NWK_SEC_OVERHEAD - HOST_APS_HDR)
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+hostNwkStats_t hostNwkStats;
+
+// Fragmentation is not linked into the host build
+APSF_SendFragmented_t *apsfSendFragmented = NULL;
+
+// ZDP transaction sequence number, bumped by the ZDP requests below
+byte ZDP_TransID = 0;
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+static hostNwkTxHook_t hostNwkTxHook = NULL;
+static uint8 hostNwkApsCounter = 0;
+
+static struct
+{
+  uint16 groupID;
+  uint8 endPoint;
+} hostNwkGroups[HOST_NWK_GROUP_MAX];
+static uint8 hostNwkGroupCnt = 0;
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+static void hostNwkRx( uint16 frmCtrl, uint16 groupID, uint16 srcAddr, uint8 srcEP, uint8 dstEP,
+                       uint16 clusterID, uint16 profileID, uint8 *asdu, uint8 len );
+
+/*********************************************************************
+ * PUBLIC FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      hostNwkReset
+ *
+ * @brief   Reset the statistics and the Tx capture.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void hostNwkReset( void )
+{
+  osal_memset( &hostNwkStats, 0, sizeof( hostNwkStats ) );
+}
+
+/*********************************************************************
+ * @fn      hostNwkSetTxHook
+ *
+ * @brief   Install a hook that sees every outgoing APS data request.
+ *
+ * @param   hook - function to call, NULL to remove
+ *
+ * @return  none
+ */
+void hostNwkSetTxHook( hostNwkTxHook_t hook )
+{
+  hostNwkTxHook = hook;
+}
+
+/*********************************************************************
+ * @fn      hostNwkDeliver
+ *
+ * @brief   Deliver a unicast data frame to AF as if APS had just
+ *          received it from 'srcAddr'.
+ *
+ * @param   srcAddr - short address of the sender
+ * @param   srcEP - source endpoint
+ * @param   dstEP - destination endpoint
+ * @param   clusterID - cluster ID
+ * @param   profileID - profile ID
+ * @param   asdu - payload (the ZCL frame)
+ * @param   len - payload length
+ *
+ * @return  none
+ */
+void hostNwkDeliver( uint16 srcAddr, uint8 srcEP, uint8 dstEP, uint16 clusterID,
+                     uint16 profileID, uint8 *asdu, uint8 len )
+{
+  hostNwkRx( APS_DATA_FRAME | APS_FC_DM_UNICAST, 0, srcAddr, srcEP, dstEP,
+             clusterID, profileID, asdu, len );
+}
+
+/*********************************************************************
+ * @fn      hostNwkDeliverGroup
+ *
+ * @brief   Deliver a group addressed data frame to AF, which hands it
+ *          to every endpoint of the group in the simulated group table.
+ *
+ * @param   srcAddr - short address of the sender
+ * @param   srcEP - source endpoint
+ * @param   groupID - destination group
+ * @param   clusterID - cluster ID
+ * @param   profileID - profile ID
+ * @param   asdu - payload (the ZCL frame)
+ * @param   len - payload length
+ *
+ * @return  none
+ */
+void hostNwkDeliverGroup( uint16 srcAddr, uint8 srcEP, uint16 groupID, uint16 clusterID,
+                          uint16 profileID, uint8 *asdu, uint8 len )
+{
+  hostNwkRx( APS_DATA_FRAME | APS_FC_DM_GROUP, groupID, srcAddr, srcEP, AF_BROADCAST_ENDPOINT,
+             clusterID, profileID, asdu, len );
+}
+
+/*********************************************************************
+ * @fn      hostNwkAddGroup
+ *
+ * @brief   Add an endpoint to a group of the simulated group table.
+ *
+ * @param   groupID - group
+ * @param   endPoint - member endpoint
+ *
+ * @return  ZSuccess, or ZApsTableFull
+ */
+ZStatus_t hostNwkAddGroup( uint16 groupID, uint8 endPoint )
+{
+  if ( hostNwkGroupCnt == HOST_NWK_GROUP_MAX )
+  {
+    return ( ZApsTableFull );
+  }
+
+  hostNwkGroups[hostNwkGroupCnt].groupID = groupID;
+  hostNwkGroups[hostNwkGroupCnt].endPoint = endPoint;
+  hostNwkGroupCnt++;
+
+  return ( ZSuccess );
+}
+
+/*********************************************************************
+ * @fn      hostNwkRemoveGroups
+ *
+ * @brief   Empty the simulated group table.
+ *
+ * @param   none
+ *
+ * @return  none
+ */
+void hostNwkRemoveGroups( void )
+{
+  hostNwkGroupCnt = 0;
+}
+
+/*********************************************************************
+ * LOCAL FUNCTIONS
+ */
+
+/*********************************************************************
+ * @fn      hostNwkRx
+ *
+ * @brief   Build the APS frame of a received data frame and pass it
+ *          to afIncomingData.
+ *
+ * @return  none
+ */
+static void hostNwkRx( uint16 frmCtrl, uint16 groupID, uint16 srcAddr, uint8 srcEP, uint8 dstEP,
+                       uint16 clusterID, uint16 profileID, uint8 *asdu, uint8 len )
+{
+  aps_FrameFormat_t aff;
+  zAddrType_t src;
+  NLDE_Signal_t sig;
+
+  aff.FrmCtrl = frmCtrl;
+  aff.XtndFrmCtrl = 0;
+  aff.DstEndPoint = dstEP;
+  aff.SrcEndPoint = srcEP;
+  aff.GroupID = groupID;
+  aff.ClusterID = clusterID;
+  aff.ProfileID = profileID;
+  aff.macDestAddr = HOST_NWK_SHORT_ADDR;
+  aff.wasBroadcast = FALSE;
+  aff.apsHdrLen = HOST_APS_HDR;
+  aff.asdu = asdu;
+  aff.asduLength = len;
+  aff.ApsCounter = hostNwkApsCounter++;
+  aff.transID = 0;
+  aff.BlkCount = 0;
+  aff.AckBits = 0;
+  aff.macSrcAddr = srcAddr;
+
+  src.addrMode = Addr16Bit;
+  src.addr.shortAddr = srcAddr;
+
+  sig.LinkQuality = 0xFF;
+  sig.correlation = 110;
+  sig.rssi = -40;
+
+  hostNwkStats.rxCount++;
+  hostNwkStats.rxBytes += len;
+
+  afIncomingData( &aff, &src, HOST_NWK_PAN_ID, &sig, 0, FALSE, osal_GetSystemClock(), 0 );
+}
+
+/*********************************************************************
+ * SIMULATED STACK ENTRY POINTS
+ */
+
+/*********************************************************************
+ * @fn      APSDE_DataReq
+ *
+ * @brief   Capture an outgoing request instead of transmitting it.
+ *
+ * @param   req - APS data request built by AF
+ *
+ * @return  ZSuccess
+ */
+ZStatus_t APSDE_DataReq( APSDE_DataReq_t *req )
+{
+  uint16 len = req->asduLen;
+
+  hostNwkStats.txCount++;
+  hostNwkStats.txBytes += len;
+
+  if ( len > HOST_NWK_CAPTURE_MAX )
+  {
+    len = HOST_NWK_CAPTURE_MAX;
+  }
+  osal_memcpy( hostNwkStats.lastTx, req->asdu, len );
+  hostNwkStats.lastTxLen = len;
+  hostNwkStats.lastTxCluster = req->clusterID;
+
+  if ( hostNwkTxHook )
+  {
+    hostNwkTxHook( req );
+  }
+
+  return ( ZSuccess );
+}
+
+/*********************************************************************
+ * @fn      APSDE_DataReqMTU
+ *
+ * @brief   MTU of the APS data service for a CC2530 frame with NWK
+ *          security always on.
+ *
+ * @param   fields - APS security selection
+ *
+ * @return  Maximum ASDU length
+ */
+uint8 APSDE_DataReqMTU( APSDE_DataReqMTU_t *fields )
+{
+  uint8 mtu = HOST_APS_MTU;
+
+  if ( fields->secure )
+  {
+    mtu -= HOST_APS_SEC_OVERHEAD;
+  }
+
+  return ( mtu );
+}
+
+/*********************************************************************
+ * @fn      aps_FindGroupForEndpoint
+ *
+ * @brief   Next endpoint of a group in the simulated group table, in
+ *          the order the memberships were added.
+ *
+ * @param   groupID - group
+ * @param   lastEP - endpoint returned by the previous call, or
+ *                   APS_GROUPS_FIND_FIRST
+ *
+ * @return  endpoint, or APS_GROUPS_EP_NOT_FOUND
+ */
+uint8 aps_FindGroupForEndpoint( uint16 groupID, uint8 lastEP )
+{
+  uint8 found = (lastEP == APS_GROUPS_FIND_FIRST);
+  uint8 idx;
+
+  for ( idx = 0; idx < hostNwkGroupCnt; idx++ )
+  {
+    if ( hostNwkGroups[idx].groupID == groupID )
+    {
+      if ( found )
+      {
+        return ( hostNwkGroups[idx].endPoint );
+      }
+      found = (hostNwkGroups[idx].endPoint == lastEP);
+    }
+  }
+
+  return ( APS_GROUPS_EP_NOT_FOUND );
+}
+
+/*********************************************************************
+ * @fn      NLME_GetShortAddr
+ *
+ * @brief   Short address of the simulated device.
+ *
+ * @return  HOST_NWK_SHORT_ADDR
+ */
+uint16 NLME_GetShortAddr( void )
+{
+  return ( HOST_NWK_SHORT_ADDR );
+}
+
+/*********************************************************************
+ * @fn      NLME_IsAddressBroadcast
+ *
+ * @brief   Classify a short address. The simulated device is a
+ *          coordinator with its receiver always on, so every valid
+ *          broadcast address is for it.
+ *
+ * @param   shortAddress - address to check
+ *
+ * @return  addr_filter_t
+ */
+addr_filter_t NLME_IsAddressBroadcast( uint16 shortAddress )
+{
+  if ( shortAddress < NWK_BROADCAST_SHORTADDR_DEVZCZR )
+  {
+    return ( ADDR_NOT_BCAST );
+  }
+
+  return ( ADDR_BCAST_FOR_ME );
+}
+
+/*********************************************************************
+ * @fn      RTG_CheckRtStatus
+ *
+ * @brief   Every destination is a neighbour in the simulation.
+ *
+ * @return  RTG_SUCCESS
+ */
+RTG_Status_t RTG_CheckRtStatus( uint16 DstAddress, byte RtStatus, uint8 options )
+{
+  (void)DstAddress;
+  (void)RtStatus;
+  (void)options;
+
+  return ( RTG_SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      RTG_AddSrcRtgEntry_Guaranteed
+ *
+ * @brief   Source routes are accepted and ignored.
+ *
+ * @return  RTG_SUCCESS
+ */
+RTG_Status_t RTG_AddSrcRtgEntry_Guaranteed( uint16 srcAddr, uint8 relayCnt, uint16* pRelayList )
+{
+  (void)srcAddr;
+  (void)relayCnt;
+  (void)pRelayList;
+
+  return ( RTG_SUCCESS );
+}
+
+/*********************************************************************
+ * @fn      ZDO_RegisterForZDOMsg
+ *
+ * @brief   ZDO is not part of the host build; no ZDO messages are
+ *          ever delivered, so registrations are accepted and ignored.
+ *
+ * @return  ZSuccess
+ */
+ZStatus_t ZDO_RegisterForZDOMsg( uint8 taskID, uint16 clusterID )
+{
+  (void)taskID;
+  (void)clusterID;
+
+  return ( ZSuccess );
+}
+
+/*********************************************************************
+ * @fn      ZDO_ParseAddrRsp / ZDO_ParseEPListRsp
+ *
+ * @brief   Never reached, see ZDO_RegisterForZDOMsg().
+ *
+ * @return  NULL
+ */
+ZDO_NwkIEEEAddrResp_t *ZDO_ParseAddrRsp( zdoIncomingMsg_t *inMsg )
+{
+  (void)inMsg;
+
+  return ( NULL );
+}
+
+ZDO_ActiveEndpointRsp_t *ZDO_ParseEPListRsp( zdoIncomingMsg_t *inMsg )
+{
+  (void)inMsg;
+
+  return ( NULL );
+}
+
+/*********************************************************************
+ * @fn      ZDP_IEEEAddrReq / ZDP_MatchDescReq
+ *
+ * @brief   ZDP requests use up a transaction sequence number and are
+ *          not transmitted.
+ *
+ * @return  afStatus_SUCCESS
+ */
+afStatus_t ZDP_IEEEAddrReq( uint16 shortAddr, byte ReqType,
+                            byte StartIndex, byte SecurityEnable )
+{
+  (void)shortAddr;
+  (void)ReqType;
+  (void)StartIndex;
+  (void)SecurityEnable;
+
+  ZDP_TransID++;
+
+  return ( afStatus_SUCCESS );
+}
+
+afStatus_t ZDP_MatchDescReq( zAddrType_t *dstAddr, uint16 nwkAddr,
+                             uint16 ProfileID,
+                             byte NumInClusters, uint16 *InClusterList,
+                             byte NumOutClusters, uint16 *OutClusterList,
+                             byte SecurityEnable )
+{
+  (void)dstAddr;
+  (void)nwkAddr;
+  (void)ProfileID;
+  (void)NumInClusters;
+  (void)InClusterList;
+  (void)NumOutClusters;
+  (void)OutClusterList;
+  (void)SecurityEnable;
+
+  ZDP_TransID++;
+
+  return ( afStatus_SUCCESS );
+}
+
+/*********************************************************************
+*********************************************************************/
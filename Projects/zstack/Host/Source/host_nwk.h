@@ -0,0 +1,101 @@
+/**************************************************************************************************
+  Filename:       host_nwk.h
+
+  Description:    Host simulation of the layers below AF (APS, NWK, routing). Outgoing APS data
+                  requests are captured instead of transmitted, and synthetic frames can be
+                  delivered to AF exactly as APS would after a successful reception.
+
+**************************************************************************************************/
+
+#ifndef HOST_NWK_H
+#define HOST_NWK_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "ZComDef.h"
+#include "APSMEDE.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Short address and PAN of the simulated device (a coordinator)
+#define HOST_NWK_SHORT_ADDR       0x0000
+#define HOST_NWK_PAN_ID           0x1A62
+
+// Largest ASDU kept by the Tx capture
+#define HOST_NWK_CAPTURE_MAX      128
+
+// Group memberships of the simulated APS group table
+#define HOST_NWK_GROUP_MAX        8
+
+/*********************************************************************
+ * TYPEDEFS
+ */
+
+// Called for every APSDE_DataReq() issued by AF
+typedef void (*hostNwkTxHook_t)( APSDE_DataReq_t *req );
+
+typedef struct
+{
+  uint32 txCount;         // APSDE_DataReq() calls
+  uint32 txBytes;         // Total ASDU bytes requested
+  uint32 rxCount;         // Frames delivered to AF
+  uint32 rxBytes;         // Total ASDU bytes delivered
+  uint16 lastTxLen;       // Length of the last captured ASDU (may be truncated)
+  uint16 lastTxCluster;
+  uint8  lastTx[HOST_NWK_CAPTURE_MAX];
+} hostNwkStats_t;
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+extern hostNwkStats_t hostNwkStats;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+/*
+ * Reset the statistics and the Tx capture
+ */
+extern void hostNwkReset( void );
+
+/*
+ * Install (or remove with NULL) a hook that sees every outgoing request
+ */
+extern void hostNwkSetTxHook( hostNwkTxHook_t hook );
+
+/*
+ * Deliver a unicast data frame to AF as if APS had just received it
+ */
+extern void hostNwkDeliver( uint16 srcAddr, uint8 srcEP, uint8 dstEP, uint16 clusterID,
+                            uint16 profileID, uint8 *asdu, uint8 len );
+
+/*
+ * Deliver a group addressed data frame to AF
+ */
+extern void hostNwkDeliverGroup( uint16 srcAddr, uint8 srcEP, uint16 groupID, uint16 clusterID,
+                                 uint16 profileID, uint8 *asdu, uint8 len );
+
+/*
+ * Add an endpoint to a group of the simulated APS group table, or empty the table
+ */
+extern ZStatus_t hostNwkAddGroup( uint16 groupID, uint8 endPoint );
+extern void hostNwkRemoveGroups( void );
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HOST_NWK_H */
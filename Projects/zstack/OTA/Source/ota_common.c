@@ -49,7 +49,7 @@
 #define osal_memcpy  memcpy
 #define osal_strlen  strlen
 #else
-#include "osal.h"
+#include "OSAL.h"
 #endif
 
 /******************************************************************************
@@ -475,7 +475,8 @@ uint8 *OTA_AfAddrToStream(afAddrType_t *pAddr, uint8 *pStream)
   {
     *pStream++ = pAddr->addrMode;
 
-    if (pAddr->addrMode == afAddr16Bit)
+    if ((pAddr->addrMode == afAddr16Bit) || (pAddr->addrMode == afAddrGroup) ||
+        (pAddr->addrMode == afAddrBroadcast))
     {
       *pStream++ = LO_UINT16(pAddr->addr.shortAddr);
       *pStream++ = HI_UINT16(pAddr->addr.shortAddr);
@@ -511,7 +512,8 @@ uint8 *OTA_StreamToAfAddr(afAddrType_t *pAddr, uint8 *pStream)
   {
     pAddr->addrMode = (afAddrMode_t) *pStream++;
 
-    if (pAddr->addrMode == afAddr16Bit)
+    if ((pAddr->addrMode == afAddr16Bit) || (pAddr->addrMode == afAddrGroup) ||
+        (pAddr->addrMode == afAddrBroadcast))
     {
       pAddr->addr.shortAddr = BUILD_UINT16(pStream[0], pStream[1]);
       pStream+= 2;
@@ -42,7 +42,7 @@
 #define OTA_COMMON_H
 
 #if !defined HAL_OTA_BOOT_CODE
-#include "af.h"
+#include "AF.h"
 #endif
 
 #ifndef _MSC_VER
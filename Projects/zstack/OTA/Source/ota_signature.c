@@ -194,9 +194,11 @@ void OTA_CalculateMmoR3(OTA_MmoCtrl_t *pCtrl, uint8 *pData, uint8 len, uint8 las
  */
 static int OTA_ValidateHashFunc(uint8 *digest, uint32 len, uint8 *data)
 {
-  len *= 8;  // Convert to bit length
+  sspMMOHash_t hash;
 
-  sspMMOHash( NULL, 0, data, (uint16)len, digest );
+  sspMMOHashInit(&hash);
+  sspMMOHashUpdate(&hash, data, (uint16)len);
+  sspMMOHashFinal(&hash, digest);
 
   return MCE_SUCCESS;
 }
@@ -0,0 +1,252 @@
+/**************************************************************************************************
+  Filename:       OnBoard.c
+
+  Description:    This file contains the board support for the host (Linux/x86) simulation
+                  build of OSAL, ZCL and AF.
+  Notes:          There are no keys, LEDs or stack probes on the host; the functions exist so
+                  that stack code links unchanged.
+
+**************************************************************************************************/
+
+/*********************************************************************
+ * INCLUDES
+ */
+
+#include "ZComDef.h"
+#include "OnBoard.h"
+#include "OSAL.h"
+
+/* Hal */
+#include "hal_mcu.h"
+#include "hal_key.h"
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Task ID not initialized
+#define NO_TASK_ID 0xFF
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+// 64-bit Extended Address of this device
+uint8 aExtendedAddress[8];
+
+/*********************************************************************
+ * LOCAL VARIABLES
+ */
+
+// Registered keys task ID, initialized to NOT USED.
+static uint8 registeredKeysTaskID = NO_TASK_ID;
+
+// State of the board random number generator (16-bit Galois LFSR).
+static uint16 randState = 0xACE1;
+
+/*********************************************************************
+ * @fn      InitBoard()
+ * @brief   Initialize the host board
+ * @param   level: COLD,WARM,READY
+ * @return  None
+ */
+void InitBoard( uint8 level )
+{
+  if ( level == OB_COLD )
+  {
+    // Interrupts off
+    osal_int_disable( INTS_ALL );
+  }
+  else  // !OB_COLD
+  {
+    // Nothing to configure: key and LED callbacks are never raised on the host.
+  }
+}
+
+/*********************************************************************
+ * @fn      TimerElapsed()
+ *
+ * @brief   Get elapsed timer clock counts
+ *
+ * @param   none
+ *
+ * @return  Always 0 - OSAL time is driven by osalTimeUpdate() on this board.
+ */
+uint32 TimerElapsed( void )
+{
+  return ( 0 );
+}
+
+/*********************************************************************
+ * @fn      RegisterForKeys
+ *
+ * @brief   Register a task for key events.
+ *
+ * @param   task_id - task to receive the keys
+ *
+ * @return  true if registered
+ *********************************************************************/
+uint8 RegisterForKeys( uint8 task_id )
+{
+  // Allow only the first task
+  if ( registeredKeysTaskID == NO_TASK_ID )
+  {
+    registeredKeysTaskID = task_id;
+    return ( true );
+  }
+  else
+    return ( false );
+}
+
+/*********************************************************************
+ * @fn      OnBoard_SendKeys
+ *
+ * @brief   Send "Key Pressed" message to application.
+ *
+ * @param   keys  - keys that were pressed
+ *          state - shifted
+ *
+ * @return  status
+ *********************************************************************/
+uint8 OnBoard_SendKeys( uint8 keys, uint8 state )
+{
+  keyChange_t *msgPtr;
+
+  if ( registeredKeysTaskID != NO_TASK_ID )
+  {
+    // Send the address to the task
+    msgPtr = (keyChange_t *)osal_msg_allocate( sizeof(keyChange_t) );
+    if ( msgPtr )
+    {
+      msgPtr->hdr.event = KEY_CHANGE;
+      msgPtr->state = state;
+      msgPtr->keys = keys;
+
+      osal_msg_send( registeredKeysTaskID, (uint8 *)msgPtr );
+    }
+    return ( ZSuccess );
+  }
+  else
+    return ( ZFailure );
+}
+
+/*********************************************************************
+ * @fn      OnBoard_KeyCallback
+ *
+ * @brief   Callback service for keys
+ *
+ * @param   keys  - keys that were pressed
+ *          state - shifted
+ *
+ * @return  void
+ *********************************************************************/
+void OnBoard_KeyCallback ( uint8 keys, uint8 state )
+{
+  (void)state;
+
+  (void)OnBoard_SendKeys( keys, (keys & HAL_KEY_SW_6) ? true : false );
+}
+
+/*********************************************************************
+ * @fn      OnBoard_stack_used
+ *
+ * @brief   Stack usage is not tracked on the host.
+ *
+ * @param   none
+ *
+ * @return  0
+ *********************************************************************/
+uint16 OnBoard_stack_used(void)
+{
+  return 0;
+}
+
+/*********************************************************************
+ * @fn      _itoa
+ *
+ * @brief   convert a 16bit number to ASCII
+ *
+ * @param   num -
+ *          buf -
+ *          radix -
+ *
+ * @return  void
+ *
+ *********************************************************************/
+void _itoa(uint16 num, uint8 *buf, uint8 radix)
+{
+  char c,i;
+  uint8 *p, rst[5];
+
+  p = rst;
+  for ( i=0; i<5; i++,p++ )
+  {
+    c = num % radix;  // Isolate a digit
+    *p = c + (( c < 10 ) ? '0' : '7');  // Convert to Ascii
+    num /= radix;
+    if ( !num )
+      break;
+  }
+
+  for ( c=0 ; c<=i; c++ )
+    *buf++ = *p--;  // Reverse character order
+
+  *buf = '\0';
+}
+
+/*********************************************************************
+ * @fn        Onboard_rand
+ *
+ * @brief    Random number generator. Deterministic on the host so that
+ *           simulation runs are repeatable.
+ *
+ * @param   none
+ *
+ * @return  uint16 - new random number
+ *
+ *********************************************************************/
+uint16 Onboard_rand( void )
+{
+  uint8 lsb = randState & 1;
+
+  randState >>= 1;
+  if ( lsb )
+  {
+    randState ^= 0xB400;
+  }
+
+  return ( randState );
+}
+
+/*********************************************************************
+ * @fn        Onboard_wait
+ *
+ * @brief    Delay wait - simulated time does not pass while busy waiting.
+ *
+ * @param   uint16 - time to wait
+ *
+ * @return  none
+ *
+ *********************************************************************/
+void Onboard_wait( uint16 timeout )
+{
+  (void)timeout;
+}
+
+/*********************************************************************
+ * @fn      Onboard_soft_reset
+ *
+ * @brief   Effect a soft reset.
+ *
+ * @param   none
+ *
+ * @return  none
+ *
+ *********************************************************************/
+void Onboard_soft_reset( void )
+{
+  HAL_SYSTEM_RESET();
+}
+
+/*********************************************************************
+*********************************************************************/
@@ -0,0 +1,177 @@
+/**************************************************************************************************
+  Filename:       OnBoard.h
+
+  Description:    Defines stuff for the host (Linux/x86) simulation build of OSAL, ZCL and AF.
+
+**************************************************************************************************/
+
+#ifndef ONBOARD_H
+#define ONBOARD_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*********************************************************************
+ * INCLUDES
+ */
+#include "hal_mcu.h"
+#include "hal_uart.h"
+#include "hal_sleep.h"
+#include "OSAL.h"
+
+/*********************************************************************
+ * GLOBAL VARIABLES
+ */
+
+// 64-bit Extended Address of this device
+extern uint8 aExtendedAddress[8];
+
+/*********************************************************************
+ * CONSTANTS
+ */
+
+// Timer clock and power-saving definitions
+#define TIMER_DECR_TIME    1  // 1ms - has to be matched with TC_OCC
+
+/* OSAL timer defines */
+#define TICK_TIME   1000   // Timer per tick - in micro-sec
+
+#define TICK_COUNT  1
+
+/*********************************************************************
+ * MACROS
+ */
+
+// These Key definitions are unique to this development system.
+// They are used to bypass functions when starting up the device.
+#define SW_BYPASS_NV    HAL_KEY_SW_5  // Bypass Network layer NV restore
+#define SW_BYPASS_START HAL_KEY_SW_1  // Bypass Network initialization
+
+/* Serial Port Definitions */
+#if defined (ZAPP_P1)
+  #define ZAPP_PORT HAL_UART_PORT_0
+#elif defined (ZAPP_P2)
+  #define ZAPP_PORT HAL_UART_PORT_1
+#else
+  #undef ZAPP_PORT
+#endif
+#if defined (ZTOOL_P1)
+  #define ZTOOL_PORT HAL_UART_PORT_0
+#elif defined (ZTOOL_P2)
+  #define ZTOOL_PORT HAL_UART_PORT_1
+#else
+  #undef ZTOOL_PORT
+#endif
+
+#define MT_UART_TX_BUFF_MAX  128
+#define MT_UART_RX_BUFF_MAX  128
+#define MT_UART_THRESHOLD   (MT_UART_RX_BUFF_MAX / 2)
+#define MT_UART_IDLE_TIMEOUT 6
+
+// Restart system from absolute beginning
+#define SystemReset()       HAL_SYSTEM_RESET()
+
+#define SystemResetSoft()  Onboard_soft_reset()
+
+/* Reset reason for reset indication */
+#define ResetReason() (0)
+
+#define WatchDogEnable(wdti)
+
+// Wait for specified microseconds
+#define MicroWait(t) Onboard_wait(t)
+
+#define OSAL_SET_CPU_INTO_SLEEP(timeout) halSleep(timeout); /* Called from OSAL_PwrMgr */
+
+/* The simulated heap matches the router/coordinator default of the CC2530 builds so that
+ * fragmentation and high-water figures measured on the host are representative.
+ */
+#if !defined INT_HEAP_LEN
+#if defined RTR_NWK
+  #define INT_HEAP_LEN  3072
+#else
+  #define INT_HEAP_LEN  2048
+#endif
+#endif
+#define MAXMEMHEAP INT_HEAP_LEN
+
+#define KEY_CHANGE_SHIFT_IDX 1
+#define KEY_CHANGE_KEYS_IDX  2
+
+// Initialization levels
+#define OB_COLD  0
+#define OB_WARM  1
+#define OB_READY 2
+
+typedef struct
+{
+  osal_event_hdr_t hdr;
+  uint8 state; // shift
+  uint8 keys;  // keys
+} keyChange_t;
+
+/*********************************************************************
+ * FUNCTIONS
+ */
+
+  /*
+   * Initialize the Peripherals
+   *    level: 0=cold, 1=warm, 2=ready
+   */
+  extern void InitBoard( uint8 level );
+
+ /*
+  * Get elapsed timer clock counts
+  */
+  extern uint32 TimerElapsed( void );
+
+  /*
+   * Register for all key events
+   */
+  extern uint8 RegisterForKeys( uint8 task_id );
+
+  /*
+   * Send "Key Pressed" message to application
+   */
+  extern uint8 OnBoard_SendKeys( uint8 keys, uint8 shift );
+
+  /*
+   * Convert an interger to an ascii string
+   */
+  extern void _itoa( uint16 num, uint8 *buf, uint8 radix );
+
+  /*
+   * Calculate the size of used stack
+   */
+  extern uint16 OnBoard_stack_used( void );
+
+  /*
+   * Callback routine to handle keys
+   */
+  extern void OnBoard_KeyCallback ( uint8 keys, uint8 state );
+
+  /*
+   * Board specific random number generator
+   */
+  extern uint16 Onboard_rand( void );
+
+  /*
+   * Board specific micro-second wait
+   */
+  extern void Onboard_wait( uint16 timeout );
+
+  /*
+   * Board specific soft reset.
+   */
+  extern void Onboard_soft_reset( void );
+
+/*********************************************************************
+*********************************************************************/
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ONBOARD_H